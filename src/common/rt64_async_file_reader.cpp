@@ -0,0 +1,435 @@
+//
+// RT64
+//
+
+#include "rt64_async_file_reader.h"
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#   define RT64_IO_URING 1
+#   include <cerrno>
+#   include <fcntl.h>
+#   include <linux/io_uring.h>
+#   include <sys/mman.h>
+#   include <sys/syscall.h>
+#   include <sys/uio.h>
+#   include <unistd.h>
+#else
+#   define RT64_IO_URING 0
+#endif
+
+namespace RT64 {
+    // AsyncFileReader
+
+    bool AsyncFileReader::isQueueFull() const {
+        return readsInFlight >= queueDepth;
+    }
+
+    uint8_t *AsyncFileReader::getRegisteredBuffer(uint32_t index) const {
+        assert(index < registeredBuffers.size());
+        return registeredBuffers[index].get();
+    }
+
+    void AsyncFileReader::allocateRegisteredBuffers(uint32_t bufferCount, size_t bufferSize) {
+        registeredBufferSize = bufferSize;
+        registeredBuffers.resize(bufferCount);
+        for (std::unique_ptr<uint8_t[]> &buffer : registeredBuffers) {
+            buffer = std::make_unique<uint8_t[]>(bufferSize);
+        }
+    }
+
+#if RT64_IO_URING
+    // AsyncFileReaderURing
+
+    struct AsyncFileReaderURing : AsyncFileReader {
+        struct Slot {
+            int fileDescriptor = -1;
+            uint8_t *destination = nullptr;
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            uint64_t bytesRead = 0;
+            int32_t bufferIndex = -1;
+            uint64_t userData = 0;
+            iovec vector = {};
+            bool active = false;
+        };
+
+        int ringFileDescriptor = -1;
+        void *submissionRing = MAP_FAILED;
+        void *completionRing = MAP_FAILED;
+        size_t submissionRingSize = 0;
+        size_t completionRingSize = 0;
+        io_uring_sqe *submissionEntries = static_cast<io_uring_sqe *>(MAP_FAILED);
+        size_t submissionEntriesSize = 0;
+        unsigned *submissionHead = nullptr;
+        unsigned *submissionTail = nullptr;
+        unsigned *submissionMask = nullptr;
+        unsigned *submissionArray = nullptr;
+        unsigned *completionHead = nullptr;
+        unsigned *completionTail = nullptr;
+        unsigned *completionMask = nullptr;
+        io_uring_cqe *completionEntries = nullptr;
+        unsigned pendingSubmissions = 0;
+        std::vector<Slot> slots;
+        bool buffersRegistered = false;
+
+        ~AsyncFileReaderURing() override {
+            if (ringFileDescriptor >= 0) {
+                // Every read must be done before the memory it writes to can be released.
+                std::vector<AsyncFileCompletion> completions;
+                flush();
+                while (readsInFlight > 0) {
+                    wait(completions, readsInFlight);
+                }
+            }
+
+            if (submissionEntries != MAP_FAILED) {
+                munmap(submissionEntries, submissionEntriesSize);
+            }
+
+            if ((completionRing != MAP_FAILED) && (completionRing != submissionRing)) {
+                munmap(completionRing, completionRingSize);
+            }
+
+            if (submissionRing != MAP_FAILED) {
+                munmap(submissionRing, submissionRingSize);
+            }
+
+            if (ringFileDescriptor >= 0) {
+                close(ringFileDescriptor);
+            }
+        }
+
+        bool setup(uint32_t queueDepth, size_t registeredBufferSize) {
+            io_uring_params params = {};
+            ringFileDescriptor = int(syscall(__NR_io_uring_setup, queueDepth, &params));
+            if (ringFileDescriptor < 0) {
+                return false;
+            }
+
+            // The completion ring can share the mapping with the submission ring on newer kernels.
+            submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            const bool singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (singleMapping) {
+                submissionRingSize = std::max(submissionRingSize, completionRingSize);
+            }
+
+            submissionRing = mmap(nullptr, submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFileDescriptor, IORING_OFF_SQ_RING);
+            if (submissionRing == MAP_FAILED) {
+                return false;
+            }
+
+            if (singleMapping) {
+                completionRing = submissionRing;
+            }
+            else {
+                completionRing = mmap(nullptr, completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFileDescriptor, IORING_OFF_CQ_RING);
+                if (completionRing == MAP_FAILED) {
+                    return false;
+                }
+            }
+
+            submissionEntriesSize = params.sq_entries * sizeof(io_uring_sqe);
+            submissionEntries = static_cast<io_uring_sqe *>(mmap(nullptr, submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFileDescriptor, IORING_OFF_SQES));
+            if (submissionEntries == MAP_FAILED) {
+                return false;
+            }
+
+            uint8_t *submissionBytes = static_cast<uint8_t *>(submissionRing);
+            submissionHead = reinterpret_cast<unsigned *>(submissionBytes + params.sq_off.head);
+            submissionTail = reinterpret_cast<unsigned *>(submissionBytes + params.sq_off.tail);
+            submissionMask = reinterpret_cast<unsigned *>(submissionBytes + params.sq_off.ring_mask);
+            submissionArray = reinterpret_cast<unsigned *>(submissionBytes + params.sq_off.array);
+
+            uint8_t *completionBytes = static_cast<uint8_t *>(completionRing);
+            completionHead = reinterpret_cast<unsigned *>(completionBytes + params.cq_off.head);
+            completionTail = reinterpret_cast<unsigned *>(completionBytes + params.cq_off.tail);
+            completionMask = reinterpret_cast<unsigned *>(completionBytes + params.cq_off.ring_mask);
+            completionEntries = reinterpret_cast<io_uring_cqe *>(completionBytes + params.cq_off.cqes);
+
+            this->queueDepth = std::min(queueDepth, params.sq_entries);
+            slots.resize(this->queueDepth);
+
+            // Registering the buffers pins them once so the kernel doesn't need to map them on every read. The reads can still target
+            // regular memory if the registration is not allowed.
+            allocateRegisteredBuffers(this->queueDepth, registeredBufferSize);
+            std::vector<iovec> bufferVectors(registeredBuffers.size());
+            for (size_t i = 0; i < registeredBuffers.size(); i++) {
+                bufferVectors[i].iov_base = registeredBuffers[i].get();
+                bufferVectors[i].iov_len = registeredBufferSize;
+            }
+
+            buffersRegistered = (syscall(__NR_io_uring_register, ringFileDescriptor, IORING_REGISTER_BUFFERS, bufferVectors.data(), unsigned(bufferVectors.size())) == 0);
+            return true;
+        }
+
+        void queueSlot(uint32_t slotIndex) {
+            Slot &slot = slots[slotIndex];
+            const unsigned tail = *submissionTail;
+            const unsigned index = tail & *submissionMask;
+            io_uring_sqe &entry = submissionEntries[index];
+            memset(&entry, 0, sizeof(io_uring_sqe));
+
+            const uint64_t remaining = slot.size - slot.bytesRead;
+            entry.fd = slot.fileDescriptor;
+            entry.off = slot.offset + slot.bytesRead;
+            entry.user_data = slotIndex;
+            if (buffersRegistered && (slot.bufferIndex >= 0)) {
+                entry.opcode = IORING_OP_READ_FIXED;
+                entry.addr = uint64_t(uintptr_t(slot.destination + slot.bytesRead));
+                entry.len = uint32_t(remaining);
+                entry.buf_index = uint16_t(slot.bufferIndex);
+            }
+            else {
+                slot.vector.iov_base = slot.destination + slot.bytesRead;
+                slot.vector.iov_len = remaining;
+                entry.opcode = IORING_OP_READV;
+                entry.addr = uint64_t(uintptr_t(&slot.vector));
+                entry.len = 1;
+            }
+
+            submissionArray[index] = index;
+            __atomic_store_n(submissionTail, tail + 1, __ATOMIC_RELEASE);
+            pendingSubmissions++;
+        }
+
+        bool submit(const AsyncFileRead &read) override {
+            assert((read.bufferIndex < 0) || (read.size <= registeredBufferSize));
+
+            if (isQueueFull() || (read.size > UINT32_MAX)) {
+                return false;
+            }
+
+            auto slotIt = std::find_if(slots.begin(), slots.end(), [](const Slot &slot) { return !slot.active; });
+            assert(slotIt != slots.end());
+
+            int fileDescriptor = open(read.filePath.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fileDescriptor < 0) {
+                return false;
+            }
+
+            Slot &slot = *slotIt;
+            slot.fileDescriptor = fileDescriptor;
+            slot.destination = read.destination;
+            slot.offset = read.offset;
+            slot.size = read.size;
+            slot.bytesRead = 0;
+            slot.bufferIndex = read.bufferIndex;
+            slot.userData = read.userData;
+            slot.active = true;
+            readsInFlight++;
+            queueSlot(uint32_t(slotIt - slots.begin()));
+            return true;
+        }
+
+        void flush() override {
+            while (pendingSubmissions > 0) {
+                int result = int(syscall(__NR_io_uring_enter, ringFileDescriptor, pendingSubmissions, 0, 0, nullptr, 0));
+                if (result >= 0) {
+                    pendingSubmissions -= std::min(unsigned(result), pendingSubmissions);
+                }
+                else if (errno != EINTR) {
+                    break;
+                }
+            }
+        }
+
+        void finishSlot(Slot &slot, bool success, std::vector<AsyncFileCompletion> &completions) {
+            close(slot.fileDescriptor);
+            slot.fileDescriptor = -1;
+            slot.active = false;
+            readsInFlight--;
+            completions.emplace_back(AsyncFileCompletion{ slot.userData, success });
+        }
+
+        void wait(std::vector<AsyncFileCompletion> &completions, uint32_t minCompletions) override {
+            flush();
+
+            uint32_t completionCount = 0;
+            minCompletions = std::min(minCompletions, readsInFlight);
+            while (completionCount < minCompletions) {
+                int result = int(syscall(__NR_io_uring_enter, ringFileDescriptor, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+                if ((result < 0) && (errno != EINTR)) {
+                    // The ring can't be waited on anymore, so there's no way to know when the memory is safe to reuse.
+                    fprintf(stderr, "io_uring_enter failed with error %d.\n", errno);
+                    abort();
+                }
+
+                unsigned head = *completionHead;
+                const unsigned tail = __atomic_load_n(completionTail, __ATOMIC_ACQUIRE);
+                while (head != tail) {
+                    const io_uring_cqe &entry = completionEntries[head & *completionMask];
+                    Slot &slot = slots[entry.user_data];
+                    if (entry.res > 0) {
+                        // Reads can return less than requested, in which case the rest is read again.
+                        slot.bytesRead += uint64_t(entry.res);
+                        if (slot.bytesRead < slot.size) {
+                            queueSlot(uint32_t(entry.user_data));
+                        }
+                        else {
+                            finishSlot(slot, true, completions);
+                            completionCount++;
+                        }
+                    }
+                    else {
+                        finishSlot(slot, false, completions);
+                        completionCount++;
+                    }
+
+                    head++;
+                }
+
+                __atomic_store_n(completionHead, head, __ATOMIC_RELEASE);
+                flush();
+            }
+        }
+    };
+#endif
+
+    // AsyncFileThreadPool
+
+    // Shared by all the readers that fall back to blocking reads so the amount of threads doesn't grow with the amount of readers.
+    struct AsyncFileThreadPool {
+        struct Request {
+            AsyncFileRead read;
+            std::function<void(const AsyncFileCompletion &)> callback;
+        };
+
+        std::vector<std::thread> threads;
+        std::deque<Request> requests;
+        std::mutex requestsMutex;
+        std::condition_variable requestsChanged;
+        bool stopThreads = false;
+
+        AsyncFileThreadPool() {
+            const uint32_t threadCount = std::max(std::thread::hardware_concurrency() / 2U, 2U);
+            for (uint32_t i = 0; i < threadCount; i++) {
+                threads.emplace_back(&AsyncFileThreadPool::threadLoop, this);
+            }
+        }
+
+        ~AsyncFileThreadPool() {
+            {
+                std::unique_lock lock(requestsMutex);
+                stopThreads = true;
+            }
+
+            requestsChanged.notify_all();
+            for (std::thread &thread : threads) {
+                thread.join();
+            }
+        }
+
+        void threadLoop() {
+            while (true) {
+                Request request;
+                {
+                    std::unique_lock lock(requestsMutex);
+                    requestsChanged.wait(lock, [this]() { return stopThreads || !requests.empty(); });
+                    if (stopThreads) {
+                        return;
+                    }
+
+                    request = std::move(requests.front());
+                    requests.pop_front();
+                }
+
+                std::ifstream fileStream(request.read.filePath, std::ios::binary);
+                bool success = false;
+                if (fileStream.is_open()) {
+                    fileStream.seekg(request.read.offset);
+                    fileStream.read(reinterpret_cast<char *>(request.read.destination), request.read.size);
+                    success = (uint64_t(fileStream.gcount()) == request.read.size);
+                }
+
+                request.callback(AsyncFileCompletion{ request.read.userData, success });
+            }
+        }
+
+        void push(Request &&request) {
+            {
+                std::unique_lock lock(requestsMutex);
+                requests.emplace_back(std::move(request));
+            }
+
+            requestsChanged.notify_one();
+        }
+
+        static AsyncFileThreadPool &get() {
+            static AsyncFileThreadPool threadPool;
+            return threadPool;
+        }
+    };
+
+    // AsyncFileReaderThreads
+
+    struct AsyncFileReaderThreads : AsyncFileReader {
+        std::vector<AsyncFileCompletion> completedReads;
+        std::mutex completedReadsMutex;
+        std::condition_variable completedReadsChanged;
+
+        ~AsyncFileReaderThreads() override {
+            std::vector<AsyncFileCompletion> completions;
+            while (readsInFlight > 0) {
+                wait(completions, readsInFlight);
+            }
+        }
+
+        bool submit(const AsyncFileRead &read) override {
+            if (isQueueFull()) {
+                return false;
+            }
+
+            readsInFlight++;
+            AsyncFileThreadPool::get().push({ read, [this](const AsyncFileCompletion &completion) {
+                // Notify while holding the lock, as the reader can be destroyed as soon as the waiting thread sees the last completion.
+                std::unique_lock lock(completedReadsMutex);
+                completedReads.emplace_back(completion);
+                completedReadsChanged.notify_all();
+            } });
+
+            return true;
+        }
+
+        void flush() override {
+            // Reads start as soon as they're submitted.
+        }
+
+        void wait(std::vector<AsyncFileCompletion> &completions, uint32_t minCompletions) override {
+            minCompletions = std::min(minCompletions, readsInFlight);
+
+            std::unique_lock lock(completedReadsMutex);
+            completedReadsChanged.wait(lock, [&]() { return completedReads.size() >= minCompletions; });
+            completions.insert(completions.end(), completedReads.begin(), completedReads.end());
+            readsInFlight -= uint32_t(completedReads.size());
+            completedReads.clear();
+        }
+    };
+
+    std::unique_ptr<AsyncFileReader> AsyncFileReader::create(uint32_t queueDepth, size_t registeredBufferSize) {
+        assert(queueDepth > 0);
+
+#   if RT64_IO_URING
+        // io_uring can be unavailable even if the headers are present, like in containers that block it.
+        std::unique_ptr<AsyncFileReaderURing> uringReader = std::make_unique<AsyncFileReaderURing>();
+        if (uringReader->setup(queueDepth, registeredBufferSize)) {
+            return uringReader;
+        }
+#   endif
+
+        std::unique_ptr<AsyncFileReaderThreads> threadsReader = std::make_unique<AsyncFileReaderThreads>();
+        threadsReader->queueDepth = queueDepth;
+        threadsReader->allocateRegisteredBuffers(queueDepth, registeredBufferSize);
+        return threadsReader;
+    }
+};
@@ -0,0 +1,54 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace RT64 {
+    struct AsyncFileRead {
+        std::filesystem::path filePath;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint8_t *destination = nullptr;
+
+        // Index of the registered buffer the destination belongs to, or negative if it's any other memory.
+        int32_t bufferIndex = -1;
+
+        uint64_t userData = 0;
+    };
+
+    struct AsyncFileCompletion {
+        uint64_t userData = 0;
+        bool success = false;
+    };
+
+    // Keeps multiple reads from files in flight at the same time. The reader can only be used from one thread at a time, and reads are
+    // rejected once the queue depth is reached until some of them complete.
+    struct AsyncFileReader {
+        uint32_t queueDepth = 0;
+        uint32_t readsInFlight = 0;
+        std::vector<std::unique_ptr<uint8_t[]>> registeredBuffers;
+        size_t registeredBufferSize = 0;
+
+        virtual ~AsyncFileReader() {}
+
+        // Queues the read, but it's not guaranteed to start until the reader is flushed.
+        virtual bool submit(const AsyncFileRead &read) = 0;
+        virtual void flush() = 0;
+
+        // Blocks until at least the requested amount of reads complete. Returns immediately if there are no reads in flight.
+        virtual void wait(std::vector<AsyncFileCompletion> &completions, uint32_t minCompletions) = 0;
+
+        bool isQueueFull() const;
+        uint8_t *getRegisteredBuffer(uint32_t index) const;
+        void allocateRegisteredBuffers(uint32_t bufferCount, size_t bufferSize);
+
+        // Uses io_uring on Linux if the kernel allows it, and reads from a pool of threads shared by every reader otherwise. The reader
+        // has one registered buffer of the given size for every read that can be in flight.
+        static std::unique_ptr<AsyncFileReader> create(uint32_t queueDepth, size_t registeredBufferSize);
+    };
+};
@@ -7,6 +7,8 @@
 #include "rt64_common.h"
 
 #include <algorithm>
+#include <cstring>
+#include <filesystem>
 #include <memory>
 
 namespace RT64 {
@@ -17,6 +19,49 @@ namespace RT64 {
         virtual bool compare(const FileSystemIteratorImplementation *other) const = 0;
     };
 
+    // Reads the contents of a file sequentially, decompressing them on the fly if necessary, straight into the memory provided by the caller.
+    struct FileSystemReader {
+        virtual ~FileSystemReader() {}
+
+        // Returns the amount of bytes written, which will only be less than requested if the file ended or couldn't be read.
+        virtual size_t read(uint8_t *dst, size_t byteCount) = 0;
+
+        // Moves forward without writing the contents anywhere. Returns the amount of bytes skipped the same way as reading does.
+        virtual size_t skip(size_t byteCount) {
+            uint8_t skipBytes[4096];
+            size_t skipCount = 0;
+            while (skipCount < byteCount) {
+                size_t readCount = read(skipBytes, std::min(byteCount - skipCount, sizeof(skipBytes)));
+                if (readCount == 0) {
+                    break;
+                }
+
+                skipCount += readCount;
+            }
+
+            return skipCount;
+        }
+    };
+
+    // Fallback for file systems that can't read their files incrementally.
+    struct FileSystemMemoryReader : FileSystemReader {
+        std::vector<uint8_t> bytes;
+        size_t cursor = 0;
+
+        size_t read(uint8_t *dst, size_t byteCount) override {
+            size_t readCount = std::min(byteCount, bytes.size() - cursor);
+            memcpy(dst, &bytes[cursor], readCount);
+            cursor += readCount;
+            return readCount;
+        }
+
+        size_t skip(size_t byteCount) override {
+            size_t skipCount = std::min(byteCount, bytes.size() - cursor);
+            cursor += skipCount;
+            return skipCount;
+        }
+    };
+
     struct FileSystem {
         struct Iterator {
             std::shared_ptr<FileSystemIteratorImplementation> implementation;
@@ -43,6 +88,33 @@ namespace RT64 {
         virtual bool exists(const std::string &path) const = 0;
         virtual std::string makeCanonical(const std::string &path) const = 0;
 
+        virtual std::unique_ptr<FileSystemReader> openReader(const std::string &path) const {
+            size_t fileDataSize = getSize(path);
+            if (fileDataSize == 0) {
+                return nullptr;
+            }
+
+            std::unique_ptr<FileSystemMemoryReader> reader = std::make_unique<FileSystemMemoryReader>();
+            reader->bytes.resize(fileDataSize);
+            if (!load(path, reader->bytes.data(), fileDataSize)) {
+                return nullptr;
+            }
+
+            return reader;
+        }
+
+        // Returns the file and the offset inside of it where the contents are stored as-is, so they can be read directly without going
+        // through the file system. Not possible if the contents are compressed or the file system doesn't store them in a regular file.
+        virtual bool getStoredLocation(const std::string &path, std::filesystem::path &filePath, uint64_t &offset) const {
+            return false;
+        }
+
+        // Returns the contents as they're stored in memory, which might be compressed. Files of the same size that are stored the same way
+        // have identical contents, so they can be compared without reading them through the file system.
+        virtual bool getStoredContents(const std::string &path, const uint8_t *&data, size_t &size) const {
+            return false;
+        }
+
         // Concrete implementation shortcut.
         bool load(const std::string &path, std::vector<uint8_t> &fileData) {
             size_t fileDataSize = getSize(path);
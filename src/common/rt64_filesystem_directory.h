@@ -48,6 +48,28 @@ namespace RT64 {
         }
     };
 
+    struct FileSystemDirectoryReader : FileSystemReader {
+        std::ifstream fileStream;
+
+        size_t fileSize = 0;
+
+        size_t read(uint8_t *dst, size_t byteCount) override {
+            fileStream.read((char *)(dst), byteCount);
+            return size_t(fileStream.gcount());
+        }
+
+        size_t skip(size_t byteCount) override {
+            std::streamoff position = fileStream.tellg();
+            if (position < 0) {
+                return 0;
+            }
+
+            size_t skipCount = std::min(byteCount, fileSize - std::min(size_t(position), fileSize));
+            fileStream.seekg(std::streamoff(skipCount), std::ios::cur);
+            return fileStream.fail() ? 0 : skipCount;
+        }
+    };
+
     struct FileSystemDirectory : FileSystem {
         std::filesystem::path directoryPath;
         std::shared_ptr<FileSystemDirectoryIterator> endIterator;
@@ -99,6 +121,24 @@ namespace RT64 {
             }
         }
 
+        std::unique_ptr<FileSystemReader> openReader(const std::string &path) const override {
+            std::unique_ptr<FileSystemDirectoryReader> reader = std::make_unique<FileSystemDirectoryReader>();
+            reader->fileStream.open(directoryPath / std::filesystem::u8path(path), std::ios::binary);
+            if (!reader->fileStream.is_open()) {
+                return nullptr;
+            }
+
+            reader->fileSize = getSize(path);
+
+            return reader;
+        }
+
+        bool getStoredLocation(const std::string &path, std::filesystem::path &filePath, uint64_t &offset) const override {
+            filePath = directoryPath / std::filesystem::u8path(path);
+            offset = 0;
+            return true;
+        }
+
         size_t getSize(const std::string &path) const override {
             std::error_code ec;
             size_t fileSize = std::filesystem::file_size(directoryPath / std::filesystem::u8path(path), ec);
@@ -0,0 +1,308 @@
+//
+// RT64
+//
+
+#include "rt64_filesystem_pack.h"
+
+#include <cassert>
+#include <string_view>
+
+#include <zstd.h>
+
+#include "rt64_filesystem_readers.h"
+#include "rt64_mapped_file.h"
+
+namespace RT64 {
+    static bool isRangeValid(uint64_t offset, uint64_t size, uint64_t totalSize) {
+        return (offset <= totalSize) && (size <= (totalSize - offset));
+    }
+
+    // FileSystemPack::Implementation
+
+    struct FileSystemPack::Implementation {
+        MappedFile packMappedFile;
+        const FileSystemPackHeader *header = nullptr;
+        const FileSystemPackEntry *entries = nullptr;
+        const FileSystemPackChunk *chunks = nullptr;
+        const char *paths = nullptr;
+        ZSTD_DDict *dictionary = nullptr;
+        std::shared_ptr<FileSystemPackIterator> endIterator;
+        std::filesystem::path packPath;
+        std::string basePath;
+        bool packOpen = false;
+
+        ~Implementation() {
+            ZSTD_freeDDict(dictionary);
+        }
+
+        bool validate() {
+            const uint64_t fileSize = packMappedFile.size();
+            if (fileSize < sizeof(FileSystemPackHeader)) {
+                return false;
+            }
+
+            header = reinterpret_cast<const FileSystemPackHeader *>(packMappedFile.data());
+            if ((header->magic != FileSystemPackMagic) || (header->version > FileSystemPackVersion)) {
+                return false;
+            }
+
+            // The tables are read in place, so they must be aligned to the size of their largest member.
+            if (((header->entriesOffset % alignof(FileSystemPackEntry)) != 0) || ((header->chunksOffset % alignof(FileSystemPackChunk)) != 0)) {
+                return false;
+            }
+
+            if (!isRangeValid(header->entriesOffset, uint64_t(header->entryCount) * sizeof(FileSystemPackEntry), fileSize) ||
+                !isRangeValid(header->chunksOffset, header->chunkCount * sizeof(FileSystemPackChunk), fileSize) ||
+                !isRangeValid(header->pathsOffset, header->pathsSize, fileSize) ||
+                !isRangeValid(header->dictionaryOffset, header->dictionarySize, fileSize))
+            {
+                return false;
+            }
+
+            entries = reinterpret_cast<const FileSystemPackEntry *>(&packMappedFile.data()[header->entriesOffset]);
+            chunks = reinterpret_cast<const FileSystemPackChunk *>(&packMappedFile.data()[header->chunksOffset]);
+            paths = reinterpret_cast<const char *>(&packMappedFile.data()[header->pathsOffset]);
+
+            // Check every entry once so the rest of the implementation can trust them.
+            for (uint32_t i = 0; i < header->entryCount; i++) {
+                const FileSystemPackEntry &entry = entries[i];
+                if (!isRangeValid(entry.pathOffset, entry.pathLength, header->pathsSize) ||
+                    !isRangeValid(entry.dataOffset, entry.compressedSize, fileSize) ||
+                    !isRangeValid(entry.firstChunk, entry.chunkCount, header->chunkCount) ||
+                    (entry.compression > FileSystemPackCompression::ZstdDictionary) ||
+                    ((entry.compression == FileSystemPackCompression::None) && (entry.compressedSize != entry.uncompressedSize)))
+                {
+                    return false;
+                }
+            }
+
+            if (header->dictionarySize > 0) {
+                dictionary = ZSTD_createDDict(&packMappedFile.data()[header->dictionaryOffset], header->dictionarySize);
+                if (dictionary == nullptr) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        std::string_view getPath(const FileSystemPackEntry &entry) const {
+            return std::string_view(&paths[entry.pathOffset], entry.pathLength);
+        }
+
+        const uint8_t *getData(const FileSystemPackEntry &entry) const {
+            return &packMappedFile.data()[entry.dataOffset];
+        }
+    };
+
+    // FileSystemPack
+
+    FileSystemPack::FileSystemPack(const std::filesystem::path &packPath, const std::string &basePath) {
+        assert(basePath.empty() || (basePath.back() != '\\') || (basePath.back() != '/'));
+
+        impl = new Implementation();
+        impl->packPath = packPath;
+        impl->basePath = basePath.empty() ? std::string() : (basePath + "/");
+        if (!impl->packMappedFile.open(packPath)) {
+            return;
+        }
+
+        impl->packOpen = impl->validate();
+        if (impl->packOpen) {
+            impl->endIterator = std::make_shared<FileSystemPackIterator>(this, impl->header->entryCount);
+        }
+    }
+
+    FileSystemPack::~FileSystemPack() {
+        delete impl;
+    }
+
+    FileSystem::Iterator FileSystemPack::begin() const {
+        return { std::make_shared<FileSystemPackIterator>(this, 0) };
+    }
+
+    FileSystem::Iterator FileSystemPack::end() const {
+        return { impl->endIterator };
+    }
+
+    bool FileSystemPack::load(const std::string &path, uint8_t *fileData, size_t fileDataMaxByteCount) const {
+        assert(impl->packOpen);
+
+        const FileSystemPackEntry *entry = findEntry(path);
+        if (entry == nullptr) {
+            return false;
+        }
+
+        // Must have enough bytes to read the entire file.
+        if (fileDataMaxByteCount < entry->uncompressedSize) {
+            return false;
+        }
+
+        std::unique_ptr<FileSystemReader> reader = openReader(path);
+        if (reader == nullptr) {
+            return false;
+        }
+
+        return reader->read(fileData, entry->uncompressedSize) == entry->uncompressedSize;
+    }
+
+    std::unique_ptr<FileSystemReader> FileSystemPack::openReader(const std::string &path) const {
+        assert(impl->packOpen);
+
+        const FileSystemPackEntry *entry = findEntry(path);
+        if (entry == nullptr) {
+            return nullptr;
+        }
+
+        switch (entry->compression) {
+        case FileSystemPackCompression::None:
+            return std::make_unique<FileSystemMappedReader>(impl->getData(*entry), entry->uncompressedSize);
+        case FileSystemPackCompression::Zstd:
+        case FileSystemPackCompression::ZstdDictionary: {
+            // The chunks of an entry are stored one after the other, so the whole entry can be decompressed as a sequence of frames.
+            const ZSTD_DDict *dictionary = (entry->compression == FileSystemPackCompression::ZstdDictionary) ? impl->dictionary : nullptr;
+            if ((entry->compression == FileSystemPackCompression::ZstdDictionary) && (dictionary == nullptr)) {
+                return nullptr;
+            }
+
+            std::unique_ptr<FileSystemZstdReader> reader = std::make_unique<FileSystemZstdReader>();
+            if (!reader->open(impl->getData(*entry), entry->compressedSize, dictionary)) {
+                return nullptr;
+            }
+
+            reader->frames.resize(entry->chunkCount);
+            for (uint32_t i = 0; i < entry->chunkCount; i++) {
+                const FileSystemPackChunk &chunk = impl->chunks[entry->firstChunk + i];
+                reader->frames[i].compressedOffset = chunk.offset;
+                reader->frames[i].uncompressedOffset = chunk.uncompressedOffset;
+            }
+
+            return reader;
+        }
+        default:
+            return nullptr;
+        }
+    }
+
+    bool FileSystemPack::getStoredLocation(const std::string &path, std::filesystem::path &filePath, uint64_t &offset) const {
+        assert(impl->packOpen);
+
+        const FileSystemPackEntry *entry = findEntry(path);
+        if ((entry == nullptr) || (entry->compression != FileSystemPackCompression::None)) {
+            return false;
+        }
+
+        filePath = impl->packPath;
+        offset = entry->dataOffset;
+        return true;
+    }
+
+    bool FileSystemPack::getStoredContents(const std::string &path, const uint8_t *&data, size_t &size) const {
+        assert(impl->packOpen);
+
+        const FileSystemPackEntry *entry = findEntry(path);
+        if (entry == nullptr) {
+            return false;
+        }
+
+        data = impl->getData(*entry);
+        size = entry->compressedSize;
+        return true;
+    }
+
+    size_t FileSystemPack::getSize(const std::string &path) const {
+        assert(impl->packOpen);
+
+        const FileSystemPackEntry *entry = findEntry(path);
+        return (entry != nullptr) ? entry->uncompressedSize : 0;
+    }
+
+    bool FileSystemPack::exists(const std::string &path) const {
+        assert(impl->packOpen);
+
+        return findEntry(path) != nullptr;
+    }
+
+    std::string FileSystemPack::makeCanonical(const std::string &path) const {
+        // Has no effect on packs, as the paths are validated for case sensitivity when they're created.
+        return path;
+    }
+
+    bool FileSystemPack::isOpen() const {
+        return impl->packOpen;
+    }
+
+    const FileSystemPackEntry *FileSystemPack::findEntry(const std::string &path) const {
+        const std::string fullPath = impl->basePath + path;
+        const uint64_t pathHash = hashPath(fullPath);
+        const FileSystemPackEntry *entriesEnd = impl->entries + impl->header->entryCount;
+        const FileSystemPackEntry *entry = std::lower_bound(impl->entries, entriesEnd, pathHash, [this, &fullPath](const FileSystemPackEntry &entry, uint64_t pathHash) {
+            if (entry.pathHash != pathHash) {
+                return entry.pathHash < pathHash;
+            }
+
+            return impl->getPath(entry) < std::string_view(fullPath);
+        });
+
+        if ((entry != entriesEnd) && (entry->pathHash == pathHash) && (impl->getPath(*entry) == fullPath)) {
+            return entry;
+        }
+        else {
+            return nullptr;
+        }
+    }
+
+    bool FileSystemPack::isPackFile(const std::filesystem::path &packPath) {
+        std::ifstream packStream(packPath, std::ios::binary);
+        if (!packStream.is_open()) {
+            return false;
+        }
+
+        uint64_t magic = 0;
+        packStream.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+        return !packStream.fail() && (magic == FileSystemPackMagic);
+    }
+
+    std::unique_ptr<FileSystem> FileSystemPack::create(const std::filesystem::path &packPath, const std::string &basePath) {
+        std::unique_ptr<FileSystemPack> packFileSystem = std::make_unique<FileSystemPack>(packPath, basePath);
+        if (!packFileSystem->isOpen()) {
+            packFileSystem.reset();
+        }
+
+        return packFileSystem;
+    }
+
+    // FileSystemPackIterator
+
+    FileSystemPackIterator::FileSystemPackIterator(const FileSystemPack *fileSystem, uint32_t entryIndex) {
+        this->fileSystem = fileSystem;
+        this->entryIndex = entryIndex;
+        skipFiltered();
+    }
+
+    const std::string &FileSystemPackIterator::value() {
+        const FileSystemPack::Implementation *impl = fileSystem->impl;
+        std::string_view entryPath = impl->getPath(impl->entries[entryIndex]);
+        path.assign(entryPath.substr(impl->basePath.size()));
+        return path;
+    }
+
+    void FileSystemPackIterator::increment() {
+        entryIndex++;
+        skipFiltered();
+    }
+
+    bool FileSystemPackIterator::compare(const FileSystemIteratorImplementation *other) const {
+        const FileSystemPackIterator *otherPackIt = static_cast<const FileSystemPackIterator *>(other);
+        return (entryIndex == otherPackIt->entryIndex);
+    }
+
+    void FileSystemPackIterator::skipFiltered() {
+        // Skip the entries that aren't inside the base path.
+        const FileSystemPack::Implementation *impl = fileSystem->impl;
+        const uint32_t entryCount = impl->header->entryCount;
+        while ((entryIndex < entryCount) && (impl->getPath(impl->entries[entryIndex]).compare(0, impl->basePath.size(), impl->basePath) != 0)) {
+            entryIndex++;
+        }
+    }
+};
@@ -0,0 +1,105 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include "rt64_filesystem.h"
+
+#include <filesystem>
+
+namespace RT64 {
+    // Pack format meant to be mapped into memory as is. The index is sorted by the hash of the path, so files can be found with a binary
+    // search without building anything when the pack is opened. Every payload starts at an offset aligned to the page size, so stored
+    // files can be copied straight out of the mapping.
+    //
+    // Layout: header, dictionary, payloads, entries, chunks, paths. The tables go last so the packer can write the payloads as they finish.
+
+    static const uint64_t FileSystemPackMagic = 0x324B415034365452ULL; // "RT64PAK2"
+    static const uint32_t FileSystemPackVersion = 1;
+    static const uint64_t FileSystemPackPayloadAlignment = 4096;
+
+    enum class FileSystemPackCompression : uint32_t {
+        None = 0,
+        Zstd = 1,
+        ZstdDictionary = 2
+    };
+
+    struct FileSystemPackHeader {
+        uint64_t magic = FileSystemPackMagic;
+        uint32_t version = FileSystemPackVersion;
+        uint32_t entryCount = 0;
+        uint64_t entriesOffset = 0;
+        uint64_t chunksOffset = 0;
+        uint64_t chunkCount = 0;
+        uint64_t pathsOffset = 0;
+        uint64_t pathsSize = 0;
+        uint64_t dictionaryOffset = 0;
+        uint64_t dictionarySize = 0;
+    };
+
+    struct FileSystemPackEntry {
+        uint64_t pathHash = 0;
+        uint64_t pathOffset = 0;
+        uint64_t dataOffset = 0;
+        uint64_t compressedSize = 0;
+        uint64_t uncompressedSize = 0;
+        uint32_t pathLength = 0;
+        FileSystemPackCompression compression = FileSystemPackCompression::None;
+        uint32_t firstChunk = 0;
+        uint32_t chunkCount = 0;
+    };
+
+    // Compressed entries can be split into chunks that are stored as independent frames, so parts of a file such as the individual
+    // mipmaps of a DDS can be decompressed on their own. Offsets are relative to the start of the entry's payload and its contents.
+    struct FileSystemPackChunk {
+        uint64_t offset = 0;
+        uint64_t compressedSize = 0;
+        uint64_t uncompressedOffset = 0;
+        uint64_t uncompressedSize = 0;
+    };
+
+    struct FileSystemPack : FileSystem {
+        struct Implementation;
+        Implementation *impl = nullptr;
+
+        FileSystemPack(const std::filesystem::path &packPath, const std::string &basePath);
+        ~FileSystemPack() override;
+        Iterator begin() const override;
+        Iterator end() const override;
+        bool load(const std::string &path, uint8_t *fileData, size_t fileDataMaxByteCount) const override;
+        std::unique_ptr<FileSystemReader> openReader(const std::string &path) const override;
+        bool getStoredLocation(const std::string &path, std::filesystem::path &filePath, uint64_t &offset) const override;
+        bool getStoredContents(const std::string &path, const uint8_t *&data, size_t &size) const override;
+        size_t getSize(const std::string &path) const override;
+        bool exists(const std::string &path) const override;
+        std::string makeCanonical(const std::string &path) const override;
+        bool isOpen() const;
+        const FileSystemPackEntry *findEntry(const std::string &path) const;
+        static bool isPackFile(const std::filesystem::path &packPath);
+        static std::unique_ptr<FileSystem> create(const std::filesystem::path &packPath, const std::string &basePath);
+
+        // FNV-1a. It only needs to be stable and spread the paths evenly, as the paths themselves are compared on collisions.
+        static uint64_t hashPath(const std::string &path) {
+            uint64_t hash = 0xCBF29CE484222325ULL;
+            for (unsigned char c : path) {
+                hash ^= c;
+                hash *= 0x100000001B3ULL;
+            }
+
+            return hash;
+        }
+    };
+
+    struct FileSystemPackIterator : FileSystemIteratorImplementation {
+        const FileSystemPack *fileSystem = nullptr;
+        uint32_t entryIndex = 0;
+        std::string path;
+
+        FileSystemPackIterator(const FileSystemPack *fileSystem, uint32_t entryIndex);
+        const std::string &value() override;
+        void increment() override;
+        bool compare(const FileSystemIteratorImplementation *other) const override;
+        void skipFiltered();
+    };
+};
@@ -0,0 +1,154 @@
+//
+// RT64
+//
+
+#include "rt64_filesystem_pack_writer.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace RT64 {
+    // FileSystemPackPayload
+
+    void FileSystemPackPayload::compress(const std::vector<uint8_t> &fileData, const std::vector<size_t> &segmentOffsets, ZSTD_CCtx *compressionContext, const ZSTD_CDict *compressionDictionary, bool useCompression) {
+        assert(!segmentOffsets.empty() && (segmentOffsets.front() == 0) && (segmentOffsets.back() == fileData.size()));
+
+        size_t compressedCapacity = 0;
+        for (size_t i = 0; (i + 1) < segmentOffsets.size(); i++) {
+            compressedCapacity += ZSTD_compressBound(segmentOffsets[i + 1] - segmentOffsets[i]);
+        }
+
+        size_t compressedSize = 0;
+        bool storeUncompressed = !useCompression;
+        data.resize(compressedCapacity);
+        chunks.clear();
+        for (size_t i = 0; ((i + 1) < segmentOffsets.size()) && !storeUncompressed; i++) {
+            const uint8_t *segmentData = &fileData[segmentOffsets[i]];
+            const size_t segmentSize = segmentOffsets[i + 1] - segmentOffsets[i];
+            size_t chunkSize = 0;
+            if (compressionDictionary != nullptr) {
+                chunkSize = ZSTD_compress_usingCDict(compressionContext, &data[compressedSize], compressedCapacity - compressedSize, segmentData, segmentSize, compressionDictionary);
+            }
+            else {
+                chunkSize = ZSTD_compressCCtx(compressionContext, &data[compressedSize], compressedCapacity - compressedSize, segmentData, segmentSize, ZSTD_maxCLevel());
+            }
+
+            if (ZSTD_isError(chunkSize)) {
+                storeUncompressed = true;
+                break;
+            }
+
+            FileSystemPackChunk chunk;
+            chunk.offset = compressedSize;
+            chunk.compressedSize = chunkSize;
+            chunk.uncompressedOffset = segmentOffsets[i];
+            chunk.uncompressedSize = segmentSize;
+            chunks.emplace_back(chunk);
+            compressedSize += chunkSize;
+        }
+
+        // Store the file as is if compressing it doesn't save anything, as it can then be read straight out of the mapped pack.
+        uncompressedSize = fileData.size();
+        if (storeUncompressed || (compressedSize >= fileData.size())) {
+            data = fileData;
+            compression = FileSystemPackCompression::None;
+            chunks.clear();
+        }
+        else {
+            data.resize(compressedSize);
+            compression = (compressionDictionary != nullptr) ? FileSystemPackCompression::ZstdDictionary : FileSystemPackCompression::Zstd;
+
+            // A single chunk doesn't need to be listed as it covers the entire file.
+            if (chunks.size() == 1) {
+                chunks.clear();
+            }
+        }
+    }
+
+    // FileSystemPackWriter
+
+    void FileSystemPackWriter::alignTo(uint64_t alignment) {
+        while ((uint64_t(stream.tellp()) % alignment) != 0) {
+            stream.put(0);
+        }
+    }
+
+    bool FileSystemPackWriter::open(const std::filesystem::path &packPath, const std::vector<uint8_t> &dictionary) {
+        stream.open(packPath, std::ios::binary);
+        if (!stream.is_open()) {
+            return false;
+        }
+
+        // The header is written again with the final offsets once all the payloads are done.
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        if (!dictionary.empty()) {
+            header.dictionaryOffset = uint64_t(stream.tellp());
+            header.dictionarySize = dictionary.size();
+            stream.write(reinterpret_cast<const char *>(dictionary.data()), dictionary.size());
+        }
+
+        return !stream.bad();
+    }
+
+    bool FileSystemPackWriter::add(const std::string &path, const FileSystemPackPayload &payload) {
+        alignTo(FileSystemPackPayloadAlignment);
+
+        FileSystemPackEntry entry;
+        entry.pathHash = FileSystemPack::hashPath(path);
+        entry.pathLength = uint32_t(path.size());
+        entry.dataOffset = uint64_t(stream.tellp());
+        entry.compressedSize = payload.data.size();
+        entry.uncompressedSize = payload.uncompressedSize;
+        entry.compression = payload.compression;
+        entry.firstChunk = uint32_t(chunks.size());
+        entry.chunkCount = uint32_t(payload.chunks.size());
+        entries.emplace_back(entry);
+        entryPaths.emplace_back(path);
+        chunks.insert(chunks.end(), payload.chunks.begin(), payload.chunks.end());
+        stream.write(reinterpret_cast<const char *>(payload.data.data()), payload.data.size());
+        return !stream.bad();
+    }
+
+    bool FileSystemPackWriter::finalize() {
+        // Sort the index so the reader can look up the entries with a binary search.
+        std::vector<uint32_t> order(entries.size());
+        for (uint32_t i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+
+        std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+            if (entries[a].pathHash != entries[b].pathHash) {
+                return entries[a].pathHash < entries[b].pathHash;
+            }
+
+            return entryPaths[a] < entryPaths[b];
+        });
+
+        std::vector<FileSystemPackEntry> sortedEntries;
+        std::string paths;
+        for (uint32_t i : order) {
+            sortedEntries.emplace_back(entries[i]);
+            sortedEntries.back().pathOffset = paths.size();
+            paths += entryPaths[i];
+        }
+
+        alignTo(alignof(FileSystemPackEntry));
+        header.entryCount = uint32_t(sortedEntries.size());
+        header.entriesOffset = uint64_t(stream.tellp());
+        stream.write(reinterpret_cast<const char *>(sortedEntries.data()), sortedEntries.size() * sizeof(FileSystemPackEntry));
+
+        alignTo(alignof(FileSystemPackChunk));
+        header.chunkCount = chunks.size();
+        header.chunksOffset = uint64_t(stream.tellp());
+        stream.write(reinterpret_cast<const char *>(chunks.data()), chunks.size() * sizeof(FileSystemPackChunk));
+
+        header.pathsOffset = uint64_t(stream.tellp());
+        header.pathsSize = paths.size();
+        stream.write(paths.data(), paths.size());
+
+        stream.seekp(0);
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        stream.close();
+        return !stream.fail();
+    }
+};
@@ -0,0 +1,38 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include "rt64_filesystem_pack.h"
+
+#include <fstream>
+
+#include <zstd.h>
+
+namespace RT64 {
+    // Contents of a file the way they're stored in the pack.
+    struct FileSystemPackPayload {
+        std::vector<uint8_t> data;
+        uint64_t uncompressedSize = 0;
+        FileSystemPackCompression compression = FileSystemPackCompression::None;
+        std::vector<FileSystemPackChunk> chunks;
+
+        // Compresses every segment of the file as its own frame. The segments are given as the offsets where each one starts, followed
+        // by the size of the file. The file is stored as is instead if compressing it doesn't save anything.
+        void compress(const std::vector<uint8_t> &fileData, const std::vector<size_t> &segmentOffsets, ZSTD_CCtx *compressionContext, const ZSTD_CDict *compressionDictionary, bool useCompression);
+    };
+
+    struct FileSystemPackWriter {
+        std::ofstream stream;
+        FileSystemPackHeader header;
+        std::vector<FileSystemPackEntry> entries;
+        std::vector<std::string> entryPaths;
+        std::vector<FileSystemPackChunk> chunks;
+
+        void alignTo(uint64_t alignment);
+        bool open(const std::filesystem::path &packPath, const std::vector<uint8_t> &dictionary);
+        bool add(const std::string &path, const FileSystemPackPayload &payload);
+        bool finalize();
+    };
+};
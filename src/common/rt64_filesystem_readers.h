@@ -0,0 +1,118 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include "rt64_filesystem.h"
+
+#include <vector>
+
+#include <zstd.h>
+
+namespace RT64 {
+    // Reads a file whose contents are already in memory, like the stored entries of a mapped archive.
+    struct FileSystemMappedReader : FileSystemReader {
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+        size_t cursor = 0;
+
+        FileSystemMappedReader(const uint8_t *data, size_t size) {
+            this->data = data;
+            this->size = size;
+        }
+
+        size_t read(uint8_t *dst, size_t byteCount) override {
+            size_t readCount = std::min(byteCount, size - cursor);
+            memcpy(dst, &data[cursor], readCount);
+            cursor += readCount;
+            return readCount;
+        }
+
+        size_t skip(size_t byteCount) override {
+            size_t skipCount = std::min(byteCount, size - cursor);
+            cursor += skipCount;
+            return skipCount;
+        }
+    };
+
+    // Decompresses one or more consecutive zstd frames. The decoder keeps its own window and only copies the results out, so the destination
+    // is never read back. This matters when it's mapped upload memory.
+    struct FileSystemZstdReader : FileSystemReader {
+        // The decompression context is big enough to be worth reusing across all the files read by the same thread. Only one reader can be
+        // in use per thread at a time.
+        struct Context {
+            ZSTD_DCtx *dctx = nullptr;
+
+            ~Context() {
+                ZSTD_freeDCtx(dctx);
+            }
+        };
+
+        // Start of a frame that can be decompressed on its own, which lets skipping jump over the frames in between.
+        struct Frame {
+            uint64_t compressedOffset = 0;
+            uint64_t uncompressedOffset = 0;
+        };
+
+        ZSTD_DCtx *dctx = nullptr;
+        ZSTD_inBuffer input = {};
+        std::vector<Frame> frames;
+        uint64_t uncompressedCursor = 0;
+
+        bool open(const uint8_t *data, size_t size, const ZSTD_DDict *dictionary) {
+            thread_local Context context;
+            if (context.dctx == nullptr) {
+                context.dctx = ZSTD_createDCtx();
+                if (context.dctx == nullptr) {
+                    return false;
+                }
+            }
+
+            dctx = context.dctx;
+            ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only);
+
+            // Referencing no dictionary also clears the one used by the previous reader.
+            if (ZSTD_isError(ZSTD_DCtx_refDDict(dctx, dictionary))) {
+                return false;
+            }
+
+            input = { data, size, 0 };
+            return true;
+        }
+
+        size_t read(uint8_t *dst, size_t byteCount) override {
+            ZSTD_outBuffer output = { dst, byteCount, 0 };
+            while (output.pos < output.size) {
+                size_t previousInput = input.pos;
+                size_t previousOutput = output.pos;
+                size_t result = ZSTD_decompressStream(dctx, &output, &input);
+                if (ZSTD_isError(result) || ((input.pos == previousInput) && (output.pos == previousOutput))) {
+                    break;
+                }
+            }
+
+            uncompressedCursor += output.pos;
+            return output.pos;
+        }
+
+        size_t skip(size_t byteCount) override {
+            const uint64_t startCursor = uncompressedCursor;
+            const uint64_t targetCursor = uncompressedCursor + byteCount;
+            auto frameIt = std::upper_bound(frames.begin(), frames.end(), targetCursor, [](uint64_t cursor, const Frame &frame) {
+                return cursor < frame.uncompressedOffset;
+            });
+
+            // Resetting the session discards whatever was left of the current frame but keeps the dictionary.
+            if ((frameIt != frames.begin()) && ((frameIt - 1)->uncompressedOffset > uncompressedCursor) && ((frameIt - 1)->compressedOffset <= input.size)) {
+                frameIt--;
+                ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only);
+                input.pos = frameIt->compressedOffset;
+                uncompressedCursor = frameIt->uncompressedOffset;
+            }
+
+            FileSystemReader::skip(targetCursor - uncompressedCursor);
+            return uncompressedCursor - startCursor;
+        }
+    };
+};
@@ -7,6 +7,7 @@
 #include <miniz/miniz.h>
 #include <zstd.h>
 
+#include "rt64_filesystem_readers.h"
 #include "rt64_mapped_file.h"
 
 namespace RT64 {
@@ -27,6 +28,40 @@ namespace RT64 {
         }
     }
 
+    // FileSystemZipReaderDeflate
+
+    // Like the zstd reader, the decoder keeps its own window and only copies the results out.
+    struct FileSystemZipReaderDeflate : FileSystemReader {
+        mz_stream stream = {};
+        bool streamInitialized = false;
+
+        ~FileSystemZipReaderDeflate() override {
+            if (streamInitialized) {
+                mz_inflateEnd(&stream);
+            }
+        }
+
+        bool open(const uint8_t *data, size_t size) {
+            stream.next_in = data;
+            stream.avail_in = mz_uint(size);
+            streamInitialized = (mz_inflateInit2(&stream, -MZ_DEFAULT_WINDOW_BITS) == MZ_OK);
+            return streamInitialized;
+        }
+
+        size_t read(uint8_t *dst, size_t byteCount) override {
+            stream.next_out = dst;
+            stream.avail_out = mz_uint(byteCount);
+            while (stream.avail_out > 0) {
+                int status = mz_inflate(&stream, MZ_NO_FLUSH);
+                if (status != MZ_OK) {
+                    break;
+                }
+            }
+
+            return byteCount - stream.avail_out;
+        }
+    };
+
     // FileSystemZip::Implementation
 
     struct FileSystemZip::Implementation {
@@ -36,6 +71,20 @@ namespace RT64 {
         MappedFile zipMappedFile;
         std::string basePath;
         bool archiveOpen = false;
+
+        const uint8_t *getFileData(const FileSystemZipInfo &fileInfo) const {
+            // Validate the local dir header.
+            const char *localDirHeader = reinterpret_cast<const char *>(&zipMappedFile.data()[fileInfo.localHeaderOffset]);
+            if (MZ_READ_LE32(localDirHeader) != MZ_ZIP_LOCAL_DIR_HEADER_SIG) {
+                return nullptr;
+            }
+
+            // Skip over unused data of the header.
+            uint32_t ldhFilenameLenOfs = MZ_READ_LE16(localDirHeader + MZ_ZIP_LDH_FILENAME_LEN_OFS);
+            uint32_t ldhExtraLenOfs = MZ_READ_LE16(localDirHeader + MZ_ZIP_LDH_EXTRA_LEN_OFS);
+            size_t dataAddress = fileInfo.localHeaderOffset + MZ_ZIP_LOCAL_DIR_HEADER_SIZE + ldhFilenameLenOfs + ldhExtraLenOfs;
+            return reinterpret_cast<const uint8_t *>(&zipMappedFile.data()[dataAddress]);
+        }
     };
 
     // FileSystemZip
@@ -135,19 +184,11 @@ namespace RT64 {
             return false;
         }
 
-        // Validate the local dir header.
-        const char *localDirHeader = reinterpret_cast<const char *>(&impl->zipMappedFile.data()[it->second.localHeaderOffset]);
-        if (MZ_READ_LE32(localDirHeader) != MZ_ZIP_LOCAL_DIR_HEADER_SIG) {
+        const uint8_t *zipFileData = impl->getFileData(it->second);
+        if (zipFileData == nullptr) {
             return false;
         }
 
-        // Skip over unused data of the header.
-        uint32_t ldhFilenameLenOfs = MZ_READ_LE16(localDirHeader + MZ_ZIP_LDH_FILENAME_LEN_OFS);
-        uint32_t ldhExtraLenOfs = MZ_READ_LE16(localDirHeader + MZ_ZIP_LDH_EXTRA_LEN_OFS);
-        size_t dataAddress = it->second.localHeaderOffset + MZ_ZIP_LOCAL_DIR_HEADER_SIZE + ldhFilenameLenOfs + ldhExtraLenOfs;
-
-        // Make sure output vector has enough bytes to hold the data.
-        const uint8_t *zipFileData = reinterpret_cast<const uint8_t *>(&impl->zipMappedFile.data()[dataAddress]);
         if (it->second.compression == FileSystemZipInfo::Compression::Zstd) {
             if (ZSTD_decompress(fileData, it->second.uncompressedSize, zipFileData, it->second.compressedSize) != it->second.uncompressedSize) {
                 return false;
@@ -165,6 +206,53 @@ namespace RT64 {
         return true;
     }
 
+    std::unique_ptr<FileSystemReader> FileSystemZip::openReader(const std::string &path) const {
+        assert(impl->archiveOpen);
+
+        auto it = impl->fileInfoMap.find(path);
+        if (it == impl->fileInfoMap.end()) {
+            return nullptr;
+        }
+
+        const uint8_t *zipFileData = impl->getFileData(it->second);
+        if (zipFileData == nullptr) {
+            return nullptr;
+        }
+
+        if (it->second.compression == FileSystemZipInfo::Compression::Zstd) {
+            std::unique_ptr<FileSystemZstdReader> reader = std::make_unique<FileSystemZstdReader>();
+            if (!reader->open(zipFileData, it->second.compressedSize, nullptr)) {
+                return nullptr;
+            }
+
+            return reader;
+        }
+        else if (it->second.compression == FileSystemZipInfo::Compression::Deflate) {
+            std::unique_ptr<FileSystemZipReaderDeflate> reader = std::make_unique<FileSystemZipReaderDeflate>();
+            if (!reader->open(zipFileData, it->second.compressedSize)) {
+                return nullptr;
+            }
+
+            return reader;
+        }
+        else {
+            return std::make_unique<FileSystemMappedReader>(zipFileData, it->second.uncompressedSize);
+        }
+    }
+
+    bool FileSystemZip::getStoredContents(const std::string &path, const uint8_t *&data, size_t &size) const {
+        assert(impl->archiveOpen);
+
+        auto it = impl->fileInfoMap.find(path);
+        if (it == impl->fileInfoMap.end()) {
+            return false;
+        }
+
+        data = impl->getFileData(it->second);
+        size = it->second.compressedSize;
+        return data != nullptr;
+    }
+
     size_t FileSystemZip::getSize(const std::string &path) const {
         assert(impl->archiveOpen);
         auto it = impl->fileInfoMap.find(path);
@@ -35,6 +35,8 @@ namespace RT64 {
         Iterator begin() const override;
         Iterator end() const override;
         bool load(const std::string &path, uint8_t *fileData, size_t fileDataMaxByteCount) const override;
+        std::unique_ptr<FileSystemReader> openReader(const std::string &path) const override;
+        bool getStoredContents(const std::string &path, const uint8_t *&data, size_t &size) const override;
         size_t getSize(const std::string &path) const override;
         bool exists(const std::string &path) const override;
         std::string makeCanonical(const std::string &path) const override;
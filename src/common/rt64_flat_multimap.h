@@ -0,0 +1,115 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace RT64 {
+    // Multimap with integer keys that uses open addressing for the keys and stores all the values in a single vector. Each key's slot links
+    // the values inserted with it in insertion order. Clearing keeps the allocations, so rebuilding the map every frame doesn't allocate.
+    template<typename Key, typename Value>
+    struct FlatMultiMap {
+        static_assert(std::is_integral<Key>::value, "Keys must be integers.");
+
+        static const uint32_t End = UINT32_MAX;
+        static const uint32_t MinimumSlotCount = 64;
+
+        struct Entry {
+            Key key;
+            Value value;
+            uint32_t next;
+        };
+
+        struct Slot {
+            Key key;
+            uint32_t first = End;
+            uint32_t last = End;
+        };
+
+        std::vector<Slot> slots;
+        std::vector<Entry> entries;
+        uint32_t keyCount = 0;
+
+        void clear() {
+            if (keyCount > 0) {
+                for (Slot &slot : slots) {
+                    slot.first = End;
+                }
+            }
+
+            entries.clear();
+            keyCount = 0;
+        }
+
+        bool empty() const {
+            return entries.empty();
+        }
+
+        size_t size() const {
+            return entries.size();
+        }
+
+        void emplace(Key key, const Value &value) {
+            // Keep the load factor under 75%.
+            if (((keyCount + 1) * 4) > (slots.size() * 3)) {
+                rehash(slots.empty() ? MinimumSlotCount : (slots.size() * 2));
+            }
+
+            const uint32_t entryIndex = uint32_t(entries.size());
+            entries.emplace_back(Entry{ key, value, End });
+
+            Slot &slot = slots[findSlot(key)];
+            if (slot.first == End) {
+                slot.key = key;
+                slot.first = entryIndex;
+                keyCount++;
+            }
+            else {
+                entries[slot.last].next = entryIndex;
+            }
+
+            slot.last = entryIndex;
+        }
+
+        // Returns the index of the first entry with the key or End if there's none. The rest can be visited by following Entry::next.
+        uint32_t first(Key key) const {
+            if (keyCount == 0) {
+                return End;
+            }
+
+            return slots[findSlot(key)].first;
+        }
+
+        uint32_t findSlot(Key key) const {
+            const size_t mask = slots.size() - 1;
+            size_t index = hashKey(key) & mask;
+            while ((slots[index].first != End) && (slots[index].key != key)) {
+                index = (index + 1) & mask;
+            }
+
+            return uint32_t(index);
+        }
+
+        void rehash(size_t slotCount) {
+            std::vector<Slot> oldSlots;
+            oldSlots.swap(slots);
+            slots.resize(slotCount);
+            for (const Slot &oldSlot : oldSlots) {
+                if (oldSlot.first != End) {
+                    slots[findSlot(oldSlot.key)] = oldSlot;
+                }
+            }
+        }
+
+        static size_t hashKey(Key key) {
+            // Keys are often aligned addresses or small indices, so mix all the bits into the upper half before using it.
+            const uint64_t mixed = (uint64_t(key) ^ (uint64_t(key) >> 32)) * 0x9E3779B97F4A7C15ULL;
+            return size_t(mixed >> 32);
+        }
+    };
+};
@@ -0,0 +1,150 @@
+//
+// RT64
+//
+
+#include "rt64_frame_limiter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "rt64_thread.h"
+
+namespace RT64 {
+    // Initial estimate of the OS timer slack. The estimate converges towards the real value after a few sleeps.
+    static const int64_t InitialSlackNanoseconds = 1'000'000;
+
+    // Oversleeps longer than this are considered outliers (e.g. the thread was preempted) and are not used for calibration. Must stay
+    // above the default timer granularity on Windows (15.6 ms), or the slack would never be calibrated on systems that use it.
+    static const int64_t SlackUpperBoundNanoseconds = 20'000'000;
+
+    // Weight of every new sample in the moving average of the slack.
+    static const double SlackSmoothing = 0.1;
+
+    // Number of standard deviations added on top of the mean slack.
+    static const double SlackStddevCount = 2.0;
+
+    // How early the frame should be presented before the vblank it's aligned to.
+    static const int64_t VblankLeadNanoseconds = 500'000;
+
+    static int64_t toNanoseconds(Timestamp t1, Timestamp t2) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count();
+    }
+
+    // FrameLimiter::SystemClock
+
+    Timestamp FrameLimiter::SystemClock::now() {
+        return Timer::current();
+    }
+
+    void FrameLimiter::SystemClock::sleepMilliseconds(uint32_t milliseconds) {
+        Thread::sleepMilliseconds(milliseconds);
+    }
+
+    void FrameLimiter::SystemClock::spin() {
+        // Do nothing and let the caller query the clock again.
+    }
+
+    // FrameLimiter
+
+    FrameLimiter::FrameLimiter(Clock *clock) {
+        this->clock = (clock != nullptr) ? clock : &systemClock;
+        slackMean = double(InitialSlackNanoseconds);
+        slackNanoseconds = InitialSlackNanoseconds;
+        reset();
+    }
+
+    void FrameLimiter::reset() {
+        nextDeadline = Timestamp();
+        driftNanoseconds = 0;
+        missedDeadlines = 0;
+    }
+
+    void FrameLimiter::setTargetRate(uint32_t targetRate) {
+        const int64_t newInterval = (targetRate > 0) ? (1'000'000'000 / int64_t(targetRate)) : 0;
+        if (newInterval != intervalNanoseconds) {
+            intervalNanoseconds = newInterval;
+            reset();
+        }
+    }
+
+    void FrameLimiter::setVblankReference(Timestamp timestamp, uint32_t refreshRate) {
+        vblankTimestamp = timestamp;
+        vblankIntervalNanoseconds = (refreshRate > 0) ? (1'000'000'000 / int64_t(refreshRate)) : 0;
+        vblankAlignment = (vblankIntervalNanoseconds > 0);
+    }
+
+    void FrameLimiter::wait() {
+        if (intervalNanoseconds <= 0) {
+            return;
+        }
+
+        // The first frame only establishes the time the next deadline is relative to.
+        if (nextDeadline == Timestamp()) {
+            nextDeadline = clock->now() + std::chrono::nanoseconds(intervalNanoseconds);
+            return;
+        }
+
+        const Timestamp deadline = vblankAlignment ? alignToVblank(nextDeadline) : nextDeadline;
+        sleepUntil(deadline);
+
+        const Timestamp wakeTimestamp = clock->now();
+        const int64_t errorNanoseconds = toNanoseconds(deadline, wakeTimestamp);
+        errorProfiler.log(errorNanoseconds / 1'000'000.0);
+
+        // Deadlines are derived from the previous deadline instead of the wake up time so errors don't accumulate over time.
+        // If the limiter fell behind by more than a full interval, start over from the current time instead of presenting
+        // a burst of frames to catch up.
+        if (errorNanoseconds > intervalNanoseconds) {
+            missedDeadlines++;
+            nextDeadline = wakeTimestamp + std::chrono::nanoseconds(intervalNanoseconds);
+        }
+        else {
+            driftNanoseconds += errorNanoseconds;
+            nextDeadline = deadline + std::chrono::nanoseconds(intervalNanoseconds);
+        }
+    }
+
+    void FrameLimiter::sleepUntil(Timestamp deadline) {
+        // Sleep for as long as the remaining time is longer than the time the OS is expected to oversleep by. Sleeps can only be requested
+        // in whole milliseconds, so anything shorter than that is left to the spin.
+        while (true) {
+            const Timestamp sleepStart = clock->now();
+            const int64_t remainingNanoseconds = toNanoseconds(sleepStart, deadline);
+            const int64_t requestedMilliseconds = (remainingNanoseconds - slackNanoseconds) / 1'000'000;
+            if (requestedMilliseconds <= 0) {
+                break;
+            }
+
+            const int64_t requestedNanoseconds = requestedMilliseconds * 1'000'000;
+            clock->sleepMilliseconds(uint32_t(requestedMilliseconds));
+            updateSlack(toNanoseconds(sleepStart, clock->now()) - requestedNanoseconds);
+        }
+
+        // Spin for the rest of the duration.
+        while (clock->now() < deadline) {
+            clock->spin();
+        }
+    }
+
+    void FrameLimiter::updateSlack(int64_t oversleepNanoseconds) {
+        if ((oversleepNanoseconds < 0) || (oversleepNanoseconds > SlackUpperBoundNanoseconds)) {
+            return;
+        }
+
+        const double delta = double(oversleepNanoseconds) - slackMean;
+        slackMean += SlackSmoothing * delta;
+        slackVariance = (1.0 - SlackSmoothing) * (slackVariance + SlackSmoothing * delta * delta);
+        slackNanoseconds = int64_t(slackMean + SlackStddevCount * std::sqrt(slackVariance));
+    }
+
+    Timestamp FrameLimiter::alignToVblank(Timestamp deadline) const {
+        if ((vblankIntervalNanoseconds <= 0) || (vblankTimestamp == Timestamp())) {
+            return deadline;
+        }
+
+        // Snap the deadline to the closest vblank so the frame is on screen for a whole number of refreshes.
+        const int64_t sinceVblank = toNanoseconds(vblankTimestamp, deadline);
+        const int64_t vblankCount = int64_t(std::llround(double(sinceVblank) / double(vblankIntervalNanoseconds)));
+        return vblankTimestamp + std::chrono::nanoseconds(vblankCount * vblankIntervalNanoseconds - VblankLeadNanoseconds);
+    }
+};
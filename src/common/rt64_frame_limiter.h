@@ -0,0 +1,53 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include "rt64_profiling_timer.h"
+#include "rt64_timer.h"
+
+namespace RT64 {
+    struct FrameLimiter {
+        // All time measurements go through the clock so the limiter's accuracy can be verified without real sleeps.
+        struct Clock {
+            virtual ~Clock() { }
+            virtual Timestamp now() = 0;
+            virtual void sleepMilliseconds(uint32_t milliseconds) = 0;
+            virtual void spin() = 0;
+        };
+
+        struct SystemClock : Clock {
+            Timestamp now() override;
+            void sleepMilliseconds(uint32_t milliseconds) override;
+            void spin() override;
+        };
+
+        SystemClock systemClock;
+        Clock *clock = nullptr;
+        int64_t intervalNanoseconds = 0;
+        Timestamp nextDeadline;
+        Timestamp vblankTimestamp;
+        int64_t vblankIntervalNanoseconds = 0;
+        bool vblankAlignment = false;
+
+        // Statistics of how much the OS oversleeps. Used to decide when to stop sleeping and start spinning.
+        double slackMean = 0.0;
+        double slackVariance = 0.0;
+        int64_t slackNanoseconds = 0;
+
+        // Accumulated difference between the deadlines and the times the limiter actually woke up at.
+        int64_t driftNanoseconds = 0;
+        uint64_t missedDeadlines = 0;
+        ProfilingTimer errorProfiler = ProfilingTimer(120);
+
+        FrameLimiter(Clock *clock = nullptr);
+        void reset();
+        void setTargetRate(uint32_t targetRate);
+        void setVblankReference(Timestamp timestamp, uint32_t refreshRate);
+        void wait();
+        void sleepUntil(Timestamp deadline);
+        void updateSlack(int64_t oversleepNanoseconds);
+        Timestamp alignToVblank(Timestamp deadline) const;
+    };
+};
@@ -0,0 +1,433 @@
+//
+// RT64
+//
+
+#include "rt64_job_system.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "rt64_thread.h"
+
+namespace RT64 {
+    static thread_local uint32_t CurrentWorkerIndex = JobSystem::AnyWorker;
+
+    static Thread::Priority toThreadPriority(JobSystem::Priority priority) {
+        switch (priority) {
+        case JobSystem::Priority::High:
+        case JobSystem::Priority::Normal:
+            return Thread::Priority::Normal;
+        case JobSystem::Priority::Low:
+            return Thread::Priority::Low;
+        case JobSystem::Priority::Idle:
+            return Thread::Priority::Idle;
+        default:
+            assert(false && "Unknown job priority.");
+            return Thread::Priority::Normal;
+        }
+    }
+
+    static Thread::Role toThreadRole(JobSystem::Priority priority) {
+        // Streaming and shader compilation can run on the efficiency cores without affecting the frame time.
+        switch (priority) {
+        case JobSystem::Priority::Low:
+        case JobSystem::Priority::Idle:
+            return Thread::Role::Background;
+        default:
+            return Thread::Role::Worker;
+        }
+    }
+
+    static bool reserveSlot(std::atomic<uint32_t> &runningCount, uint32_t limit) {
+        uint32_t currentCount = runningCount;
+        while (currentCount < limit) {
+            if (runningCount.compare_exchange_weak(currentCount, currentCount + 1)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // JobCounter
+
+    void JobCounter::increment() {
+        std::unique_lock<std::mutex> lock(mutex);
+        pending++;
+    }
+
+    void JobCounter::decrement() {
+        // Notify while holding the lock, as the waiter is free to destroy the counter as soon as it can observe it reached zero.
+        std::unique_lock<std::mutex> lock(mutex);
+        assert(pending > 0);
+        pending--;
+        if (pending == 0) {
+            condition.notify_all();
+        }
+    }
+
+    void JobCounter::wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this]() {
+            return pending == 0;
+        });
+    }
+
+    bool JobCounter::idle() {
+        std::unique_lock<std::mutex> lock(mutex);
+        return pending == 0;
+    }
+
+    // JobSystem::Worker
+
+    JobSystem::Worker::Worker(JobSystem *jobSystem, uint32_t index) {
+        assert(jobSystem != nullptr);
+
+        this->jobSystem = jobSystem;
+        this->index = index;
+    }
+
+    JobSystem::Worker::~Worker() {
+        if (thread != nullptr) {
+            thread->join();
+            thread.reset();
+        }
+    }
+
+    void JobSystem::Worker::loop() {
+        Thread::setCurrentThreadName("RT64 Worker");
+        Thread::setCurrentThreadRole(Thread::Role::Worker);
+        CurrentWorkerIndex = index;
+
+        Thread::Priority threadPriority = Thread::Priority::Normal;
+        Thread::Role threadRole = Thread::Role::Worker;
+        Job job;
+        while (jobSystem->running) {
+            // Any submission that happens after this point will change the signal count and prevent the worker from sleeping.
+            const uint64_t observedSignal = jobSystem->signalCount;
+            if (jobSystem->delayedCount > 0) {
+                Timestamp nextDueTime;
+                std::unique_lock<std::mutex> sleepLock(jobSystem->sleepMutex);
+                jobSystem->promoteDelayedJobs(nextDueTime);
+            }
+
+            if (jobSystem->dequeue(index, job)) {
+                const Thread::Priority jobThreadPriority = toThreadPriority(job.priority);
+                if (jobThreadPriority != threadPriority) {
+                    Thread::setCurrentThreadPriority(jobThreadPriority);
+                    threadPriority = jobThreadPriority;
+                }
+
+                const Thread::Role jobThreadRole = toThreadRole(job.priority);
+                if (jobThreadRole != threadRole) {
+                    Thread::setCurrentThreadRole(jobThreadRole);
+                    threadRole = jobThreadRole;
+                }
+
+                jobSystem->runJob(job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> sleepLock(jobSystem->sleepMutex);
+            Timestamp nextDueTime;
+            if (jobSystem->promoteDelayedJobs(nextDueTime) || (observedSignal != jobSystem->signalCount)) {
+                continue;
+            }
+
+            auto wakeUp = [&]() {
+                return !jobSystem->running || (observedSignal != jobSystem->signalCount);
+            };
+
+            if (nextDueTime != Timestamp()) {
+                jobSystem->sleepCondition.wait_until(sleepLock, nextDueTime, wakeUp);
+            }
+            else {
+                jobSystem->sleepCondition.wait(sleepLock, wakeUp);
+            }
+        }
+    }
+
+    // JobSystem
+
+    JobSystem::JobSystem(uint32_t workerCount) {
+        assert(workerCount > 0);
+
+        // Reserve at least one worker for high priority jobs so long running background work can't delay them. The limit applies to all
+        // the other priorities combined, as each of them also has its own limit that can be raised up to the worker count.
+        backgroundLimit = std::max(workerCount - 1U, 1U);
+        backgroundRunningCount = 0;
+        for (uint32_t i = 0; i < uint32_t(Priority::Count); i++) {
+            runningCounts[i] = 0;
+            concurrencyLimits[i] = (Priority(i) == Priority::High) ? workerCount : backgroundLimit;
+        }
+
+        queuedCount = 0;
+        submissionCursor = 0;
+        signalCount = 0;
+        delayedCount = 0;
+        running = true;
+
+        workers.resize(workerCount);
+        for (uint32_t i = 0; i < workerCount; i++) {
+            workers[i] = std::make_unique<Worker>(this, i);
+        }
+
+        // Threads are only started once all workers exist, as any of them can steal from the others.
+        for (uint32_t i = 0; i < workerCount; i++) {
+            workers[i]->thread = std::make_unique<std::thread>(&Worker::loop, workers[i].get());
+        }
+    }
+
+    JobSystem::~JobSystem() {
+        {
+            std::unique_lock<std::mutex> sleepLock(sleepMutex);
+            running = false;
+            signalCount++;
+        }
+
+        sleepCondition.notify_all();
+
+        for (std::unique_ptr<Worker> &worker : workers) {
+            worker->thread->join();
+            worker->thread.reset();
+        }
+
+        // Release the counters of any jobs that never got to run so nothing waits on them forever.
+        for (std::unique_ptr<Worker> &worker : workers) {
+            for (std::deque<Job> &queue : worker->queues) {
+                for (const Job &job : queue) {
+                    if (job.counter != nullptr) {
+                        job.counter->decrement();
+                    }
+                }
+            }
+        }
+
+        workers.clear();
+
+        for (const DelayedJob &delayedJob : delayedJobs) {
+            if (delayedJob.job.counter != nullptr) {
+                delayedJob.job.counter->decrement();
+            }
+        }
+
+        delayedJobs.clear();
+    }
+
+    void JobSystem::submit(Priority priority, Function function, JobCounter *counter, uint32_t workerHint) {
+        assert(function != nullptr);
+
+        if (counter != nullptr) {
+            counter->increment();
+        }
+
+        Job job;
+        job.function = std::move(function);
+        job.counter = counter;
+        job.priority = priority;
+        job.workerHint = workerHint;
+        enqueue(std::move(job));
+        signal();
+    }
+
+    void JobSystem::submitDelayed(Priority priority, int64_t delayMicroseconds, Function function, JobCounter *counter, uint32_t workerHint) {
+        assert(function != nullptr);
+
+        if (counter != nullptr) {
+            counter->increment();
+        }
+
+        DelayedJob delayedJob;
+        delayedJob.dueTime = Timer::current() + std::chrono::microseconds(delayMicroseconds);
+        delayedJob.job.function = std::move(function);
+        delayedJob.job.counter = counter;
+        delayedJob.job.priority = priority;
+        delayedJob.job.workerHint = workerHint;
+
+        {
+            std::unique_lock<std::mutex> sleepLock(sleepMutex);
+            delayedJobs.emplace_back(std::move(delayedJob));
+            delayedCount++;
+            signalCount++;
+        }
+
+        // Workers must re-evaluate when they should wake up next.
+        sleepCondition.notify_all();
+    }
+
+    void JobSystem::parallelFor(Priority priority, size_t count, size_t minBatchSize, const RangeFunction &function) {
+        // Waiting for the batches from a worker could take up the slot they need to run, so this is only meant for other threads.
+        assert(currentWorkerIndex() == AnyWorker);
+
+        // The calling thread runs a batch of its own while it waits. Ranges too small to split are run entirely on it.
+        const size_t batchCount = std::max(std::min(size_t(workers.size()) + 1, count / std::max(minBatchSize, size_t(1))), size_t(1));
+        const size_t batchSize = (count + batchCount - 1) / batchCount;
+        JobCounter batchCounter;
+        for (size_t i = 1; i < batchCount; i++) {
+            const size_t begin = std::min(i * batchSize, count);
+            const size_t end = std::min(begin + batchSize, count);
+            submit(priority, [&function, begin, end]() { function(begin, end); }, &batchCounter);
+        }
+
+        function(0, std::min(batchSize, count));
+        batchCounter.wait();
+    }
+
+    void JobSystem::setConcurrencyLimit(Priority priority, uint32_t limit) {
+        assert(priority < Priority::Count);
+        assert(limit > 0);
+
+        {
+            std::unique_lock<std::mutex> sleepLock(sleepMutex);
+            concurrencyLimits[uint32_t(priority)] = std::min(limit, uint32_t(workers.size()));
+            signalCount++;
+        }
+
+        sleepCondition.notify_all();
+    }
+
+    uint32_t JobSystem::getWorkerCount() const {
+        return uint32_t(workers.size());
+    }
+
+    void JobSystem::enqueue(Job &&job) {
+        // Jobs go to the hinted worker first. Jobs submitted by a worker stay on its own queue to keep the data hot in its cache.
+        uint32_t workerIndex = job.workerHint;
+        if (workerIndex >= workers.size()) {
+            workerIndex = CurrentWorkerIndex;
+        }
+
+        if (workerIndex >= workers.size()) {
+            workerIndex = submissionCursor++ % uint32_t(workers.size());
+        }
+
+        Worker &worker = *workers[workerIndex];
+        {
+            std::unique_lock<std::mutex> queueLock(worker.queueMutex);
+            worker.queues[uint32_t(job.priority)].emplace_back(std::move(job));
+        }
+
+        queuedCount++;
+    }
+
+    bool JobSystem::dequeue(uint32_t workerIndex, Job &job) {
+        if (queuedCount == 0) {
+            return false;
+        }
+
+        const uint32_t workerCount = uint32_t(workers.size());
+        for (uint32_t p = 0; p < uint32_t(Priority::Count); p++) {
+            // Reserve a slot for the priority before looking for the job so the concurrency limit can't be exceeded.
+            if (!reserveSlot(runningCounts[p], concurrencyLimits[p])) {
+                continue;
+            }
+
+            // Every priority after High shares the same combined limit, so none of them can run if it's been reached.
+            const bool background = (Priority(p) != Priority::High);
+            if (background && !reserveSlot(backgroundRunningCount, backgroundLimit)) {
+                runningCounts[p]--;
+                return false;
+            }
+
+            // Look at the worker's own queue first (newest job) and steal from the other workers afterwards (oldest job).
+            bool found = false;
+            for (uint32_t i = 0; (i < workerCount) && !found; i++) {
+                Worker &victim = *workers[(workerIndex + i) % workerCount];
+                std::unique_lock<std::mutex> queueLock(victim.queueMutex);
+                std::deque<Job> &queue = victim.queues[p];
+                if (queue.empty()) {
+                    continue;
+                }
+
+                if (i == 0) {
+                    job = std::move(queue.back());
+                    queue.pop_back();
+                }
+                else {
+                    job = std::move(queue.front());
+                    queue.pop_front();
+                }
+
+                found = true;
+            }
+
+            if (found) {
+                queuedCount--;
+                return true;
+            }
+
+            runningCounts[p]--;
+            if (background) {
+                backgroundRunningCount--;
+            }
+        }
+
+        return false;
+    }
+
+    bool JobSystem::promoteDelayedJobs(Timestamp &nextDueTime) {
+        // Must be called while holding the sleep mutex.
+        nextDueTime = Timestamp();
+        if (delayedJobs.empty()) {
+            return false;
+        }
+
+        const Timestamp currentTime = Timer::current();
+        bool promoted = false;
+        auto it = delayedJobs.begin();
+        while (it != delayedJobs.end()) {
+            if (it->dueTime <= currentTime) {
+                enqueue(std::move(it->job));
+                it = delayedJobs.erase(it);
+                delayedCount--;
+                promoted = true;
+            }
+            else {
+                if ((nextDueTime == Timestamp()) || (it->dueTime < nextDueTime)) {
+                    nextDueTime = it->dueTime;
+                }
+
+                it++;
+            }
+        }
+
+        if (promoted) {
+            signalCount++;
+            sleepCondition.notify_all();
+        }
+
+        return promoted;
+    }
+
+    void JobSystem::signal() {
+        {
+            std::unique_lock<std::mutex> sleepLock(sleepMutex);
+            signalCount++;
+        }
+
+        sleepCondition.notify_one();
+    }
+
+    void JobSystem::runJob(Job &job) {
+        job.function();
+        job.function = nullptr;
+        runningCounts[uint32_t(job.priority)]--;
+        if (job.priority != Priority::High) {
+            backgroundRunningCount--;
+        }
+
+        if (job.counter != nullptr) {
+            job.counter->decrement();
+            job.counter = nullptr;
+        }
+
+        // Jobs held back by a concurrency limit can be picked up now that a slot was freed.
+        if (queuedCount > 0) {
+            signal();
+        }
+    }
+
+    uint32_t JobSystem::currentWorkerIndex() {
+        return CurrentWorkerIndex;
+    }
+};
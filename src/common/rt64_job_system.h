@@ -0,0 +1,98 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "rt64_timer.h"
+
+namespace RT64 {
+    // Counts the jobs submitted with it that haven't finished yet. Allows any thread to wait for a group of jobs.
+    struct JobCounter {
+        std::mutex mutex;
+        std::condition_variable condition;
+        uint32_t pending = 0;
+
+        void increment();
+        void decrement();
+        void wait();
+        bool idle();
+    };
+
+    struct JobSystem {
+        enum class Priority {
+            High,
+            Normal,
+            Low,
+            Idle,
+            Count
+        };
+
+        typedef std::function<void()> Function;
+        typedef std::function<void(size_t begin, size_t end)> RangeFunction;
+
+        static const uint32_t AnyWorker = UINT32_MAX;
+
+        struct Job {
+            Function function;
+            JobCounter *counter = nullptr;
+            Priority priority = Priority::Normal;
+            uint32_t workerHint = AnyWorker;
+        };
+
+        struct DelayedJob {
+            Timestamp dueTime;
+            Job job;
+        };
+
+        struct Worker {
+            JobSystem *jobSystem = nullptr;
+            uint32_t index = 0;
+            std::unique_ptr<std::thread> thread;
+            std::mutex queueMutex;
+            std::array<std::deque<Job>, size_t(Priority::Count)> queues;
+
+            Worker(JobSystem *jobSystem, uint32_t index);
+            ~Worker();
+            void loop();
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::array<std::atomic<uint32_t>, size_t(Priority::Count)> runningCounts;
+        std::array<std::atomic<uint32_t>, size_t(Priority::Count)> concurrencyLimits;
+        std::atomic<uint32_t> backgroundRunningCount;
+        uint32_t backgroundLimit = 0;
+        std::atomic<uint32_t> queuedCount;
+        std::atomic<uint32_t> submissionCursor;
+        std::atomic<bool> running;
+        std::mutex sleepMutex;
+        std::condition_variable sleepCondition;
+        std::atomic<uint64_t> signalCount;
+        std::vector<DelayedJob> delayedJobs;
+        std::atomic<uint32_t> delayedCount;
+
+        JobSystem(uint32_t workerCount);
+        ~JobSystem();
+        void submit(Priority priority, Function function, JobCounter *counter = nullptr, uint32_t workerHint = AnyWorker);
+        void submitDelayed(Priority priority, int64_t delayMicroseconds, Function function, JobCounter *counter = nullptr, uint32_t workerHint = AnyWorker);
+        void parallelFor(Priority priority, size_t count, size_t minBatchSize, const RangeFunction &function);
+        void setConcurrencyLimit(Priority priority, uint32_t limit);
+        uint32_t getWorkerCount() const;
+        void enqueue(Job &&job);
+        bool dequeue(uint32_t workerIndex, Job &job);
+        bool promoteDelayedJobs(Timestamp &nextDueTime);
+        void signal();
+        void runJob(Job &job);
+        static uint32_t currentWorkerIndex();
+    };
+};
@@ -85,4 +85,9 @@ namespace RT64 {
         assert(!history.empty());
         return std::accumulate(history.begin(), history.end(), 0.0) / history.size();
     }
+
+    double ProfilingTimer::latest() const {
+        assert(!history.empty());
+        return history[(historyIndex + history.size() - 1) % history.size()];
+    }
 };
\ No newline at end of file
@@ -31,5 +31,6 @@ namespace RT64 {
         size_t size() const;
         const double *data() const;
         double average() const;
+        double latest() const;
     };
 };
\ No newline at end of file
@@ -0,0 +1,155 @@
+//
+// RT64
+//
+
+#include "rt64_replacement_cache.h"
+
+#include <fstream>
+
+#include "xxHash/xxh3.h"
+
+#include "rt64_mapped_file.h"
+
+namespace RT64 {
+    // ReplacementCache
+
+    uint64_t ReplacementCache::hashDatabase(const std::vector<uint8_t> &databaseBytes) {
+        return XXH3_64bits(databaseBytes.data(), databaseBytes.size());
+    }
+
+    uint64_t ReplacementCache::hashIndex(const FileSystem *fileSystem, const std::filesystem::path &packPath) {
+        // Resolving depends on which files exist, so the paths are hashed. The separator keeps different lists of paths from producing the
+        // same stream of bytes. Files with identical contents are also resolved to the same path, which can change along with any of the
+        // contents, so the size and modification time of the pack are included too.
+        XXH3_state_t xxh3;
+        XXH3_64bits_reset(&xxh3);
+        for (const std::string &path : *fileSystem) {
+            XXH3_64bits_update(&xxh3, path.data(), path.size());
+            XXH3_64bits_update(&xxh3, "\n", 1);
+        }
+
+        std::error_code ec;
+        const uint64_t packSize = std::filesystem::file_size(packPath, ec);
+        const int64_t packWriteTime = std::filesystem::last_write_time(packPath, ec).time_since_epoch().count();
+        XXH3_64bits_update(&xxh3, &packSize, sizeof(packSize));
+        XXH3_64bits_update(&xxh3, &packWriteTime, sizeof(packWriteTime));
+        return XXH3_64bits_digest(&xxh3);
+    }
+
+    bool ReplacementCache::load(const std::filesystem::path &cachePath, uint64_t databaseHash, uint64_t indexHash, uint32_t fileSystemIndex, uint32_t &hashVersion, std::unordered_map<uint64_t, ReplacementResolvedPath> &resolvedPathMap, std::unordered_set<std::string> *pathsToPreload) {
+        MappedFile cacheMappedFile;
+        if (!cacheMappedFile.open(cachePath)) {
+            return false;
+        }
+
+        const uint8_t *cacheData = cacheMappedFile.data();
+        const uint64_t cacheSize = cacheMappedFile.size();
+        if (cacheSize < sizeof(ReplacementCacheHeader)) {
+            return false;
+        }
+
+        const ReplacementCacheHeader *header = reinterpret_cast<const ReplacementCacheHeader *>(cacheData);
+        if ((header->magic != ReplacementCacheMagic) || (header->version != ReplacementCacheVersion)) {
+            return false;
+        }
+
+        // The cache is stale if either the database or the files in the pack changed since it was created.
+        if ((header->databaseHash != databaseHash) || (header->indexHash != indexHash)) {
+            return false;
+        }
+
+        const uint64_t entriesSize = header->entryCount * sizeof(ReplacementCacheEntry);
+        if ((header->entryCount > (cacheSize / sizeof(ReplacementCacheEntry))) || ((sizeof(ReplacementCacheHeader) + entriesSize + header->pathsSize) != cacheSize)) {
+            return false;
+        }
+
+        const ReplacementCacheEntry *entries = reinterpret_cast<const ReplacementCacheEntry *>(&cacheData[sizeof(ReplacementCacheHeader)]);
+        const char *paths = reinterpret_cast<const char *>(&cacheData[sizeof(ReplacementCacheHeader) + entriesSize]);
+        std::unordered_map<uint64_t, ReplacementResolvedPath> cacheResolvedPathMap;
+        cacheResolvedPathMap.reserve(header->entryCount);
+        for (uint64_t i = 0; i < header->entryCount; i++) {
+            const ReplacementCacheEntry &entry = entries[i];
+            if ((entry.pathOffset > header->pathsSize) || (entry.pathLength > (header->pathsSize - entry.pathOffset))) {
+                return false;
+            }
+
+            if ((entry.resolvedOperation > uint8_t(ReplacementOperation::Auto)) || (entry.originalOperation > uint8_t(ReplacementOperation::Auto)) ||
+                (entry.resolvedShift > uint8_t(ReplacementShift::Auto)) || (entry.originalShift > uint8_t(ReplacementShift::Auto)))
+            {
+                return false;
+            }
+
+            ReplacementResolvedPath &resolvedPath = cacheResolvedPathMap[entry.textureHash];
+            resolvedPath.fileSystemIndex = fileSystemIndex;
+            resolvedPath.textureHash = entry.textureHash;
+            resolvedPath.relativePath.assign(&paths[entry.pathOffset], entry.pathLength);
+            resolvedPath.resolvedOperation = ReplacementOperation(entry.resolvedOperation);
+            resolvedPath.originalOperation = ReplacementOperation(entry.originalOperation);
+            resolvedPath.resolvedShift = ReplacementShift(entry.resolvedShift);
+            resolvedPath.originalShift = ReplacementShift(entry.originalShift);
+        }
+
+        // Only modify the outputs once the entire cache was read successfully.
+        for (auto &it : cacheResolvedPathMap) {
+            if ((it.second.resolvedOperation == ReplacementOperation::Preload) && (pathsToPreload != nullptr)) {
+                pathsToPreload->insert(it.second.relativePath);
+            }
+        }
+
+        hashVersion = header->hashVersion;
+        resolvedPathMap = std::move(cacheResolvedPathMap);
+        return true;
+    }
+
+    bool ReplacementCache::save(const std::filesystem::path &cachePath, uint64_t databaseHash, uint64_t indexHash, uint32_t hashVersion, const std::unordered_map<uint64_t, ReplacementResolvedPath> &resolvedPathMap) {
+        ReplacementCacheHeader header;
+        header.hashVersion = hashVersion;
+        header.databaseHash = databaseHash;
+        header.indexHash = indexHash;
+        header.entryCount = resolvedPathMap.size();
+
+        std::vector<ReplacementCacheEntry> entries;
+        std::string paths;
+        entries.reserve(resolvedPathMap.size());
+        for (const auto &it : resolvedPathMap) {
+            const ReplacementResolvedPath &resolvedPath = it.second;
+            ReplacementCacheEntry entry;
+            entry.textureHash = it.first;
+            entry.pathOffset = paths.size();
+            entry.pathLength = uint32_t(resolvedPath.relativePath.size());
+            entry.resolvedOperation = uint8_t(resolvedPath.resolvedOperation);
+            entry.originalOperation = uint8_t(resolvedPath.originalOperation);
+            entry.resolvedShift = uint8_t(resolvedPath.resolvedShift);
+            entry.originalShift = uint8_t(resolvedPath.originalShift);
+            entries.emplace_back(entry);
+            paths += resolvedPath.relativePath;
+        }
+
+        header.pathsSize = paths.size();
+
+        // Write to a temporary file first so a cache that failed to be written completely is never picked up.
+        std::error_code ec;
+        std::filesystem::create_directories(cachePath.parent_path(), ec);
+
+        std::filesystem::path cacheNewPath = cachePath;
+        cacheNewPath += ".new";
+        {
+            std::ofstream cacheStream(cacheNewPath, std::ios::binary);
+            if (!cacheStream.is_open()) {
+                return false;
+            }
+
+            cacheStream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            cacheStream.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(ReplacementCacheEntry));
+            cacheStream.write(paths.data(), paths.size());
+            if (cacheStream.bad()) {
+                cacheStream.close();
+                std::filesystem::remove(cacheNewPath, ec);
+                return false;
+            }
+        }
+
+        std::filesystem::rename(cacheNewPath, cachePath, ec);
+        return !ec;
+    }
+};
@@ -0,0 +1,45 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include "rt64_replacement_database.h"
+
+namespace RT64 {
+    // Binary sidecar that holds the paths a database resolved to in a pack, so the database doesn't need to be parsed and resolved again
+    // on every launch. It's only valid for the exact contents of the database and the pack it was created from, as entries that use
+    // identical files are resolved to the same path.
+    //
+    // Layout: header, entries, paths.
+
+    static const uint64_t ReplacementCacheMagic = 0x3148435234365452ULL; // "RT64RCH1"
+    static const uint32_t ReplacementCacheVersion = 2;
+
+    struct ReplacementCacheHeader {
+        uint64_t magic = ReplacementCacheMagic;
+        uint32_t version = ReplacementCacheVersion;
+        uint32_t hashVersion = 0;
+        uint64_t databaseHash = 0;
+        uint64_t indexHash = 0;
+        uint64_t entryCount = 0;
+        uint64_t pathsSize = 0;
+    };
+
+    struct ReplacementCacheEntry {
+        uint64_t textureHash = 0;
+        uint64_t pathOffset = 0;
+        uint32_t pathLength = 0;
+        uint8_t resolvedOperation = 0;
+        uint8_t originalOperation = 0;
+        uint8_t resolvedShift = 0;
+        uint8_t originalShift = 0;
+    };
+
+    struct ReplacementCache {
+        static uint64_t hashDatabase(const std::vector<uint8_t> &databaseBytes);
+        static uint64_t hashIndex(const FileSystem *fileSystem, const std::filesystem::path &packPath);
+        static bool load(const std::filesystem::path &cachePath, uint64_t databaseHash, uint64_t indexHash, uint32_t fileSystemIndex, uint32_t &hashVersion, std::unordered_map<uint64_t, ReplacementResolvedPath> &resolvedPathMap, std::unordered_set<std::string> *pathsToPreload);
+        static bool save(const std::filesystem::path &cachePath, uint64_t databaseHash, uint64_t indexHash, uint32_t hashVersion, const std::unordered_map<uint64_t, ReplacementResolvedPath> &resolvedPathMap);
+    };
+};
@@ -5,8 +5,13 @@
 #include "rt64_replacement_database.h"
 
 #include <cinttypes>
+#include <cstring>
+#include <map>
+
+#include "xxHash/xxh3.h"
 
 #include "rt64_filesystem_directory.h"
+#include "rt64_job_system.h"
 
 namespace RT64 {
     const std::string ReplacementDatabaseFilename = "rt64.json";
@@ -55,6 +60,73 @@ namespace RT64 {
         return (patIndex == pat.size());
     }
 
+    // ReplacementFilterMatcher
+
+    void ReplacementFilterMatcher::addFilter(const std::string &wildcard) {
+        const uint32_t filterIndex = uint32_t(wildcards.size());
+        wildcards.emplace_back(wildcard);
+
+        // Filters without any wildcards can only match one path, so they can be looked up directly.
+        const size_t prefixLength = wildcard.find_first_of("*?");
+        if (prefixLength == std::string::npos) {
+            literalFilters[wildcard] = filterIndex;
+            return;
+        }
+
+        uint32_t nodeIndex = 0;
+        for (size_t i = 0; i < prefixLength; i++) {
+            const char c = wildcard[i];
+            auto &children = nodes[nodeIndex].children;
+            auto childIt = std::find_if(children.begin(), children.end(), [c](const std::pair<char, uint32_t> &child) { return child.first == c; });
+            if (childIt != children.end()) {
+                nodeIndex = childIt->second;
+            }
+            else {
+                const uint32_t childIndex = uint32_t(nodes.size());
+                nodes[nodeIndex].children.emplace_back(c, childIndex);
+                nodes.emplace_back();
+                nodeIndex = childIndex;
+            }
+        }
+
+        nodes[nodeIndex].filterIndices.emplace_back(filterIndex);
+    }
+
+    uint32_t ReplacementFilterMatcher::find(const std::string &path) const {
+        uint32_t bestIndex = None;
+        auto literalIt = literalFilters.find(path);
+        if (literalIt != literalFilters.end()) {
+            bestIndex = literalIt->second;
+        }
+
+        // Every node visited while walking down the path holds the filters whose prefix matches it. Only the filters that appear after
+        // the best match so far need to be checked, as the last filter in the list that matches is the one that wins.
+        uint32_t nodeIndex = 0;
+        size_t pathIndex = 0;
+        while (true) {
+            const Node &node = nodes[nodeIndex];
+            for (uint32_t filterIndex : node.filterIndices) {
+                if (((bestIndex == None) || (filterIndex > bestIndex)) && checkWildcard(path, wildcards[filterIndex])) {
+                    bestIndex = filterIndex;
+                }
+            }
+
+            if (pathIndex >= path.size()) {
+                break;
+            }
+
+            const char c = path[pathIndex++];
+            auto childIt = std::find_if(node.children.begin(), node.children.end(), [c](const std::pair<char, uint32_t> &child) { return child.first == c; });
+            if (childIt == node.children.end()) {
+                break;
+            }
+
+            nodeIndex = childIt->second;
+        }
+
+        return bestIndex;
+    }
+
     // ReplacementDatabase
 
     uint32_t ReplacementDatabase::addReplacement(const ReplacementTexture &texture) {
@@ -127,6 +199,16 @@ namespace RT64 {
         }
     }
 
+    ReplacementOperation ReplacementDatabase::resolveOperation(const std::string &relativePath, ReplacementOperation operation, const ReplacementFilterMatcher &matcher) const {
+        if (operation == ReplacementOperation::Auto) {
+            const uint32_t filterIndex = matcher.find(relativePath);
+            return (filterIndex != ReplacementFilterMatcher::None) ? operationFilters[filterIndex].operation : config.defaultOperation;
+        }
+        else {
+            return operation;
+        }
+    }
+
     ReplacementShift ReplacementDatabase::resolveShift(const std::string &relativePath, ReplacementShift shift) {
         if (shift == ReplacementShift::Auto) {
             ReplacementShift resolution = config.defaultShift;
@@ -144,8 +226,18 @@ namespace RT64 {
             return shift;
         }
     }
+
+    ReplacementShift ReplacementDatabase::resolveShift(const std::string &relativePath, ReplacementShift shift, const ReplacementFilterMatcher &matcher) const {
+        if (shift == ReplacementShift::Auto) {
+            const uint32_t filterIndex = matcher.find(relativePath);
+            return (filterIndex != ReplacementFilterMatcher::None) ? shiftFilters[filterIndex].shift : config.defaultShift;
+        }
+        else {
+            return shift;
+        }
+    }
     
-    void ReplacementDatabase::resolvePaths(const FileSystem *fileSystem, uint32_t fileSystemIndex, std::unordered_map<uint64_t, ReplacementResolvedPath> &resolvedPathMap, bool onlyDDS, std::vector<uint64_t> *hashesMissing, std::unordered_set<std::string> *pathsToPreload) {
+    void ReplacementDatabase::resolvePaths(const FileSystem *fileSystem, uint32_t fileSystemIndex, std::unordered_map<uint64_t, ReplacementResolvedPath> &resolvedPathMap, bool onlyDDS, std::vector<uint64_t> *hashesMissing, std::unordered_set<std::string> *pathsToPreload, JobSystem *jobSystem) {
         std::unordered_map<std::string, std::string> autoPathMap;
         for (const std::string &relativePath : *fileSystem) {
             const std::filesystem::path relativePathFs = std::filesystem::u8path(relativePath);
@@ -172,88 +264,334 @@ namespace RT64 {
             }
         }
 
-        auto addResolvedPath = [&](uint64_t hash, const std::string &relativePath, ReplacementOperation operation, ReplacementShift shift) {
-            // Do not modify the entry if it's already in the map.
-            if (resolvedPathMap.find(hash) != resolvedPathMap.end()) {
-                return;
-            }
-
-            ReplacementResolvedPath &resolvedPath = resolvedPathMap[hash];
-            resolvedPath.fileSystemIndex = fileSystemIndex;
-            resolvedPath.textureHash = hash;
-            resolvedPath.relativePath = relativePath;
-            resolvedPath.originalOperation = operation;
-            resolvedPath.originalShift = shift;
-            resolvedPath.resolvedOperation = resolveOperation(relativePath, operation);
-            resolvedPath.resolvedShift = resolveShift(relativePath, shift);
-
-            if ((resolvedPath.resolvedOperation == ReplacementOperation::Preload) && (pathsToPreload != nullptr)) {
-                pathsToPreload->insert(relativePath);
-            }
-        };
-
-        // Assign paths to all entries in the database.
+        // Resolve every entry in the database on its own first, as looking up the files and matching the filters are the expensive parts.
         // If the entry already has a relative path, look for textures with extensions that are valid.
         // If the entry doesn't have a path but uses auto-path logic, then it'll try to resolve the path using that scheme.
-        uint32_t textureIndex = 0;
-        for (const ReplacementTexture &texture : textures) {
-            if (!texture.path.empty()) {
-                uint64_t hashRT64 = ReplacementDatabase::stringToHash(texture.hashes.rt64);
-                std::string relativePath = FileSystem::toForwardSlashes(texture.path);
-                std::string relativePathBase = removeKnownExtension(relativePath);
-                bool fileExists = false;
-                for (uint32_t i = 0; i < std::size(ReplacementKnownExtensions); i++) {
-                    const std::string relativePathKnown = relativePathBase + ReplacementKnownExtensions[i];
-                    std::string canonicalPath = fileSystem->makeCanonical(relativePathKnown);
-                    if (!canonicalPath.empty() && fileSystem->exists(canonicalPath)) {
-                        if (!onlyDDS || (i == 0)) {
-                            std::string relativePathFinal = FileSystem::toForwardSlashes(canonicalPath);
-                            addResolvedPath(hashRT64, relativePathFinal, texture.operation, texture.shift);
+        struct TextureResolution {
+            uint64_t hash = 0;
+            std::string relativePath;
+            ReplacementOperation resolvedOperation = ReplacementOperation::Auto;
+            ReplacementShift resolvedShift = ReplacementShift::Auto;
+            bool found = false;
+            bool missing = false;
+        };
+
+        const ReplacementFilterMatcher operationMatcher(operationFilters);
+        const ReplacementFilterMatcher shiftMatcher(shiftFilters);
+        std::vector<TextureResolution> resolutions(textures.size());
+        auto resolveTextures = [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; t++) {
+                const ReplacementTexture &texture = textures[t];
+                TextureResolution &resolution = resolutions[t];
+                if (!texture.path.empty()) {
+                    resolution.hash = ReplacementDatabase::stringToHash(texture.hashes.rt64);
+                    std::string relativePath = FileSystem::toForwardSlashes(texture.path);
+                    std::string relativePathBase = removeKnownExtension(relativePath);
+                    bool fileExists = false;
+                    for (uint32_t i = 0; i < std::size(ReplacementKnownExtensions); i++) {
+                        const std::string relativePathKnown = relativePathBase + ReplacementKnownExtensions[i];
+                        std::string canonicalPath = fileSystem->makeCanonical(relativePathKnown);
+                        if (!canonicalPath.empty() && fileSystem->exists(canonicalPath)) {
+                            if (!onlyDDS || (i == 0)) {
+                                resolution.relativePath = FileSystem::toForwardSlashes(canonicalPath);
+                                resolution.found = true;
+                            }
+
+                            fileExists = true;
+                            break;
                         }
+                    }
 
-                        fileExists = true;
-                        break;
+                    resolution.missing = !fileExists;
+                }
+                else {
+                    // Assign the correct hash as the search string.
+                    std::string searchString;
+                    if (config.autoPath == ReplacementAutoPath::Rice) {
+                        searchString = texture.hashes.rice;
+                    }
+                    else if (config.autoPath == ReplacementAutoPath::RT64) {
+                        searchString = texture.hashes.rt64;
+                    }
+
+                    // Find in the auto path map the entry.
+                    auto it = autoPathMap.find(searchString);
+                    if (it != autoPathMap.end()) {
+                        resolution.hash = ReplacementDatabase::stringToHash(texture.hashes.rt64);
+                        resolution.relativePath = it->second;
+                        resolution.found = true;
                     }
                 }
 
-                if (!fileExists && (hashesMissing != nullptr)) {
-                    hashesMissing->emplace_back(hashRT64);
+                if (resolution.found) {
+                    resolution.resolvedOperation = resolveOperation(resolution.relativePath, texture.operation, operationMatcher);
+                    resolution.resolvedShift = resolveShift(resolution.relativePath, texture.shift, shiftMatcher);
                 }
             }
-            else {
-                // Assign the correct hash as the search string.
-                std::string searchString;
-                if (config.autoPath == ReplacementAutoPath::Rice) {
-                    searchString = texture.hashes.rice;
-                }
-                else if (config.autoPath == ReplacementAutoPath::RT64) {
-                    searchString = texture.hashes.rt64;
-                }
+        };
 
-                // Find in the auto path map the entry.
-                auto it = autoPathMap.find(searchString);
-                if (it != autoPathMap.end()) {
-                    uint64_t hashRT64 = ReplacementDatabase::stringToHash(texture.hashes.rt64);
-                    addResolvedPath(hashRT64, it->second, texture.operation, texture.shift);
-                }
+        // Split the entries in batches across the job system if there's one. Small databases aren't worth the cost of submitting jobs.
+        const size_t MinTexturesPerBatch = 1024;
+        if (jobSystem != nullptr) {
+            jobSystem->parallelFor(JobSystem::Priority::Normal, textures.size(), MinTexturesPerBatch, resolveTextures);
+        }
+        else {
+            resolveTextures(0, textures.size());
+        }
+
+        // Add the results in the order the entries appear in the database, so the first entry to use a hash is still the one that's kept.
+        for (size_t t = 0; t < textures.size(); t++) {
+            const ReplacementTexture &texture = textures[t];
+            const TextureResolution &resolution = resolutions[t];
+            if (resolution.missing && (hashesMissing != nullptr)) {
+                hashesMissing->emplace_back(resolution.hash);
+            }
+
+            // Do not modify the entry if it's already in the map.
+            if (!resolution.found || (resolvedPathMap.find(resolution.hash) != resolvedPathMap.end())) {
+                continue;
             }
 
-            textureIndex++;
+            ReplacementResolvedPath &resolvedPath = resolvedPathMap[resolution.hash];
+            resolvedPath.fileSystemIndex = fileSystemIndex;
+            resolvedPath.textureHash = resolution.hash;
+            resolvedPath.relativePath = resolution.relativePath;
+            resolvedPath.originalOperation = texture.operation;
+            resolvedPath.originalShift = texture.shift;
+            resolvedPath.resolvedOperation = resolution.resolvedOperation;
+            resolvedPath.resolvedShift = resolution.resolvedShift;
+
+            if ((resolvedPath.resolvedOperation == ReplacementOperation::Preload) && (pathsToPreload != nullptr)) {
+                pathsToPreload->insert(resolvedPath.relativePath);
+            }
         }
     }
 
     void ReplacementDatabase::resolveOperations(std::unordered_map<uint64_t, ReplacementResolvedPath> &resolvedPathMap) {
+        const ReplacementFilterMatcher operationMatcher(operationFilters);
         for (auto &it : resolvedPathMap) {
-            it.second.resolvedOperation = resolveOperation(it.second.relativePath, it.second.originalOperation);
+            it.second.resolvedOperation = resolveOperation(it.second.relativePath, it.second.originalOperation, operationMatcher);
         }
     }
 
     void ReplacementDatabase::resolveShifts(std::unordered_map<uint64_t, ReplacementResolvedPath> &resolvedPathMap) {
+        const ReplacementFilterMatcher shiftMatcher(shiftFilters);
         for (auto &it : resolvedPathMap) {
-            it.second.resolvedShift = resolveShift(it.second.relativePath, it.second.originalShift);
+            it.second.resolvedShift = resolveShift(it.second.relativePath, it.second.originalShift, shiftMatcher);
         }
     }
 
+    static bool hashFileContents(const FileSystem *fileSystem, const std::string &relativePath, std::vector<uint8_t> &chunkBytes, uint64_t &hash) {
+        // The contents are hashed as they're stored when possible to avoid decompressing them. Identical files stored with different
+        // compression won't be found to be duplicates, but packs compress every file the same way, so they're rare in practice.
+        const uint8_t *storedData = nullptr;
+        size_t storedSize = 0;
+        if (fileSystem->getStoredContents(relativePath, storedData, storedSize)) {
+            hash = XXH3_64bits(storedData, storedSize);
+            return true;
+        }
+
+        std::unique_ptr<FileSystemReader> reader = fileSystem->openReader(relativePath);
+        if (reader == nullptr) {
+            return false;
+        }
+
+        XXH3_state_t xxh3;
+        XXH3_64bits_reset(&xxh3);
+        size_t readCount = 0;
+        while ((readCount = reader->read(chunkBytes.data(), chunkBytes.size())) > 0) {
+            XXH3_64bits_update(&xxh3, chunkBytes.data(), readCount);
+        }
+
+        hash = XXH3_64bits_digest(&xxh3);
+        return true;
+    }
+
+    static size_t readChunk(FileSystemReader &reader, std::vector<uint8_t> &chunkBytes) {
+        size_t chunkSize = 0;
+        size_t readCount = 0;
+        while ((chunkSize < chunkBytes.size()) && ((readCount = reader.read(chunkBytes.data() + chunkSize, chunkBytes.size() - chunkSize)) > 0)) {
+            chunkSize += readCount;
+        }
+
+        return chunkSize;
+    }
+
+    static bool compareFileContents(const FileSystem *fileSystem, const std::string &pathA, const std::string &pathB, std::vector<uint8_t> &chunkBytesA, std::vector<uint8_t> &chunkBytesB) {
+        // Compare the contents the same way they were hashed if both files allow it.
+        const uint8_t *storedDataA = nullptr;
+        const uint8_t *storedDataB = nullptr;
+        size_t storedSizeA = 0;
+        size_t storedSizeB = 0;
+        if (fileSystem->getStoredContents(pathA, storedDataA, storedSizeA) && fileSystem->getStoredContents(pathB, storedDataB, storedSizeB)) {
+            return (storedSizeA == storedSizeB) && (memcmp(storedDataA, storedDataB, storedSizeA) == 0);
+        }
+
+        std::unique_ptr<FileSystemReader> readerA = fileSystem->openReader(pathA);
+        std::unique_ptr<FileSystemReader> readerB = fileSystem->openReader(pathB);
+        if ((readerA == nullptr) || (readerB == nullptr)) {
+            return false;
+        }
+
+        size_t chunkSize = 0;
+        do {
+            chunkSize = readChunk(*readerA, chunkBytesA);
+            if ((readChunk(*readerB, chunkBytesB) != chunkSize) || (memcmp(chunkBytesA.data(), chunkBytesB.data(), chunkSize) != 0)) {
+                return false;
+            }
+        } while (chunkSize > 0);
+
+        return true;
+    }
+
+    uint32_t ReplacementDatabase::deduplicatePaths(const FileSystem *fileSystem, std::unordered_map<uint64_t, ReplacementResolvedPath> &resolvedPathMap, std::unordered_set<std::string> *pathsToPreload, JobSystem *jobSystem) {
+        // Only files of the same size can be identical, so the contents are only hashed for the sizes shared by more than one file.
+        struct ContentCandidate {
+            const std::string *relativePath = nullptr;
+            const std::string *contentPath = nullptr;
+            size_t size = 0;
+            uint64_t hash = 0;
+            bool hashed = false;
+            bool identical = false;
+        };
+
+        std::unordered_map<size_t, std::vector<const std::string *>> sizePathsMap;
+        std::unordered_set<std::string> relativePaths;
+        for (const auto &it : resolvedPathMap) {
+            relativePaths.insert(it.second.relativePath);
+        }
+
+        for (const std::string &relativePath : relativePaths) {
+            const size_t fileSize = fileSystem->getSize(relativePath);
+            if (fileSize > 0) {
+                sizePathsMap[fileSize].emplace_back(&relativePath);
+            }
+        }
+
+        std::vector<ContentCandidate> candidates;
+        for (const auto &it : sizePathsMap) {
+            if (it.second.size() > 1) {
+                for (const std::string *relativePath : it.second) {
+                    ContentCandidate candidate;
+                    candidate.relativePath = relativePath;
+                    candidate.size = it.first;
+                    candidates.emplace_back(candidate);
+                }
+            }
+        }
+
+        if (candidates.empty()) {
+            return 0;
+        }
+
+        auto hashCandidates = [&](size_t begin, size_t end) {
+            std::vector<uint8_t> chunkBytes(65536);
+            for (size_t c = begin; c < end; c++) {
+                ContentCandidate &candidate = candidates[c];
+                candidate.hashed = hashFileContents(fileSystem, *candidate.relativePath, chunkBytes, candidate.hash);
+            }
+        };
+
+        // Split the files in batches across the job system the same way as resolving the paths does.
+        const size_t MinFilesPerBatch = 64;
+        if (jobSystem != nullptr) {
+            jobSystem->parallelFor(JobSystem::Priority::Normal, candidates.size(), MinFilesPerBatch, hashCandidates);
+        }
+        else {
+            hashCandidates(0, candidates.size());
+        }
+
+        // The first path in alphabetical order is kept for every group of identical files, so the choice doesn't depend on the order of
+        // the database or the map.
+        std::map<std::pair<size_t, uint64_t>, const std::string *> contentPathMap;
+        for (const ContentCandidate &candidate : candidates) {
+            if (!candidate.hashed) {
+                continue;
+            }
+
+            const std::string *&contentPath = contentPathMap[{ candidate.size, candidate.hash }];
+            if ((contentPath == nullptr) || (*candidate.relativePath < *contentPath)) {
+                contentPath = candidate.relativePath;
+            }
+        }
+
+        std::vector<size_t> redirectCandidates;
+        for (size_t c = 0; c < candidates.size(); c++) {
+            ContentCandidate &candidate = candidates[c];
+            if (!candidate.hashed) {
+                continue;
+            }
+
+            candidate.contentPath = contentPathMap[{ candidate.size, candidate.hash }];
+            if (candidate.contentPath != candidate.relativePath) {
+                redirectCandidates.emplace_back(c);
+            }
+        }
+
+        // A matching hash is not proof enough, as a collision would show the wrong image and be kept across launches by the replacement
+        // cache. The contents of every file are compared against the one it would be redirected to before doing so.
+        auto compareCandidates = [&](size_t begin, size_t end) {
+            std::vector<uint8_t> chunkBytesA(65536);
+            std::vector<uint8_t> chunkBytesB(65536);
+            for (size_t r = begin; r < end; r++) {
+                ContentCandidate &candidate = candidates[redirectCandidates[r]];
+                candidate.identical = compareFileContents(fileSystem, *candidate.relativePath, *candidate.contentPath, chunkBytesA, chunkBytesB);
+            }
+        };
+
+        if (jobSystem != nullptr) {
+            jobSystem->parallelFor(JobSystem::Priority::Normal, redirectCandidates.size(), MinFilesPerBatch, compareCandidates);
+        }
+        else {
+            compareCandidates(0, redirectCandidates.size());
+        }
+
+        std::unordered_map<std::string, std::string> redirectedPaths;
+        std::unordered_set<std::string> contentPaths;
+        for (size_t c : redirectCandidates) {
+            const ContentCandidate &candidate = candidates[c];
+            if (candidate.identical) {
+                redirectedPaths[*candidate.relativePath] = *candidate.contentPath;
+                contentPaths.insert(*candidate.contentPath);
+            }
+        }
+
+        // Every entry that used a duplicate is redirected, so the duplicates themselves never need to be preloaded.
+        uint32_t redirectedCount = 0;
+        std::unordered_set<std::string> preloadedPaths;
+        for (auto &it : resolvedPathMap) {
+            ReplacementResolvedPath &resolvedPath = it.second;
+            auto redirectIt = redirectedPaths.find(resolvedPath.relativePath);
+            if (redirectIt != redirectedPaths.end()) {
+                if ((resolvedPath.resolvedOperation == ReplacementOperation::Preload) && (pathsToPreload != nullptr)) {
+                    pathsToPreload->erase(resolvedPath.relativePath);
+                }
+
+                resolvedPath.relativePath = redirectIt->second;
+                redirectedCount++;
+            }
+
+            if ((resolvedPath.resolvedOperation == ReplacementOperation::Preload) && (contentPaths.find(resolvedPath.relativePath) != contentPaths.end())) {
+                preloadedPaths.insert(resolvedPath.relativePath);
+            }
+        }
+
+        // Entries that share a path also share the loaded texture, which is only reference counted if it isn't preloaded. The whole group
+        // is preloaded if any of its entries is, so an entry can't reference count a texture that was preloaded for another one.
+        for (auto &it : resolvedPathMap) {
+            ReplacementResolvedPath &resolvedPath = it.second;
+            if (preloadedPaths.find(resolvedPath.relativePath) != preloadedPaths.end()) {
+                resolvedPath.resolvedOperation = ReplacementOperation::Preload;
+            }
+        }
+
+        if (pathsToPreload != nullptr) {
+            pathsToPreload->insert(preloadedPaths.begin(), preloadedPaths.end());
+        }
+
+        return redirectedCount;
+    }
+
     uint64_t ReplacementDatabase::stringToHash(const std::string &str) {
         return strtoull(str.c_str(), nullptr, 16);
     }
@@ -2,6 +2,8 @@
 // RT64
 //
 
+#pragma once
+
 #include <filesystem>
 #include <unordered_set>
 
@@ -12,6 +14,8 @@
 using json = nlohmann::json;
 
 namespace RT64 {
+    struct JobSystem;
+
     extern const std::string ReplacementDatabaseFilename;
     extern const std::string ReplacementLowMipCacheFilename;
     extern const std::string ReplacementPackExtension;
@@ -91,6 +95,32 @@ namespace RT64 {
         ReplacementShift shift = ReplacementShift::Half;
     };
 
+    // Finds the last filter in a list whose wildcard matches a path. Filters are indexed in a trie by the literal prefix that comes before
+    // their first wildcard, so a path is only checked against the filters that could possibly match it.
+    struct ReplacementFilterMatcher {
+        static const uint32_t None = UINT32_MAX;
+
+        struct Node {
+            std::vector<std::pair<char, uint32_t>> children;
+            std::vector<uint32_t> filterIndices;
+        };
+
+        std::vector<Node> nodes;
+        std::vector<std::string> wildcards;
+        std::unordered_map<std::string, uint32_t> literalFilters;
+
+        template<typename T>
+        ReplacementFilterMatcher(const std::vector<T> &filters) {
+            nodes.emplace_back();
+            for (const T &filter : filters) {
+                addFilter(filter.wildcard);
+            }
+        }
+
+        void addFilter(const std::string &wildcard);
+        uint32_t find(const std::string &path) const;
+    };
+
     struct ReplacementResolvedPath {
         uint32_t fileSystemIndex = 0;
         uint64_t textureHash = 0;
@@ -125,10 +155,13 @@ namespace RT64 {
         ReplacementTexture getReplacement(const std::string &hash) const;
         void buildHashMaps();
         ReplacementOperation resolveOperation(const std::string &relativePath, ReplacementOperation operation);
+        ReplacementOperation resolveOperation(const std::string &relativePath, ReplacementOperation operation, const ReplacementFilterMatcher &matcher) const;
         ReplacementShift resolveShift(const std::string &relativePath, ReplacementShift shift);
-        void resolvePaths(const FileSystem *fileSystem, uint32_t fileSystemIndex, std::unordered_map<uint64_t, ReplacementResolvedPath> &resolvedPathMap, bool onlyDDS, std::vector<uint64_t> *hashesMissing = nullptr, std::unordered_set<std::string> *pathsToPreload = nullptr);
+        ReplacementShift resolveShift(const std::string &relativePath, ReplacementShift shift, const ReplacementFilterMatcher &matcher) const;
+        void resolvePaths(const FileSystem *fileSystem, uint32_t fileSystemIndex, std::unordered_map<uint64_t, ReplacementResolvedPath> &resolvedPathMap, bool onlyDDS, std::vector<uint64_t> *hashesMissing = nullptr, std::unordered_set<std::string> *pathsToPreload = nullptr, JobSystem *jobSystem = nullptr);
         void resolveOperations(std::unordered_map<uint64_t, ReplacementResolvedPath> &resolvedPathMap);
         void resolveShifts(std::unordered_map<uint64_t, ReplacementResolvedPath> &resolvedPathMap);
+        static uint32_t deduplicatePaths(const FileSystem *fileSystem, std::unordered_map<uint64_t, ReplacementResolvedPath> &resolvedPathMap, std::unordered_set<std::string> *pathsToPreload = nullptr, JobSystem *jobSystem = nullptr);
         static uint64_t stringToHash(const std::string &str);
         static std::string hashToString(uint32_t hash);
         static std::string hashToString(uint64_t hash);
@@ -4,7 +4,12 @@
 
 #include "rt64_thread.h"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <fstream>
+#include <map>
+#include <mutex>
 #include <thread>
 
 #if defined(_WIN64)
@@ -12,6 +17,7 @@
 #   include "utf8conv/utf8conv.h"
 #elif defined(__linux__)
 #   include <pthread.h>
+#   include <sched.h>
 #endif
 
 namespace RT64 {
@@ -37,6 +43,301 @@ namespace RT64 {
     }
 #   endif
 
+#   if defined(__linux__)
+    static bool readFileString(const std::string &path, std::string &value) {
+        std::ifstream stream(path);
+        if (!stream.is_open()) {
+            return false;
+        }
+
+        std::getline(stream, value);
+        return !stream.fail();
+    }
+
+    static bool readFileUint(const std::string &path, uint64_t &value) {
+        std::string str;
+        if (!readFileString(path, str)) {
+            return false;
+        }
+
+        try {
+            value = std::stoull(str);
+            return true;
+        }
+        catch (...) {
+            return false;
+        }
+    }
+
+    // Parses the list format used by sysfs, e.g. "0-3,8,10-11".
+    static std::vector<uint32_t> parseCPUList(const std::string &str) {
+        std::vector<uint32_t> ids;
+        size_t start = 0;
+        while (start < str.size()) {
+            size_t end = str.find(',', start);
+            if (end == std::string::npos) {
+                end = str.size();
+            }
+
+            const std::string range = str.substr(start, end - start);
+            const size_t dash = range.find('-');
+            try {
+                const uint32_t first = uint32_t(std::stoul(range.substr(0, dash)));
+                const uint32_t last = (dash != std::string::npos) ? uint32_t(std::stoul(range.substr(dash + 1))) : first;
+                for (uint32_t i = first; i <= last; i++) {
+                    ids.emplace_back(i);
+                }
+            }
+            catch (...) {
+                // Ignore malformed ranges.
+            }
+
+            start = end + 1;
+        }
+
+        return ids;
+    }
+#   endif
+
+    // CPUTopology
+
+    CPUTopology CPUTopology::detect() {
+        CPUTopology topology;
+
+#   if defined(_WIN32)
+        DWORD bufferSize = 0;
+        GetLogicalProcessorInformationEx(RelationAll, nullptr, &bufferSize);
+        std::vector<uint8_t> buffer(bufferSize);
+        auto infoBegin = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data());
+        DWORD_PTR processMask = 0;
+        DWORD_PTR systemMask = 0;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) {
+            processMask = ~DWORD_PTR(0);
+        }
+
+        if ((bufferSize > 0) && GetLogicalProcessorInformationEx(RelationAll, infoBegin, &bufferSize)) {
+            // Only the first processor group is considered, as affinity masks can't span multiple groups. Processors outside of the
+            // process's affinity mask can't be used by any of its threads.
+            std::map<uint32_t, uint32_t> processorCaches;
+            for (DWORD offset = 0; offset < bufferSize;) {
+                auto info = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data() + offset);
+                if ((info->Relationship == RelationCache) && (info->Cache.Level == 3) && (info->Cache.GroupMask.Group == 0)) {
+                    for (uint32_t i = 0; i < 64; i++) {
+                        if (info->Cache.GroupMask.Mask & (KAFFINITY(1) << i)) {
+                            processorCaches[i] = topology.cacheCount;
+                        }
+                    }
+
+                    topology.cacheCount++;
+                }
+
+                offset += info->Size;
+            }
+
+            for (DWORD offset = 0; offset < bufferSize;) {
+                auto info = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data() + offset);
+                if ((info->Relationship == RelationProcessorCore) && (info->Processor.GroupMask[0].Group == 0)) {
+                    for (uint32_t i = 0; i < 64; i++) {
+                        if ((info->Processor.GroupMask[0].Mask & (KAFFINITY(1) << i)) && (processMask & (DWORD_PTR(1) << i))) {
+                            LogicalProcessor processor;
+                            processor.id = i;
+                            processor.coreIndex = topology.coreCount;
+                            processor.cacheIndex = processorCaches[i];
+                            processor.efficiencyClass = info->Processor.EfficiencyClass;
+                            topology.processors.emplace_back(processor);
+                        }
+                    }
+
+                    topology.coreCount++;
+                }
+
+                offset += info->Size;
+            }
+        }
+#   elif defined(__linux__)
+        std::string onlineList;
+        std::vector<uint32_t> onlineIds;
+        if (readFileString("/sys/devices/system/cpu/online", onlineList)) {
+            onlineIds = parseCPUList(onlineList);
+        }
+
+        // Processors outside of the set the process is allowed to run on can't be used by any of its threads.
+        cpu_set_t allowedSet;
+        CPU_ZERO(&allowedSet);
+        const bool allowedSetValid = (sched_getaffinity(0, sizeof(allowedSet), &allowedSet) == 0);
+
+        std::map<uint64_t, uint32_t> coreIndices;
+        std::map<std::string, uint32_t> cacheIndices;
+        std::vector<uint64_t> performanceValues;
+        for (uint32_t id : onlineIds) {
+            if (allowedSetValid && ((id >= CPU_SETSIZE) || !CPU_ISSET(id, &allowedSet))) {
+                continue;
+            }
+
+            const std::string cpuPath = "/sys/devices/system/cpu/cpu" + std::to_string(id);
+            uint64_t packageId = 0;
+            uint64_t coreId = id;
+            readFileUint(cpuPath + "/topology/physical_package_id", packageId);
+            readFileUint(cpuPath + "/topology/core_id", coreId);
+
+            // SMT siblings share the same core identifier within a package.
+            const uint64_t coreKey = (packageId << 32) | coreId;
+            auto coreIt = coreIndices.find(coreKey);
+            if (coreIt == coreIndices.end()) {
+                coreIt = coreIndices.emplace(coreKey, uint32_t(coreIndices.size())).first;
+            }
+
+            // Processors that share the same last level cache report the same list of siblings.
+            std::string cacheKey;
+            if (!readFileString(cpuPath + "/cache/index3/shared_cpu_list", cacheKey)) {
+                cacheKey = "package" + std::to_string(packageId);
+            }
+
+            auto cacheIt = cacheIndices.find(cacheKey);
+            if (cacheIt == cacheIndices.end()) {
+                cacheIt = cacheIndices.emplace(cacheKey, uint32_t(cacheIndices.size())).first;
+            }
+
+            // Relative capacity is reported by big.LITTLE systems. Hybrid x86 CPUs can be told apart by their maximum frequency instead.
+            uint64_t performanceValue = 0;
+            if (!readFileUint(cpuPath + "/cpu_capacity", performanceValue)) {
+                readFileUint(cpuPath + "/cpufreq/cpuinfo_max_freq", performanceValue);
+            }
+
+            LogicalProcessor processor;
+            processor.id = id;
+            processor.coreIndex = coreIt->second;
+            processor.cacheIndex = cacheIt->second;
+            topology.processors.emplace_back(processor);
+            performanceValues.emplace_back(performanceValue);
+        }
+
+        // Cores within a small margin of the fastest one are considered performance cores. This prevents the small frequency
+        // differences between the preferred cores of regular CPUs from being detected as a hybrid design.
+        const uint64_t maxPerformanceValue = performanceValues.empty() ? 0 : *std::max_element(performanceValues.begin(), performanceValues.end());
+        for (size_t i = 0; i < topology.processors.size(); i++) {
+            const bool performanceCore = (performanceValues[i] * 100) >= (maxPerformanceValue * 85);
+            topology.processors[i].efficiencyClass = performanceCore ? 1 : 0;
+        }
+
+        topology.coreCount = uint32_t(coreIndices.size());
+        topology.cacheCount = uint32_t(cacheIndices.size());
+#   endif
+
+        // Fall back to treating every logical processor as its own core if the topology couldn't be retrieved.
+        if (topology.processors.empty()) {
+            const uint32_t processorCount = std::max(std::thread::hardware_concurrency(), 1U);
+            for (uint32_t i = 0; i < processorCount; i++) {
+                LogicalProcessor processor;
+                processor.id = i;
+                processor.coreIndex = i;
+                topology.processors.emplace_back(processor);
+            }
+
+            topology.coreCount = processorCount;
+            topology.cacheCount = 1;
+        }
+
+        const auto classCompare = [](const LogicalProcessor &a, const LogicalProcessor &b) { return a.efficiencyClass < b.efficiencyClass; };
+        const auto classRange = std::minmax_element(topology.processors.begin(), topology.processors.end(), classCompare);
+        topology.hybrid = (classRange.first->efficiencyClass != classRange.second->efficiencyClass);
+        topology.cacheCount = std::max(topology.cacheCount, 1U);
+        return topology;
+    }
+
+    // Affinity policy
+
+    const uint32_t ThreadRoleCount = uint32_t(Thread::Role::Background) + 1;
+
+    struct AffinityPlan {
+        // An empty set of processors means the threads of that role are not pinned.
+        std::array<std::vector<uint32_t>, ThreadRoleCount> roleProcessors;
+    };
+
+    static std::mutex AffinityPlanMutex;
+    static AffinityPlan CurrentAffinityPlan;
+
+    static AffinityPlan buildAffinityPlan(const CPUTopology &topology, Thread::AffinityPolicy policy) {
+        AffinityPlan plan;
+        if (policy == Thread::AffinityPolicy::Disabled) {
+            return plan;
+        }
+
+        // Group the processors of the fastest cores by their core and count how many of them are in each cache domain.
+        uint32_t maxEfficiencyClass = 0;
+        for (const CPUTopology::LogicalProcessor &processor : topology.processors) {
+            maxEfficiencyClass = std::max(maxEfficiencyClass, processor.efficiencyClass);
+        }
+
+        std::map<uint32_t, std::vector<uint32_t>> fastCoreProcessors;
+        std::map<uint32_t, uint32_t> fastCoreCaches;
+        std::vector<uint32_t> cacheFastCoreCounts(topology.cacheCount, 0);
+        for (const CPUTopology::LogicalProcessor &processor : topology.processors) {
+            if (processor.efficiencyClass == maxEfficiencyClass) {
+                if (fastCoreProcessors[processor.coreIndex].empty()) {
+                    fastCoreCaches[processor.coreIndex] = processor.cacheIndex;
+                    cacheFastCoreCounts[std::min(processor.cacheIndex, topology.cacheCount - 1)]++;
+                }
+
+                fastCoreProcessors[processor.coreIndex].emplace_back(processor.id);
+            }
+        }
+
+        // The dedicated threads share data constantly, so they're kept on the cache domain with the most fast cores.
+        const uint32_t primaryCache = uint32_t(std::max_element(cacheFastCoreCounts.begin(), cacheFastCoreCounts.end()) - cacheFastCoreCounts.begin());
+        std::vector<uint32_t> fastCoreOrder;
+        for (const auto &it : fastCoreCaches) {
+            if (it.second == primaryCache) {
+                fastCoreOrder.emplace_back(it.first);
+            }
+        }
+
+        for (const auto &it : fastCoreCaches) {
+            if (it.second != primaryCache) {
+                fastCoreOrder.emplace_back(it.first);
+            }
+        }
+
+        // Only give the render and present threads a physical core of their own if the workers are left with at least as many fast cores.
+        // The emulator's thread is never pinned, as it belongs to the host application.
+        const Thread::Role DedicatedRoles[] = { Thread::Role::Render, Thread::Role::Present };
+        const uint32_t DedicatedRoleCount = uint32_t(std::size(DedicatedRoles));
+        const bool dedicatedCores = (fastCoreOrder.size() >= (DedicatedRoleCount * 2));
+        if (!dedicatedCores && !topology.hybrid) {
+            return plan;
+        }
+
+        std::vector<uint32_t> dedicatedProcessors;
+        if (dedicatedCores) {
+            for (uint32_t i = 0; i < DedicatedRoleCount; i++) {
+                const std::vector<uint32_t> &coreProcessors = fastCoreProcessors[fastCoreOrder[i]];
+                plan.roleProcessors[uint32_t(DedicatedRoles[i])] = coreProcessors;
+                dedicatedProcessors.insert(dedicatedProcessors.end(), coreProcessors.begin(), coreProcessors.end());
+            }
+        }
+
+        // Workers can use anything that isn't reserved. Background work is moved to the efficiency cores if the CPU has any.
+        std::vector<uint32_t> &workerProcessors = plan.roleProcessors[uint32_t(Thread::Role::Worker)];
+        std::vector<uint32_t> &backgroundProcessors = plan.roleProcessors[uint32_t(Thread::Role::Background)];
+        for (const CPUTopology::LogicalProcessor &processor : topology.processors) {
+            if (std::find(dedicatedProcessors.begin(), dedicatedProcessors.end(), processor.id) != dedicatedProcessors.end()) {
+                continue;
+            }
+
+            workerProcessors.emplace_back(processor.id);
+
+            if (topology.hybrid && (processor.efficiencyClass < maxEfficiencyClass)) {
+                backgroundProcessors.emplace_back(processor.id);
+            }
+        }
+
+        if (backgroundProcessors.empty()) {
+            backgroundProcessors = workerProcessors;
+        }
+
+        return plan;
+    }
+
     // Thread
 
     void Thread::setCurrentThreadName(const std::string &str) {
@@ -66,6 +367,73 @@ namespace RT64 {
 #   endif
     }
 
+    bool Thread::setCurrentThreadAffinity(const std::vector<uint32_t> &processorIds) {
+        if (processorIds.empty()) {
+            return false;
+        }
+
+#   if defined(_WIN32)
+        DWORD_PTR mask = 0;
+        for (uint32_t id : processorIds) {
+            if (id < 64) {
+                mask |= DWORD_PTR(1) << id;
+            }
+        }
+
+        return (mask != 0) && (SetThreadAffinityMask(GetCurrentThread(), mask) != 0);
+#   elif defined(__linux__)
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        for (uint32_t id : processorIds) {
+            if (id < CPU_SETSIZE) {
+                CPU_SET(id, &cpuSet);
+            }
+        }
+
+        return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#   elif defined(__APPLE__)
+        // macOS does not allow pinning threads to specific processors.
+        return false;
+#   else
+        static_assert(false, "Unimplemented");
+#   endif
+    }
+
+    void Thread::setCurrentThreadRole(Role role) {
+        std::vector<uint32_t> processorIds;
+        {
+            std::unique_lock<std::mutex> lock(AffinityPlanMutex);
+            processorIds = CurrentAffinityPlan.roleProcessors[uint32_t(role)];
+        }
+
+        if (!processorIds.empty()) {
+            setCurrentThreadAffinity(processorIds);
+        }
+    }
+
+    void Thread::setAffinityPolicy(AffinityPolicy policy) {
+        AffinityPlan plan = buildAffinityPlan(getTopology(), policy);
+        std::unique_lock<std::mutex> lock(AffinityPlanMutex);
+        CurrentAffinityPlan = std::move(plan);
+    }
+
+    const CPUTopology &Thread::getTopology() {
+        static const CPUTopology topology = CPUTopology::detect();
+        return topology;
+    }
+
+    uint32_t Thread::getRoleProcessorCount(Role role) {
+        {
+            std::unique_lock<std::mutex> lock(AffinityPlanMutex);
+            const std::vector<uint32_t> &processorIds = CurrentAffinityPlan.roleProcessors[uint32_t(role)];
+            if (!processorIds.empty()) {
+                return uint32_t(processorIds.size());
+            }
+        }
+
+        return std::max(uint32_t(getTopology().processors.size()), 1U);
+    }
+
     void Thread::sleepMilliseconds(uint32_t millis) {
 #   if defined(_WIN32)
         // The implementations of std::chrono::sleep_until and sleep_for were affected by changing the system clock backwards in older versions
@@ -6,8 +6,27 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 namespace RT64 {
+    struct CPUTopology {
+        struct LogicalProcessor {
+            uint32_t id = 0;
+            uint32_t coreIndex = 0;
+            uint32_t cacheIndex = 0;
+
+            // Higher values indicate faster cores. All processors have the same class on CPUs that aren't hybrid.
+            uint32_t efficiencyClass = 0;
+        };
+
+        std::vector<LogicalProcessor> processors;
+        uint32_t coreCount = 0;
+        uint32_t cacheCount = 0;
+        bool hybrid = false;
+
+        static CPUTopology detect();
+    };
+
     struct Thread {
         enum class Priority {
             Idle,
@@ -18,8 +37,28 @@ namespace RT64 {
             Highest
         };
 
+        // The emulator's own thread belongs to the host application, so it never gets a role.
+        enum class Role {
+            Render,
+            Present,
+            Worker,
+            Background
+        };
+
+        enum class AffinityPolicy {
+            Disabled,
+            Automatic
+        };
+
         static void setCurrentThreadName(const std::string &str);
         static void setCurrentThreadPriority(Priority priority);
+        static bool setCurrentThreadAffinity(const std::vector<uint32_t> &processorIds);
+        static void setCurrentThreadRole(Role role);
+        static void setAffinityPolicy(AffinityPolicy policy);
+        static const CPUTopology &getTopology();
+
+        // Amount of processors the threads of the role can run on, which is every processor available to the process if they aren't pinned.
+        static uint32_t getRoleProcessorCount(Role role);
         static void sleepMilliseconds(uint32_t millis);
     };
-};
\ No newline at end of file
+};
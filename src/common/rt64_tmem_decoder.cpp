@@ -0,0 +1,249 @@
+//
+// RT64
+//
+
+#include "rt64_tmem_decoder.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "shared/rt64_f3d_defines.h"
+
+namespace RT64 {
+    static const uint32_t TMEMBytes = 0x1000;
+    static const uint32_t TMEMPaletteAddress = 0x800;
+    static const uint32_t TMEMMask8 = 0xFFF;
+    static const uint32_t TMEMMask16 = 0x7FF;
+
+    // Color conversions. They match the ones in Formats.hlsli, which always produce an exact multiple of 1/255 that the UNORM output stores as is.
+
+    static const uint32_t OpaqueBlack = 0xFF000000U;
+
+    static inline uint32_t packRGBA(uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    static inline uint32_t I4ToRGBA(uint32_t i4) {
+        const uint32_t i = (i4 << 4) | i4;
+        return packRGBA(i, i, i, i);
+    }
+
+    static inline uint32_t IA4ToRGBA(uint32_t ia4) {
+        uint32_t i = ia4 & 0b1110;
+        i = (i << 4) | (i << 1) | (i >> 2);
+        return packRGBA(i, i, i, (ia4 & 1) ? 0xFF : 0x00);
+    }
+
+    static inline uint32_t I8ToRGBA(uint32_t i) {
+        return packRGBA(i, i, i, i);
+    }
+
+    static inline uint32_t IA8ToRGBA(uint32_t ia8) {
+        uint32_t i = (ia8 >> 4) & 0xF;
+        uint32_t a = (ia8 >> 0) & 0xF;
+        i = (i << 4) | i;
+        a = (a << 4) | a;
+        return packRGBA(i, i, i, a);
+    }
+
+    static inline uint32_t RGBA16ToRGBA(uint32_t rgba16) {
+        const uint32_t r = (rgba16 >> 11) & 0x1F;
+        const uint32_t g = (rgba16 >> 6) & 0x1F;
+        const uint32_t b = (rgba16 >> 1) & 0x1F;
+        return packRGBA((r << 3) | (r >> 2), (g << 3) | (g >> 2), (b << 3) | (b >> 2), (rgba16 & 1) ? 0xFF : 0x00);
+    }
+
+    static inline uint32_t IA16ToRGBA(uint32_t ia16) {
+        const uint32_t i = (ia16 >> 8) & 0xFF;
+        const uint32_t a = ia16 & 0xFF;
+        return packRGBA(i, i, i, a);
+    }
+
+    // TMEM access. Matches implLoadTMEM and loadTLUT in TextureDecoder.hlsli.
+
+    struct TMEMView {
+        const uint8_t *bytes;
+        uint32_t size;
+        uint32_t address;
+        uint32_t stride;
+
+        inline uint32_t load(uint32_t finalAddress) const {
+            // Out of bounds loads on the TMEM texture return zero.
+            return (finalAddress < size) ? bytes[finalAddress] : 0;
+        }
+
+        inline uint32_t loadMasked(uint32_t relativeAddress, uint32_t maskAddress, uint32_t orAddress, bool oddRow) const {
+            // A division by zero on the GPU returns all ones, which turns the row start into zero after the multiplication.
+            const uint32_t rowStart = (stride > 0) ? ((relativeAddress / stride) * stride) : 0;
+            const uint32_t wordIndex = (relativeAddress - rowStart) / 4;
+            const uint32_t swapWordIndex = wordIndex ^ 1;
+            const uint32_t finalAddress = oddRow ?
+                (address + rowStart + (swapWordIndex * 4) + (relativeAddress & 0x3)) :
+                (address + relativeAddress);
+            return load(((finalAddress & maskAddress) | orAddress) & TMEMMask8);
+        }
+
+        inline uint32_t loadTLUT(uint32_t paletteAddress) const {
+            return load(paletteAddress & TMEMMask8);
+        }
+    };
+
+    template<uint32_t Siz, bool UsesTlut>
+    static inline uint32_t sampleTexel(const TMEMView &tmem, const TMEMDecoder::Params &params, uint32_t x, uint32_t y) {
+        const bool oddRow = (y & 1);
+        const bool oddColumn = (x & 1);
+        const bool isRgba32 = (params.fmt == G_IM_FMT_RGBA) && (Siz == G_IM_SIZ_32b);
+        const uint32_t tmemShift = isRgba32 ? 2 : Siz;
+        const uint32_t addressMask = (isRgba32 || UsesTlut) ? TMEMMask16 : TMEMMask8;
+        const uint32_t pixelAddress = y * params.stride + ((x << tmemShift) >> 1);
+        const uint32_t pixelValue0 = tmem.loadMasked(pixelAddress + 0, addressMask, 0x0, oddRow);
+        const uint32_t pixelShift = oddColumn ? 0 : 4;
+        const uint32_t pixelValue4bit = (pixelValue0 >> pixelShift) & 0xF;
+        if (UsesTlut) {
+            const uint32_t paletteAddress = (Siz == G_IM_SIZ_4b) ?
+                (TMEMPaletteAddress + (params.palette << 7) + (pixelValue4bit << 3)) :
+                (TMEMPaletteAddress + (pixelValue0 << 3));
+            const uint32_t paletteValue = tmem.loadTLUT(paletteAddress + 1) | (tmem.loadTLUT(paletteAddress) << 8);
+            switch (params.tlut) {
+            case G_TT_RGBA16:
+                return RGBA16ToRGBA(paletteValue);
+            case G_TT_IA16:
+                return IA16ToRGBA(paletteValue);
+            default:
+                return OpaqueBlack;
+            }
+        }
+
+        switch (Siz) {
+        case G_IM_SIZ_4b:
+            switch (params.fmt) {
+            case G_IM_FMT_CI:
+                // Not a real format. Loads the palette index as the upper bits of the value.
+                return I8ToRGBA(std::min((params.palette << 4) | pixelValue4bit, 0xFFU));
+            case G_IM_FMT_IA:
+                return IA4ToRGBA(pixelValue4bit);
+            case G_IM_FMT_I:
+            case G_IM_FMT_RGBA:
+                return I4ToRGBA(pixelValue4bit);
+            default:
+                return OpaqueBlack;
+            }
+        case G_IM_SIZ_8b:
+            switch (params.fmt) {
+            case G_IM_FMT_IA:
+                return IA8ToRGBA(pixelValue0);
+            case G_IM_FMT_I:
+            case G_IM_FMT_RGBA:
+            case G_IM_FMT_CI:
+                return I8ToRGBA(pixelValue0);
+            default:
+                return OpaqueBlack;
+            }
+        case G_IM_SIZ_16b: {
+            const uint32_t pixelValue1 = tmem.loadMasked(pixelAddress + 1, addressMask, 0x0, oddRow);
+            switch (params.fmt) {
+            case G_IM_FMT_RGBA:
+                return RGBA16ToRGBA(pixelValue1 | (pixelValue0 << 8));
+            case G_IM_FMT_IA:
+                return IA16ToRGBA(pixelValue1 | (pixelValue0 << 8));
+            case G_IM_FMT_CI:
+            case G_IM_FMT_I:
+                return packRGBA(pixelValue0, pixelValue1, pixelValue0, pixelValue1);
+            default:
+                return OpaqueBlack;
+            }
+        }
+        case G_IM_SIZ_32b: {
+            const uint32_t pixelValue1 = tmem.loadMasked(pixelAddress + 1, addressMask, 0x0, oddRow);
+            const uint32_t pixelAddress2 = isRgba32 ? pixelAddress : (pixelAddress + 2);
+            const uint32_t orAddress = isRgba32 ? (TMEMBytes >> 1) : 0;
+            const uint32_t pixelValue2 = tmem.loadMasked(pixelAddress2 + 0, addressMask, orAddress, oddRow);
+            const uint32_t pixelValue3 = tmem.loadMasked(pixelAddress2 + 1, addressMask, orAddress, oddRow);
+            switch (params.fmt) {
+            case G_IM_FMT_RGBA:
+                return packRGBA(pixelValue0, pixelValue1, pixelValue2, pixelValue3);
+            case G_IM_FMT_CI:
+            case G_IM_FMT_IA:
+            case G_IM_FMT_I:
+                return oddColumn ? packRGBA(pixelValue0, pixelValue1, pixelValue0, pixelValue1) : packRGBA(pixelValue2, pixelValue3, pixelValue2, pixelValue3);
+            default:
+                return OpaqueBlack;
+            }
+        }
+        default:
+            return OpaqueBlack;
+        }
+    }
+
+    // The size and TLUT usage are resolved once per texture so the inner loop only has to deal with the format, which is also invariant.
+    template<uint32_t Siz, bool UsesTlut>
+    static void decodeRows(const TMEMView &tmem, const TMEMDecoder::Params &params, uint32_t width, uint32_t height, uint8_t *dst, uint32_t dstRowPitch) {
+        for (uint32_t y = 0; y < height; y++) {
+            uint32_t *dstRow = reinterpret_cast<uint32_t *>(dst + size_t(y) * dstRowPitch);
+            for (uint32_t x = 0; x < width; x++) {
+                dstRow[x] = sampleTexel<Siz, UsesTlut>(tmem, params, x, y);
+            }
+        }
+    }
+
+    // TMEMDecoder::Params
+
+    TMEMDecoder::Params::Params(const LoadTile &loadTile, uint32_t tlut) {
+        fmt = loadTile.fmt;
+        siz = loadTile.siz;
+        address = uint32_t(loadTile.tmem) << 3;
+        stride = uint32_t(loadTile.line) << 3;
+        palette = loadTile.palette;
+        this->tlut = tlut;
+    }
+
+    // TMEMDecoder
+
+    uint32_t TMEMDecoder::decodeTexel(const uint8_t *TMEM, uint32_t tmemSize, const Params &params, uint32_t x, uint32_t y) {
+        const TMEMView tmem = { TMEM, tmemSize, params.address, params.stride };
+        const bool usesTlut = (params.tlut > 0);
+        switch (params.siz) {
+        case G_IM_SIZ_4b:
+            return usesTlut ? sampleTexel<G_IM_SIZ_4b, true>(tmem, params, x, y) : sampleTexel<G_IM_SIZ_4b, false>(tmem, params, x, y);
+        case G_IM_SIZ_8b:
+            return usesTlut ? sampleTexel<G_IM_SIZ_8b, true>(tmem, params, x, y) : sampleTexel<G_IM_SIZ_8b, false>(tmem, params, x, y);
+        case G_IM_SIZ_16b:
+            return usesTlut ? sampleTexel<G_IM_SIZ_16b, true>(tmem, params, x, y) : sampleTexel<G_IM_SIZ_16b, false>(tmem, params, x, y);
+        case G_IM_SIZ_32b:
+            return usesTlut ? sampleTexel<G_IM_SIZ_32b, true>(tmem, params, x, y) : sampleTexel<G_IM_SIZ_32b, false>(tmem, params, x, y);
+        default:
+            return OpaqueBlack;
+        }
+    }
+
+    void TMEMDecoder::decode(const uint8_t *TMEM, uint32_t tmemSize, const Params &params, uint32_t width, uint32_t height, uint8_t *dst, uint32_t dstRowPitch) {
+        assert(dst != nullptr);
+        assert(dstRowPitch >= (width * sizeof(uint32_t)));
+
+        const TMEMView tmem = { TMEM, tmemSize, params.address, params.stride };
+        const bool usesTlut = (params.tlut > 0);
+        switch (params.siz) {
+        case G_IM_SIZ_4b:
+            usesTlut ? decodeRows<G_IM_SIZ_4b, true>(tmem, params, width, height, dst, dstRowPitch) : decodeRows<G_IM_SIZ_4b, false>(tmem, params, width, height, dst, dstRowPitch);
+            break;
+        case G_IM_SIZ_8b:
+            usesTlut ? decodeRows<G_IM_SIZ_8b, true>(tmem, params, width, height, dst, dstRowPitch) : decodeRows<G_IM_SIZ_8b, false>(tmem, params, width, height, dst, dstRowPitch);
+            break;
+        case G_IM_SIZ_16b:
+            usesTlut ? decodeRows<G_IM_SIZ_16b, true>(tmem, params, width, height, dst, dstRowPitch) : decodeRows<G_IM_SIZ_16b, false>(tmem, params, width, height, dst, dstRowPitch);
+            break;
+        case G_IM_SIZ_32b:
+            usesTlut ? decodeRows<G_IM_SIZ_32b, true>(tmem, params, width, height, dst, dstRowPitch) : decodeRows<G_IM_SIZ_32b, false>(tmem, params, width, height, dst, dstRowPitch);
+            break;
+        default:
+            for (uint32_t y = 0; y < height; y++) {
+                uint32_t *dstRow = reinterpret_cast<uint32_t *>(dst + size_t(y) * dstRowPitch);
+                for (uint32_t x = 0; x < width; x++) {
+                    dstRow[x] = OpaqueBlack;
+                }
+            }
+
+            break;
+        }
+    }
+};
@@ -0,0 +1,33 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include <cstdint>
+
+#include "rt64_load_types.h"
+
+namespace RT64 {
+    // CPU implementation of TextureDecodeCS. Every format, size and TLUT mode produces exactly the same RGBA8 values the decode shader
+    // writes to its UNORM output, so it can be used to verify the shader or to decode textures that are too small to be worth a dispatch.
+    struct TMEMDecoder {
+        struct Params {
+            uint32_t fmt = 0;
+            uint32_t siz = 0;
+            uint32_t address = 0;
+            uint32_t stride = 0;
+            uint32_t tlut = 0;
+            uint32_t palette = 0;
+
+            Params() = default;
+            Params(const LoadTile &loadTile, uint32_t tlut);
+        };
+
+        // Returns the texel as a packed RGBA8 value with red in the lowest byte.
+        static uint32_t decodeTexel(const uint8_t *TMEM, uint32_t tmemSize, const Params &params, uint32_t x, uint32_t y);
+
+        // Decodes a whole texture into rows of packed RGBA8 values. The row pitch is specified in bytes.
+        static void decode(const uint8_t *TMEM, uint32_t tmemSize, const Params &params, uint32_t width, uint32_t height, uint8_t *dst, uint32_t dstRowPitch);
+    };
+};
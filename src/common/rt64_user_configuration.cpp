@@ -15,6 +15,8 @@ namespace RT64 {
         j["displayBuffering"] = cfg.displayBuffering;
         j["antialiasing"] = cfg.antialiasing;
         j["resolutionMultiplier"] = cfg.resolutionMultiplier;
+        j["dynamicResolutionMin"] = cfg.dynamicResolutionMin;
+        j["dynamicResolutionMax"] = cfg.dynamicResolutionMax;
         j["downsampleMultiplier"] = cfg.downsampleMultiplier;
         j["filtering"] = cfg.filtering;
         j["aspectRatio"] = cfg.aspectRatio;
@@ -27,7 +29,9 @@ namespace RT64 {
         j["refreshRateTarget"] = cfg.refreshRateTarget;
         j["internalColorFormat"] = cfg.internalColorFormat;
         j["hardwareResolve"] = cfg.hardwareResolve;
+        j["threadAffinity"] = cfg.threadAffinity;
         j["idleWorkActive"] = cfg.idleWorkActive;
+        j["transcodeReplacements"] = cfg.transcodeReplacements;
         j["developerMode"] = cfg.developerMode;
     }
 
@@ -38,6 +42,8 @@ namespace RT64 {
         cfg.displayBuffering = j.value("displayBuffering", defaultCfg.displayBuffering);
         cfg.antialiasing = j.value("antialiasing", defaultCfg.antialiasing);
         cfg.resolutionMultiplier = j.value("resolutionMultiplier", defaultCfg.resolutionMultiplier);
+        cfg.dynamicResolutionMin = j.value("dynamicResolutionMin", defaultCfg.dynamicResolutionMin);
+        cfg.dynamicResolutionMax = j.value("dynamicResolutionMax", defaultCfg.dynamicResolutionMax);
         cfg.downsampleMultiplier = j.value("downsampleMultiplier", defaultCfg.downsampleMultiplier);
         cfg.filtering = j.value("filtering", defaultCfg.filtering);
         cfg.aspectRatio = j.value("aspectRatio", defaultCfg.aspectRatio);
@@ -50,7 +56,9 @@ namespace RT64 {
         cfg.refreshRateTarget = j.value("refreshRateTarget", defaultCfg.refreshRateTarget);
         cfg.internalColorFormat = j.value("internalColorFormat", defaultCfg.internalColorFormat);
         cfg.hardwareResolve = j.value("hardwareResolve", defaultCfg.hardwareResolve);
+        cfg.threadAffinity = j.value("threadAffinity", defaultCfg.threadAffinity);
         cfg.idleWorkActive = j.value("idleWorkActive", defaultCfg.idleWorkActive);
+        cfg.transcodeReplacements = j.value("transcodeReplacements", defaultCfg.transcodeReplacements);
         cfg.developerMode = j.value("developerMode", defaultCfg.developerMode);
     }
 
@@ -69,6 +77,8 @@ namespace RT64 {
         displayBuffering = DisplayBuffering::Double;
         antialiasing = Antialiasing::None;
         resolutionMultiplier = 2.0f;
+        dynamicResolutionMin = 1.0f;
+        dynamicResolutionMax = 4.0f;
         downsampleMultiplier = 1;
         filtering = Filtering::AntiAliasedPixelScaling;
         aspectRatio = AspectRatio::Original;
@@ -81,7 +91,9 @@ namespace RT64 {
         refreshRateTarget = 60;
         internalColorFormat = InternalColorFormat::Automatic;
         hardwareResolve = HardwareResolve::Automatic;
+        threadAffinity = ThreadAffinity::Disabled;
         idleWorkActive = true;
+        transcodeReplacements = false;
         developerMode = false;
     }
 
@@ -97,7 +109,10 @@ namespace RT64 {
         clampEnum<RefreshRate>(refreshRate);
         clampEnum<InternalColorFormat>(internalColorFormat);
         clampEnum<HardwareResolve>(hardwareResolve);
+        clampEnum<ThreadAffinity>(threadAffinity);
         resolutionMultiplier = std::clamp<double>(resolutionMultiplier, 0.0f, ResolutionMultiplierLimit);
+        dynamicResolutionMin = std::clamp<double>(dynamicResolutionMin, 1.0f, ResolutionMultiplierLimit);
+        dynamicResolutionMax = std::clamp<double>(dynamicResolutionMax, dynamicResolutionMin, ResolutionMultiplierLimit);
         downsampleMultiplier = std::clamp<int>(downsampleMultiplier, 1, ResolutionMultiplierLimit);
         aspectTarget = std::clamp<double>(aspectTarget, 0.1f, 100.0f);
         extAspectTarget = std::clamp<double>(extAspectTarget, 0.1f, 100.0f);
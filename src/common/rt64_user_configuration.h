@@ -24,6 +24,7 @@ namespace RT64 {
             Original,
             WindowIntegerScale,
             Manual,
+            Dynamic,
             OptionCount
         };
 
@@ -83,11 +84,19 @@ namespace RT64 {
             OptionCount
         };
 
+        enum class ThreadAffinity {
+            Disabled,
+            Automatic,
+            OptionCount
+        };
+
         GraphicsAPI graphicsAPI;
         Resolution resolution;
         DisplayBuffering displayBuffering;
         Antialiasing antialiasing;
         double resolutionMultiplier;
+        double dynamicResolutionMin;
+        double dynamicResolutionMax;
         int downsampleMultiplier;
         Filtering filtering;
         AspectRatio aspectRatio;
@@ -100,7 +109,9 @@ namespace RT64 {
         int refreshRateTarget;
         InternalColorFormat internalColorFormat;
         HardwareResolve hardwareResolve;
+        ThreadAffinity threadAffinity;
         bool idleWorkActive;
+        bool transcodeReplacements;
         bool developerMode;
 
         UserConfiguration();
@@ -124,7 +135,8 @@ namespace RT64 {
     NLOHMANN_JSON_SERIALIZE_ENUM(UserConfiguration::Resolution, {
         { UserConfiguration::Resolution::Original, "Original" },
         { UserConfiguration::Resolution::WindowIntegerScale, "WindowIntegerScale" },
-        { UserConfiguration::Resolution::Manual, "Manual" }
+        { UserConfiguration::Resolution::Manual, "Manual" },
+        { UserConfiguration::Resolution::Dynamic, "Dynamic" }
     });
 
     NLOHMANN_JSON_SERIALIZE_ENUM(UserConfiguration::AspectRatio, {
@@ -170,6 +182,11 @@ namespace RT64 {
         { UserConfiguration::HardwareResolve::Automatic, "Automatic" }
     });
 
+    NLOHMANN_JSON_SERIALIZE_ENUM(UserConfiguration::ThreadAffinity, {
+        { UserConfiguration::ThreadAffinity::Disabled, "Disabled" },
+        { UserConfiguration::ThreadAffinity::Automatic, "Automatic" }
+    });
+
     struct ConfigurationJSON {
         static bool read(UserConfiguration &cfg, std::istream &stream);
         static bool write(const UserConfiguration &cfg, std::ostream &stream);
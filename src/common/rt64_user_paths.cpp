@@ -20,6 +20,7 @@ namespace RT64 {
     const std::filesystem::path ConfigurationFile = "rt64.json";
     const std::filesystem::path ImGuiFile = "rt64-imgui.ini";
     const std::filesystem::path LogFile = "rt64.log";
+    const std::filesystem::path ReplacementCacheDirectory = "replacement-cache";
 
     std::filesystem::path UserPaths::detectDataPath(const std::filesystem::path &appId) {
         std::filesystem::path resultPath;
@@ -67,6 +68,7 @@ namespace RT64 {
             configurationPath = dataPath / ConfigurationFile;
             imguiPath = dataPath / ImGuiFile;
             logPath = dataPath / LogFile;
+            replacementCachePath = dataPath / ReplacementCacheDirectory;
         }
     }
 
@@ -11,6 +11,7 @@
 #include "common/rt64_dynamic_libraries.h"
 #include "common/rt64_elapsed_timer.h"
 #include "common/rt64_math.h"
+#include "common/rt64_thread.h"
 
 #if RT_ENABLED
 #   include "res/bluenoise/LDR_64_64_64_RGB1.h"
@@ -99,6 +100,11 @@ namespace RT64 {
             saveConfiguration();
         }
 
+        // Configure the affinity policy before any of the threads are created. The workers are sized to the processors they can run on.
+        const bool automaticAffinity = (userConfig.threadAffinity == UserConfiguration::ThreadAffinity::Automatic);
+        Thread::setAffinityPolicy(automaticAffinity ? Thread::AffinityPolicy::Automatic : Thread::AffinityPolicy::Disabled);
+        threadsAvailable = Thread::getRoleProcessorCount(Thread::Role::Worker);
+
         // Create the interpreter and its associated state.
         interpreter = std::make_unique<Interpreter>();
         state = std::make_unique<State>(core.RDRAM, core.MI_INTR_REG, core.checkInterrupts);
@@ -300,13 +306,16 @@ namespace RT64 {
             initHook(renderInterface.get(), device.get());
         }
 
+        // Create the job system that runs all the background work.
+        jobSystem = std::make_unique<JobSystem>(threadsAvailable);
+
         // Create all the render workers.
-        drawDataUploader = std::make_unique<BufferUploader>(device.get());
-        transformsUploader = std::make_unique<BufferUploader>(device.get());
-        tilesUploader = std::make_unique<BufferUploader>(device.get());
-        workloadExtrasUploader = std::make_unique<BufferUploader>(device.get());
-        workloadVelocityUploader = std::make_unique<BufferUploader>(device.get());
-        workloadTilesUploader = std::make_unique<BufferUploader>(device.get());
+        drawDataUploader = std::make_unique<BufferUploader>(device.get(), jobSystem.get());
+        transformsUploader = std::make_unique<BufferUploader>(device.get(), jobSystem.get());
+        tilesUploader = std::make_unique<BufferUploader>(device.get(), jobSystem.get());
+        workloadExtrasUploader = std::make_unique<BufferUploader>(device.get(), jobSystem.get());
+        workloadVelocityUploader = std::make_unique<BufferUploader>(device.get(), jobSystem.get());
+        workloadTilesUploader = std::make_unique<BufferUploader>(device.get(), jobSystem.get());
         framebufferGraphicsWorker = std::make_unique<RenderWorker>(device.get(), "Framebuffer Graphics", RenderCommandListType::DIRECT);
         textureDirectWorker = std::make_unique<RenderWorker>(device.get(), "Texture Direct", RenderCommandListType::DIRECT);
         textureCopyWorker = std::make_unique<RenderWorker>(device.get(), "Texture Copy", RenderCommandListType::COPY);
@@ -348,11 +357,11 @@ namespace RT64 {
         shaderLibrary->setupMultisamplingShaders(renderInterface.get(), device.get(), multisampling);
 
         // Create the shader caches.
-        // Estimate the amount of shader compiler threads by trying to use about half of the system's available threads.
-        // We need the ubershader pipelines done as soon as possible, so we use a different thread count that demands more of the system.
+        // Estimate the amount of shader compiler jobs that can run at once by trying to use about half of the system's available threads.
+        // We need the ubershader pipelines done as soon as possible, so those are created with a higher priority that demands more of the system.
         const uint32_t rasterShaderThreads = std::max(threadsAvailable / 2U, 1U);
-        const uint32_t ubershaderThreads = uint32_t(std::max(int(threadsAvailable) - 2, 1));
-        rasterShaderCache = std::make_unique<RasterShaderCache>(rasterShaderThreads, ubershaderThreads);
+        jobSystem->setConcurrencyLimit(JobSystem::Priority::Idle, rasterShaderThreads);
+        rasterShaderCache = std::make_unique<RasterShaderCache>(jobSystem.get());
         rasterShaderCache->setup(device.get(), renderInterface->getCapabilities().shaderFormat, shaderLibrary.get(), multisampling);
 
 #   if RT_ENABLED
@@ -363,13 +372,23 @@ namespace RT64 {
 
         // Create the texture cache.
         const uint32_t textureCacheThreads = std::max(threadsAvailable / 4U, 1U);
-        textureCache = std::make_unique<TextureCache>(textureDirectWorker.get(), textureCopyWorker.get(), textureCacheThreads, shaderLibrary.get());
+        jobSystem->setConcurrencyLimit(JobSystem::Priority::Low, textureCacheThreads);
+        textureCache = std::make_unique<TextureCache>(textureDirectWorker.get(), textureCopyWorker.get(), jobSystem.get(), textureCacheThreads, shaderLibrary.get());
+        if (!userPaths.isEmpty()) {
+            textureCache->setReplacementCacheDirectory(userPaths.replacementCachePath);
+        }
+
+        textureCache->setReplacementTranscoding(userConfig.transcodeReplacements);
 
         // Compute the approximate pool for texture replacements from the dedicated video memory.
         const uint64_t MinimumTexturePoolSize = 512 * 1024 * 1024;
         uint64_t texturePoolSize = std::max((deviceDescription.dedicatedVideoMemory * 2) / 3, MinimumTexturePoolSize);
         textureCache->setReplacementPoolMaxSize(texturePoolSize);
 
+        // Textures decoded from TMEM get their own smaller budget out of the remaining video memory.
+        const uint64_t MinimumTextureMapSize = 128 * 1024 * 1024;
+        textureCache->setTextureMapMaxSize(std::max(deviceDescription.dedicatedVideoMemory / 8, MinimumTextureMapSize));
+
 #   if RT_ENABLED
         // Create the blue noise texture, upload it and wait for it to finish.
         std::unique_ptr<RenderBuffer> blueNoiseUploadBuffer;
@@ -397,6 +416,7 @@ namespace RT64 {
 
         WorkloadQueue::External workloadExt;
         workloadExt.device = device.get();
+        workloadExt.jobSystem = jobSystem.get();
         workloadExt.workloadGraphicsWorker = workloadGraphicsWorker.get();
         workloadExt.workloadExtrasUploader = workloadExtrasUploader.get();
         workloadExt.workloadVelocityUploader = workloadVelocityUploader.get();
@@ -430,6 +450,7 @@ namespace RT64 {
         stateExt.appWindow = appWindow.get();
         stateExt.interpreter = interpreter.get();
         stateExt.device = device.get();
+        stateExt.jobSystem = jobSystem.get();
         stateExt.swapChain = swapChain.get();
         stateExt.framebufferGraphicsWorker = framebufferGraphicsWorker.get();
         stateExt.shaderLibrary = shaderLibrary.get();
@@ -692,6 +713,7 @@ namespace RT64 {
         blueNoiseTexture.texture.reset();
 #   endif
         textureCache.reset();
+        jobSystem.reset();
         framebufferGraphicsWorker.reset();
         textureDirectWorker.reset();
         textureCopyWorker.reset();
@@ -11,6 +11,7 @@
 #include "common/rt64_emulator_configuration.h"
 #include "common/rt64_enhancement_configuration.h"
 #include "common/rt64_elapsed_timer.h"
+#include "common/rt64_job_system.h"
 #include "common/rt64_profiling_timer.h"
 #include "common/rt64_user_paths.h"
 #include "shared/rt64_point_light.h"
@@ -115,6 +116,7 @@ namespace RT64 {
         std::unique_ptr<ApplicationWindow> appWindow;
         std::unique_ptr<RenderDevice> device;
         std::unique_ptr<RenderSwapChain> swapChain;
+        std::unique_ptr<JobSystem> jobSystem;
         std::unique_ptr<RenderWorker> framebufferGraphicsWorker;
         std::unique_ptr<BufferUploader> drawDataUploader;
         std::unique_ptr<BufferUploader> transformsUploader;
@@ -0,0 +1,110 @@
+//
+// RT64
+//
+
+#include "rt64_dynamic_resolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace RT64 {
+    // Weight of every new sample in the moving average of the GPU time.
+    static const double GpuTimeSmoothing = 0.25;
+
+    // The multiplier is lowered when the GPU time goes above this fraction of the target.
+    static const double DecreaseUsage = 0.95;
+
+    // The multiplier is raised when the GPU time at the next step is estimated to be below this fraction of the target.
+    static const double IncreaseUsage = 0.8;
+
+    // Consecutive frames required before the multiplier is lowered or raised.
+    static const uint32_t DecreaseThreshold = 3;
+    static const uint32_t IncreaseThreshold = 90;
+
+    // Frames ignored after a change. The GPU time is only available a few frames after the frame was submitted.
+    static const uint32_t SettleFrames = 4;
+
+    // DynamicResolution
+
+    const double DynamicResolution::StepSize = 0.25;
+
+    void DynamicResolution::setBounds(double minMultiplier, double maxMultiplier) {
+        const double newMin = std::max(quantize(minMultiplier), StepSize);
+        const double newMax = std::max(quantize(maxMultiplier), newMin);
+        if ((newMin != this->minMultiplier) || (newMax != this->maxMultiplier)) {
+            this->minMultiplier = newMin;
+            this->maxMultiplier = newMax;
+            reset();
+        }
+    }
+
+    void DynamicResolution::reset() {
+        multiplier = maxMultiplier;
+        gpuTimeMs = 0.0;
+        gpuTimeValid = false;
+        overBudgetCount = 0;
+        underBudgetCount = 0;
+        settleCount = SettleFrames;
+    }
+
+    double DynamicResolution::update(double frameGpuTimeMs, double targetTimeMs) {
+        if (settleCount > 0) {
+            settleCount--;
+            return multiplier;
+        }
+
+        if ((frameGpuTimeMs <= 0.0) || (targetTimeMs <= 0.0)) {
+            return multiplier;
+        }
+
+        if (!gpuTimeValid) {
+            gpuTimeMs = frameGpuTimeMs;
+            gpuTimeValid = true;
+        }
+        else {
+            gpuTimeMs += (frameGpuTimeMs - gpuTimeMs) * GpuTimeSmoothing;
+        }
+
+        // The cost of the frame is assumed to scale with the amount of pixels, which grows with the square of the multiplier.
+        auto estimateTime = [this](double newMultiplier) {
+            const double ratio = newMultiplier / multiplier;
+            return gpuTimeMs * ratio * ratio;
+        };
+
+        double newMultiplier = multiplier;
+        if ((gpuTimeMs > (targetTimeMs * DecreaseUsage)) && (multiplier > minMultiplier)) {
+            underBudgetCount = 0;
+            overBudgetCount++;
+            if (overBudgetCount >= DecreaseThreshold) {
+                // Jump straight to the multiplier that is estimated to fit, but always go down by at least one step.
+                const double fitMultiplier = std::floor((multiplier * std::sqrt((targetTimeMs * DecreaseUsage) / gpuTimeMs)) / StepSize) * StepSize;
+                newMultiplier = std::clamp(std::min(fitMultiplier, multiplier - StepSize), minMultiplier, maxMultiplier);
+            }
+        }
+        else if ((multiplier < maxMultiplier) && (estimateTime(multiplier + StepSize) < (targetTimeMs * IncreaseUsage))) {
+            overBudgetCount = 0;
+            underBudgetCount++;
+            if (underBudgetCount >= IncreaseThreshold) {
+                newMultiplier = std::min(multiplier + StepSize, maxMultiplier);
+            }
+        }
+        else {
+            overBudgetCount = 0;
+            underBudgetCount = 0;
+        }
+
+        if (newMultiplier != multiplier) {
+            gpuTimeMs = estimateTime(newMultiplier);
+            multiplier = newMultiplier;
+            overBudgetCount = 0;
+            underBudgetCount = 0;
+            settleCount = SettleFrames;
+        }
+
+        return multiplier;
+    }
+
+    double DynamicResolution::quantize(double value) const {
+        return std::round(value / StepSize) * StepSize;
+    }
+};
@@ -0,0 +1,29 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include <cstdint>
+
+namespace RT64 {
+    // Picks the resolution multiplier for every frame so the GPU time stays under a target. The multiplier is always
+    // a multiple of the step size within the bounds, so the sizes of the render targets only take a few distinct values.
+    struct DynamicResolution {
+        static const double StepSize;
+
+        double minMultiplier = 1.0;
+        double maxMultiplier = 1.0;
+        double multiplier = 1.0;
+        double gpuTimeMs = 0.0;
+        bool gpuTimeValid = false;
+        uint32_t overBudgetCount = 0;
+        uint32_t underBudgetCount = 0;
+        uint32_t settleCount = 0;
+
+        void setBounds(double minMultiplier, double maxMultiplier);
+        void reset();
+        double update(double frameGpuTimeMs, double targetTimeMs);
+        double quantize(double value) const;
+    };
+};
@@ -2,6 +2,9 @@
 // RT64
 //
 
+#include <algorithm>
+#include <cstring>
+
 #include "common/rt64_math.h"
 
 #include "rt64_game_frame.h"
@@ -298,20 +301,19 @@ namespace RT64 {
 
             // Match the transforms linearly in the order they were submitted.
             ModifiedBuffers modifiedBuffers;
-            auto curIt = curWorkload.transformIdMap.begin();
-            auto prevIt = prevWorkload.transformIdMap.begin();
-            bool modifiedVelocityBuffer = false;
-            while ((curIt != curWorkload.transformIdMap.end()) && (prevIt != prevWorkload.transformIdMap.end())) {
-                if (curIt->first < prevIt->first) {
-                    curIt++;
-                }
-                else if (curIt->first > prevIt->first) {
-                    prevIt++;
+            const FlatMultiMap<uint32_t, uint32_t> &curIdMap = curWorkload.transformIdMap;
+            const FlatMultiMap<uint32_t, uint32_t> &prevIdMap = prevWorkload.transformIdMap;
+            for (const auto &curSlot : curIdMap.slots) {
+                if (curSlot.first == curIdMap.End) {
+                    continue;
                 }
-                else {
-                    matchTransform(curWorkload, prevWorkload, curWorkloadMap, prevWorkloadMap, curIt->second, prevIt->second, modifiedBuffers);
-                    curIt++;
-                    prevIt++;
+
+                uint32_t curEntry = curSlot.first;
+                uint32_t prevEntry = prevIdMap.first(curSlot.key);
+                while ((curEntry != curIdMap.End) && (prevEntry != prevIdMap.End)) {
+                    matchTransform(curWorkload, prevWorkload, curWorkloadMap, prevWorkloadMap, curIdMap.entries[curEntry].value, prevIdMap.entries[prevEntry].value, modifiedBuffers);
+                    curEntry = curIdMap.entries[curEntry].next;
+                    prevEntry = prevIdMap.entries[prevEntry].next;
                 }
             }
 
@@ -325,6 +327,7 @@ namespace RT64 {
                 curTransformMap.rigidBody = RigidBody();
                 curTransformMap.prevTransformIndex = 0;
                 curTransformMap.mapped = false;
+                curTransformMap.varying = false;
             }
         }
 
@@ -375,6 +378,13 @@ namespace RT64 {
         matchScenes(perspectiveScenes, prevFrame.perspectiveScenes);
         matchScenes(orthographicScenes, prevFrame.orthographicScenes);
 
+        for (uint32_t w : workloads) {
+            GameFrameMap::WorkloadMap &workloadMap = frameMap.workloads[w];
+            if (workloadMap.mapped) {
+                countVaryingMaps(workloadMap);
+            }
+        }
+
         if (!workloadsModified.empty()) {
             thread_local std::vector<BufferUploader::Upload> uploads;
             uploads.clear();
@@ -403,8 +413,8 @@ namespace RT64 {
             return;
         }
 
-        thread_local std::multimap<uint64_t, GameCallMap> curCallHashMap;
-        thread_local std::multimap<uint64_t, GameCallMap> prevCallHashMap;
+        thread_local FlatMultiMap<uint64_t, GameCallMap> curCallHashMap;
+        thread_local FlatMultiMap<uint64_t, GameCallMap> prevCallHashMap;
         curCallHashMap.clear();
         prevCallHashMap.clear();
 
@@ -518,22 +528,23 @@ namespace RT64 {
         lookAtCheckSet.clear();
 
         // Traverse the map and fill the set with all the combinations of transforms to check.
-        for (std::pair<uint64_t, GameCallMap> curIt : curCallHashMap) {
-            auto prevRange = prevCallHashMap.equal_range(curIt.first);
-            for (auto prevIt = prevRange.first; prevIt != prevRange.second; prevIt++) {
-                const GameIndices::Projection &curProjIndices = curScene.projections[curIt.second.sceneProjIndex];
+        for (const auto &curEntry : curCallHashMap.entries) {
+            for (uint32_t prevEntry = prevCallHashMap.first(curEntry.key); prevEntry != prevCallHashMap.End; prevEntry = prevCallHashMap.entries[prevEntry].next) {
+                const GameCallMap &curCallMap = curEntry.value;
+                const GameCallMap &prevCallMap = prevCallHashMap.entries[prevEntry].value;
+                const GameIndices::Projection &curProjIndices = curScene.projections[curCallMap.sceneProjIndex];
                 const Workload &curWorkload = workloadQueue.workloads[curProjIndices.workloadIndex];
                 const FramebufferPair &curFbPair = curWorkload.fbPairs[curProjIndices.fbPairIndex];
                 const Projection &curProj = curFbPair.projections[curProjIndices.projectionIndex];
-                const GameCall &curCall = curProj.gameCalls[curIt.second.callIndex];
-                const GameIndices::Projection &prevProjIndices = prevScene.projections[prevIt->second.sceneProjIndex];
+                const GameCall &curCall = curProj.gameCalls[curCallMap.callIndex];
+                const GameIndices::Projection &prevProjIndices = prevScene.projections[prevCallMap.sceneProjIndex];
                 const Workload &prevWorkload = workloadQueue.workloads[prevProjIndices.workloadIndex];
                 const FramebufferPair &prevFbPair = prevWorkload.fbPairs[prevProjIndices.fbPairIndex];
                 const Projection &prevProj = prevFbPair.projections[prevProjIndices.projectionIndex];
-                const GameCall &prevCall = prevProj.gameCalls[prevIt->second.callIndex];
+                const GameCall &prevCall = prevProj.gameCalls[prevCallMap.callIndex];
                 const uint32_t curWorldMatrixCount = (curCall.callDesc.maxWorldMatrix - curCall.callDesc.minWorldMatrix) + 1;
                 const uint32_t prevWorldMatrixCount = (prevCall.callDesc.maxWorldMatrix - prevCall.callDesc.minWorldMatrix) + 1;
-                if ((curWorldMatrixCount == prevWorldMatrixCount) && curIt.second.doTransformMatching && prevIt->second.doTransformMatching) {
+                if ((curWorldMatrixCount == prevWorldMatrixCount) && curCallMap.doTransformMatching && prevCallMap.doTransformMatching) {
                     for (uint32_t w = 0; w < curWorldMatrixCount; w++) {
                         const uint32_t curWorldMatrix = curCall.callDesc.minWorldMatrix + w;
                         const uint32_t curGroupIndex = curWorkload.drawData.worldTransformGroups[curWorldMatrix];
@@ -547,11 +558,11 @@ namespace RT64 {
                     }
                 }
 
-                if ((curCall.callDesc.tileCount == prevCall.callDesc.tileCount) && (curIt.second.doTileInterpolation && prevIt->second.doTileInterpolation)) {
+                if ((curCall.callDesc.tileCount == prevCall.callDesc.tileCount) && (curCallMap.doTileInterpolation && prevCallMap.doTileInterpolation)) {
                     for (uint32_t t = 0; t < curCall.callDesc.tileCount; t++) {
                         const DrawCallTile &curCallTile = curWorkload.drawData.callTiles[curCall.callDesc.tileIndex + t];
                         const DrawCallTile &prevCallTile = prevWorkload.drawData.callTiles[prevCall.callDesc.tileIndex + t];
-                        bool doTileMatching = curIt.second.doTileMatching && prevIt->second.doTileMatching;
+                        bool doTileMatching = curCallMap.doTileMatching && prevCallMap.doTileMatching;
                         if (doTileMatching && (curCallTile.tmemHashOrID != prevCallTile.tmemHashOrID)) {
                             continue;
                         }
@@ -678,6 +689,7 @@ namespace RT64 {
             curTileMap.deltaLrs = wrappedLrs || (abs(deltaLrs) >= curTile.masks * 2) ? curTileMap.deltaLrs : deltaLrs;
             curTileMap.deltaLrt = wrappedLrt || (abs(deltaLrt) >= curTile.maskt * 2) ? curTileMap.deltaLrt : deltaLrt;
             curTileMap.mapped = true;
+            curTileMap.varying = (curTileMap.deltaUls != 0.0f) || (curTileMap.deltaUlt != 0.0f) || (curTileMap.deltaLrs != 0.0f) || (curTileMap.deltaLrt != 0.0f);
             firstCurWorkloadMap.prevTilesMapped[indices.second] = true;
             tileInterpolationUsed = tileInterpolationUsed || tileScrolled;
         }
@@ -704,6 +716,7 @@ namespace RT64 {
             curLookAtMap.mapped = true;
             curLookAtMap.deltaX = hlslpp::float3(curLookAt.x) - hlslpp::float3(prevLookAt.x);
             curLookAtMap.deltaY = hlslpp::float3(curLookAt.y) - hlslpp::float3(prevLookAt.y);
+            curLookAtMap.varying = (memcmp(&curLookAt, &prevLookAt, sizeof(interop::RSPLookAt)) != 0);
             firstCurWorkloadMap.prevLookAtMapped[indices.second] = true;
             lookAtInterpolationUsed = lookAtInterpolationUsed || lookAtMoved;
         }
@@ -725,6 +738,7 @@ namespace RT64 {
         curTransformMap.rigidBody.updateDecomposition(curTransform, curGroup.decompose);
         curTransformMap.prevTransformIndex = prevTransformIndex;
         curTransformMap.mapped = true;
+        curTransformMap.varying = (memcmp(&curTransform, &prevTransform, sizeof(hlslpp::float4x4)) != 0);
         curWorkloadMap.prevTransformsMapped[prevTransformIndex] = true;
 
         uint64_t curVertexHash = 0;
@@ -751,6 +765,7 @@ namespace RT64 {
                 }
 
                 modifiedBuffers.positionVelocity = true;
+                curTransformMap.varying = true;
             }
         }
 
@@ -778,13 +793,25 @@ namespace RT64 {
                         curVelFloatsRef[i * 2 + 1] -= lround(curVelFloatsRef[i * 2 + 1] / WrappingModulo[1]) * WrappingModulo[1];
                     }
                 }
+
+                curTransformMap.varying = true;
             }
 
             modifiedBuffers.texcoordVelocity = true;
         }
     }
     
-    void GameFrame::buildCallHashMap(uint32_t sceneProjIndex, const Workload &workload, const Projection &proj, std::multimap<uint64_t, GameCallMap> &hashMap) const {
+    void GameFrame::countVaryingMaps(GameFrameMap::WorkloadMap &workloadMap) const {
+        auto countVarying = [](const auto &maps) {
+            return uint32_t(std::count_if(maps.begin(), maps.end(), [](const auto &map) { return map.varying; }));
+        };
+
+        workloadMap.varyingTransformCount = countVarying(workloadMap.transforms);
+        workloadMap.varyingTileCount = countVarying(workloadMap.tiles);
+        workloadMap.varyingLookAtCount = countVarying(workloadMap.lookAt);
+    }
+
+    void GameFrame::buildCallHashMap(uint32_t sceneProjIndex, const Workload &workload, const Projection &proj, FlatMultiMap<uint64_t, GameCallMap> &hashMap) const {
         for (uint32_t c = 0; c < proj.gameCallCount; c++) {
             const GameCall &call = proj.gameCalls[c];
             uint32_t matrixIdHash = 0;
@@ -806,7 +833,7 @@ namespace RT64 {
         }
     }
 
-    void GameFrame::buildTransformIdMap(const Workload &workload, std::multimap<uint32_t, uint32_t> &idMap, std::vector<uint32_t> &ignoredIdVector) const {
+    void GameFrame::buildTransformIdMap(const Workload &workload, FlatMultiMap<uint32_t, uint32_t> &idMap, std::vector<uint32_t> &ignoredIdVector) const {
         idMap.clear();
         ignoredIdVector.clear();
 
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "common/rt64_flat_multimap.h"
 #include "preset/rt64_preset_scene.h"
 #include "render/rt64_buffer_uploader.h"
 
@@ -43,6 +44,7 @@ namespace RT64 {
     }
 
     struct GameFrameMap {
+        // Maps are varying when their interpolated result depends on the frame weights.
         struct ViewProjectionMap {
             RigidBody rigidBody;
             uint32_t prevTransformIndex = 0;
@@ -53,6 +55,7 @@ namespace RT64 {
             RigidBody rigidBody;
             uint32_t prevTransformIndex = 0;
             bool mapped = false;
+            bool varying = false;
         };
 
         struct TileMap {
@@ -65,12 +68,14 @@ namespace RT64 {
             float prevLrs = 0;
             float prevLrt = 0;
             bool mapped = false;
+            bool varying = false;
         };
 
         struct LookAtMap {
             hlslpp::float3 deltaX = {};
             hlslpp::float3 deltaY = {};
             bool mapped = false;
+            bool varying = false;
         };
 
         struct WorkloadMap {
@@ -82,6 +87,9 @@ namespace RT64 {
             std::vector<bool> prevTilesMapped;
             std::vector<bool> prevLookAtMapped;
             uint32_t prevWorkloadIndex = 0;
+            uint32_t varyingTransformCount = 0;
+            uint32_t varyingTileCount = 0;
+            uint32_t varyingLookAtCount = 0;
             bool mapped = false;
         };
 
@@ -128,8 +136,9 @@ namespace RT64 {
         void match(RenderWorker *worker, WorkloadQueue &workloadQueue, const GameFrame &prevFrame, BufferUploader *velocityUploader, bool &velocityUploaderUsed, bool &tileInterpolationUsed, bool &lookAtInterpolationUsed);
         void matchScene(WorkloadQueue &workloadQueue, const GameFrame &prevFrame, const GameScene &curScene, const GameScene &prevScene, std::unordered_map<uint32_t, ModifiedBuffers> &workloadsModified, bool &tileInterpolationUsed, bool &lookAtInterpolationUsed);
         void matchTransform(Workload &curWorkload, const Workload &prevWorkload, GameFrameMap::WorkloadMap &curWorkloadMap, const GameFrameMap::WorkloadMap *prevWorkloadMap, uint32_t curTransformIndex, uint32_t prevTransformIndex, ModifiedBuffers &modifiedBuffers);
-        void buildCallHashMap(uint32_t sceneProjIndex, const Workload &workload, const Projection &proj, std::multimap<uint64_t, GameCallMap> &hashMap) const;
-        void buildTransformIdMap(const Workload &workload, std::multimap<uint32_t, uint32_t> &idMap, std::vector<uint32_t> &ignoredIdVector) const;
+        void countVaryingMaps(GameFrameMap::WorkloadMap &workloadMap) const;
+        void buildCallHashMap(uint32_t sceneProjIndex, const Workload &workload, const Projection &proj, FlatMultiMap<uint64_t, GameCallMap> &hashMap) const;
+        void buildTransformIdMap(const Workload &workload, FlatMultiMap<uint32_t, uint32_t> &idMap, std::vector<uint32_t> &ignoredIdVector) const;
         uint64_t hashFromCall(const GameCall &call, uint32_t matrixIdHash) const;
         bool isDebuggerCameraEnabled(const WorkloadQueue &workloadQueue);
     };
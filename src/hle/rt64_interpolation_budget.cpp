@@ -0,0 +1,87 @@
+//
+// RT64
+//
+
+#include "rt64_interpolation_budget.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace RT64 {
+    // Weight of every new sample in the moving average of the frame cost.
+    static const double FrameCostSmoothing = 0.2;
+
+    // Fraction of the logical frame's time window the rendered frames are allowed to use.
+    static const double BudgetUsage = 0.9;
+
+    // Fraction of the time window one extra frame must fit in before the limit is raised.
+    static const double IncreaseUsage = 0.7;
+
+    // Consecutive logical frames required before the limit is lowered or raised.
+    static const uint32_t DecreaseThreshold = 2;
+    static const uint32_t IncreaseThreshold = 60;
+
+    // InterpolationBudget
+
+    void InterpolationBudget::reset() {
+        frameCostMs = 0.0;
+        frameCostValid = false;
+        frameLimit = 0;
+        overBudgetCount = 0;
+        underBudgetCount = 0;
+    }
+
+    void InterpolationBudget::addFrameCost(double costMs) {
+        if (!frameCostValid) {
+            frameCostMs = costMs;
+            frameCostValid = true;
+        }
+        else {
+            frameCostMs += (costMs - frameCostMs) * FrameCostSmoothing;
+        }
+    }
+
+    uint32_t InterpolationBudget::update(uint32_t displayFrames, double windowMs) {
+        if (!frameCostValid || (frameCostMs <= 0.0) || (windowMs <= 0.0) || (displayFrames <= 1)) {
+            return displayFrames;
+        }
+
+        // A limit of zero means the renderer is not limited.
+        const uint32_t currentLimit = (frameLimit > 0) ? std::min(frameLimit, displayFrames) : displayFrames;
+        const uint32_t affordableFrames = std::max(uint32_t(std::floor((windowMs * BudgetUsage) / frameCostMs)), 1U);
+        if (affordableFrames < currentLimit) {
+            underBudgetCount = 0;
+            overBudgetCount++;
+            if (overBudgetCount >= DecreaseThreshold) {
+                frameLimit = affordableFrames;
+                overBudgetCount = 0;
+            }
+        }
+        else if ((frameLimit > 0) && ((frameCostMs * (currentLimit + 1)) < (windowMs * IncreaseUsage))) {
+            overBudgetCount = 0;
+            underBudgetCount++;
+            if (underBudgetCount >= IncreaseThreshold) {
+                frameLimit = (currentLimit + 1 >= displayFrames) ? 0 : (currentLimit + 1);
+                underBudgetCount = 0;
+            }
+        }
+        else {
+            overBudgetCount = 0;
+            underBudgetCount = 0;
+        }
+
+        return (frameLimit > 0) ? std::min(frameLimit, displayFrames) : displayFrames;
+    }
+
+    bool InterpolationBudget::renderFrame(uint32_t frame, uint32_t displayFrames, uint32_t budgetFrames) {
+        // The first frame is always rendered. The rest of the budget is spread evenly across the intermediate frames,
+        // always including the last one so the interpolation still reaches the current logical frame.
+        if ((frame == 0) || (budgetFrames >= displayFrames)) {
+            return true;
+        }
+
+        const uint32_t intermediateFrames = displayFrames - 1;
+        const uint32_t intermediateBudget = budgetFrames - 1;
+        return ((frame * intermediateBudget) / intermediateFrames) > (((frame - 1) * intermediateBudget) / intermediateFrames);
+    }
+};
@@ -0,0 +1,25 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include <cstdint>
+
+namespace RT64 {
+    // Limits how many frames are rendered for every logical frame based on how long the recent frames took to render.
+    // The limit drops as soon as the renderer can't keep up and only goes back up after it has stayed comfortably under
+    // the budget for a while, so it doesn't oscillate between two values.
+    struct InterpolationBudget {
+        double frameCostMs = 0.0;
+        bool frameCostValid = false;
+        uint32_t frameLimit = 0;
+        uint32_t overBudgetCount = 0;
+        uint32_t underBudgetCount = 0;
+
+        void reset();
+        void addFrameCost(double costMs);
+        uint32_t update(uint32_t displayFrames, double windowMs);
+        static bool renderFrame(uint32_t frame, uint32_t displayFrames, uint32_t budgetFrames);
+    };
+};
@@ -103,6 +103,7 @@ namespace RT64 {
         UserConfiguration::Filtering filtering;
         uint32_t viOriginalRate;
         uint32_t targetRate;
+        uint32_t swapChainRate;
         {
             std::scoped_lock<std::mutex> configurationLock(ext.sharedResources->configurationMutex);
             resolutionScale = ext.sharedResources->resolutionScale;
@@ -112,6 +113,7 @@ namespace RT64 {
             filtering = ext.sharedResources->userConfig.filtering;
             viOriginalRate = ext.sharedResources->viOriginalRate;
             targetRate = ext.sharedResources->targetRate;
+            swapChainRate = ext.sharedResources->swapChainRate;
         }
 
         RenderTarget *colorTarget = nullptr;
@@ -127,6 +129,8 @@ namespace RT64 {
         
         // Perform any external write operations indicated by the event.
         if (!present.fbOperations.empty()) {
+            ext.sharedResources->externalTargetWrites++;
+
             const std::scoped_lock lock(screenFbChangePoolMutex);
             {
                 RenderWorkerExecution workerExecution(ext.presentGraphicsWorker);
@@ -389,17 +393,23 @@ namespace RT64 {
             }
 
             if (presentFrame && swapChainValid) {
-                // Wait until the approximate time the next present should be at the current intended rate.
-                if ((presentTimestamp != Timestamp()) && (targetRate > 0) && (targetRate > viOriginalRate)) {
-                    Timer::preciseSleepUntil(presentTimestamp + std::chrono::nanoseconds(1'000'000'000 / targetRate));
+                // Wait until the time the next present should be at the current intended rate.
+                if ((targetRate > 0) && (targetRate > viOriginalRate)) {
+                    frameLimiter.setTargetRate(targetRate);
+                    frameLimiter.wait();
+                }
+                else {
+                    frameLimiter.setTargetRate(0);
                 }
 
                 if (presentWaitEnabled) {
                     ext.swapChain->wait();
+
+                    // The wait returns once the previous frame is on screen, which gives the limiter a reference to align the next deadlines to.
+                    frameLimiter.setVblankReference(Timer::current(), swapChainRate);
                 }
 
                 RenderCommandSemaphore *waitSemaphore = drawSemaphores[swapChainIndex].get();
-                presentTimestamp = Timer::current();
                 swapChainValid = ext.swapChain->present(swapChainIndex, &waitSemaphore, 1);
                 presentProfiler.logAndRestart();
             }
@@ -432,6 +442,7 @@ namespace RT64 {
 
     void PresentQueue::threadLoop() {
         Thread::setCurrentThreadName("RT64 Present");
+        Thread::setCurrentThreadRole(Thread::Role::Present);
 
         // Create the semaphore the acquire method will use.
         acquiredSemaphore = ext.device->createCommandSemaphore();
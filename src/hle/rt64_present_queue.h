@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "common/rt64_frame_limiter.h"
 #include "common/rt64_profiling_timer.h"
 #include "gui/rt64_inspector.h"
 #include "render/rt64_vi_renderer.h"
@@ -54,7 +55,7 @@ namespace RT64 {
         std::unique_ptr<VIRenderer> viRenderer;
         std::unique_ptr<Inspector> inspector;
         ProfilingTimer presentProfiler = ProfilingTimer(120);
-        Timestamp presentTimestamp;
+        FrameLimiter frameLimiter;
         VIHistory viHistory;
         bool presentWaitEnabled = false;
 
@@ -84,20 +84,19 @@ namespace RT64 {
         }
         transformIndex = newTransformIndex;
         lerpDecompose = decompose;
+        updateLerpPrevTransform();
     }
 
     
-    hlslpp::float4x4 RigidBody::lerp(float weight, const hlslpp::float4x4& fallbackPrev, const hlslpp::float4x4& fallbackCur, bool slerp) const {
-        // Return a linear component-wise interpolation of the fallback matrices if decomposition is disabled or if either decomposition is invalid.
-        if (!lerpDecompose || !transforms[0].valid || !transforms[1].valid) {
-            return lerpMatrixComponents(fallbackPrev, fallbackCur, lerpTranslation, lerpRotation, lerpPerspective, weight);
-        }
-
+    void RigidBody::updateLerpPrevTransform() {
         const DecomposedTransform &prevTransform = transforms[transformIndex ^ 1];
-        DecomposedTransform prevTransformCopy = prevTransform;
         const DecomposedTransform &curTransform = transforms[transformIndex];
-        DecomposedTransform lerpedTransform;
-        
+        DecomposedTransform &prevTransformCopy = lerpPrevTransform;
+        prevTransformCopy = prevTransform;
+        if (!prevTransform.valid || !curTransform.valid) {
+            return;
+        }
+
         // When the coordinate system is flipped between transforms due to a different sign in the determinant, we bias the rotation and scale of the
         // previous transform to be similar to the new one by producing a transform that produces an equivalent matrix but with a rotation and scale
         // that are closer to what's intended. This is necessary to improve interpolation between objects that use mirroring in animations.
@@ -128,9 +127,17 @@ namespace RT64 {
                 prevTransformCopy.scale = hlslpp::float3(-prevTransform.scale.x, -prevTransform.scale.y, prevTransform.scale.z);
             }
         }
+    }
+
+    hlslpp::float4x4 RigidBody::lerp(float weight, const hlslpp::float4x4& fallbackPrev, const hlslpp::float4x4& fallbackCur, bool slerp) const {
+        // Return a linear component-wise interpolation of the fallback matrices if decomposition is disabled or if either decomposition is invalid.
+        if (!lerpDecompose || !transforms[0].valid || !transforms[1].valid) {
+            return lerpMatrixComponents(fallbackPrev, fallbackCur, lerpTranslation, lerpRotation, lerpPerspective, weight);
+        }
 
         // Lerp the two transforms.
-        lerpedTransform = lerpTransforms(prevTransformCopy, curTransform, weight, lerpTranslation, lerpRotation, lerpScale, lerpSkew, lerpPerspective, slerp);
+        const DecomposedTransform &curTransform = transforms[transformIndex];
+        const DecomposedTransform lerpedTransform = lerpTransforms(lerpPrevTransform, curTransform, weight, lerpTranslation, lerpRotation, lerpScale, lerpSkew, lerpPerspective, slerp);
 
         // Compose a matrix from the resultant transform.
         return recomposeMatrix(lerpedTransform.rotation, lerpedTransform.scale, lerpedTransform.skew, lerpedTransform.translation, lerpedTransform.perspective);
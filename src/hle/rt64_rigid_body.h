@@ -10,6 +10,10 @@
 namespace RT64 {
     struct RigidBody {
         DecomposedTransform transforms[2];
+
+        // Previous transform biased towards the coordinate system of the current one. Only depends on the decompositions, so it's computed
+        // once per update instead of once for every interpolated frame.
+        DecomposedTransform lerpPrevTransform;
         hlslpp::float3 linearVelocity = {};
         float angularVelocity = 0.0f;
         uint8_t transformIndex = 0;
@@ -35,6 +39,9 @@ namespace RT64 {
         // Decomposes the given matrix if specified and updates the tracked decomposed values.
         void updateDecomposition(const hlslpp::float4x4 &curTransform, bool decompose);
 
+        // Computes the previous transform used for interpolation from the decomposed transforms.
+        void updateLerpPrevTransform();
+
         // Lerps between the previous and current transform with the given weight and recomposes the result into a matrix.
         // Falls back to the provided matrix if decomposition has failed for either transform.
         hlslpp::float4x4 lerp(float weight, const hlslpp::float4x4& fallbackPrev, const hlslpp::float4x4& fallbackCur, bool slerp) const;
@@ -1209,9 +1209,9 @@ namespace RT64 {
             const int workloadCursor = state->ext.workloadQueue->writeCursor;
             Workload &workload = state->ext.workloadQueue->workloads[workloadCursor];
 
-            auto range = workload.physicalAddressTransformMap.equal_range(rdramAddress);
-            for (auto it = range.first; it != range.second; it++) {
-                uint32_t matrix_id = it->second;
+            const FlatMultiMap<uint32_t, uint32_t> &addressMap = workload.physicalAddressTransformMap;
+            for (uint32_t e = addressMap.first(rdramAddress); e != addressMap.End; e = addressMap.entries[e].next) {
+                uint32_t matrix_id = addressMap.entries[e].value;
                 if (proj && (matrix_id < workload.drawData.viewProjTransformGroups.size())) {
                     uint32_t groupIndex = workload.drawData.viewProjTransformGroups[matrix_id];
                     setGroupProperties(&workload.drawData.transformGroups[groupIndex], false);
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <mutex>
 
 #include "common/rt64_common.h"
@@ -47,6 +48,9 @@ namespace RT64 {
         RenderTargetManager renderTargetManager;
         std::mutex managerMutex;
 
+        // Incremented every time a target is written to outside of the workload queue.
+        std::atomic<uint32_t> externalTargetWrites = 0;
+
         // Workload to present state.
         uint32_t viOriginalRate = 0;
         std::vector<uint32_t> colorImageAddressVector;
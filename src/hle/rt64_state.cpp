@@ -70,7 +70,7 @@ namespace RT64 {
         this->ext = ext;
 
         rspProcessor = std::make_unique<RSPProcessor>(ext.device);
-        framebufferRenderer = std::make_unique<FramebufferRenderer>(ext.framebufferGraphicsWorker, false, ext.createdGraphicsAPI, ext.shaderLibrary);
+        framebufferRenderer = std::make_unique<FramebufferRenderer>(ext.framebufferGraphicsWorker, false, ext.createdGraphicsAPI, ext.shaderLibrary, ext.jobSystem);
         renderFramebufferManager = std::make_unique<RenderFramebufferManager>(ext.device);
 
         const RenderMultisampling multisampling = RasterShader::generateMultisamplingPattern(ext.userConfig->msaaSampleCount(), ext.device->getCapabilities().sampleLocations);
@@ -1747,6 +1747,7 @@ namespace RT64 {
         }
         
         // Advance the workload queue at the end of a full synchronization.
+        workload.computeLayoutFingerprint();
         advanceWorkload(workload, false);
         ext.workloadQueue->advanceToNextWorkload();
 
@@ -2075,11 +2076,21 @@ namespace RT64 {
                         ImGui::Text("You must restart the application for this change to be applied.");
                     }
 
-                    resConfigChanged = ImGui::Combo("Resolution Mode", reinterpret_cast<int *>(&userConfig.resolution), "Original\0Window Integer Scale\0Manual\0") || resConfigChanged;
+                    resConfigChanged = ImGui::Combo("Resolution Mode", reinterpret_cast<int *>(&userConfig.resolution), "Original\0Window Integer Scale\0Manual\0Dynamic\0") || resConfigChanged;
                     const bool manualResolution = (userConfig.resolution == UserConfiguration::Resolution::Manual);
                     if (manualResolution) {
                         resConfigChanged = ImGui::InputDouble("Resolution Multiplier", &userConfig.resolutionMultiplier) || resConfigChanged;
                     }
+
+                    const bool dynamicResolution = (userConfig.resolution == UserConfiguration::Resolution::Dynamic);
+                    if (dynamicResolution) {
+                        resConfigChanged = ImGui::InputDouble("Minimum Resolution Multiplier", &userConfig.dynamicResolutionMin) || resConfigChanged;
+                        resConfigChanged = ImGui::InputDouble("Maximum Resolution Multiplier", &userConfig.dynamicResolutionMax) || resConfigChanged;
+                        ext.sharedQueueResources->configurationMutex.lock();
+                        const float currentMultiplier = float(ext.sharedQueueResources->resolutionScale.y);
+                        ext.sharedQueueResources->configurationMutex.unlock();
+                        ImGui::Text("Current Resolution Multiplier: %.2f", currentMultiplier);
+                    }
                     
                     genConfigChanged = ImGui::InputInt("Downsample Multiplier", &userConfig.downsampleMultiplier) || genConfigChanged;
                     
@@ -2150,6 +2161,22 @@ namespace RT64 {
 
                     genConfigChanged = ImGui::Checkbox("Three-Point Filtering", &userConfig.threePointFiltering) || genConfigChanged;
                     genConfigChanged = ImGui::Checkbox("High Performance State", &userConfig.idleWorkActive) || genConfigChanged;
+
+                    if (ImGui::Checkbox("Transcode PNG Replacements", &userConfig.transcodeReplacements)) {
+                        ext.textureCache->setReplacementTranscoding(userConfig.transcodeReplacements);
+                        genConfigChanged = true;
+                    }
+
+                    // Store the thread affinity that was used during initialization the first time we check this.
+                    static UserConfiguration::ThreadAffinity configThreadAffinity = UserConfiguration::ThreadAffinity::OptionCount;
+                    if (configThreadAffinity == UserConfiguration::ThreadAffinity::OptionCount) {
+                        configThreadAffinity = userConfig.threadAffinity;
+                    }
+
+                    genConfigChanged = ImGui::Combo("Thread Affinity", reinterpret_cast<int *>(&userConfig.threadAffinity), "Disabled\0Automatic\0") || genConfigChanged;
+                    if (userConfig.threadAffinity != configThreadAffinity) {
+                        ImGui::Text("You must restart the application for this change to be applied.");
+                    }
                     
                     // Emulator configuration.
                     ImGui::NewLine();
@@ -2396,6 +2423,7 @@ namespace RT64 {
                         const double FrametimeLimit = 20.0;
                         const int Stride = static_cast<int>(sizeof(double));
                         const auto &presentProfiler = ext.presentQueue->presentProfiler;
+                        const auto &pacingProfiler = ext.presentQueue->frameLimiter.errorProfiler;
                         const auto &rendererCPUProfiler = ext.workloadQueue->rendererCPUProfiler;
                         const auto &rendererGPUProfiler = ext.workloadQueue->rendererGPUProfiler;
                         const auto &matchingProfiler = ext.workloadQueue->matchingProfiler;
@@ -2405,6 +2433,7 @@ namespace RT64 {
                         ImPlot::SetupAxisLimits(ImAxis_Y1, 0.0, FrametimeLimit);
                         ImPlot::SetupAxis(ImAxis_Y1, "ms", ImPlotAxisFlags_AutoFit);
                         ImPlot::PlotLine<double>("Present", presentProfiler.data(), static_cast<int>(presentProfiler.size()), 1.0, 0.0, ImPlotLineFlags_None, presentProfiler.index(), Stride);
+                        ImPlot::PlotLine<double>("Pacing Error", pacingProfiler.data(), static_cast<int>(pacingProfiler.size()), 1.0, 0.0, ImPlotLineFlags_None, pacingProfiler.index(), Stride);
                         ImPlot::PlotLine<double>("Renderer (CPU)", rendererCPUProfiler.data(), static_cast<int>(rendererCPUProfiler.size()), 1.0, 0.0, ImPlotLineFlags_None, rendererCPUProfiler.index(), Stride);
                         ImPlot::PlotLine<double>("Renderer (GPU)", rendererGPUProfiler.data(), static_cast<int>(rendererGPUProfiler.size()), 1.0, 0.0, ImPlotLineFlags_None, rendererGPUProfiler.index(), Stride);
                         ImPlot::PlotLine<double>("Matching", matchingProfiler.data(), static_cast<int>(matchingProfiler.size()), 1.0, 0.0, ImPlotLineFlags_None, matchingProfiler.index(), Stride);
@@ -2429,10 +2458,12 @@ namespace RT64 {
                         const double screenCpuProfilerAverage = screenCpuProfiler.average();
                         const double textureStreamAverage = ext.textureCache->getAverageStreamLoadTime() / 1000.0;
                         ImGui::Text("Average Present (OS): %fms (%.1f FPS)\n", averagePresent, 1000.0 / averagePresent);
+                        ImGui::Text("Average Pacing Error: %fms (%" PRIu64 " missed)\n", pacingProfiler.average(), ext.presentQueue->frameLimiter.missedDeadlines);
                         ImGui::Text("Average Renderer (CPU): %fms (%.1f FPS)\n", averageRendererCPU, 1000.0 / averageRendererCPU);
                         ImGui::Text("Average Renderer (GPU): %fms (%.1f FPS)\n", averageRendererGPU, 1000.0 / averageRendererGPU);
                         ImGui::Text("Average Matching (CPU): %fms (%.1f FPS)\n", averageMatching, 1000.0 / averageMatching);
                         ImGui::Text("Average Workload: %fms (%.1f FPS)\n", averageWorkload, 1000.0 / averageWorkload);
+                        ImGui::Text("Reused Workloads: %" PRIu64 "\n", ext.workloadQueue->reusedWorkloadCount.load());
                         ImGui::Text("Average Display List (API): %fms (%.1f FPS)\n", dlApiProfilerAverage, 1000.0 / dlApiProfilerAverage);
                         ImGui::Text("Average Display List (CPU): %fms (%.1f FPS)\n", dlCpuProfilerAverage, 1000.0 / dlCpuProfilerAverage);
                         ImGui::Text("Average Update Screen (API): %fms (%.1f FPS)\n", screenApiProfilerAverage, 1000.0 / screenApiProfilerAverage);
@@ -2447,6 +2478,11 @@ namespace RT64 {
                         ImGui::Text("Texture Pool Used: %.1f MB\n", double(poolUsed) / megabyteSize);
                         ImGui::Text("Texture Pool Cached: %.1f MB\n", double(poolCached) / megabyteSize);
                         ImGui::Text("Texture Pool Limit: %1.f MB\n", double(poolLimit) / megabyteSize);
+
+                        uint64_t textureMapUsed, textureMapLimit;
+                        ext.textureCache->getTextureMapStats(textureMapUsed, textureMapLimit);
+                        ImGui::Text("Texture Cache Used: %.1f MB\n", double(textureMapUsed) / megabyteSize);
+                        ImGui::Text("Texture Cache Limit: %1.f MB\n", double(textureMapLimit) / megabyteSize);
                         ImGui::Text("Average Texture Stream: %fms\n", textureStreamAverage);
                     }
 
@@ -44,6 +44,7 @@ namespace RT64 {
             ApplicationWindow *appWindow;
             Interpreter *interpreter;
             RenderDevice *device;
+            JobSystem *jobSystem;
             RenderSwapChain *swapChain;
             RenderWorker *framebufferGraphicsWorker;
             ShaderLibrary *shaderLibrary;
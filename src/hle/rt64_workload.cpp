@@ -4,6 +4,10 @@
 
 #include "rt64_workload.h"
 
+#include <algorithm>
+
+#include "xxHash/xxh3.h"
+
 namespace RT64 {
     // Common functions.
 
@@ -20,6 +24,8 @@ namespace RT64 {
         gameCallCount = 0;
         viOriginalRate = 0;
         workloadId = 0;
+        layoutFingerprint = 0;
+        fingerprint = 0;
         extended.testZIndexCount = 0;
         extended.ditherNoiseStrength = 1.0f;
 
@@ -285,6 +291,265 @@ namespace RT64 {
         nextDrawDataRange(r.triColorFloats);
     }
 
+    template<typename T>
+    static void hashValue(XXH3_state_t *state, const T &value) {
+        XXH3_64bits_update(state, &value, sizeof(T));
+    }
+
+    template<typename T>
+    static void hashVector(XXH3_state_t *state, const std::vector<T> &vector) {
+        hashValue(state, vector.size());
+        if (!vector.empty()) {
+            XXH3_64bits_update(state, vector.data(), vector.size() * sizeof(T));
+        }
+    }
+
+    // Structures with padding are hashed one field at a time, as the contents of the padding bytes are undefined.
+
+    static void hashLoadTile(XXH3_state_t *state, const LoadTile &loadTile) {
+        hashValue(state, loadTile.fmt);
+        hashValue(state, loadTile.siz);
+        hashValue(state, loadTile.line);
+        hashValue(state, loadTile.tmem);
+        hashValue(state, loadTile.palette);
+        hashValue(state, loadTile.cms);
+        hashValue(state, loadTile.cmt);
+        hashValue(state, loadTile.masks);
+        hashValue(state, loadTile.maskt);
+        hashValue(state, loadTile.shifts);
+        hashValue(state, loadTile.shiftt);
+        hashValue(state, loadTile.uls);
+        hashValue(state, loadTile.ult);
+        hashValue(state, loadTile.lrs);
+        hashValue(state, loadTile.lrt);
+    }
+
+    static void hashCallTiles(XXH3_state_t *state, const std::vector<DrawCallTile> &callTiles) {
+        hashValue(state, callTiles.size());
+        for (const DrawCallTile &callTile : callTiles) {
+            hashLoadTile(state, callTile.loadTile);
+            hashValue(state, callTile.tmemHashOrID);
+            hashValue(state, callTile.sampleWidth);
+            hashValue(state, callTile.sampleHeight);
+            hashValue(state, callTile.lineWidth);
+            hashValue(state, callTile.tlut);
+            hashValue(state, callTile.minTexcoord);
+            hashValue(state, callTile.maxTexcoord);
+            hashValue(state, callTile.syncRequired);
+            hashValue(state, callTile.tileCopyUsed);
+            hashValue(state, callTile.tileCopyWidth);
+            hashValue(state, callTile.tileCopyHeight);
+            hashValue(state, callTile.reinterpretTile);
+            hashValue(state, callTile.reinterpretSiz);
+            hashValue(state, callTile.reinterpretFmt);
+            hashValue(state, callTile.rawTMEM);
+            hashValue(state, callTile.valid);
+        }
+    }
+
+    static void hashLoadOperations(XXH3_state_t *state, const std::vector<LoadOperation> &loadOperations) {
+        hashValue(state, loadOperations.size());
+        for (const LoadOperation &loadOp : loadOperations) {
+            hashValue(state, loadOp.type);
+            hashLoadTile(state, loadOp.tile);
+            hashValue(state, loadOp.texture);
+            switch (loadOp.type) {
+            case LoadOperation::Type::Tile:
+                hashValue(state, loadOp.operationTile.tile);
+                hashValue(state, loadOp.operationTile.uls);
+                hashValue(state, loadOp.operationTile.ult);
+                hashValue(state, loadOp.operationTile.lrs);
+                hashValue(state, loadOp.operationTile.lrt);
+                break;
+            case LoadOperation::Type::Block:
+                hashValue(state, loadOp.operationBlock.tile);
+                hashValue(state, loadOp.operationBlock.uls);
+                hashValue(state, loadOp.operationBlock.ult);
+                hashValue(state, loadOp.operationBlock.lrs);
+                hashValue(state, loadOp.operationBlock.dxt);
+                break;
+            case LoadOperation::Type::TLUT:
+                hashValue(state, loadOp.operationTLUT.tile);
+                hashValue(state, loadOp.operationTLUT.uls);
+                hashValue(state, loadOp.operationTLUT.ult);
+                hashValue(state, loadOp.operationTLUT.lrs);
+                hashValue(state, loadOp.operationTLUT.lrt);
+                break;
+            }
+        }
+    }
+
+    static void hashDrawCall(XXH3_state_t *state, const DrawCall &callDesc) {
+        hashValue(state, callDesc.uid);
+        hashValue(state, callDesc.callIndex);
+        hashValue(state, callDesc.minWorldMatrix);
+        hashValue(state, callDesc.maxWorldMatrix);
+        hashValue(state, callDesc.triangleCount);
+        hashValue(state, callDesc.rect);
+        hashValue(state, callDesc.rectDsdx);
+        hashValue(state, callDesc.rectDtdy);
+        hashValue(state, callDesc.rectLeftOrigin);
+        hashValue(state, callDesc.rectRightOrigin);
+        hashValue(state, callDesc.scissorRect);
+        hashValue(state, callDesc.scissorMode);
+        hashValue(state, callDesc.scissorLeftOrigin);
+        hashValue(state, callDesc.scissorRightOrigin);
+        hashValue(state, callDesc.colorCombiner);
+        hashValue(state, callDesc.otherMode);
+        hashValue(state, callDesc.rdpParams);
+        hashValue(state, callDesc.fillColor);
+        hashValue(state, callDesc.tileIndex);
+        hashValue(state, callDesc.tileCount);
+        hashValue(state, callDesc.loadIndex);
+        hashValue(state, callDesc.loadCount);
+        hashValue(state, callDesc.textureOn);
+        hashValue(state, callDesc.textureTile);
+        hashValue(state, callDesc.textureLevels);
+        hashValue(state, callDesc.geometryMode);
+        hashValue(state, callDesc.objRenderMode);
+        hashValue(state, callDesc.cullBothMask);
+        hashValue(state, callDesc.shadingSmoothMask);
+        hashValue(state, callDesc.NoN);
+        hashValue(state, callDesc.extendedType);
+        if (callDesc.extendedType != DrawExtendedType::None) {
+            hashValue(state, callDesc.extendedData.vertexTestZ.vertexIndex);
+        }
+
+        hashValue(state, uint32_t(callDesc.extendedFlags.forceUpscale2D));
+        hashValue(state, uint32_t(callDesc.extendedFlags.forceTrueBilerp));
+        hashValue(state, uint32_t(callDesc.extendedFlags.forceScaleLOD));
+        hashValue(state, callDesc.extraParams);
+    }
+
+    void Workload::computeLayoutFingerprint() {
+        // The layout fingerprint only covers the structure of the workload and the hashes that were already computed for the shaders and
+        // the textures, so it's cheap enough to compute for every workload. Workloads that read from RDRAM or from the contents of other
+        // framebuffers are left without one.
+        layoutFingerprint = 0;
+        fingerprint = 0;
+        if (fbPairCount == 0) {
+            return;
+        }
+
+        for (uint32_t f = 0; f < fbPairCount; f++) {
+            const FramebufferPair &fbPair = fbPairs[f];
+            if (!fbPair.startFbOperations.empty() || !fbPair.endFbOperations.empty() || !fbPair.startFbDiscards.empty()) {
+                return;
+            }
+        }
+
+        for (const DrawCallTile &callTile : drawData.callTiles) {
+            if (callTile.tileCopyUsed || callTile.reinterpretTile) {
+                return;
+            }
+        }
+
+        // The addresses are left out so double buffered games can match the workload that rendered to the other buffer.
+        XXH3_state_t xxh3;
+        XXH3_state_t *state = &xxh3;
+        XXH3_64bits_reset(state);
+        for (uint32_t f = 0; f < fbPairCount; f++) {
+            const FramebufferPair &fbPair = fbPairs[f];
+            hashValue(state, fbPair.colorImage.fmt);
+            hashValue(state, fbPair.colorImage.siz);
+            hashValue(state, fbPair.colorImage.width);
+            hashValue(state, fbPair.depthRead);
+            hashValue(state, fbPair.depthWrite);
+            hashValue(state, fbPair.ditherPatterns);
+            hashValue(state, fbPair.scissorRect);
+            hashValue(state, fbPair.drawColorRect);
+            hashValue(state, fbPair.drawDepthRect);
+            hashValue(state, fbPair.projectionCount);
+            for (uint32_t p = 0; p < fbPair.projectionCount; p++) {
+                const Projection &proj = fbPair.projections[p];
+                hashValue(state, proj.type);
+                hashValue(state, proj.transformsIndex);
+                hashValue(state, proj.scissorRect);
+                hashValue(state, proj.gameCallCount);
+                for (uint32_t c = 0; c < proj.gameCallCount; c++) {
+                    const GameCall &gameCall = proj.gameCalls[c];
+                    hashDrawCall(state, gameCall.callDesc);
+                    hashValue(state, gameCall.shaderDesc.hash());
+                    hashValue(state, gameCall.meshDesc);
+                }
+
+                hashValue(state, proj.pointLightCount);
+            }
+        }
+
+        // Texture contents are represented by the hashes stored in the tiles.
+        const DrawData &d = drawData;
+        hashCallTiles(state, d.callTiles);
+        hashValue(state, d.posFloats.size());
+        hashValue(state, d.triPosFloats.size());
+        hashValue(state, d.worldTransforms.size());
+        hashValue(state, uint32_t(viFbSize[0]));
+        hashValue(state, uint32_t(viFbSize[1]));
+        hashValue(state, extended.testZIndexCount);
+        hashValue(state, extended.ditherNoiseStrength);
+        hashValue(state, float(extended.texcoordWrapPoint[0]));
+        hashValue(state, float(extended.texcoordWrapPoint[1]));
+
+        // Zero is reserved for workloads that can't be reused.
+        layoutFingerprint = std::max(XXH3_64bits_digest(state), uint64_t(1));
+    }
+
+    void Workload::computeFingerprint() {
+        // The fingerprint identifies workloads that will produce the exact same output as long as the targets they render to weren't
+        // modified since. Hashing the draw data is by far the most expensive part, so it should only be done for workloads whose layout
+        // already matches the one that rendered the targets.
+        fingerprint = 0;
+        if (layoutFingerprint == 0) {
+            return;
+        }
+
+        XXH3_state_t xxh3;
+        XXH3_state_t *state = &xxh3;
+        XXH3_64bits_reset(state);
+        hashValue(state, layoutFingerprint);
+        for (uint32_t f = 0; f < fbPairCount; f++) {
+            const FramebufferPair &fbPair = fbPairs[f];
+            hashValue(state, fbPair.colorImage.address);
+            hashValue(state, fbPair.depthImage.address);
+            for (uint32_t p = 0; p < fbPair.projectionCount; p++) {
+                const Projection &proj = fbPair.projections[p];
+                XXH3_64bits_update(state, proj.pointLights.data(), proj.pointLightCount * sizeof(interop::PointLight));
+            }
+        }
+
+        const DrawData &d = drawData;
+        hashVector(state, d.posFloats);
+        hashVector(state, d.tcFloats);
+        hashVector(state, d.normColBytes);
+        hashVector(state, d.viewProjIndices);
+        hashVector(state, d.worldIndices);
+        hashVector(state, d.fogIndices);
+        hashVector(state, d.lightIndices);
+        hashVector(state, d.lightCounts);
+        hashVector(state, d.lookAtIndices);
+        hashVector(state, d.faceIndices);
+        hashVector(state, d.modifyPosUints);
+        hashVector(state, d.rdpParams);
+        hashVector(state, d.extraParams);
+        hashVector(state, d.renderParams);
+        hashVector(state, d.viewTransforms);
+        hashVector(state, d.projTransforms);
+        hashVector(state, d.worldTransforms);
+        hashVector(state, d.rdpTiles);
+        hashVector(state, d.rspViewports);
+        hashVector(state, d.viewportClipRatios);
+        hashVector(state, d.viewportOrigins);
+        hashVector(state, d.rspFog);
+        hashVector(state, d.rspLights);
+        hashVector(state, d.rspLookAt);
+        hashLoadOperations(state, d.loadOperations);
+        hashVector(state, d.triPosFloats);
+        hashVector(state, d.triTcFloats);
+        hashVector(state, d.triColorFloats);
+        hashVector(state, pointLights);
+        fingerprint = std::max(XXH3_64bits_digest(state), uint64_t(1));
+    }
+
     void Workload::begin(uint64_t submissionFrame) {
         reset();
 
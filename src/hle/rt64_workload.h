@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "common/rt64_flat_multimap.h"
 #include "render/rt64_buffer_uploader.h"
 #include "shared/rt64_extra_params.h"
 #include "shared/rt64_gpu_tile.h"
@@ -228,11 +229,13 @@ namespace RT64 {
         hlslpp::uint2 viFbSize = {};
         DebuggerRenderer debuggerRenderer;
         DebuggerCamera debuggerCamera;
-        std::multimap<uint32_t, uint32_t> transformIdMap;
-        std::multimap<uint32_t, uint32_t> physicalAddressTransformMap;
+        FlatMultiMap<uint32_t, uint32_t> transformIdMap;
+        FlatMultiMap<uint32_t, uint32_t> physicalAddressTransformMap;
         std::vector<uint32_t> transformIgnoredIds;
         uint64_t workloadId = 0;
         uint64_t presentId = 0;
+        uint64_t layoutFingerprint = 0;
+        uint64_t fingerprint = 0;
         bool paused = false;
 
         struct {
@@ -250,6 +253,8 @@ namespace RT64 {
         void uploadDrawData(RenderWorker *worker, BufferUploader *bufferUploader);
         void updateOutputBuffers(RenderWorker *worker);
         void nextDrawDataRanges();
+        void computeLayoutFingerprint();
+        void computeFingerprint();
         void begin(uint64_t submissionFrame);
         bool addFramebufferPair(uint32_t colorAddress, uint8_t colorFmt, uint8_t colorSiz, uint16_t colorWidth, uint32_t depthAddress);
         int currentFramebufferPairIndex() const;
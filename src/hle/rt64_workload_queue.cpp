@@ -8,6 +8,8 @@
 
 #include "rt64_present_queue.h"
 
+#include "xxHash/xxh3.h"
+
 #define ENABLE_HIGH_RESOLUTION_RENDERER 1
 
 namespace RT64 {
@@ -20,17 +22,13 @@ namespace RT64 {
     WorkloadQueue::~WorkloadQueue() {
         threadsRunning = false;
         cursorCondition.notify_all();
-        idleCondition.notify_all();
 
         if (renderThread != nullptr) {
             renderThread->join();
             delete renderThread;
         }
 
-        if (idleThread != nullptr) {
-            idleThread->join();
-            delete idleThread;
-        }
+        idleCounter.wait();
 
         workloadIdCondition.notify_all();
     }
@@ -100,18 +98,17 @@ namespace RT64 {
 
         rspProcessor = std::make_unique<RSPProcessor>(ext.device);
         vertexProcessor = std::make_unique<VertexProcessor>(ext.device);
-        framebufferRenderer = std::make_unique<FramebufferRenderer>(ext.workloadGraphicsWorker, true, ext.createdGraphicsAPI, ext.shaderLibrary);
+        framebufferRenderer = std::make_unique<FramebufferRenderer>(ext.workloadGraphicsWorker, true, ext.createdGraphicsAPI, ext.shaderLibrary, ext.jobSystem);
         renderFramebufferManager = std::make_unique<RenderFramebufferManager>(ext.device);
         queryPool = ext.device->createQueryPool(2);
 
-        projectionProcessor.setup(ext.workloadGraphicsWorker);
-        transformProcessor.setup(ext.workloadGraphicsWorker);
-        tileProcessor.setup(ext.workloadGraphicsWorker);
-        lookAtProcessor.setup(ext.workloadGraphicsWorker);
+        projectionProcessor.setup(ext.workloadGraphicsWorker, ext.jobSystem);
+        transformProcessor.setup(ext.workloadGraphicsWorker, ext.jobSystem);
+        tileProcessor.setup(ext.workloadGraphicsWorker, ext.jobSystem);
+        lookAtProcessor.setup(ext.workloadGraphicsWorker, ext.jobSystem);
 
         threadsRunning = true;
         renderThread = new std::thread(&WorkloadQueue::renderThreadLoop, this);
-        idleThread = new std::thread(&WorkloadQueue::idleThreadLoop, this);
     }
 
     void WorkloadQueue::updateMultisampling() {
@@ -182,8 +179,33 @@ namespace RT64 {
             break;
         }
 
+        // Find the target refresh rate from the configuration.
+        const auto refreshRate = ext.sharedResources->userConfig.refreshRate;
+        switch (refreshRate) {
+        case UserConfiguration::RefreshRate::Display:
+            workloadConfig.targetRate = ext.sharedResources->swapChainRate;
+            break;
+        case UserConfiguration::RefreshRate::Manual:
+            workloadConfig.targetRate = ext.sharedResources->userConfig.refreshRateTarget;
+
+            // Limit the target rate to the rate detected by the swap chain.
+            if ((ext.sharedResources->swapChainRate > 0) && (workloadConfig.targetRate > ext.sharedResources->swapChainRate)) {
+                workloadConfig.targetRate = ext.sharedResources->swapChainRate;
+            }
+
+            break;
+        case UserConfiguration::RefreshRate::Original:
+        default:
+            workloadConfig.targetRate = 0;
+            break;
+        }
+
+        // Store the rate that was chosen for the configuration.
+        ext.sharedResources->targetRate = workloadConfig.targetRate;
+
         // Compute the resolution scaling to be used for the frame.
         float resolutionMultiplier;
+        float maxResolutionMultiplier = 0.0f;
         const auto resolutionMode = ext.sharedResources->userConfig.resolution;
         switch (resolutionMode) {
         case UserConfiguration::Resolution::WindowIntegerScale:
@@ -198,6 +220,15 @@ namespace RT64 {
         case UserConfiguration::Resolution::Manual:
             resolutionMultiplier = float(ext.sharedResources->userConfig.resolutionMultiplier);
             break;
+        case UserConfiguration::Resolution::Dynamic: {
+            // Every rendered frame must fit in the interval of the display rate when interpolating or the original rate otherwise.
+            const uint32_t frameRate = std::max(workloadConfig.targetRate, ext.sharedResources->viOriginalRate);
+            const double targetTimeMs = 1000.0 / double((frameRate > 0) ? frameRate : 60);
+            dynamicResolution.setBounds(ext.sharedResources->userConfig.dynamicResolutionMin, ext.sharedResources->userConfig.dynamicResolutionMax);
+            resolutionMultiplier = float(dynamicResolution.update(rendererGPUProfiler.latest(), targetTimeMs));
+            maxResolutionMultiplier = float(dynamicResolution.maxMultiplier);
+            break;
+        }
         case UserConfiguration::Resolution::Original:
         default:
             resolutionMultiplier = 1.0f;
@@ -209,33 +240,13 @@ namespace RT64 {
         // Build the resolution scale vector from the configuration.
         workloadConfig.aspectRatioScale = workloadConfig.aspectRatioTarget / workloadConfig.aspectRatioSource;
         workloadConfig.resolutionScale = { resolutionMultiplier * workloadConfig.aspectRatioScale, resolutionMultiplier };
+
+        // Targets are always allocated for the biggest multiplier the dynamic resolution can pick so they're never resized when it changes.
+        maxResolutionMultiplier = std::max(maxResolutionMultiplier, resolutionMultiplier);
+        workloadConfig.allocationResolutionScale = { maxResolutionMultiplier * workloadConfig.aspectRatioScale, maxResolutionMultiplier };
         workloadConfig.downsampleMultiplier = ext.sharedResources->userConfig.downsampleMultiplier;
         ext.sharedResources->resolutionScale = workloadConfig.resolutionScale;
 
-        // Find the target refresh rate from the configuration.
-        const auto refreshRate = ext.sharedResources->userConfig.refreshRate;
-        switch (refreshRate) {
-        case UserConfiguration::RefreshRate::Display:
-            workloadConfig.targetRate = ext.sharedResources->swapChainRate;
-            break;
-        case UserConfiguration::RefreshRate::Manual:
-            workloadConfig.targetRate = ext.sharedResources->userConfig.refreshRateTarget;
-
-            // Limit the target rate to the rate detected by the swap chain.
-            if ((ext.sharedResources->swapChainRate > 0) && (workloadConfig.targetRate > ext.sharedResources->swapChainRate)) {
-                workloadConfig.targetRate = ext.sharedResources->swapChainRate;
-            }
-
-            break;
-        case UserConfiguration::RefreshRate::Original:
-        default:
-            workloadConfig.targetRate = 0;
-            break;
-        }
-
-        // Store the rate that was chosen for the configuration.
-        ext.sharedResources->targetRate = workloadConfig.targetRate;
-
 #   if RT_ENABLED
         workloadConfig.raytracingEnabled = rtEnabled;
 
@@ -271,13 +282,22 @@ namespace RT64 {
             fbManager.destroyAllTileCopies();
             ext.sharedResources->fbConfigChanged = false;
             ext.sharedResources->interpolatedColorTargets.clear();
+            targetFingerprints.clear();
         }
 
         if (ext.sharedResources->userConfigChanged) {
+            targetFingerprints.clear();
+
+            bool scheduleIdle = false;
             idleMutex.lock();
             idleActive = ext.sharedResources->userConfig.idleWorkActive;
+            scheduleIdle = idleActive && !idleScheduled;
+            idleScheduled = idleScheduled || scheduleIdle;
             idleMutex.unlock();
-            idleCondition.notify_all();
+
+            if (scheduleIdle) {
+                ext.jobSystem->submit(JobSystem::Priority::Normal, [this]() { idleJob(); }, &idleCounter);
+            }
         }
     }
 
@@ -292,7 +312,7 @@ namespace RT64 {
     void WorkloadQueue::threadRenderFrame(GameFrame &curFrame, const GameFrame &prevFrame, const WorkloadConfiguration &workloadConfig,
         const DebuggerRenderer &debuggerRenderer, const DebuggerCamera &debuggerCamera, float curFrameWeight, float prevFrameWeight,
         float deltaTimeMs, RenderTargetKey overrideTargetKey, int32_t overrideTargetFbPairIndex, RenderTarget *overrideTarget,
-        uint32_t overrideTargetModifier, bool uploadVelocity, bool uploadExtras, bool interpolateTiles, bool interpolateLookAts)
+        uint32_t overrideTargetModifier, bool uploadVelocity, bool uploadExtras, bool interpolateTiles, bool interpolateLookAts, bool reuseStatic)
     {
 #   if ENABLE_HIGH_RESOLUTION_RENDERER
         std::scoped_lock<std::mutex> managerLock(ext.sharedResources->workloadMutex);
@@ -329,6 +349,7 @@ namespace RT64 {
             transformParams.prevFrame = &prevFrame;
             transformParams.curFrameWeight = curFrameWeight;
             transformParams.prevFrameWeight = prevFrameWeight;
+            transformParams.reuseStatic = reuseStatic;
             transformProcessor.process(transformParams);
             transformProcessor.upload(transformParams);
             uploadTransforms = true;
@@ -343,6 +364,7 @@ namespace RT64 {
             tileParams.prevFrame = &prevFrame;
             tileParams.curFrameWeight = curFrameWeight;
             tileParams.prevFrameWeight = prevFrameWeight;
+            tileParams.reuseStatic = reuseStatic;
             tileProcessor.process(tileParams);
             tileProcessor.upload(tileParams);
             uploadTiles = true;
@@ -357,6 +379,7 @@ namespace RT64 {
             lookAtParams.prevFrame = &prevFrame;
             lookAtParams.curFrameWeight = curFrameWeight;
             lookAtParams.prevFrameWeight = prevFrameWeight;
+            lookAtParams.reuseStatic = reuseStatic;
             lookAtProcessor.process(lookAtParams);
             lookAtProcessor.upload(lookAtParams);
             uploadLookAts = true;
@@ -414,6 +437,7 @@ namespace RT64 {
             RenderTarget *colorTarget;
             RenderTarget *depthTarget;
             RenderFramebufferKey fbKey;
+            bool targetScaleChanged;
             auto getTargetsFromPair = [&](uint32_t f) {
                 const FramebufferPair &fbPair = workload.fbPairs[f];
                 const auto &colorImg = fbPair.colorImage;
@@ -428,8 +452,10 @@ namespace RT64 {
                     // When the target is much bigger than the reference height, we reduce the resolution scaling (but clamped to 1.0).
                     const uint32_t heightThreshold = (workload.viFbSize[1] > 0) ? ((workload.viFbSize[1] * 3) / 2) : 360;
                     uint32_t downsampleMultiplier = workloadConfig.downsampleMultiplier;
+                    hlslpp::float2 allocationResScale = workloadConfig.allocationResolutionScale;
                     if ((nativeColorHeight >= heightThreshold) && (fixedResScale[1] >= 2.0f)) {
                         fixedResScale = hlslpp::max(fixedResScale / 2.0f, hlslpp::float2(1.0f, 1.0f));
+                        allocationResScale = hlslpp::max(allocationResScale / 2.0f, hlslpp::float2(1.0f, 1.0f));
                         downsampleMultiplier = std::max(downsampleMultiplier / 2U, 1U);
                     }
 
@@ -468,11 +494,21 @@ namespace RT64 {
                     rtWidth = targetWidth;
                     rtHeight = targetHeight;
 
+                    if (allocationResScale[1] > fixedResScale[1]) {
+                        uint32_t allocationWidth, allocationHeight, allocationMisalignX;
+                        allocationResScale = RenderTarget::computeFixedResolutionScale(colorImg.width, allocationResScale);
+                        RenderTarget::computeScaledSize(nativeColorWidth, nativeColorHeight, allocationResScale, allocationWidth, allocationHeight, allocationMisalignX);
+                        rtWidth = std::max(rtWidth, allocationWidth);
+                        rtHeight = std::max(rtHeight, allocationHeight);
+                    }
+
                     // The desired size should not be less than the existing size of the color and depth targets.
                     RenderTarget *chosenRt = nullptr;
+                    targetScaleChanged = false;
                     if (depthFb != nullptr) {
                         fbKey.depthTargetKey = RenderTargetKey(depthFb->addressStart, depthFb->width, depthFb->siz, Framebuffer::Type::Depth);
                         depthTarget = &targetManager.get(fbKey.depthTargetKey);
+                        targetScaleChanged = !depthTarget->isEmpty() && ((depthTarget->resolutionScale[0] != fixedResScale[0]) || (depthTarget->resolutionScale[1] != fixedResScale[1]));
                         depthTarget->resolutionScale = fixedResScale;
                         rtWidth = std::max(rtWidth, depthTarget->width);
                         rtHeight = std::max(rtHeight, depthTarget->height);
@@ -483,6 +519,7 @@ namespace RT64 {
                     }
 
                     if (colorTarget != nullptr) {
+                        targetScaleChanged = targetScaleChanged || (!colorTarget->isEmpty() && ((colorTarget->resolutionScale[0] != fixedResScale[0]) || (colorTarget->resolutionScale[1] != fixedResScale[1])));
                         rtWidth = std::max(rtWidth, colorTarget->width);
                         rtHeight = std::max(rtHeight, colorTarget->height);
                         chosenRt = colorTarget;
@@ -568,6 +605,18 @@ namespace RT64 {
                             depthFb->readHeight = 0;
                         }
                     }
+
+                    // The dynamic resolution renders into a smaller or bigger region of the same targets when it changes the scale. The contents
+                    // rendered at the previous scale are read again from RDRAM at the new one instead of discarding the targets.
+                    if (targetScaleChanged) {
+                        if (colorFb != nullptr) {
+                            colorFb->readHeight = 0;
+                        }
+
+                        if (depthFb != nullptr) {
+                            depthFb->readHeight = 0;
+                        }
+                    }
                 }
 
                 fbManager.setupOperations(ext.workloadGraphicsWorker, fbPair.startFbOperations, fixedResScale, targetManager, &resizedTargets);
@@ -878,8 +927,139 @@ namespace RT64 {
         workloadIdCondition.notify_all();
     }
 
+    void WorkloadQueue::threadComputeTargetFingerprints(const Workload &workload, bool reusable, std::unordered_map<uint32_t, uint64_t> &fingerprints) const {
+        // Every target written by the workload is tagged with the fingerprint and the framebuffer pair that wrote to it last. The tag is only
+        // valid if the contents of the target don't depend on what was left in it before, which is only guaranteed when the area drawn by the
+        // framebuffer pair was cleared by a fill rectangle earlier in the workload. Targets that are blended or accumulated over get no tag.
+        thread_local std::unordered_map<uint32_t, FixedRect> clearedRects;
+        clearedRects.clear();
+
+        auto tagTarget = [&](uint32_t address, uint32_t fbPairIndex, bool depth, bool cleared) {
+            const uint64_t tag = (uint64_t(fbPairIndex) << 1) | (depth ? 1 : 0);
+            fingerprints[address] = (reusable && cleared) ? (workload.fingerprint ^ ((tag + 1) * 0x9E3779B97F4A7C15ULL)) : 0;
+            if (!cleared) {
+                clearedRects.erase(address);
+            }
+        };
+
+        auto isCleared = [&](uint32_t address, const FixedRect &rect) {
+            auto it = clearedRects.find(address);
+            return (it != clearedRects.end()) && it->second.fullyInside(rect);
+        };
+
+        for (uint32_t f = 0; f < workload.fbPairCount; f++) {
+            const FramebufferPair &fbPair = workload.fbPairs[f];
+            if (fbPair.drawColorRect.isEmpty()) {
+                continue;
+            }
+
+            // Check if the first call of the framebuffer pair is a fill rectangle that covers everything it draws.
+            for (uint32_t p = 0; p < fbPair.projectionCount; p++) {
+                const Projection &proj = fbPair.projections[p];
+                if (proj.gameCallCount == 0) {
+                    continue;
+                }
+
+                const DrawCall &callDesc = proj.gameCalls[0].callDesc;
+                if ((proj.type == Projection::Type::Rectangle) && (callDesc.otherMode.cycleType() == G_CYC_FILL)) {
+                    const FixedRect fillRect = callDesc.scissorRect.intersection(callDesc.rect);
+                    if (!fillRect.isNull() && fillRect.fullyInside(fbPair.drawColorRect) && !isCleared(fbPair.colorImage.address, fillRect)) {
+                        clearedRects[fbPair.colorImage.address] = fillRect;
+                    }
+                }
+
+                break;
+            }
+
+            if (fbPair.fastPaths.clearDepthOnly) {
+                tagTarget(fbPair.colorImage.address, f, true, isCleared(fbPair.colorImage.address, fbPair.drawColorRect));
+                continue;
+            }
+
+            bool cleared = isCleared(fbPair.colorImage.address, fbPair.drawColorRect);
+            if (fbPair.depthRead || fbPair.depthWrite) {
+                cleared = cleared && isCleared(fbPair.depthImage.address, fbPair.drawColorRect);
+            }
+
+            tagTarget(fbPair.colorImage.address, f, false, cleared);
+
+            if (fbPair.depthWrite) {
+                tagTarget(fbPair.depthImage.address, f, true, cleared);
+            }
+        }
+    }
+
+    bool WorkloadQueue::threadReuseTargets(Workload &workload, const WorkloadConfiguration &workloadConfig) {
+        // Any change that affects how workloads are rendered invalidates the contents of all the targets.
+        const float configValues[] = {
+            float(workloadConfig.resolutionScale.x), float(workloadConfig.resolutionScale.y), float(workloadConfig.downsampleMultiplier), float(workloadConfig.targetRate),
+            workloadConfig.aspectRatioScale, workloadConfig.extAspectPercentage, float(workloadConfig.postBlendNoise), float(workloadConfig.postBlendNoiseNegative)
+        };
+
+        const uint64_t configHash = XXH3_64bits(configValues, sizeof(configValues));
+        const uint32_t externalWrites = ext.sharedResources->externalTargetWrites;
+        uint32_t textureVersion = 0;
+        {
+            const std::unique_lock<std::mutex> textureMapLock(ext.textureCache->textureMapMutex);
+            textureVersion = ext.textureCache->textureMap.globalVersion;
+        }
+
+        if ((configHash != targetFingerprintsConfigHash) || (textureVersion != targetFingerprintsTextureVersion) || (externalWrites != targetFingerprintsExternalWrites)) {
+            targetFingerprints.clear();
+            targetFingerprintsConfigHash = configHash;
+            targetFingerprintsTextureVersion = textureVersion;
+            targetFingerprintsExternalWrites = externalWrites;
+            return false;
+        }
+
+        if ((workload.layoutFingerprint == 0) || workload.paused || workloadConfig.raytracingEnabled || targetFingerprints.empty()) {
+            return false;
+        }
+
+        const DebuggerRenderer &debuggerRenderer = workload.debuggerRenderer;
+        if ((debuggerRenderer.framebufferIndex >= 0) || (debuggerRenderer.globalDrawCallIndex >= 0) || workload.debuggerCamera.enabled) {
+            return false;
+        }
+
+        // Only the final frame is left in the targets when interpolating, so the workload must be rendered normally.
+        if ((workload.viOriginalRate > 0) && (workloadConfig.targetRate > workload.viOriginalRate)) {
+            return false;
+        }
+
+        // The draw data is only hashed if the structure of the workload is the same as the last one that rendered to the targets.
+        if (workload.layoutFingerprint != targetLayoutFingerprint) {
+            return false;
+        }
+
+        if (workload.fingerprint == 0) {
+            workload.computeFingerprint();
+        }
+
+        thread_local std::unordered_map<uint32_t, uint64_t> expectedFingerprints;
+        expectedFingerprints.clear();
+        threadComputeTargetFingerprints(workload, true, expectedFingerprints);
+        if (expectedFingerprints.empty()) {
+            return false;
+        }
+
+        for (const auto &it : expectedFingerprints) {
+            // Targets without a tag depend on their previous contents, so the workload must be rendered again.
+            if (it.second == 0) {
+                return false;
+            }
+
+            auto targetIt = targetFingerprints.find(it.first);
+            if ((targetIt == targetFingerprints.end()) || (targetIt->second != it.second)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
     void WorkloadQueue::renderThreadLoop() {
         Thread::setCurrentThreadName("RT64 Workload");
+        Thread::setCurrentThreadRole(Thread::Role::Render);
 
         WorkloadConfiguration workloadConfig;
         int64_t logicalTicks = 0;
@@ -970,6 +1150,32 @@ namespace RT64 {
                     }
                 }
 
+                // The targets already contain the result of this workload if an identical one rendered them last. Only the present needs to run again.
+                if (threadReuseTargets(workload, workloadConfig)) {
+                    ext.sharedResources->viOriginalRate = workload.viOriginalRate;
+                    if (lastPresentId != workload.presentId) {
+                        ext.sharedResources->interpolatedFramesIndex = ext.sharedResources->interpolatedFramesIndex ^ 1;
+                        lastPresentId = workload.presentId;
+                    }
+
+                    InterpolatedFrameCounters &curFrameCounters = ext.sharedResources->interpolatedFrames[ext.sharedResources->interpolatedFramesIndex];
+                    curFrameCounters.skipped = false;
+                    curFrameCounters.presented = 0;
+                    curFrameCounters.available = 0;
+                    curFrameCounters.count = 1;
+
+                    threadAdvanceWorkloadId(workload.workloadId);
+                    threadConfigurationValidate();
+                    threadAdvanceBarrier();
+                    reusedWorkloadCount++;
+
+                    processCursor = -1;
+                    workloadProfiler.end();
+                    workloadProfiler.log();
+                    workloadProfiler.reset();
+                    continue;
+                }
+
                 float prevFrameWeight = 0.0f;
                 float curFrameWeight = 1.0f;
                 float deltaTimeMs = 1.0f / 30.0f;
@@ -1059,12 +1265,25 @@ namespace RT64 {
                 const int64_t setupTimeMicro = workloadTimer.elapsedMicroseconds();
                 const int64_t adjustedTimeWindowMicro = originalTimeMicro - setupTimeMicro;
                 const int64_t maxTimePerFrameMicro = adjustedTimeWindowMicro / displayFrames;
+
+                // Only render as many interpolated frames as the measured render cost allows and spread them evenly across the window.
+                uint32_t budgetFrames = displayFrames;
+                if (generateInterpolatedFrames) {
+                    budgetFrames = interpolationBudget.update(displayFrames, adjustedTimeWindowMicro / 1000.0);
+                }
+
                 bool skippedFrames = false;
                 bool skipWorkloadNow = false;
                 uint32_t targetIndex = 0;
                 uint32_t framesRendered = 0;
                 int64_t renderTimeTotalMicro = 0;
                 for (uint32_t frame = 0; (frame < displayFrames) && !skipWorkloadNow; frame++) {
+                    if (!InterpolationBudget::renderFrame(frame, displayFrames, budgetFrames)) {
+                        displayTicks += workload.viOriginalRate;
+                        skippedFrames = true;
+                        continue;
+                    }
+
                     // Evaluate if this frame should be skipped. Measure the current time and compare it to what frame is estimated should be have been rendered by now.
                     if ((frame > 0) && (originalTimeMicro > 0)) {
                         const int64_t currentTimeMicro = workloadTimer.elapsedMicroseconds() - setupTimeMicro;
@@ -1116,13 +1335,18 @@ namespace RT64 {
                         ext.workloadExtrasUploader->submit(ext.workloadGraphicsWorker, { extrasUpload });
                     }
 
+                    // Static draws produce the same processor results on every frame, so only the first frame rendered needs to compute them.
+                    const bool reuseStatic = (framesRendered > 0);
                     int64_t renderTimeMicro = workloadTimer.elapsedMicroseconds();
                     threadRenderFrame(curFrame, prevFrame, workloadConfig, workload.debuggerRenderer, workload.debuggerCamera, curFrameWeight, prevFrameWeight, deltaTimeMs,
-                        interpolationTargetKey, interpolationTargetFbPairIndex, overrideTarget, overrideModifier, velocityUploaderUsed, uploadExtras, tileInterpolationUsed, lookAtInterpolationUsed);
+                        interpolationTargetKey, interpolationTargetFbPairIndex, overrideTarget, overrideModifier, velocityUploaderUsed, uploadExtras, tileInterpolationUsed, lookAtInterpolationUsed, reuseStatic);
 
                     // Add total time the frame took to render.
                     renderTimeTotalMicro += workloadTimer.elapsedMicroseconds() - renderTimeMicro;
 
+                    // The frame is as expensive as the slowest of the CPU and GPU work.
+                    interpolationBudget.addFrameCost(std::max(rendererCPUProfiler.latest(), rendererGPUProfiler.latest()));
+
                     // After one frame is rendered, we indicate the workload has been processed so the present thread can start presenting frames as soon as it can.
                     if (frame == 0) {
                         threadAdvanceWorkloadId(workload.workloadId);
@@ -1162,6 +1386,17 @@ namespace RT64 {
                     ext.sharedResources->interpolatedCondition.notify_all();
                 }
 
+                // Remember which workload wrote to each target last. The result can only be reused if the final frame is the one left in the targets.
+                const DebuggerRenderer &debuggerRenderer = workload.debuggerRenderer;
+                const bool debuggerActive = (debuggerRenderer.framebufferIndex >= 0) || (debuggerRenderer.globalDrawCallIndex >= 0) || workload.debuggerCamera.enabled;
+                const bool reusable = (workload.layoutFingerprint != 0) && !workload.paused && !generateInterpolatedFrames && !workloadConfig.raytracingEnabled && !debuggerActive;
+                if (reusable && (workload.fingerprint == 0) && (workload.layoutFingerprint == targetLayoutFingerprint)) {
+                    workload.computeFingerprint();
+                }
+
+                threadComputeTargetFingerprints(workload, reusable && (workload.fingerprint != 0), targetFingerprints);
+                targetLayoutFingerprint = reusable ? workload.layoutFingerprint : 0;
+
                 threadConfigurationValidate();
 
                 if (!workload.paused) {
@@ -1176,7 +1411,7 @@ namespace RT64 {
         }
     }
     
-    void WorkloadQueue::idleThreadLoop() {
+    void WorkloadQueue::idleJob() {
         // Beware traveler as you enter the zone of dirty driver hacks. Given N64 games are not exactly a demanding thing to render
         // nowadays for modern GPUs and due to how the plugin's cooperative multiqueue system works, it's sometimes just not possible
         // to keep the GPU busy at all times. It is often the case that the GPU might've already rendered all the frames it needed to
@@ -1186,39 +1421,35 @@ namespace RT64 {
         // resulting in very low power states that cause unwanted frametime spikes that can no longer reach the target framerate. This
         // results in visible judder during gameplay.
         //
-        // This thread will take care of sending some GPU work that does nothing useful while the GPU is not actually busy generating
+        // This job will take care of sending some GPU work that does nothing useful while the GPU is not actually busy generating
         // new frames. The waiting interval is close to the minimum resolution the OS provides and big enough to not cause any significant
         // delays or unwanted power consumption: it's just enough to keep the driver from downclocking to a power state level that is
         // usually intended for 2D work or video playback.
         //
         // This workaround is not required if the driver is configured to be at the "Max Performance" power state.
 
-        Thread::setCurrentThreadName("RT64 Idle");
-
         const ShaderRecord &idle = ext.shaderLibrary->idle;
         RenderCommandList *commandList = ext.workloadGraphicsWorker->commandList.get();
-        while (threadsRunning) {
-            {
-                std::unique_lock<std::mutex> idleLock(idleMutex);
-                idleCondition.wait(idleLock, [&]() {
-                    return idleActive || !threadsRunning;
-                });
-            }
+        if (threadsRunning && workerMutex.try_lock()) {
+            commandList->begin();
+            commandList->setPipeline(idle.pipeline.get());
+            commandList->setComputePipelineLayout(idle.pipelineLayout.get());
+            commandList->dispatch(1, 1, 1);
+            commandList->end();
+            ext.workloadGraphicsWorker->execute();
+            ext.workloadGraphicsWorker->wait();
+            workerMutex.unlock();
+        }
 
-            if (threadsRunning) {
-                if (workerMutex.try_lock()) {
-                    commandList->begin();
-                    commandList->setPipeline(idle.pipeline.get());
-                    commandList->setComputePipelineLayout(idle.pipelineLayout.get());
-                    commandList->dispatch(1, 1, 1);
-                    commandList->end();
-                    ext.workloadGraphicsWorker->execute();
-                    ext.workloadGraphicsWorker->wait();
-                    workerMutex.unlock();
-                }
-                
-                Thread::sleepMilliseconds(1);
+        // The job reschedules itself for as long as the workaround is active instead of keeping a thread asleep.
+        {
+            std::unique_lock<std::mutex> idleLock(idleMutex);
+            idleScheduled = idleActive && threadsRunning;
+            if (!idleScheduled) {
+                return;
             }
         }
+
+        ext.jobSystem->submitDelayed(JobSystem::Priority::Normal, 1000, [this]() { idleJob(); }, &idleCounter);
     }
 };
\ No newline at end of file
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 
 #include "common/rt64_enhancement_configuration.h"
 #include "common/rt64_profiling_timer.h"
@@ -16,6 +17,8 @@
 #include "render/rt64_look_at_processor.h"
 #include "render/rt64_transform_processor.h"
 
+#include "rt64_dynamic_resolution.h"
+#include "rt64_interpolation_budget.h"
 #include "rt64_shared_queue_resources.h"
 #include "rt64_workload.h"
 
@@ -31,6 +34,7 @@ namespace RT64 {
     struct WorkloadQueue {
         struct External {
             RenderDevice *device = nullptr;
+            JobSystem *jobSystem = nullptr;
             RenderWorker *workloadGraphicsWorker = nullptr;
             BufferUploader *workloadExtrasUploader = nullptr;
             BufferUploader *workloadVelocityUploader = nullptr;
@@ -49,6 +53,7 @@ namespace RT64 {
 
         struct WorkloadConfiguration {
             hlslpp::float2 resolutionScale = 1.0f;
+            hlslpp::float2 allocationResolutionScale = 1.0f;
             uint32_t downsampleMultiplier = 1;
             bool raytracingEnabled = false;
             float aspectRatioSource = 1.0f;
@@ -72,10 +77,10 @@ namespace RT64 {
         std::mutex workloadIdMutex;
         std::condition_variable workloadIdCondition;
         std::thread *renderThread = nullptr;
-        std::thread *idleThread = nullptr;
         bool idleActive = false;
+        bool idleScheduled = false;
         std::mutex idleMutex;
-        std::condition_variable idleCondition;
+        JobCounter idleCounter;
         std::mutex workerMutex;
         std::mutex threadMutex;
         std::atomic<bool> threadsRunning = false;
@@ -95,11 +100,19 @@ namespace RT64 {
         FramebufferChangePool scratchFbChangePool;
         ProfilingTimer rendererCPUProfiler = ProfilingTimer(120);
         ProfilingTimer rendererGPUProfiler = ProfilingTimer(120);
+        InterpolationBudget interpolationBudget;
+        DynamicResolution dynamicResolution;
         ProfilingTimer matchingProfiler = ProfilingTimer(120);
         ProfilingTimer workloadProfiler = ProfilingTimer(120);
         std::array<GameFrame, 2> gameFrames;
         uint32_t prevFrameIndex = uint32_t(gameFrames.size()) - 1;
         uint32_t curFrameIndex = 0;
+        std::unordered_map<uint32_t, uint64_t> targetFingerprints;
+        uint64_t targetFingerprintsConfigHash = 0;
+        uint32_t targetFingerprintsTextureVersion = 0;
+        uint32_t targetFingerprintsExternalWrites = 0;
+        uint64_t targetLayoutFingerprint = 0;
+        std::atomic<uint64_t> reusedWorkloadCount = 0;
 
         WorkloadQueue();
         ~WorkloadQueue();
@@ -116,11 +129,13 @@ namespace RT64 {
         void threadRenderFrame(GameFrame &curFrame, const GameFrame &prevFrame, const WorkloadConfiguration &workloadConfig,
             const DebuggerRenderer &debuggerRenderer, const DebuggerCamera &debuggerCamera, float curFrameWeight, float prevFrameWeight,
             float deltaTimeMs, RenderTargetKey overrideTargetKey, int32_t overrideTargetFbPairIndex, RenderTarget *overrideTarget,
-            uint32_t overrideTargetModifier, bool uploadVelocity, bool uploadExtras, bool interpolateTiles, bool interpolateLookAts);
+            uint32_t overrideTargetModifier, bool uploadVelocity, bool uploadExtras, bool interpolateTiles, bool interpolateLookAts, bool reuseStatic);
 
         void threadAdvanceBarrier();
         void threadAdvanceWorkloadId(uint64_t newWorkloadId);
+        void threadComputeTargetFingerprints(const Workload &workload, bool reusable, std::unordered_map<uint32_t, uint64_t> &fingerprints) const;
+        bool threadReuseTargets(Workload &workload, const WorkloadConfiguration &workloadConfig);
         void renderThreadLoop();
-        void idleThreadLoop();
+        void idleJob();
     };
 };
\ No newline at end of file
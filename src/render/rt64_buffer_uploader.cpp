@@ -5,8 +5,6 @@
 #include <algorithm>
 #include <cstring>
 
-#include "common/rt64_thread.h"
-
 #include "rt64_buffer_uploader.h"
 
 namespace RT64 {
@@ -24,45 +22,16 @@ namespace RT64 {
 
     // BufferUploader
 
-    BufferUploader::BufferUploader(RenderDevice *device) {
+    BufferUploader::BufferUploader(RenderDevice *device, JobSystem *jobSystem) {
         assert(device != nullptr);
+        assert(jobSystem != nullptr);
 
         this->device = device;
-        workAvailable = false;
-        thread = new std::thread(&BufferUploader::threadLoop, this);
+        this->jobSystem = jobSystem;
     }
 
     BufferUploader::~BufferUploader() {
-        running = false;
-        workCondition.notify_all();
-        thread->join();
-        delete thread;
-    }
-
-    void BufferUploader::threadLoop() {
-        Thread::setCurrentThreadName("RT64 Buffer");
-
-        running = true;
-
-        while (running) {
-            std::unique_lock<std::mutex> queueLock(workMutex);
-            workCondition.wait(queueLock, [this]() {
-                return !running || workAvailable;
-            });
-            
-            if (running) {
-                for (const Upload &u : pendingUploads) {
-                    threadUpload(u);
-                }
-            }
-
-            {
-                std::unique_lock<std::mutex> readyLock(readyMutex);
-                workAvailable = false;
-            }
-
-            readyCondition.notify_all();
-        }
+        wait();
     }
 
     void BufferUploader::threadUpload(const Upload &upload) {
@@ -108,14 +77,23 @@ namespace RT64 {
     }
 
     void BufferUploader::submit(RenderWorker *worker, const std::vector<Upload> &uploads) {
-        {
-            std::unique_lock<std::mutex> queueLock(workMutex);
-            pendingUploads = uploads;
-            updateResources(worker, pendingUploads);
-            workAvailable = true;
-        }
+        // The uploads from the previous submission must be done before the pending list can be replaced.
+        wait();
+
+        pendingUploads = uploads;
+        updateResources(worker, pendingUploads);
 
-        workCondition.notify_all();
+        // Each upload is an independent copy into its own buffer, so they can all run in parallel.
+        for (const Upload &u : pendingUploads) {
+            if (!u.valid()) {
+                continue;
+            }
+
+            const Upload *upload = &u;
+            jobSystem->submit(JobSystem::Priority::High, [this, upload]() {
+                threadUpload(*upload);
+            }, &uploadCounter);
+        }
     }
 
     void BufferUploader::commandListBeforeBarriers(RenderWorker *worker) {
@@ -167,9 +145,6 @@ namespace RT64 {
     }
     
     void BufferUploader::wait() {
-        std::unique_lock<std::mutex> readyLock(readyMutex);
-        readyCondition.wait(readyLock, [this]() {
-            return !workAvailable;
-        });
+        uploadCounter.wait();
     }
 };
\ No newline at end of file
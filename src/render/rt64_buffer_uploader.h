@@ -4,12 +4,8 @@
 
 #pragma once
 
-#include <mutex>
-#include <thread>
-#include <atomic>
-#include <condition_variable>
-
 #include "rt64_render_worker.h"
+#include "common/rt64_job_system.h"
 #include "common/rt64_plume.h"
 
 namespace RT64 {
@@ -45,19 +41,13 @@ namespace RT64 {
             bool valid() const;
         };
 
-        std::thread *thread;
-        std::atomic<bool> running;
-        bool workAvailable;
-        std::mutex workMutex;
-        std::mutex readyMutex;
-        std::condition_variable workCondition;
-        std::condition_variable readyCondition;
         RenderDevice *device;
+        JobSystem *jobSystem;
+        JobCounter uploadCounter;
         std::vector<Upload> pendingUploads;
 
-        BufferUploader(RenderDevice *device);
+        BufferUploader(RenderDevice *device, JobSystem *jobSystem);
         ~BufferUploader();
-        void threadLoop();
         void threadUpload(const Upload &upload);
         void updateResources(RenderWorker *worker, std::vector<Upload> &blankUploads); // Upload data does not need to be filled in with valid data, only the sizes.
         void commandListBeforeBarriers(RenderWorker *worker);
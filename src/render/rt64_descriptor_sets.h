@@ -644,14 +644,18 @@ namespace RT64 {
     };
 
     struct TextureDecodeDescriptorSet : RenderDescriptorSetBase {
-        uint32_t TMEM;
-        uint32_t RGBA32;
+        static const int UpperRange = 256;
+
+        uint32_t gDescriptors;
+        uint32_t gTMEMAtlas;
+        uint32_t gOutputs;
 
         TextureDecodeDescriptorSet(RenderDevice *device = nullptr) {
             builder.begin();
-            TMEM = builder.addTexture(1);
-            RGBA32 = builder.addReadWriteTexture(2);
-            builder.end();
+            gDescriptors = builder.addStructuredBuffer(1);
+            gTMEMAtlas = builder.addFormattedBuffer(2);
+            gOutputs = builder.addReadWriteTexture(3, UpperRange);
+            builder.end(true, UpperRange);
 
             if (device != nullptr) {
                 create(device);
@@ -140,7 +140,7 @@ namespace RT64 {
 
     // FramebufferRenderer
     
-    FramebufferRenderer::FramebufferRenderer(RenderWorker *worker, bool rtSupport, UserConfiguration::GraphicsAPI graphicsAPI, const ShaderLibrary *shaderLibrary) {
+    FramebufferRenderer::FramebufferRenderer(RenderWorker *worker, bool rtSupport, UserConfiguration::GraphicsAPI graphicsAPI, const ShaderLibrary *shaderLibrary, JobSystem *jobSystem) {
         assert(worker != nullptr);
 
         this->shaderLibrary = shaderLibrary;
@@ -149,7 +149,7 @@ namespace RT64 {
         frameParams.viewUbershaders = false;
         frameParams.ditherNoiseStrength = 1.0f;
 
-        shaderUploader = std::make_unique<BufferUploader>(worker->device);
+        shaderUploader = std::make_unique<BufferUploader>(worker->device, jobSystem);
         descCommonSet = std::make_unique<FramebufferRendererDescriptorCommonSet>(shaderLibrary->samplerLibrary, worker->device->getCapabilities().raytracing, worker->device);
 
 #   if RT_ENABLED
@@ -149,7 +149,7 @@ namespace RT64 {
             uint32_t maxGameCall;
         };
 
-        FramebufferRenderer(RenderWorker *worker, bool rtSupport, UserConfiguration::GraphicsAPI graphicsAPI, const ShaderLibrary *shaderLibrary);
+        FramebufferRenderer(RenderWorker *worker, bool rtSupport, UserConfiguration::GraphicsAPI graphicsAPI, const ShaderLibrary *shaderLibrary, JobSystem *jobSystem);
         ~FramebufferRenderer();
         void resetFramebuffers(RenderWorker *worker, bool ubershadersVisible, float ditherNoiseStrength, const RenderMultisampling &multisampling);
         void updateTextureCache(TextureCache *textureCache);
@@ -14,8 +14,8 @@ namespace RT64 {
 
     LookAtProcessor::~LookAtProcessor() { }
 
-    void LookAtProcessor::setup(RenderWorker *worker) {
-        bufferUploader = std::make_unique<BufferUploader>(worker->device);
+    void LookAtProcessor::setup(RenderWorker *worker, JobSystem *jobSystem) {
+        bufferUploader = std::make_unique<BufferUploader>(worker->device, jobSystem);
     }
 
     void LookAtProcessor::process(const ProcessParams &p) {
@@ -27,11 +27,17 @@ namespace RT64 {
             if (prevFrameValid) {
                 const GameFrameMap::WorkloadMap &workloadMap = p.curFrame->frameMap.workloads[w];
                 auto &lerpRspLookAts = drawData.lerpRspLookAt;
-                lerpRspLookAts = curLookAts;
+                const bool reuseStatic = p.reuseStatic && (lerpRspLookAts.size() == curLookAts.size());
+                if (reuseStatic && (workloadMap.varyingLookAtCount == 0)) {
+                    continue;
+                }
+                else if (!reuseStatic) {
+                    lerpRspLookAts = curLookAts;
+                }
 
                 for (size_t l = 0; l < curLookAts.size(); l++) {
                     const GameFrameMap::LookAtMap &lookAtMap = workloadMap.lookAt[l];
-                    if (!lookAtMap.mapped) {
+                    if (!lookAtMap.mapped || (reuseStatic && !lookAtMap.varying)) {
                         continue;
                     }
 
@@ -49,7 +55,8 @@ namespace RT64 {
 
         for (uint32_t w : p.curFrame->workloads) {
             const bool prevFrameValid = (p.prevFrame != nullptr) && p.curFrame->frameMap.workloads[w].mapped;
-            if (prevFrameValid) {
+            const bool reuseBuffer = p.reuseStatic && (p.curFrame->frameMap.workloads[w].varyingLookAtCount == 0);
+            if (prevFrameValid && !reuseBuffer) {
                 Workload &workload = p.workloadQueue->workloads[w];
                 DrawBuffers &drawBuffers = workload.drawBuffers;
                 const DrawData &drawData = workload.drawData;
@@ -59,8 +66,7 @@ namespace RT64 {
             }
         }
 
-        if (!uploads.empty()) {
-            bufferUploader->submit(p.worker, uploads);
-        }
+        // Submit even if there's nothing to upload so the copies from the previous submission aren't recorded again.
+        bufferUploader->submit(p.worker, uploads);
     }
 };
\ No newline at end of file
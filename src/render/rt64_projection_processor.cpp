@@ -23,8 +23,8 @@ namespace RT64 {
         bufferUploader.reset(nullptr);
     }
 
-    void ProjectionProcessor::setup(RenderWorker *worker) {
-        bufferUploader = std::make_unique<BufferUploader>(worker->device);
+    void ProjectionProcessor::setup(RenderWorker *worker, JobSystem *jobSystem) {
+        bufferUploader = std::make_unique<BufferUploader>(worker->device, jobSystem);
     }
 
     void ProjectionProcessor::process(const ProcessParams &p) {
@@ -404,8 +404,11 @@ namespace RT64 {
     const uint64_t RasterShaderUber::RasterPSLibraryHash = 0;
 #endif
 
-    RasterShaderUber::RasterShaderUber(RenderDevice *device, RenderShaderFormat shaderFormat, const RenderMultisampling &multisampling, const ShaderLibrary *shaderLibrary, uint32_t threadCount) {
+    RasterShaderUber::RasterShaderUber(RenderDevice *device, RenderShaderFormat shaderFormat, const RenderMultisampling &multisampling, const ShaderLibrary *shaderLibrary, JobSystem *jobSystem) {
         assert(device != nullptr);
+        assert(jobSystem != nullptr);
+
+        this->jobSystem = jobSystem;
 
         // Create the shaders.
         const void *VSBlob = nullptr;
@@ -457,10 +460,10 @@ namespace RT64 {
         layoutBuilder.end();
         pipelineLayout = layoutBuilder.create(device);
 
-        // Generate all possible combinations of pipeline creations and assign them to each thread. Skip the ones that are invalid.
+        // Generate all possible combinations of pipeline creations.
         uint32_t pipelineCount = uint32_t(std::size(pipelines));
-        pipelineThreadCreations.clear();
-        pipelineThreadCreations.resize(std::min(threadCount, pipelineCount));
+        pipelineCreations.clear();
+        pipelineCreations.reserve(pipelineCount);
 
         PipelineCreation creation;
         creation.device = device;
@@ -473,22 +476,23 @@ namespace RT64 {
         creation.usesHDR = shaderLibrary->usesHDR;
         creation.multisampling = multisampling;
 
-        uint32_t threadIndex = 0;
         for (uint32_t i = 0; i < pipelineCount; i++) {
             creation.zCmp = i & (1 << 0);
             creation.zUpd = i & (1 << 1);
             creation.cvgAdd = i & (1 << 2);
-
-            pipelineThreadCreations[threadIndex].emplace_back(creation);
-            threadIndex = (threadIndex + 1) % threadCount;
+            pipelineCreations.emplace_back(creation);
         }
 
-        // Spawn the threads that will compile all the pipelines.
-        pipelineThreads.clear();
-        pipelineThreads.resize(pipelineThreadCreations.size());
-        for (uint32_t i = 0; i < uint32_t(pipelineThreads.size()); i++) {
-            pipelineThreads[i] = std::make_unique<std::thread>(&RasterShaderUber::threadCreatePipelines, this, i);
-        }
+        // Delay the creation of all other pipelines until the first pipeline is created. This can help the
+        // driver reuse its shader cache between pipelines and achieve a much lower creation time than if
+        // all jobs started at the same time.
+        jobSystem->submit(JobSystem::Priority::Normal, [this, pipelineCount]() {
+            createPipeline(0);
+
+            for (uint32_t i = 1; i < pipelineCount; i++) {
+                this->jobSystem->submit(JobSystem::Priority::Normal, [this, i]() { createPipeline(i); }, &pipelineCounter);
+            }
+        }, &pipelineCounter);
 
         // Create the pipelines for post blend operations.
         std::unique_ptr<RenderShader> postBlendAddPixelShader;
@@ -558,40 +562,16 @@ namespace RT64 {
         waitForPipelineCreation();
     }
 
-    void RasterShaderUber::threadCreatePipelines(uint32_t threadIndex) {
-        // Delay the creation of all other pipelines until the first pipeline is created. This can help the
-        // driver reuse its shader cache between pipelines and achieve a much lower creation time than if
-        // all threads started at the same time.
-        if (threadIndex > 0) {
-            std::unique_lock<std::mutex> lock(firstPipelineMutex);
-            firstPipelineCondition.wait(lock, [this]() {
-                return (pipelines[0] != nullptr);
-            });
-        }
-
-        for (const PipelineCreation &creation : pipelineThreadCreations[threadIndex]) {
-            uint32_t pipelineIndex = pipelineStateIndex(creation.zCmp, creation.zUpd, creation.cvgAdd);
-
-            if (pipelineIndex == 0) {
-                firstPipelineMutex.lock();
-                pipelines[pipelineIndex] = RasterShader::createPipeline(creation);
-                firstPipelineMutex.unlock();
-                firstPipelineCondition.notify_all();
-            }
-            else {
-                pipelines[pipelineIndex] = RasterShader::createPipeline(creation);
-            }
-        }
+    void RasterShaderUber::createPipeline(uint32_t creationIndex) {
+        const PipelineCreation &creation = pipelineCreations[creationIndex];
+        uint32_t pipelineIndex = pipelineStateIndex(creation.zCmp, creation.zUpd, creation.cvgAdd);
+        pipelines[pipelineIndex] = RasterShader::createPipeline(creation);
     }
 
     void RasterShaderUber::waitForPipelineCreation() {
         if (!pipelinesCreated) {
-            for (std::unique_ptr<std::thread> &thread : pipelineThreads) {
-                thread->join();
-            }
-
-            pipelineThreads.clear();
-            pipelineThreadCreations.clear();
+            pipelineCounter.wait();
+            pipelineCreations.clear();
             vertexShader.reset();
             pixelShader.reset();
             pipelinesCreated = true;
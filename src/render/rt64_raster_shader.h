@@ -13,6 +13,7 @@
 #include "re-spirv/re-spirv.h"
 
 #include "plume_render_interface.h"
+#include "common/rt64_job_system.h"
 #include "shared/rt64_blender.h"
 #include "shared/rt64_color_combiner.h"
 #include "shared/rt64_other_mode.h"
@@ -82,18 +83,17 @@ namespace RT64 {
         std::unique_ptr<RenderPipeline> postBlendDitherNoiseAddPipeline;
         std::unique_ptr<RenderPipeline> postBlendDitherNoiseSubPipeline;
         std::unique_ptr<RenderPipeline> postBlendDitherNoiseSubNegativePipeline;
-        std::mutex firstPipelineMutex;
-        std::condition_variable firstPipelineCondition;
         bool pipelinesCreated = false;
         std::unique_ptr<RenderPipelineLayout> pipelineLayout;
-        std::vector<std::vector<PipelineCreation>> pipelineThreadCreations;
-        std::vector<std::unique_ptr<std::thread>> pipelineThreads;
+        std::vector<PipelineCreation> pipelineCreations;
+        JobSystem *jobSystem;
+        JobCounter pipelineCounter;
         std::unique_ptr<RenderShader> vertexShader;
         std::unique_ptr<RenderShader> pixelShader;
 
-        RasterShaderUber(RenderDevice *device, RenderShaderFormat shaderFormat, const RenderMultisampling &multisampling, const ShaderLibrary *shaderLibrary, uint32_t threadCount);
+        RasterShaderUber(RenderDevice *device, RenderShaderFormat shaderFormat, const RenderMultisampling &multisampling, const ShaderLibrary *shaderLibrary, JobSystem *jobSystem);
         ~RasterShaderUber();
-        void threadCreatePipelines(uint32_t threadIndex);
+        void createPipeline(uint32_t creationIndex);
         void waitForPipelineCreation();
         uint32_t pipelineStateIndex(bool zCmp, bool zUpd, bool cvgAdd) const;
         const RenderPipeline *getPipeline(bool zCmp, bool zUpd, bool cvgAdd) const;
@@ -4,95 +4,51 @@
 
 #include "rt64_raster_shader_cache.h"
 
-#include "common/rt64_thread.h"
-
 #define ENABLE_OPTIMIZED_SHADER_GENERATION
 
 namespace RT64 {
-    // RasterShaderCache::CompilationThread
-    
-    RasterShaderCache::CompilationThread::CompilationThread(RasterShaderCache *shaderCache) {
-        assert(shaderCache != nullptr);
-
-        this->shaderCache = shaderCache;
-
-        thread = std::make_unique<std::thread>(&CompilationThread::loop, this);
-        threadRunning = false;
-    }
-
-    RasterShaderCache::CompilationThread::~CompilationThread() {
-        threadRunning = false;
-        shaderCache->descQueueChanged.notify_all();
-        thread->join();
-        thread.reset(nullptr);
-    }
-
-    void RasterShaderCache::CompilationThread::loop() {
-        Thread::setCurrentThreadName("RT64 Shader");
-
-        // The shader compilation thread should have idle priority by default as the application can use the ubershader in the meantime.
-        Thread::setCurrentThreadPriority(Thread::Priority::Idle);
-
-        threadRunning = true;
-
-        while (threadRunning) {
-            ShaderDescription shaderDesc;
-            bool fromPriorityQueue = false;
-            
-            // Check the top of the queue or wait if it's empty.
-            {
-                std::unique_lock<std::mutex> queueLock(shaderCache->descQueueMutex);
-                shaderCache->descQueueActiveCount--;
-                shaderCache->descQueueChanged.wait(queueLock, [this]() {
-                    return !threadRunning || !shaderCache->descQueue.empty();
-                });
-
-                shaderCache->descQueueActiveCount++;
-                if (!shaderCache->descQueue.empty()) {
-                    shaderDesc = shaderCache->descQueue.front();
-                    shaderCache->descQueue.pop();
-                    fromPriorityQueue = true;
-                }
-            }
-            
-            // Compile the shader at the top of the queue.
-            if (fromPriorityQueue) {
-                assert((shaderCache->shaderUber != nullptr) && "Ubershader should've been created by the time a new shader is submitted to the cache.");
-                const RenderPipelineLayout *uberPipelineLayout = shaderCache->shaderUber->pipelineLayout.get();
-                const RenderMultisampling multisampling = shaderCache->multisampling;
-                std::unique_ptr<RasterShader> newShader = std::make_unique<RasterShader>(shaderCache->device, shaderDesc, uberPipelineLayout, shaderCache->shaderFormat, multisampling, shaderCache->shaderCompiler.get(), &shaderCache->optimizerCacheSPIRV);
-
-                {
-                    const std::unique_lock<std::mutex> lock(shaderCache->GPUShadersMutex);
-                    shaderCache->GPUShaders[shaderDesc.hash()] = std::move(newShader);
-                }
-            }
-        }
-    }
-
     // RasterShaderCache
 
-    RasterShaderCache::RasterShaderCache(uint32_t threadCount, uint32_t ubershaderThreadCount) {
-        assert(threadCount > 0);
+    RasterShaderCache::RasterShaderCache(JobSystem *jobSystem) {
+        assert(jobSystem != nullptr);
 
-        this->threadCount = threadCount;
-        this->ubershaderThreadCount = ubershaderThreadCount;
+        this->jobSystem = jobSystem;
 
 #ifdef ENABLE_OPTIMIZED_SHADER_GENERATION
 #   ifdef _WIN32
         shaderCompiler = std::make_unique<ShaderCompiler>();
 #   endif
 
-        descQueueActiveCount = threadCount;
-
-        for (uint32_t t = 0; t < threadCount; t++) {
-            compilationThreads.push_back(std::make_unique<CompilationThread>(this));
-        }
+        compilationEnabled = true;
 #endif
     }
 
     RasterShaderCache::~RasterShaderCache() {
-        compilationThreads.clear();
+        waitForAll();
+    }
+
+    void RasterShaderCache::compileNext() {
+        // Jobs don't own a specific description, they just compile whatever is at the top of the queue.
+        // The queue might've been cleared in the meantime, in which case there's nothing left to do.
+        ShaderDescription shaderDesc;
+        {
+            std::unique_lock<std::mutex> queueLock(descQueueMutex);
+            if (descQueue.empty()) {
+                return;
+            }
+
+            shaderDesc = descQueue.front();
+            descQueue.pop();
+        }
+
+        assert((shaderUber != nullptr) && "Ubershader should've been created by the time a new shader is submitted to the cache.");
+        const RenderPipelineLayout *uberPipelineLayout = shaderUber->pipelineLayout.get();
+        std::unique_ptr<RasterShader> newShader = std::make_unique<RasterShader>(device, shaderDesc, uberPipelineLayout, shaderFormat, multisampling, shaderCompiler.get(), &optimizerCacheSPIRV);
+
+        {
+            const std::unique_lock<std::mutex> lock(GPUShadersMutex);
+            GPUShaders[shaderDesc.hash()] = std::move(newShader);
+        }
     }
 
     void RasterShaderCache::setup(RenderDevice *device, RenderShaderFormat shaderFormat, const ShaderLibrary *shaderLibrary, const RenderMultisampling &multisampling) {
@@ -102,7 +58,7 @@ namespace RT64 {
         this->shaderFormat = shaderFormat;
         this->multisampling = multisampling;
 
-        shaderUber = std::make_unique<RasterShaderUber>(device, shaderFormat, multisampling, shaderLibrary, ubershaderThreadCount);
+        shaderUber = std::make_unique<RasterShaderUber>(device, shaderFormat, multisampling, shaderLibrary, jobSystem);
         usesHDR = shaderLibrary->usesHDR;
 
         // Initialize the re-spirv optimizer cache.
@@ -112,6 +68,10 @@ namespace RT64 {
     }
 
     void RasterShaderCache::submit(const ShaderDescription &desc) {
+        if (!compilationEnabled) {
+            return;
+        }
+
         {
             std::unique_lock<std::mutex> queueLock(submissionMutex);
 
@@ -131,7 +91,8 @@ namespace RT64 {
             descQueue.push(desc);
         }
 
-        descQueueChanged.notify_all();
+        // The compilation should have idle priority as the application can use the ubershader in the meantime.
+        jobSystem->submit(JobSystem::Priority::Idle, [this]() { compileNext(); }, &descQueueCounter);
     }
     
     void RasterShaderCache::waitForAll() {
@@ -140,11 +101,7 @@ namespace RT64 {
             descQueue = std::queue<ShaderDescription>();
         }
 
-        bool keepWaiting = false;
-        do {
-            std::unique_lock<std::mutex> queueLock(descQueueMutex);
-            keepWaiting = (descQueueActiveCount > 0);
-        } while (keepWaiting);
+        descQueueCounter.wait();
     }
 
     void RasterShaderCache::destroyAll() {
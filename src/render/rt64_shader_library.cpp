@@ -7,6 +7,7 @@
 #include "common/rt64_common.h"
 #include "shared/rt64_render_target_copy.h"
 #include "shared/rt64_rsp_vertex_test_z.h"
+#include "shared/rt64_texture_decode.h"
 
 #include "shaders/FbChangesClearCS.hlsl.spirv.h"
 #include "shaders/FbChangesDrawColorPS.hlsl.spirv.h"
@@ -573,7 +574,7 @@ namespace RT64 {
         {
             TextureDecodeDescriptorSet descriptorSet;
             layoutBuilder.begin();
-            layoutBuilder.addPushConstant(0, 0, sizeof(uint32_t) * 8, RenderShaderStageFlag::COMPUTE);
+            layoutBuilder.addPushConstant(0, 0, sizeof(interop::TextureDecodeCB), RenderShaderStageFlag::COMPUTE);
             layoutBuilder.addDescriptorSet(descriptorSet);
             layoutBuilder.end();
             textureDecode.pipelineLayout = layoutBuilder.create(device);
@@ -18,6 +18,9 @@ namespace RT64 {
         uint32_t tlut = 0;
         LoadTile loadTile;
         uint32_t mipmaps = 0;
+
+        // Amount of the largest mipmaps of the source that weren't loaded. The dimensions are the ones of the largest mipmap loaded.
+        uint32_t residentMip = 0;
         uint64_t memorySize = 0;
         std::vector<uint8_t> bytesTMEM;
         bool decodeTMEM = false;
@@ -0,0 +1,57 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace RT64 {
+    struct TextureBudget {
+        struct EvictionCandidate {
+            uint32_t textureIndex;
+            uint64_t idleFrames;
+            uint64_t memorySize;
+        };
+
+        // Sorts the candidates so the ones that free the most memory for the least amount of time they've been unused come first.
+        // Returns how many of them must be evicted in that order to fit in the budget, which can be all of them if it's not enough.
+        static size_t sortEvictionCandidates(std::vector<EvictionCandidate> &candidates, uint64_t memorySize, uint64_t maxMemorySize) {
+            auto score = [](const EvictionCandidate &candidate) {
+                return candidate.idleFrames * std::max(candidate.memorySize, uint64_t(1));
+            };
+
+            std::stable_sort(candidates.begin(), candidates.end(), [&](const EvictionCandidate &a, const EvictionCandidate &b) {
+                return score(a) > score(b);
+            });
+
+            size_t evictCount = 0;
+            while ((memorySize > maxMemorySize) && (evictCount < candidates.size())) {
+                memorySize -= std::min(candidates[evictCount].memorySize, memorySize);
+                evictCount++;
+            }
+
+            return evictCount;
+        }
+
+        // Preloaded textures and the low mip cache can never be evicted, so the streamed textures only get what they leave of the pool.
+        // A minimum share is always left to them, as otherwise a large enough preload would stop streaming altogether.
+        static uint64_t streamedPoolBudget(uint64_t maxPoolSize, uint64_t permanentPoolSize) {
+            const uint64_t minimumBudget = maxPoolSize / 4;
+            return std::max(maxPoolSize - std::min(permanentPoolSize, maxPoolSize), minimumBudget);
+        }
+
+        // The pool is under pressure when the streamed textures in use fill their share of it, as anything streamed in then would go over
+        // the budget without any texture that could be evicted to make room for it.
+        static bool isPoolUnderPressure(uint64_t usedPoolSize, uint64_t permanentPoolSize, uint64_t maxPoolSize) {
+            if (maxPoolSize == 0) {
+                return false;
+            }
+
+            const uint64_t streamedUsedSize = usedPoolSize - std::min(permanentPoolSize, usedPoolSize);
+            return streamedUsedSize >= streamedPoolBudget(maxPoolSize, permanentPoolSize);
+        }
+    };
+};
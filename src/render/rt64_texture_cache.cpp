@@ -12,13 +12,19 @@
 #include "gbi/rt64_f3d.h"
 
 #include "common/rt64_filesystem_directory.h"
+#include "common/rt64_filesystem_pack.h"
+#include "common/rt64_filesystem_readers.h"
 #include "common/rt64_filesystem_zip.h"
 #include "common/rt64_load_types.h"
-#include "common/rt64_thread.h"
+#include "common/rt64_mapped_file.h"
+#include "common/rt64_replacement_cache.h"
+#include "common/rt64_tmem_decoder.h"
 #include "common/rt64_tmem_hasher.h"
 #include "hle/rt64_workload_queue.h"
 
 #include "rt64_texture_cache.h"
+#include "rt64_texture_decode_batch.h"
+#include "rt64_texture_transcoder.h"
 
 #define ONLY_USE_LOW_MIP_CACHE 0
 
@@ -29,6 +35,33 @@ namespace RT64 {
     static const uint32_t TextureDataPitchAlignment = 256;
     static const uint32_t TextureDataPlacementAlignment = 512;
 
+    static_assert(TextureDecodeBatch::TexturesPerDispatch == TextureDecodeDescriptorSet::UpperRange, "Every decode dispatch must fit in one descriptor set.");
+
+    // How long the streaming jobs wait before checking again if the replacement pool is still full.
+    static const int64_t StreamPressureRetryMicroseconds = 50000;
+
+    // Stream requests for textures that haven't been used in this many frames are moved behind the rest of the queue, and the ones whose
+    // textures were evicted from the map are cancelled.
+    static const uint64_t StreamStaleFrameAge = WORKLOAD_QUEUE_SIZE * 2;
+
+    // Streamed DDS textures are first loaded with only the mipmaps up to this size so they can be shown as soon as possible. The complete
+    // texture is requested afterwards and replaces the partial one once it's loaded, unless the request is cancelled because the pool is full.
+    static const uint32_t StreamPartialMaxDimension = 256;
+
+    // Amount of reads each streaming job keeps in flight, and the size of the buffers they're read into unless the file is larger.
+    static const uint32_t StreamReadQueueDepth = 8;
+    static const size_t StreamReadBufferSize = 1024 * 1024;
+
+    // Streaming jobs stop taking new requests while the textures they loaded and that haven't been uploaded yet take this much memory.
+    // Each job finishes the batch it already read, so the limit can be exceeded by up to one batch per job.
+    static const uint64_t StreamResultMaxBytesInFlight = 256 * 1024 * 1024;
+
+    // Upper bound on the memory used by the low mips prefetched when a replacement directory is loaded.
+    static const uint64_t LowMipCachePrefetchMaxSize = 64 * 1024 * 1024;
+
+    // Textures up to this size are decoded on the CPU while they're placed in the staging buffer, as it's cheaper than the dispatch.
+    static const uint32_t TextureDecodeCPUPixelLimit = 32 * 32;
+
     ReplacementMap::ReplacementMap() {
         // Empty constructor.
     }
@@ -41,6 +74,10 @@ namespace RT64 {
         for (auto it : lowMipCacheTextures) {
             delete it.second.texture;
         }
+
+        for (auto it : partialTextureMap) {
+            delete it.second.texture;
+        }
     }
 
     void ReplacementMap::clear(std::vector<Texture *> &evictedTextures) {
@@ -49,23 +86,50 @@ namespace RT64 {
         }
 
         for (auto it : lowMipCacheTextures) {
+            if (it.second.texture != nullptr) {
+                evictedTextures.emplace_back(it.second.texture);
+            }
+        }
+
+        for (auto it : partialTextureMap) {
             evictedTextures.emplace_back(it.second.texture);
         }
 
         loadedTextureMap.clear();
+        partialTextureMap.clear();
+        partialTextureReverseMap.clear();
         loadedTextureReverseMap.clear();
         unusedTextureList.clear();
         lowMipCacheTextures.clear();
+        lowMipCacheFiles.clear();
+        lowMipCacheUsagePath.clear();
         replacementDirectories.clear();
         resolvedHashVersions.clear();
         fileSystemStreamResolvedPaths.clear();
 
         usedTexturePoolSize = 0;
         cachedTexturePoolSize = 0;
+        permanentTexturePoolSize = 0;
         fileSystemIsDirectory = false;
     }
 
     void ReplacementMap::evict(std::vector<Texture *> &evictedTextures) {
+        // Partial textures are only kept for as long as a texture uses them. The request for the rest of their mipmaps can be cancelled
+        // or held back by the pool's pressure for as long as it lasts, so they can't wait for it to be done to be released.
+        for (auto it = partialTextureMap.begin(); it != partialTextureMap.end();) {
+            if (it->second.references == 0) {
+                Texture *partialTexture = it->second.texture;
+                evictedTextures.emplace_back(partialTexture);
+                usedTexturePoolSize -= partialTexture->memorySize;
+                cachedTexturePoolSize -= partialTexture->memorySize;
+                partialTextureReverseMap.erase(partialTexture);
+                it = partialTextureMap.erase(it);
+            }
+            else {
+                it++;
+            }
+        }
+
         while ((cachedTexturePoolSize > maxTexturePoolSize) && !unusedTextureList.empty()) {
             // Push texture to the eviction list.
             Texture *lastUnusedTexture = unusedTextureList.back();
@@ -146,6 +210,27 @@ namespace RT64 {
         }
     }
 
+    void ReplacementMap::addPartialTexture(Texture *texture, uint32_t fileSystemIndex, const std::string &relativePath) {
+        // Partial textures are considered as in use for as long as they exist, as they're evicted as soon as nothing references them.
+        uint64_t pathHash = hashFromRelativePath(fileSystemIndex, relativePath);
+        assert(partialTextureMap.find(pathHash) == partialTextureMap.end());
+        partialTextureMap[pathHash].texture = texture;
+        partialTextureReverseMap[texture] = pathHash;
+        usedTexturePoolSize += texture->memorySize;
+        cachedTexturePoolSize += texture->memorySize;
+    }
+
+    Texture *ReplacementMap::getPartialTexture(uint32_t fileSystemIndex, const std::string &relativePath) const {
+        uint64_t pathHash = hashFromRelativePath(fileSystemIndex, relativePath);
+        auto it = partialTextureMap.find(pathHash);
+        if (it != partialTextureMap.end()) {
+            return it->second.texture;
+        }
+        else {
+            return nullptr;
+        }
+    }
+
     uint64_t ReplacementMap::hashFromRelativePath(uint32_t fileSystemIndex, const std::string &relativePath) const {
         XXH3_state_t xxh3;
         XXH3_64bits_reset(&xxh3);
@@ -155,6 +240,12 @@ namespace RT64 {
     }
 
     void ReplacementMap::incrementReference(Texture *texture) {
+        auto partialIt = partialTextureReverseMap.find(texture);
+        if (partialIt != partialTextureReverseMap.end()) {
+            partialTextureMap[partialIt->second].references++;
+            return;
+        }
+
         auto it = loadedTextureReverseMap.find(texture);
         assert(it != loadedTextureReverseMap.end());
 
@@ -171,6 +262,15 @@ namespace RT64 {
     }
 
     void ReplacementMap::decrementReference(Texture *texture) {
+        // Partial textures that reach zero references are released by the next eviction.
+        auto partialIt = partialTextureReverseMap.find(texture);
+        if (partialIt != partialTextureReverseMap.end()) {
+            PartialEntry &partialEntry = partialTextureMap[partialIt->second];
+            assert(partialEntry.references > 0);
+            partialEntry.references--;
+            return;
+        }
+
         auto it = loadedTextureReverseMap.find(texture);
         MapEntry &entry = it->second->second;
         assert(entry.references > 0);
@@ -235,7 +335,7 @@ namespace RT64 {
             hashes.push_back(0);
             versions.push_back(0);
             creationFrames.push_back(0);
-            listIterators.push_back(accessList.end());
+            accessList.addNode();
         }
 
         hashMap[hash] = textureIndex;
@@ -248,10 +348,10 @@ namespace RT64 {
         hashes[textureIndex] = hash;
         versions[textureIndex]++;
         creationFrames[textureIndex] = creationFrame;
+        memorySize += texture->memorySize;
         globalVersion++;
 
-        accessList.push_front({ textureIndex, creationFrame });
-        listIterators[textureIndex] = accessList.begin();
+        accessList.pushFront(textureIndex, creationFrame);
     }
 
     void TextureMap::replace(uint64_t hash, Texture *texture, bool shiftedByHalf, bool referenceCounted) {
@@ -313,68 +413,87 @@ namespace RT64 {
             textureDimensions = cachedTextureDimensions[textureIndex];
         }
 
-        // Remove the existing entry from the list if it exists.
-        AccessList::iterator listIt = listIterators[textureIndex];
-        if (listIt != accessList.end()) {
-            accessList.erase(listIt);
-        }
-
-        // Push a new access entry to the front of the list and store the new iterator.
-        accessList.push_front({ textureIndex, submissionFrame });
-        listIterators[textureIndex] = accessList.begin();
+        // Move the entry to the front of the list with the new access time.
+        accessList.moveToFront(textureIndex, submissionFrame);
         return true;
     }
 
     bool TextureMap::evict(uint64_t submissionFrame, std::vector<uint64_t> &evictedHashes) {
         evictedHashes.clear();
+        latestSubmissionFrame = std::max(latestSubmissionFrame, submissionFrame);
 
-        auto it = accessList.rbegin();
-        while (it != accessList.rend()) {
-            assert(submissionFrame >= it->second);
-            
-            // The max age allowed is the difference between the last time the texture was used and the time it was uploaded.
-            // Ensure the textures live long enough for the frame queue to use them.
-            const uint64_t MinimumMaxAge = WORKLOAD_QUEUE_SIZE * 2;
-            const uint64_t MaximumMaxAge = WORKLOAD_QUEUE_SIZE * 32;
-            const uint64_t age = submissionFrame - it->second;
-            const uint64_t maxAge = std::clamp(it->second - creationFrames[it->first], MinimumMaxAge, MaximumMaxAge);
+        // The max age allowed is the difference between the last time the texture was used and the time it was uploaded.
+        // Ensure the textures live long enough for the frame queue to use them.
+        const uint64_t MinimumMaxAge = WORKLOAD_QUEUE_SIZE * 2;
+        const uint64_t MaximumMaxAge = WORKLOAD_QUEUE_SIZE * 32;
+        uint32_t textureIndex = accessList.tail;
+        while (textureIndex != AccessList::None) {
+            const uint64_t accessFrame = accessList.nodes[textureIndex].frame;
+            const uint32_t previousIndex = accessList.nodes[textureIndex].previous;
+            assert(submissionFrame >= accessFrame);
+
+            const uint64_t age = submissionFrame - accessFrame;
+            const uint64_t maxAge = std::clamp(accessFrame - creationFrames[textureIndex], MinimumMaxAge, MaximumMaxAge);
 
             // Evict all entries that are present in the access list and are older than the frame by the specified margin.
             if (age >= maxAge) {
-                const uint32_t textureIndex = it->first;
-                const uint64_t textureHash = hashes[textureIndex];
-                evictedTextures.emplace_back(textures[textureIndex]);
-                textures[textureIndex] = nullptr;
-                textureScales[textureIndex] = { 1.0f, 1.0f };
-                hashes[textureIndex] = 0;
-                creationFrames[textureIndex] = 0;
-                freeSpaces.push_back(textureIndex);
-                listIterators[textureIndex] = accessList.end();
-                hashMap.erase(textureHash);
-                evictedHashes.push_back(textureHash);
-                it = decltype(it)(accessList.erase(std::next(it).base()));
-
-                // If a texture replacement was used for this texture, decrease the reference in the map.
-                if (textureReplacementReferenceCounted[textureIndex] && (textureReplacements[textureIndex] != nullptr)) {
-                    replacementMap.decrementReference(textureReplacements[textureIndex]);
-                }
-
-                textureReplacements[textureIndex] = nullptr;
-                textureReplacementShiftedByHalf[textureIndex] = false;
-                textureReplacementReferenceCounted[textureIndex] = false;
+                evictIndex(textureIndex, evictedHashes);
             }
             // Stop iterating if we reach an entry that has been used in the present.
             else if (age == 0) {
                 break;
             }
-            else {
-                it++;
+
+            textureIndex = previousIndex;
+        }
+
+        // If the textures still go over the budget, evict the ones that would free the most memory for the least amount of time they've been
+        // unused. Textures that might still be used by the frames in the queue are never considered.
+        if ((maxMemorySize > 0) && (memorySize > maxMemorySize)) {
+            evictionCandidates.clear();
+            textureIndex = accessList.tail;
+            while (textureIndex != AccessList::None) {
+                const uint64_t age = submissionFrame - accessList.nodes[textureIndex].frame;
+                if (age < MinimumMaxAge) {
+                    break;
+                }
+
+                evictionCandidates.emplace_back(TextureBudget::EvictionCandidate{ textureIndex, age, textures[textureIndex]->memorySize });
+                textureIndex = accessList.nodes[textureIndex].previous;
+            }
+
+            const size_t evictCount = TextureBudget::sortEvictionCandidates(evictionCandidates, memorySize, maxMemorySize);
+            for (size_t i = 0; i < evictCount; i++) {
+                evictIndex(evictionCandidates[i].textureIndex, evictedHashes);
             }
         }
 
         return !evictedHashes.empty();
     }
 
+    void TextureMap::evictIndex(uint32_t textureIndex, std::vector<uint64_t> &evictedHashes) {
+        const uint64_t textureHash = hashes[textureIndex];
+        memorySize -= textures[textureIndex]->memorySize;
+        evictedTextures.emplace_back(textures[textureIndex]);
+        textures[textureIndex] = nullptr;
+        textureScales[textureIndex] = { 1.0f, 1.0f };
+        hashes[textureIndex] = 0;
+        creationFrames[textureIndex] = 0;
+        freeSpaces.push_back(textureIndex);
+        accessList.remove(textureIndex);
+        hashMap.erase(textureHash);
+        evictedHashes.push_back(textureHash);
+
+        // If a texture replacement was used for this texture, decrease the reference in the map.
+        if (textureReplacementReferenceCounted[textureIndex] && (textureReplacements[textureIndex] != nullptr)) {
+            replacementMap.decrementReference(textureReplacements[textureIndex]);
+        }
+
+        textureReplacements[textureIndex] = nullptr;
+        textureReplacementShiftedByHalf[textureIndex] = false;
+        textureReplacementReferenceCounted[textureIndex] = false;
+    }
+
     Texture *TextureMap::get(uint32_t index) const {
         assert(index < textures.size());
         return textures[index];
@@ -384,82 +503,15 @@ namespace RT64 {
         return textures.size();
     }
 
-    // TextureCache::StreamThread
-
-    TextureCache::StreamThread::StreamThread(TextureCache *textureCache) {
-        assert(textureCache != nullptr);
-
-        this->textureCache = textureCache;
-
-        threadRunning = true;
-        worker = std::make_unique<RenderWorker>(textureCache->directWorker->device, "RT64 Stream Worker", RenderCommandListType::COPY);
-        thread = std::make_unique<std::thread>(&StreamThread::loop, this);
-    }
-
-    TextureCache::StreamThread::~StreamThread() {
-        threadRunning = false;
-        textureCache->streamDescStackChanged.notify_all();
-        thread->join();
-        thread.reset(nullptr);
-    }
-
-    void TextureCache::StreamThread::loop() {
-        Thread::setCurrentThreadName("RT64 Stream");
-
-        // Texture streaming threads should have a priority somewhere inbetween the main threads and the shader compilation threads.
-        Thread::setCurrentThreadPriority(Thread::Priority::Low);
-
-        std::vector<uint8_t> replacementBytes;
-        while (threadRunning) {
-            StreamDescription streamDesc;
-
-            // Check the top of the queue or wait if it's empty.
-            {
-                std::unique_lock queueLock(textureCache->streamDescStackMutex);
-                textureCache->streamDescStackActiveCount--;
-                textureCache->streamDescStackChanged.wait(queueLock, [this]() {
-                    return !threadRunning || !textureCache->streamDescStack.empty();
-                });
-
-                textureCache->streamDescStackActiveCount++;
-
-                if (!textureCache->streamDescStack.empty()) {
-                    streamDesc = textureCache->streamDescStack.top();
-                    textureCache->streamDescStack.pop();
-                }
-            }
-            
-            if (!streamDesc.relativePath.empty()) {
-                ElapsedTimer elapsedTimer;
-                bool fileLoaded = textureCache->textureMap.replacementMap.fileSystems[streamDesc.fileSystemIndex]->load(streamDesc.relativePath, replacementBytes);
-                textureCache->addStreamLoadTime(elapsedTimer.elapsedMicroseconds());
-
-                if (fileLoaded) {
-                    worker->commandList->begin();
-                    Texture *texture = TextureCache::loadTextureFromBytes(worker->device, worker->commandList.get(), replacementBytes, uploadResource);
-                    worker->commandList->end();
-
-                    // Only execute the command list and wait if the texture was loaded successfully.
-                    if (texture != nullptr) {
-                        worker->execute();
-                        worker->wait();
-                        textureCache->uploadQueueMutex.lock();
-                        textureCache->streamResultQueue.emplace_back(texture, streamDesc.fileSystemIndex, streamDesc.relativePath, streamDesc.fromPreload);
-                        textureCache->uploadQueueMutex.unlock();
-                        textureCache->uploadQueueChanged.notify_all();
-                    }
-                }
-            }
-        }
-    }
-
     // TextureCache
 
-    TextureCache::TextureCache(RenderWorker *directWorker, RenderWorker *copyWorker, uint32_t threadCount, const ShaderLibrary *shaderLibrary) {
+    TextureCache::TextureCache(RenderWorker *directWorker, RenderWorker *copyWorker, JobSystem *jobSystem, uint32_t threadCount, const ShaderLibrary *shaderLibrary) {
         assert(directWorker != nullptr);
+        assert(jobSystem != nullptr);
 
         this->directWorker = directWorker;
         this->copyWorker = copyWorker;
+        this->jobSystem = jobSystem;
         this->shaderLibrary = shaderLibrary;
 
         lockCounter = 0;
@@ -478,30 +530,27 @@ namespace RT64 {
         poolDesc.allowOnlyBuffers = true;
         uploadResourcePool = directWorker->device->createPool(poolDesc);
 
-        // Create upload thread.
-        uploadThread = std::make_unique<std::thread>(&TextureCache::uploadThreadLoop, this);
-
-        // Create streaming threads.
-        streamDescStackActiveCount = threadCount;
-
+        // Create the workers used by the streaming jobs. The amount of workers limits how many streaming jobs can run at the same time.
         for (uint32_t i = 0; i < threadCount; i++) {
-            streamThreads.push_back(std::make_unique<StreamThread>(this));
+            std::unique_ptr<StreamWorker> streamWorker = std::make_unique<StreamWorker>();
+            streamWorker->asyncReader = AsyncFileReader::create(StreamReadQueueDepth, StreamReadBufferSize);
+            freeStreamWorkers.emplace_back(streamWorker.get());
+            streamWorkers.emplace_back(std::move(streamWorker));
         }
     }
 
     TextureCache::~TextureCache() {
         waitForAllStreamThreads(true);
-        streamThreads.clear();
-
-        if (uploadThread != nullptr) {
-            uploadThreadRunning = false;
-            uploadQueueChanged.notify_all();
-            uploadThread->join();
-            uploadThread.reset();
-        }
+        cancelLowMipCachePrefetch();
+        cancelTranscodeJobs();
+        uploadCounter.wait();
+        saveLowMipCacheUsage();
+        streamWorkers.clear();
         
         descriptorSets.clear();
-        tmemUploadResources.clear();
+        decodeDescriptorBuffer.reset();
+        tmemStagingBufferView.reset();
+        tmemStagingBuffer.reset();
         replacementUploadResources.clear();
         uploadResourcePool.reset(nullptr);
     }
@@ -529,9 +578,16 @@ namespace RT64 {
     }
     
     void TextureCache::setRGBA32(Texture *dstTexture, RenderDevice *device, RenderCommandList *commandList, const uint8_t *bytes, size_t byteCount, uint32_t width, uint32_t height, uint32_t rowPitch, std::unique_ptr<RenderBuffer> &dstUploadResource, RenderPool *uploadResourcePool, std::mutex *uploadResourcePoolMutex) {
+        assert(commandList != nullptr);
+
+        TextureCopyList copyList;
+        setRGBA32(dstTexture, device, copyList, bytes, byteCount, width, height, rowPitch, dstUploadResource, uploadResourcePool, uploadResourcePoolMutex);
+        copyList.record(commandList);
+    }
+
+    void TextureCache::setRGBA32(Texture *dstTexture, RenderDevice *device, TextureCopyList &copyList, const uint8_t *bytes, size_t byteCount, uint32_t width, uint32_t height, uint32_t rowPitch, std::unique_ptr<RenderBuffer> &dstUploadResource, RenderPool *uploadResourcePool, std::mutex *uploadResourcePoolMutex) {
         assert(dstTexture != nullptr);
         assert(device != nullptr);
-        assert(commandList != nullptr);
         assert(bytes != nullptr);
         assert(width > 0);
         assert(height > 0);
@@ -560,8 +616,9 @@ namespace RT64 {
         dstUploadResource->unmap();
 
         uint32_t alignedRowWidth = alignedRowPitch / RenderFormatSize(dstTexture->format);
-        commandList->barriers(RenderBarrierStage::COPY, RenderTextureBarrier(dstTexture->texture.get(), RenderTextureLayout::COPY_DEST));
-        commandList->copyTextureRegion(RenderTextureCopyLocation::Subresource(dstTexture->texture.get()), RenderTextureCopyLocation::PlacedFootprint(dstUploadResource.get(), dstTexture->format, width, height, 1, alignedRowWidth));
+        copyList.barriers.emplace_back(dstTexture->texture.get(), RenderTextureLayout::COPY_DEST);
+        copyList.destinations.emplace_back(RenderTextureCopyLocation::Subresource(dstTexture->texture.get()));
+        copyList.sources.emplace_back(RenderTextureCopyLocation::PlacedFootprint(dstUploadResource.get(), dstTexture->format, width, height, 1, alignedRowWidth));
     }
 
     static RenderTextureDimension toRenderDimension(ddspp::TextureType type) {
@@ -732,19 +789,21 @@ namespace RT64 {
         }
     }
 
-    bool TextureCache::setDDS(Texture *dstTexture, RenderDevice *device, RenderCommandList *commandList, const uint8_t *bytes, size_t byteCount, std::unique_ptr<RenderBuffer> &dstUploadResource, RenderPool *uploadResourcePool, std::mutex *uploadResourcePoolMutex) {
-        assert(dstTexture != nullptr);
-        assert(device != nullptr);
-        assert(commandList != nullptr);
-        assert(bytes != nullptr);
-
-        ddspp::Descriptor ddsDescriptor;
-        ddspp::Result result = ddspp::decode_header((unsigned char *)(bytes), ddsDescriptor);
-        if (result != ddspp::Success) {
-            return false;
+    static uint32_t firstDDSMipForDimension(const ddspp::Descriptor &ddsDescriptor, uint32_t maxDimension) {
+        // Zero means every mipmap is loaded. The smallest mipmap is always loaded even if it's still larger than requested.
+        uint32_t firstMip = 0;
+        if (maxDimension > 0) {
+            while (((firstMip + 1) < ddsDescriptor.numMips) && (std::max(ddsDescriptor.width >> firstMip, ddsDescriptor.height >> firstMip) > maxDimension)) {
+                firstMip++;
+            }
         }
 
+        return firstMip;
+    }
+
+    static void createDDSTexture(Texture *dstTexture, RenderDevice *device, const ddspp::Descriptor &ddsDescriptor, uint32_t firstMip, std::vector<uint32_t> &mipmapOffsets, uint32_t &totalSize) {
         assert(ddsDescriptor.arraySize == 1 && "DDS with multiple arrays are not supported yet.");
+        assert(firstMip < std::max(ddsDescriptor.numMips, 1U));
 
         // Retrieve the block size of the format.
         uint32_t blockWidth, blockHeight;
@@ -752,37 +811,69 @@ namespace RT64 {
 
         RenderTextureDesc desc;
         desc.dimension = toRenderDimension(ddsDescriptor.type);
-        desc.width = nextSizeAlignedTo(ddsDescriptor.width, blockWidth);
-        desc.height = nextSizeAlignedTo(ddsDescriptor.height, blockHeight);
+        desc.width = nextSizeAlignedTo(std::max(ddsDescriptor.width >> firstMip, 1U), blockWidth);
+        desc.height = nextSizeAlignedTo(std::max(ddsDescriptor.height >> firstMip, 1U), blockHeight);
         desc.depth = 1;
         desc.arraySize = 1;
-        desc.mipLevels = ddsDescriptor.numMips;
+        desc.mipLevels = ddsDescriptor.numMips - firstMip;
         desc.format = toRenderFormat(ddsDescriptor.format);
 
         dstTexture->texture = device->createTexture(desc);
         dstTexture->width = desc.width;
         dstTexture->height = desc.height;
         dstTexture->mipmaps = desc.mipLevels;
+        dstTexture->residentMip = firstMip;
         dstTexture->format = desc.format;
 
-        const uint8_t *imageData = &bytes[ddsDescriptor.headerSize];
-        size_t imageDataSize = byteCount - ddsDescriptor.headerSize;
-
         // Compute the additional padding that will be required on the buffer to align the mipmap data.
-        std::vector<uint32_t> mipmapOffsets;
-        const uint32_t formatSize = RenderFormatSize(desc.format);
-        uint32_t totalSize = 0;
+        mipmapOffsets.clear();
+        totalSize = 0;
         for (uint32_t mip = 0; mip < desc.mipLevels; mip++) {
             totalSize = nextSizeAlignedTo(totalSize, TextureDataPlacementAlignment);
             mipmapOffsets.emplace_back(totalSize);
 
             uint32_t mipHeight = std::max(desc.height >> mip, 1U);
-            uint32_t ddsRowPitch = ddspp::get_row_pitch(ddsDescriptor, mip);
+            uint32_t ddsRowPitch = ddspp::get_row_pitch(ddsDescriptor, firstMip + mip);
             uint32_t alignedRowPitch = nextSizeAlignedTo(ddsRowPitch, TextureDataPitchAlignment);
             uint32_t rowCount = (mipHeight + blockWidth - 1) / blockWidth;
             totalSize += alignedRowPitch * rowCount;
         }
 
+        dstTexture->memorySize = totalSize;
+    }
+
+    static void recordDDSCopies(Texture *dstTexture, const ddspp::Descriptor &ddsDescriptor, const std::vector<uint32_t> &mipmapOffsets, RenderBuffer *uploadResource, TextureCopyList &copyList) {
+        uint32_t blockWidth, blockHeight;
+        ddspp::get_block_size(ddsDescriptor.format, blockWidth, blockHeight);
+        copyList.barriers.emplace_back(dstTexture->texture.get(), RenderTextureLayout::COPY_DEST);
+
+        const uint32_t formatSize = RenderFormatSize(dstTexture->format);
+        for (uint32_t mip = 0; mip < dstTexture->mipmaps; mip++) {
+            uint32_t offset = mipmapOffsets[mip];
+            uint32_t mipWidth = std::max(dstTexture->width >> mip, 1U);
+            uint32_t mipHeight = std::max(dstTexture->height >> mip, 1U);
+            uint32_t ddsRowPitch = ddspp::get_row_pitch(ddsDescriptor, dstTexture->residentMip + mip);
+            uint32_t alignedRowWidth = ((nextSizeAlignedTo(ddsRowPitch, TextureDataPitchAlignment) + formatSize - 1) / formatSize) * blockWidth;
+            copyList.destinations.emplace_back(RenderTextureCopyLocation::Subresource(dstTexture->texture.get(), mip));
+            copyList.sources.emplace_back(RenderTextureCopyLocation::PlacedFootprint(uploadResource, dstTexture->format, mipWidth, mipHeight, 1, alignedRowWidth, offset));
+        }
+    }
+
+    bool TextureCache::setDDS(Texture *dstTexture, RenderDevice *device, TextureCopyList &copyList, const uint8_t *bytes, size_t byteCount, std::unique_ptr<RenderBuffer> &dstUploadResource, RenderPool *uploadResourcePool, std::mutex *uploadResourcePoolMutex) {
+        assert(dstTexture != nullptr);
+        assert(device != nullptr);
+        assert(bytes != nullptr);
+
+        ddspp::Descriptor ddsDescriptor;
+        ddspp::Result result = ddspp::decode_header((unsigned char *)(bytes), ddsDescriptor);
+        if (result != ddspp::Success) {
+            return false;
+        }
+
+        std::vector<uint32_t> mipmapOffsets;
+        uint32_t totalSize;
+        createDDSTexture(dstTexture, device, ddsDescriptor, 0, mipmapOffsets, totalSize);
+
         if (uploadResourcePool != nullptr) {
             assert(uploadResourcePoolMutex != nullptr);
             std::unique_lock queueLock(*uploadResourcePoolMutex);
@@ -792,14 +883,15 @@ namespace RT64 {
             dstUploadResource = device->createBuffer(RenderBufferDesc::UploadBuffer(totalSize));
         }
 
-        dstTexture->memorySize = totalSize;
-
         // Copy each mipmap into the buffer with the correct padding applied.
+        uint32_t blockWidth, blockHeight;
+        ddspp::get_block_size(ddsDescriptor.format, blockWidth, blockHeight);
+        const uint8_t *imageData = &bytes[ddsDescriptor.headerSize];
         uint8_t *dstData = reinterpret_cast<uint8_t *>(dstUploadResource->map());
         memset(dstData, 0, totalSize);
-        for (uint32_t mip = 0; mip < desc.mipLevels; mip++) {
+        for (uint32_t mip = 0; mip < dstTexture->mipmaps; mip++) {
             uint32_t mipOffset = mipmapOffsets[mip];
-            uint32_t mipHeight = std::max(desc.height >> mip, 1U);
+            uint32_t mipHeight = std::max(dstTexture->height >> mip, 1U);
             uint32_t ddsOffset = ddspp::get_offset(ddsDescriptor, mip, 0);
             uint32_t ddsRowPitch = ddspp::get_row_pitch(ddsDescriptor, mip);
             uint32_t alignedRowPitch = nextSizeAlignedTo(ddsRowPitch, TextureDataPitchAlignment);
@@ -809,142 +901,278 @@ namespace RT64 {
 
         dstUploadResource->unmap();
 
-        commandList->barriers(RenderBarrierStage::COPY, RenderTextureBarrier(dstTexture->texture.get(), RenderTextureLayout::COPY_DEST));
+        recordDDSCopies(dstTexture, ddsDescriptor, mipmapOffsets, dstUploadResource.get(), copyList);
+        return true;
+    }
 
-        for (uint32_t mip = 0; mip < desc.mipLevels; mip++) {
-            uint32_t offset = mipmapOffsets[mip];
-            uint32_t mipWidth = std::max(desc.width >> mip, 1U);
-            uint32_t mipHeight = std::max(desc.height >> mip, 1U);
-            uint32_t ddsRowPitch = ddspp::get_row_pitch(ddsDescriptor, mip);
-            uint32_t alignedRowWidth = ((nextSizeAlignedTo(ddsRowPitch, TextureDataPitchAlignment) + formatSize - 1) / formatSize) * blockWidth;
-            commandList->copyTextureRegion(RenderTextureCopyLocation::Subresource(dstTexture->texture.get(), mip), RenderTextureCopyLocation::PlacedFootprint(dstUploadResource.get(), desc.format, mipWidth, mipHeight, 1, alignedRowWidth, offset));
+    bool TextureCache::setDDS(Texture *dstTexture, RenderDevice *device, TextureCopyList &copyList, FileSystemReader &reader, std::unique_ptr<RenderBuffer> &dstUploadResource, uint32_t maxDimension) {
+        assert(dstTexture != nullptr);
+        assert(device != nullptr);
+
+        // Only the header is read first, as it's all that's needed to size the upload buffer. The caller must've read the magic already.
+        uint8_t headerBytes[sizeof(uint32_t) + sizeof(ddspp::Header) + sizeof(ddspp::HeaderDXT10)];
+        const uint32_t ddsMagic = ddspp::DDS_MAGIC;
+        memcpy(headerBytes, &ddsMagic, sizeof(uint32_t));
+        size_t headerSize = sizeof(uint32_t) + sizeof(ddspp::Header);
+        if (reader.read(&headerBytes[sizeof(uint32_t)], sizeof(ddspp::Header)) != sizeof(ddspp::Header)) {
+            return false;
         }
 
-        return true;
-    }
+        if (ddspp::is_dxt10(*reinterpret_cast<const ddspp::Header *>(&headerBytes[sizeof(uint32_t)]))) {
+            if (reader.read(&headerBytes[headerSize], sizeof(ddspp::HeaderDXT10)) != sizeof(ddspp::HeaderDXT10)) {
+                return false;
+            }
+        }
 
-    bool TextureCache::setLowMipCache(RenderDevice *device, RenderCommandList *commandList, const uint8_t *bytes, size_t byteCount, std::unique_ptr<RenderBuffer> &dstUploadResource, std::unordered_map<std::string, LowMipCacheTexture> &dstTextureMap, uint64_t &totalMemory) {
-        dstUploadResource = device->createBuffer(RenderBufferDesc::UploadBuffer(byteCount));
+        ddspp::Descriptor ddsDescriptor;
+        ddspp::Result result = ddspp::decode_header(headerBytes, ddsDescriptor);
+        if (result != ddspp::Success) {
+            return false;
+        }
+
+        // The largest mipmaps go first in the file, so the ones that aren't needed are skipped over.
+        const uint32_t firstMip = firstDDSMipForDimension(ddsDescriptor, maxDimension);
+        std::vector<uint32_t> mipmapOffsets;
+        uint32_t totalSize;
+        createDDSTexture(dstTexture, device, ddsDescriptor, firstMip, mipmapOffsets, totalSize);
+        dstUploadResource = device->createBuffer(RenderBufferDesc::UploadBuffer(totalSize));
+
+        // Decompress every mipmap straight into its place in the buffer. The padding at the end of the rows is never read by the copies,
+        // so it's left as is. Rows are read one by one only when the padding doesn't match.
+        uint32_t blockWidth, blockHeight;
+        ddspp::get_block_size(ddsDescriptor.format, blockWidth, blockHeight);
+        uint8_t *dstData = reinterpret_cast<uint8_t *>(dstUploadResource->map());
+        uint32_t readCursor = 0;
+        bool readFailed = false;
+        for (uint32_t mip = 0; (mip < dstTexture->mipmaps) && !readFailed; mip++) {
+            uint32_t mipOffset = mipmapOffsets[mip];
+            uint32_t mipHeight = std::max(dstTexture->height >> mip, 1U);
+            uint32_t ddsOffset = ddspp::get_offset(ddsDescriptor, firstMip + mip, 0);
+            uint32_t ddsRowPitch = ddspp::get_row_pitch(ddsDescriptor, firstMip + mip);
+            uint32_t alignedRowPitch = nextSizeAlignedTo(ddsRowPitch, TextureDataPitchAlignment);
+            uint32_t rowCount = (mipHeight + blockWidth - 1) / blockWidth;
+
+            // Skip over any data in between the mipmaps, including the mipmaps that aren't loaded.
+            if (readCursor < ddsOffset) {
+                const size_t skipCount = ddsOffset - readCursor;
+                readFailed = (reader.skip(skipCount) != skipCount);
+                readCursor = ddsOffset;
+            }
+
+            if (readFailed || (readCursor > ddsOffset)) {
+                readFailed = true;
+                break;
+            }
+
+            if (ddsRowPitch == alignedRowPitch) {
+                const size_t mipSize = size_t(ddsRowPitch) * rowCount;
+                readFailed = (reader.read(&dstData[mipOffset], mipSize) != mipSize);
+            }
+            else {
+                for (uint32_t row = 0; (row < rowCount) && !readFailed; row++) {
+                    readFailed = (reader.read(&dstData[mipOffset + row * alignedRowPitch], ddsRowPitch) != ddsRowPitch);
+                }
+            }
+
+            readCursor += ddsRowPitch * rowCount;
+        }
 
-        // Upload the entire file to the GPU to copy data from it directly.
-        void *uploadData = dstUploadResource->map();
-        memcpy(uploadData, bytes, byteCount);
         dstUploadResource->unmap();
 
-        std::vector<RenderTextureBarrier> beforeCopyBarriers;
-        std::vector<RenderTextureCopyLocation> copyDestinations;
-        std::vector<RenderTextureCopyLocation> copySources;
-        std::list<std::pair<std::string, Texture *>> texturesLoaded;
+        if (readFailed) {
+            dstUploadResource.reset();
+            return false;
+        }
+
+        recordDDSCopies(dstTexture, ddsDescriptor, mipmapOffsets, dstUploadResource.get(), copyList);
+        return true;
+    }
+
+    static void alignToTexturePlacement(size_t &byteCursor) {
+        if ((byteCursor % TextureDataPlacementAlignment) != 0) {
+            byteCursor += TextureDataPlacementAlignment - (byteCursor % TextureDataPlacementAlignment);
+        }
+    }
+
+    bool TextureCache::indexLowMipCache(FileSystemReader &reader, uint32_t cacheIndex, std::unordered_map<std::string, LowMipCacheTexture> &dstTextureMap) {
+        // Only the headers are read here. The mipmaps are skipped and only read when the texture is used for the first time.
+        std::list<std::pair<std::string, LowMipCacheTexture>> entriesIndexed;
+        std::vector<uint32_t> mipmapSizes;
+        std::string cachePath;
         size_t byteCursor = 0;
         bool readFailed = false;
-        while (byteCursor < byteCount) {
-            const ReplacementMipmapCacheHeader *cacheHeader = reinterpret_cast<const ReplacementMipmapCacheHeader *>(&bytes[byteCursor]);
+        while (true) {
+            const size_t headerOffset = byteCursor;
+            ReplacementMipmapCacheHeader cacheHeader;
+            const size_t headerReadCount = reader.read(reinterpret_cast<uint8_t *>(&cacheHeader), sizeof(ReplacementMipmapCacheHeader));
+            if (headerReadCount == 0) {
+                break;
+            }
+            else if (headerReadCount < sizeof(ReplacementMipmapCacheHeader)) {
+                readFailed = true;
+                break;
+            }
+
             byteCursor += sizeof(ReplacementMipmapCacheHeader);
 
-            if (cacheHeader->magic != ReplacementMipmapCacheHeaderMagic) {
+            if (cacheHeader.magic != ReplacementMipmapCacheHeaderMagic) {
                 readFailed = true;
                 break;
             }
 
-            if (cacheHeader->version > ReplacementMipmapCacheHeaderVersion) {
+            if (cacheHeader.version > ReplacementMipmapCacheHeaderVersion) {
                 readFailed = true;
                 break;
             }
 
-            const uint32_t *mipmapSizes = reinterpret_cast<const uint32_t *>(&bytes[byteCursor]);
-            byteCursor += cacheHeader->mipCount * sizeof(uint32_t);
+            // Only the sizes are needed to index the entry. The aligned row pitches that follow them are read along with the mipmaps.
+            mipmapSizes.resize(cacheHeader.mipCount * 2);
+            cachePath.resize(cacheHeader.pathLength);
+            const size_t tableSize = mipmapSizes.size() * sizeof(uint32_t);
+            if ((reader.read(reinterpret_cast<uint8_t *>(mipmapSizes.data()), tableSize) < tableSize) || (reader.read(reinterpret_cast<uint8_t *>(cachePath.data()), cachePath.size()) < cachePath.size())) {
+                readFailed = true;
+                break;
+            }
 
-            const uint32_t *mipmapAlignedRowPitches = reinterpret_cast<const uint32_t *>(&bytes[byteCursor]);
-            byteCursor += cacheHeader->mipCount * sizeof(uint32_t);
+            byteCursor += tableSize + cachePath.size();
 
-            std::string cachePath(reinterpret_cast<const char *>(&bytes[byteCursor]), cacheHeader->pathLength);
-            byteCursor += cacheHeader->pathLength;
+            LowMipCacheTexture entry;
+            entry.cacheIndex = cacheIndex;
+            entry.headerOffset = headerOffset;
+            for (uint32_t i = 0; (i < cacheHeader.mipCount) && !readFailed; i++) {
+                size_t mipmapCursor = byteCursor;
+                alignToTexturePlacement(mipmapCursor);
+                mipmapCursor += mipmapSizes[i];
 
-            auto alignToTexturePlacement = [](size_t &byteCursor) {
-                if ((byteCursor % TextureDataPlacementAlignment) != 0) {
-                    byteCursor += TextureDataPlacementAlignment - (byteCursor % TextureDataPlacementAlignment);
-                }
-            };
+                const size_t skipCount = mipmapCursor - byteCursor;
+                readFailed = (reader.skip(skipCount) < skipCount);
+                byteCursor = mipmapCursor;
+                entry.memorySize += mipmapSizes[i];
+            }
 
-            std::string cachePathForward = FileSystem::toForwardSlashes(cachePath);
-            const bool skipTexture = (dstTextureMap.find(cachePathForward) != dstTextureMap.end());
-            if (skipTexture) {
-                for (uint32_t i = 0; i < cacheHeader->mipCount; i++) {
-                    alignToTexturePlacement(byteCursor);
-                    byteCursor += mipmapSizes[i];
-                }
+            if (readFailed) {
+                break;
             }
-            else {
-                RenderFormat renderFormat = toRenderFormat(ddspp::DXGIFormat(cacheHeader->dxgiFormat));
-                RenderTextureDesc textureDesc = RenderTextureDesc::Texture2D(cacheHeader->width, cacheHeader->height, cacheHeader->mipCount, renderFormat);
-                Texture *newTexture = new Texture();
-                newTexture->texture = device->createTexture(textureDesc);
-                newTexture->format = renderFormat;
-                newTexture->width = cacheHeader->width;
-                newTexture->height = cacheHeader->height;
-                newTexture->mipmaps = cacheHeader->mipCount;
-
-                const uint32_t formatSize = RenderFormatSize(renderFormat);
-                const uint32_t blockWidth = RenderFormatBlockWidth(renderFormat);
-                for (uint32_t i = 0; i < cacheHeader->mipCount; i++) {
-                    alignToTexturePlacement(byteCursor);
-                    uint32_t mipmapWidth = std::max(cacheHeader->width >> i, 1U);
-                    uint32_t mipmapHeight = std::max(cacheHeader->height >> i, 1U);
-                    uint32_t alignedRowWidth = ((mipmapAlignedRowPitches[i] + formatSize - 1) / formatSize) * blockWidth;
-                    beforeCopyBarriers.emplace_back(RenderTextureBarrier(newTexture->texture.get(), RenderTextureLayout::COPY_DEST));
-                    copyDestinations.emplace_back(RenderTextureCopyLocation::Subresource(newTexture->texture.get(), i));
-                    copySources.emplace_back(RenderTextureCopyLocation::PlacedFootprint(dstUploadResource.get(), renderFormat, mipmapWidth, mipmapHeight, 1, alignedRowWidth, byteCursor));
-                    byteCursor += mipmapSizes[i];
-                    newTexture->memorySize += mipmapSizes[i];
-                }
 
-                totalMemory += newTexture->memorySize;
-                texturesLoaded.emplace_back(cachePathForward, newTexture);
+            entry.byteCount = byteCursor - headerOffset;
+
+            std::string cachePathForward = FileSystem::toForwardSlashes(cachePath);
+            if (dstTextureMap.find(cachePathForward) == dstTextureMap.end()) {
+                entriesIndexed.emplace_back(cachePathForward, entry);
             }
         }
 
         if (readFailed) {
-            // Delete all textures that were loaded.
-            for (auto pair : texturesLoaded) {
-                delete pair.second;
-            }
-
             return false;
         }
 
-        if (!texturesLoaded.empty()) {
-            // Only add textures to the map if reading the entire cache was successful.
-            for (auto pair : texturesLoaded) {
-                dstTextureMap[pair.first] = { pair.second, false };
-            }
+        // Only add entries to the map if reading the entire cache was successful.
+        for (const auto &pair : entriesIndexed) {
+            dstTextureMap[pair.first] = pair.second;
+        }
 
-            // Record to the command list.
-            commandList->barriers(RenderBarrierStage::COPY, beforeCopyBarriers);
+        return true;
+    }
 
-            for (size_t i = 0; i < copyDestinations.size(); i++) {
-                commandList->copyTextureRegion(copyDestinations[i], copySources[i]);
-            }
+    bool TextureCache::readLowMipCacheEntry(const LowMipCacheFile &cacheFile, size_t headerOffset, size_t byteCount, std::vector<uint8_t> &entryBytes, const uint8_t *&entryData) {
+        if (!cacheFile.bytes.empty()) {
+            assert((headerOffset + byteCount) <= cacheFile.bytes.size());
+            entryData = &cacheFile.bytes[headerOffset];
+            return true;
+        }
+
+        std::ifstream cacheStream(cacheFile.filePath, std::ios::binary);
+        if (!cacheStream.is_open()) {
+            return false;
+        }
+
+        entryBytes.resize(byteCount);
+        cacheStream.seekg(cacheFile.fileOffset + headerOffset);
+        cacheStream.read(reinterpret_cast<char *>(entryBytes.data()), byteCount);
+        if (cacheStream.fail()) {
+            return false;
         }
 
+        entryData = entryBytes.data();
         return true;
     }
 
-    Texture *TextureCache::loadTextureFromBytes(RenderDevice *device, RenderCommandList *commandList, const std::vector<uint8_t> &fileBytes, std::unique_ptr<RenderBuffer> &dstUploadResource, RenderPool *resourcePool, std::mutex *uploadResourcePoolMutex) {
+    Texture *TextureCache::loadLowMipCacheTexture(RenderDevice *device, TextureCopyList &copyList, const uint8_t *entryData, size_t headerOffset, size_t byteCount, std::unique_ptr<RenderBuffer> &dstUploadResource) {
+        // The entry was already validated when the cache was indexed. The cursor is kept relative to the start of the cache, as that's
+        // what the mipmaps are aligned to.
+        size_t byteCursor = headerOffset;
+        const ReplacementMipmapCacheHeader *cacheHeader = reinterpret_cast<const ReplacementMipmapCacheHeader *>(entryData);
+        byteCursor += sizeof(ReplacementMipmapCacheHeader);
+
+        const uint32_t *mipmapSizes = reinterpret_cast<const uint32_t *>(&entryData[byteCursor - headerOffset]);
+        byteCursor += cacheHeader->mipCount * sizeof(uint32_t);
+
+        const uint32_t *mipmapAlignedRowPitches = reinterpret_cast<const uint32_t *>(&entryData[byteCursor - headerOffset]);
+        byteCursor += cacheHeader->mipCount * sizeof(uint32_t);
+        byteCursor += cacheHeader->pathLength;
+
+        // The mipmaps were already laid out by the packer with the placement and pitch alignment the copies need, so the entire range
+        // can be uploaded as is. The start of the range is aligned as well, so the offsets stay valid relative to it.
+        alignToTexturePlacement(byteCursor);
+        const size_t dataStart = byteCursor;
+        size_t dataEnd = byteCursor;
+        for (uint32_t i = 0; i < cacheHeader->mipCount; i++) {
+            alignToTexturePlacement(dataEnd);
+            dataEnd += mipmapSizes[i];
+        }
+
+        assert((dataEnd - headerOffset) <= byteCount);
+        dstUploadResource = device->createBuffer(RenderBufferDesc::UploadBuffer(std::max(dataEnd - dataStart, size_t(1))));
+        void *uploadData = dstUploadResource->map();
+        memcpy(uploadData, &entryData[dataStart - headerOffset], dataEnd - dataStart);
+        dstUploadResource->unmap();
+
+        RenderFormat renderFormat = toRenderFormat(ddspp::DXGIFormat(cacheHeader->dxgiFormat));
+        RenderTextureDesc textureDesc = RenderTextureDesc::Texture2D(cacheHeader->width, cacheHeader->height, cacheHeader->mipCount, renderFormat);
+        Texture *newTexture = new Texture();
+        newTexture->texture = device->createTexture(textureDesc);
+        newTexture->format = renderFormat;
+        newTexture->width = cacheHeader->width;
+        newTexture->height = cacheHeader->height;
+        newTexture->mipmaps = cacheHeader->mipCount;
+
+        const uint32_t formatSize = RenderFormatSize(renderFormat);
+        const uint32_t blockWidth = RenderFormatBlockWidth(renderFormat);
+        copyList.barriers.emplace_back(RenderTextureBarrier(newTexture->texture.get(), RenderTextureLayout::COPY_DEST));
+        for (uint32_t i = 0; i < cacheHeader->mipCount; i++) {
+            alignToTexturePlacement(byteCursor);
+            uint32_t mipmapWidth = std::max(cacheHeader->width >> i, 1U);
+            uint32_t mipmapHeight = std::max(cacheHeader->height >> i, 1U);
+            uint32_t alignedRowWidth = ((mipmapAlignedRowPitches[i] + formatSize - 1) / formatSize) * blockWidth;
+            copyList.destinations.emplace_back(RenderTextureCopyLocation::Subresource(newTexture->texture.get(), i));
+            copyList.sources.emplace_back(RenderTextureCopyLocation::PlacedFootprint(dstUploadResource.get(), renderFormat, mipmapWidth, mipmapHeight, 1, alignedRowWidth, byteCursor - dataStart));
+            byteCursor += mipmapSizes[i];
+            newTexture->memorySize += mipmapSizes[i];
+        }
+
+        return newTexture;
+    }
+
+    Texture *TextureCache::loadTextureFromBytes(RenderDevice *device, TextureCopyList &copyList, const uint8_t *fileBytes, size_t fileSize, std::unique_ptr<RenderBuffer> &dstUploadResource, RenderPool *resourcePool, std::mutex *uploadResourcePoolMutex) {
         const uint32_t PNG_MAGIC = 0x474E5089;
+        if (fileSize < sizeof(uint32_t)) {
+            return nullptr;
+        }
+
         Texture *replacementTexture = new Texture();
-        uint32_t magicNumber = *reinterpret_cast<const uint32_t *>(fileBytes.data());
+        uint32_t magicNumber = *reinterpret_cast<const uint32_t *>(fileBytes);
         bool loadedTexture = false;
         switch (magicNumber) {
         case ddspp::DDS_MAGIC:
-            loadedTexture = TextureCache::setDDS(replacementTexture, device, commandList, fileBytes.data(), fileBytes.size(), dstUploadResource, resourcePool, uploadResourcePoolMutex);
+            loadedTexture = TextureCache::setDDS(replacementTexture, device, copyList, fileBytes, fileSize, dstUploadResource, resourcePool, uploadResourcePoolMutex);
             break;
         case PNG_MAGIC: {
             int width, height;
-            stbi_uc *data = stbi_load_from_memory(fileBytes.data(), fileBytes.size(), &width, &height, nullptr, 4);
+            stbi_uc *data = stbi_load_from_memory(fileBytes, int(fileSize), &width, &height, nullptr, 4);
             if (data != nullptr) {
                 uint32_t rowPitch = uint32_t(width) * 4;
                 size_t byteCount = uint32_t(height) * rowPitch;
-                TextureCache::setRGBA32(replacementTexture, device, commandList, data, byteCount, uint32_t(width), uint32_t(height), rowPitch, dstUploadResource, resourcePool);
+                TextureCache::setRGBA32(replacementTexture, device, copyList, data, byteCount, uint32_t(width), uint32_t(height), rowPitch, dstUploadResource, resourcePool, uploadResourcePoolMutex);
                 stbi_image_free(data);
                 loadedTexture = true;
             }
@@ -965,38 +1193,86 @@ namespace RT64 {
         }
     }
 
-    void TextureCache::uploadThreadLoop() {
-        Thread::setCurrentThreadName("RT64 Texture");
+    Texture *TextureCache::loadTextureFromBytes(RenderDevice *device, TextureCopyList &copyList, const std::vector<uint8_t> &fileBytes, std::unique_ptr<RenderBuffer> &dstUploadResource, RenderPool *resourcePool, std::mutex *uploadResourcePoolMutex) {
+        return TextureCache::loadTextureFromBytes(device, copyList, fileBytes.data(), fileBytes.size(), dstUploadResource, resourcePool, uploadResourcePoolMutex);
+    }
 
-        uploadThreadRunning = true;
+    Texture *TextureCache::loadDDSFromReader(RenderDevice *device, TextureCopyList &copyList, FileSystemReader &reader, size_t fileSize, std::vector<uint8_t> &fileBytes, std::unique_ptr<RenderBuffer> &dstUploadResource, uint32_t maxDimension) {
+        uint32_t magicNumber = 0;
+        if ((fileSize < sizeof(uint32_t)) || (reader.read(reinterpret_cast<uint8_t *>(&magicNumber), sizeof(uint32_t)) != sizeof(uint32_t))) {
+            return nullptr;
+        }
 
-        std::vector<TextureUpload> queueCopy;
-        std::vector<TextureUpload> newQueue;
-        std::vector<ReplacementResolvedPath> resolvedPathQueueCopy;
-        std::vector<StreamResult> streamResultQueueCopy;
-        std::vector<TextureMapAddition> textureMapAdditions;
-        std::vector<ReplacementMapAddition> replacementMapAdditions;
-        std::vector<RenderTextureBarrier> beforeCopyBarriers;
-        std::vector<RenderTextureBarrier> beforeDecodeBarriers;
-        std::vector<RenderTextureBarrier> afterDecodeBarriers;
-        std::vector<uint8_t> replacementBytes;
+        if (magicNumber == ddspp::DDS_MAGIC) {
+            Texture *replacementTexture = new Texture();
+            if (TextureCache::setDDS(replacementTexture, device, copyList, reader, dstUploadResource, maxDimension)) {
+                return replacementTexture;
+            }
+            else {
+                delete replacementTexture;
+                return nullptr;
+            }
+        }
 
-        while (uploadThreadRunning) {
-            resolvedPathQueueCopy.clear();
-            streamResultQueueCopy.clear();
+        // Any other format must be entirely in memory to be decoded, which is left to the caller so it can use a different decoder.
+        fileBytes.resize(fileSize);
+        memcpy(fileBytes.data(), &magicNumber, sizeof(uint32_t));
+        if (reader.read(&fileBytes[sizeof(uint32_t)], fileSize - sizeof(uint32_t)) != (fileSize - sizeof(uint32_t))) {
+            fileBytes.clear();
+        }
+
+        return nullptr;
+    }
+
+    void TextureCache::scheduleUploadJob() {
+        // Only one upload job can be in flight at a time, as the uploads must be processed in the order they were queued.
+        {
+            std::unique_lock queueLock(uploadQueueMutex);
+            if (uploadJobScheduled) {
+                return;
+            }
+
+            uploadJobScheduled = true;
+        }
+
+        jobSystem->submit(JobSystem::Priority::Normal, [this]() { uploadJob(); }, &uploadCounter);
+    }
+
+    void TextureCache::uploadJob() {
+        std::vector<TextureUpload> queueCopy;
+        std::vector<uint32_t> stagingOffsets;
+        std::vector<uint32_t> decodedOffsets;
+        TextureDecodeBatch decodeBatch;
+        std::vector<ReplacementResolvedPath> resolvedPathQueueCopy;
+        std::vector<StreamResult> streamResultQueueCopy;
+        std::vector<LowMipCacheResult> lowMipCacheResultQueueCopy;
+        std::vector<TextureMapAddition> textureMapAdditions;
+        std::vector<ReplacementMapAddition> replacementMapAdditions;
+        std::vector<RenderTextureBarrier> beforeCopyBarriers;
+        std::vector<RenderTextureBarrier> beforeDecodeBarriers;
+        std::vector<RenderTextureBarrier> afterDecodeBarriers;
+        std::vector<uint8_t> replacementBytes;
+
+        while (true) {
+            resolvedPathQueueCopy.clear();
+            streamResultQueueCopy.clear();
+            lowMipCacheResultQueueCopy.clear();
             beforeCopyBarriers.clear();
             beforeDecodeBarriers.clear();
             afterDecodeBarriers.clear();
 
-            // Check the top of the queue or wait if it's empty.
+            // Check the top of the queue or finish the job if it's empty.
             {
                 std::unique_lock queueLock(uploadQueueMutex);
-                uploadQueueChanged.wait(queueLock, [this]() {
-                    return !uploadThreadRunning || !uploadQueue.empty() || !resolvedPathQueue.empty() || !streamResultQueue.empty();
-                });
+                if (uploadQueue.empty() && resolvedPathQueue.empty() && streamResultQueue.empty() && lowMipCacheResultQueue.empty()) {
+                    uploadJobScheduled = false;
+                    return;
+                }
 
+                // Take all the pending uploads at once instead of copying them so producers only hold the lock for as long as it takes to push.
                 if (!uploadQueue.empty()) {
-                    queueCopy = uploadQueue;
+                    queueCopy.swap(uploadQueue);
+                    uploadsInProgress = queueCopy.size();
                 }
 
                 if (!resolvedPathQueue.empty()) {
@@ -1005,8 +1281,39 @@ namespace RT64 {
                 }
 
                 if (!streamResultQueue.empty()) {
-                    streamResultQueueCopy.insert(streamResultQueueCopy.end(), streamResultQueue.begin(), streamResultQueue.end());
-                    streamResultQueue.clear();
+                    streamResultQueueCopy.swap(streamResultQueue);
+                }
+
+                if (!lowMipCacheResultQueue.empty()) {
+                    lowMipCacheResultQueueCopy.swap(lowMipCacheResultQueue);
+                }
+            }
+
+            // Remember how much memory the stream results take before any of them can be deleted, so it can be released once they're uploaded.
+            uint64_t streamResultBytes = 0;
+            for (const StreamResult &result : streamResultQueueCopy) {
+                if (result.texture != nullptr) {
+                    streamResultBytes += result.texture->memorySize;
+                }
+            }
+
+            if (!lowMipCacheResultQueueCopy.empty()) {
+                // Adopt the prefetched low mips unless the entry was already loaded because it was used before the prefetch got to it.
+                std::unique_lock lock(textureMapMutex);
+                for (LowMipCacheResult &result : lowMipCacheResultQueueCopy) {
+                    auto lowMipCacheIt = textureMap.replacementMap.lowMipCacheTextures.find(result.relativePath);
+                    if ((lowMipCacheIt == textureMap.replacementMap.lowMipCacheTextures.end()) || (lowMipCacheIt->second.texture != nullptr)) {
+                        delete result.texture;
+                        result.texture = nullptr;
+                        continue;
+                    }
+
+                    lowMipCacheIt->second.texture = result.texture;
+                    lowMipCacheIt->second.transitioned = true;
+                    textureMap.replacementMap.usedTexturePoolSize += result.texture->memorySize;
+                    textureMap.replacementMap.cachedTexturePoolSize += result.texture->memorySize;
+                    textureMap.replacementMap.permanentTexturePoolSize += result.texture->memorySize;
+                    afterDecodeBarriers.emplace_back(result.texture->texture.get(), RenderTextureLayout::SHADER_READ);
                 }
             }
             
@@ -1015,18 +1322,63 @@ namespace RT64 {
                     // Add the textures to the replacement pool as a loaded texture.
                     std::unique_lock lock(textureMapMutex);
                     for (const StreamResult &result : streamResultQueueCopy) {
+                        // The request was cancelled by the streaming thread. Queue it again if any other texture is still waiting on the
+                        // same file, or forget about it entirely so the path can be requested again if the texture shows up later.
+                        if (result.texture == nullptr) {
+                            auto &streamResolvedPaths = textureMap.replacementMap.fileSystemStreamResolvedPaths[result.fileSystemIndex];
+                            auto range = streamResolvedPaths.equal_range(result.relativePath);
+                            auto aliveIt = std::find_if(range.first, range.second, [&](const auto &it) {
+                                return textureMap.hashMap.find(it.second.textureHash) != textureMap.hashMap.end();
+                            });
+
+                            if (aliveIt != range.second) {
+                                const uint64_t projectedSize = textureMap.replacementMap.fileSystems[result.fileSystemIndex]->getSize(result.relativePath);
+                                const bool partialLoaded = (textureMap.replacementMap.getPartialTexture(result.fileSystemIndex, result.relativePath) != nullptr);
+                                pushStreamDescription(StreamDescription(result.fileSystemIndex, result.relativePath, false, aliveIt->second.textureHash, textureMap.latestSubmissionFrame, projectedSize, partialLoaded ? 0 : StreamPartialMaxDimension));
+                            }
+                            else {
+                                // None of the textures that could be using the partial texture are alive anymore, so it's released by the next eviction.
+                                streamResolvedPaths.erase(range.first, range.second);
+                                textureMap.replacementMap.fileSystemStreamSets[result.fileSystemIndex].erase(result.relativePath);
+                            }
+
+                            continue;
+                        }
+
+                        // Show the partial texture in place of the replacement until the request for the complete texture is done.
+                        // TODO: The complete request reads the whole file again into a separate texture. Streaming only the missing mipmaps
+                        // into the partial texture and dropping the top mipmaps of loaded textures under pool pressure is left for later.
+                        if (result.texture->residentMip > 0) {
+                            auto &streamResolvedPaths = textureMap.replacementMap.fileSystemStreamResolvedPaths[result.fileSystemIndex];
+                            auto range = streamResolvedPaths.equal_range(result.relativePath);
+                            auto aliveIt = std::find_if(range.first, range.second, [&](const auto &it) {
+                                return textureMap.hashMap.find(it.second.textureHash) != textureMap.hashMap.end();
+                            });
+
+                            const uint64_t textureHash = (aliveIt != range.second) ? aliveIt->second.textureHash : ((range.first != range.second) ? range.first->second.textureHash : 0);
+                            const uint64_t projectedSize = textureMap.replacementMap.fileSystems[result.fileSystemIndex]->getSize(result.relativePath);
+                            textureMap.replacementMap.addPartialTexture(result.texture, result.fileSystemIndex, result.relativePath);
+                            pushStreamDescription(StreamDescription(result.fileSystemIndex, result.relativePath, false, textureHash, textureMap.latestSubmissionFrame, projectedSize));
+                            continue;
+                        }
+
                         textureMap.replacementMap.addLoadedTexture(result.texture, result.fileSystemIndex, result.relativePath, !result.fromPreload);
 
                         // Increment texture pool memory used permanently if the texture was preloaded.
                         if (result.fromPreload) {
                             textureMap.replacementMap.usedTexturePoolSize += result.texture->memorySize;
                             textureMap.replacementMap.cachedTexturePoolSize += result.texture->memorySize;
+                            textureMap.replacementMap.permanentTexturePoolSize += result.texture->memorySize;
                         }
                     }
                 }
 
                 // Add all the pending transition barriers and replacement checks.
                 for (const StreamResult &result : streamResultQueueCopy) {
+                    if (result.texture == nullptr) {
+                        continue;
+                    }
+
                     afterDecodeBarriers.emplace_back(result.texture->texture.get(), RenderTextureLayout::SHADER_READ);
 
                     auto &streamResolvedPaths = textureMap.replacementMap.fileSystemStreamResolvedPaths[result.fileSystemIndex];
@@ -1040,29 +1392,91 @@ namespace RT64 {
             }
 
             if (!queueCopy.empty() || !resolvedPathQueueCopy.empty() || !afterDecodeBarriers.empty()) {
-                // Create new upload buffers and descriptor heaps to fill out the required size.
+                // Place the contents of every upload in the batch in a single staging buffer. The buffer only grows, as the previous batch
+                // is guaranteed to be done with it by the time a new one starts. The same buffer is used as the TMEM atlas the decoder reads from.
                 const size_t queueSize = queueCopy.size();
-                const uint64_t TMEMSize = 0x1000;
-                {
+                uint32_t stagingSize = 0;
+                stagingOffsets.resize(queueSize);
+                decodedOffsets.resize(queueSize);
+                for (size_t i = 0; i < queueSize; i++) {
+                    const TextureUpload &upload = queueCopy[i];
+                    stagingOffsets[i] = stagingSize;
+                    stagingSize += uint32_t(upload.bytesTMEM.size());
+                    stagingSize = nextSizeAlignedTo(stagingSize, TextureDataPlacementAlignment);
+
+                    // Reserve space for the decoded texture if it's small enough to be decoded on the CPU.
+                    decodedOffsets[i] = UINT32_MAX;
+                    if (upload.decodeTMEM && (upload.width > 0) && (upload.height > 0) && ((upload.width * upload.height) <= TextureDecodeCPUPixelLimit)) {
+                        decodedOffsets[i] = stagingSize;
+                        stagingSize += nextSizeAlignedTo(upload.width * RenderFormatSize(RenderFormat::R8G8B8A8_UNORM), TextureDataPitchAlignment) * upload.height;
+                        stagingSize = nextSizeAlignedTo(stagingSize, TextureDataPlacementAlignment);
+                    }
+                }
+
+                if (stagingSize > tmemStagingBufferSize) {
+                    tmemStagingBufferSize = std::max(uint64_t(stagingSize), tmemStagingBufferSize * 2);
+
                     std::unique_lock queueLock(uploadResourcePoolMutex);
-                    for (size_t i = tmemUploadResources.size(); i < queueSize; i++) {
-                        tmemUploadResources.emplace_back(uploadResourcePool->createBuffer(RenderBufferDesc::UploadBuffer(TMEMSize)));
+                    tmemStagingBuffer = uploadResourcePool->createBuffer(RenderBufferDesc::UploadBuffer(tmemStagingBufferSize, RenderBufferFlag::FORMATTED));
+                    tmemStagingBufferView = tmemStagingBuffer->createBufferFormattedView(RenderFormat::R8_UINT);
+                }
+
+                // Describe every texture that must be decoded.
+                decodeBatch.clear();
+                for (size_t i = 0; i < queueSize; i++) {
+                    const TextureUpload &upload = queueCopy[i];
+                    if (!upload.decodeTMEM || (decodedOffsets[i] != UINT32_MAX)) {
+                        continue;
                     }
+
+                    interop::TextureDecodeDescriptor desc;
+                    desc.resolution.x = upload.width;
+                    desc.resolution.y = upload.height;
+                    desc.fmt = upload.loadTile.fmt;
+                    desc.siz = upload.loadTile.siz;
+                    desc.address = interop::uint(upload.loadTile.tmem) << 3;
+                    desc.stride = interop::uint(upload.loadTile.line) << 3;
+                    desc.tlut = upload.tlut;
+                    desc.palette = upload.loadTile.palette;
+                    desc.tmemOffset = stagingOffsets[i];
+                    decodeBatch.add(desc);
                 }
 
-                for (size_t i = descriptorSets.size(); i < queueSize; i++) {
+                const uint32_t decodeChunkCount = decodeBatch.dispatchCount();
+                for (size_t i = descriptorSets.size(); i < decodeChunkCount; i++) {
                     descriptorSets.emplace_back(std::make_unique<TextureDecodeDescriptorSet>(directWorker->device));
                 }
 
+                if (!decodeBatch.empty()) {
+                    const uint64_t descriptorsSize = decodeBatch.descriptors.size() * sizeof(interop::TextureDecodeDescriptor);
+                    if (descriptorsSize > decodeDescriptorBufferSize) {
+                        decodeDescriptorBufferSize = std::max(descriptorsSize, decodeDescriptorBufferSize * 2);
+
+                        std::unique_lock queueLock(uploadResourcePoolMutex);
+                        decodeDescriptorBuffer = uploadResourcePool->createBuffer(RenderBufferDesc::UploadBuffer(decodeDescriptorBufferSize, RenderBufferFlag::STORAGE));
+                    }
+
+                    void *descriptorsData = decodeDescriptorBuffer->map();
+                    memcpy(descriptorsData, decodeBatch.descriptors.data(), descriptorsSize);
+                    decodeDescriptorBuffer->unmap();
+
+                    for (uint32_t c = 0; c < decodeChunkCount; c++) {
+                        TextureDecodeDescriptorSet *descSet = descriptorSets[c].get();
+                        descSet->setBuffer(descSet->gDescriptors, decodeDescriptorBuffer.get(), RenderBufferStructuredView(sizeof(interop::TextureDecodeDescriptor)));
+                        descSet->setBuffer(descSet->gTMEMAtlas, tmemStagingBuffer.get(), tmemStagingBufferSize, tmemStagingBufferView.get());
+                    }
+                }
+
                 // Upload all textures in the queue using the copy worker. It's worth noting the usage of a copy worker during copy texture operations is intentional
                 // to avoid issues with drivers that are not very explicit about where they execute the copy texture operations and end up causing subtle synchronization
                 // issues that can't be accounted for. Using dedicated copy queues for these operations has shown to eliminate these issues entirely.
                 copyWorker->commandList->begin();
                 textureMapAdditions.clear();
 
+                uint8_t *stagingData = (stagingSize > 0) ? reinterpret_cast<uint8_t *>(tmemStagingBuffer->map()) : nullptr;
                 for (size_t i = 0; i < queueSize; i++) {
                     static uint32_t TMEMGlobalCounter = 0;
-                    const TextureUpload &upload = queueCopy[i];
+                    TextureUpload &upload = queueCopy[i];
                     Texture *newTexture = new Texture();
                     newTexture->creationFrame = upload.creationFrame;
                     textureMapAdditions.emplace_back(TextureMapAddition{ upload.hash, newTexture });
@@ -1072,64 +1486,152 @@ namespace RT64 {
                     newTexture->height = upload.height;
                     newTexture->tmem = copyWorker->device->createTexture(RenderTextureDesc::Texture1D(std::max(uint32_t(upload.bytesTMEM.size()), 1U), 1, newTexture->format));
                     newTexture->tmem->setName("Texture Cache TMEM #" + std::to_string(TMEMGlobalCounter++));
-                    newTexture->bytesTMEM = upload.bytesTMEM;
                     newTexture->loadTile = upload.loadTile;
                     newTexture->tlut = upload.tlut;
                     newTexture->decodeTMEM = upload.decodeTMEM;
 
                     if (!upload.bytesTMEM.empty()) {
-                        void *dstData = tmemUploadResources[i]->map();
-                        memcpy(dstData, upload.bytesTMEM.data(), upload.bytesTMEM.size());
-                        tmemUploadResources[i]->unmap();
+                        memcpy(&stagingData[stagingOffsets[i]], upload.bytesTMEM.data(), upload.bytesTMEM.size());
                     }
 
+                    if (decodedOffsets[i] != UINT32_MAX) {
+                        static uint32_t DecodedGlobalCounter = 0;
+                        const uint32_t rowPitch = nextSizeAlignedTo(upload.width * RenderFormatSize(RenderFormat::R8G8B8A8_UNORM), TextureDataPitchAlignment);
+                        TMEMDecoder::decode(upload.bytesTMEM.data(), uint32_t(upload.bytesTMEM.size()), TMEMDecoder::Params(upload.loadTile, upload.tlut), upload.width, upload.height, &stagingData[decodedOffsets[i]], rowPitch);
+                        newTexture->texture = copyWorker->device->createTexture(RenderTextureDesc::Texture2D(upload.width, upload.height, 1, RenderFormat::R8G8B8A8_UNORM));
+                        newTexture->texture->setName("Texture Cache RGBA32 (CPU) #" + std::to_string(DecodedGlobalCounter++));
+                        beforeCopyBarriers.emplace_back(newTexture->texture.get(), RenderTextureLayout::COPY_DEST);
+                    }
+
+                    // The upload owns its bytes, so the texture can take them instead of making another copy.
+                    newTexture->memorySize = upload.bytesTMEM.size();
+                    newTexture->bytesTMEM = std::move(upload.bytesTMEM);
                     beforeCopyBarriers.emplace_back(newTexture->tmem.get(), RenderTextureLayout::COPY_DEST);
                 }
 
+                if (stagingData != nullptr) {
+                    tmemStagingBuffer->unmap();
+                }
+
+                for (const StreamResult &result : streamResultQueueCopy) {
+                    if (result.texture != nullptr) {
+                        beforeCopyBarriers.insert(beforeCopyBarriers.end(), result.copyList.barriers.begin(), result.copyList.barriers.end());
+                    }
+                }
+
                 copyWorker->commandList->barriers(RenderBarrierStage::COPY, beforeCopyBarriers);
 
+                // Copy every texture the streaming jobs loaded since the last batch. Their upload resources must live until the batch is done.
+                for (StreamResult &result : streamResultQueueCopy) {
+                    if (result.texture == nullptr) {
+                        continue;
+                    }
+
+                    const TextureCopyList &copyList = result.copyList;
+                    for (size_t i = 0; i < copyList.destinations.size(); i++) {
+                        copyWorker->commandList->copyTextureRegion(copyList.destinations[i], copyList.sources[i]);
+                    }
+
+                    replacementUploadResources.emplace_back(std::move(result.uploadResource));
+                }
+
+                for (LowMipCacheResult &result : lowMipCacheResultQueueCopy) {
+                    if (result.texture == nullptr) {
+                        continue;
+                    }
+
+                    result.copyList.record(copyWorker->commandList.get());
+                    replacementUploadResources.emplace_back(std::move(result.uploadResource));
+                }
+
+                uint32_t decodeIndex = 0;
                 for (size_t i = 0; i < queueSize; i++) {
                     const TextureUpload &upload = queueCopy[i];
-                    const uint32_t byteCount = uint32_t(upload.bytesTMEM.size());
                     Texture *dstTexture = textureMapAdditions[i].texture;
+                    const uint32_t byteCount = uint32_t(dstTexture->bytesTMEM.size());
                     if (byteCount > 0) {
                         copyWorker->commandList->copyTextureRegion(
                             RenderTextureCopyLocation::Subresource(dstTexture->tmem.get()),
-                            RenderTextureCopyLocation::PlacedFootprint(tmemUploadResources[i].get(), RenderFormat::R8_UINT, byteCount, 1, 1, byteCount)
+                            RenderTextureCopyLocation::PlacedFootprint(tmemStagingBuffer.get(), RenderFormat::R8_UINT, byteCount, 1, 1, byteCount, stagingOffsets[i])
                         );
                     }
 
                     beforeDecodeBarriers.emplace_back(dstTexture->tmem.get(), RenderTextureLayout::SHADER_READ);
 
-                    if (upload.decodeTMEM) {
+                    if (decodedOffsets[i] != UINT32_MAX) {
+                        dstTexture->memorySize += uint64_t(upload.width) * upload.height * RenderFormatSize(RenderFormat::R8G8B8A8_UNORM);
+                        const uint32_t rowWidth = nextSizeAlignedTo(upload.width * RenderFormatSize(RenderFormat::R8G8B8A8_UNORM), TextureDataPitchAlignment) / RenderFormatSize(RenderFormat::R8G8B8A8_UNORM);
+                        dstTexture->format = RenderFormat::R8G8B8A8_UNORM;
+                        copyWorker->commandList->copyTextureRegion(
+                            RenderTextureCopyLocation::Subresource(dstTexture->texture.get()),
+                            RenderTextureCopyLocation::PlacedFootprint(tmemStagingBuffer.get(), dstTexture->format, upload.width, upload.height, 1, rowWidth, decodedOffsets[i])
+                        );
+
+                        afterDecodeBarriers.emplace_back(dstTexture->texture.get(), RenderTextureLayout::SHADER_READ);
+                    }
+                    else if (upload.decodeTMEM) {
                         static uint32_t TextureGlobalCounter = 0;
-                        TextureDecodeDescriptorSet *descSet = descriptorSets[i].get();
+                        TextureDecodeDescriptorSet *descSet = descriptorSets[decodeIndex / TextureDecodeDescriptorSet::UpperRange].get();
                         dstTexture->format = RenderFormat::R8G8B8A8_UNORM;
                         dstTexture->texture = directWorker->device->createTexture(RenderTextureDesc::Texture2D(upload.width, upload.height, 1, dstTexture->format, RenderTextureFlag::STORAGE | RenderTextureFlag::UNORDERED_ACCESS));
                         dstTexture->texture->setName("Texture Cache RGBA32 #" + std::to_string(TextureGlobalCounter++));
-                        descSet->setTexture(descSet->TMEM, dstTexture->tmem.get(), RenderTextureLayout::SHADER_READ);
-                        descSet->setTexture(descSet->RGBA32, dstTexture->texture.get(), RenderTextureLayout::GENERAL);
+                        dstTexture->memorySize += uint64_t(upload.width) * upload.height * RenderFormatSize(dstTexture->format);
+                        descSet->setTexture(descSet->gOutputs + (decodeIndex % TextureDecodeDescriptorSet::UpperRange), dstTexture->texture.get(), RenderTextureLayout::GENERAL);
                         beforeDecodeBarriers.emplace_back(dstTexture->texture.get(), RenderTextureLayout::GENERAL);
+                        afterDecodeBarriers.emplace_back(dstTexture->texture.get(), RenderTextureLayout::SHADER_READ);
+                        decodeIndex++;
                     }
 
-                    addResolvedPaths(upload.hash, upload.width, upload.height, upload.tlut, upload.loadTile, upload.bytesTMEM, upload.decodeTMEM, resolvedPathQueueCopy);
+                    addResolvedPaths(upload.hash, upload.width, upload.height, upload.tlut, upload.loadTile, dstTexture->bytesTMEM, upload.decodeTMEM, resolvedPathQueueCopy);
+                }
+
+                // Stream requests made by this batch are prioritized by the frame they were made on.
+                uint64_t streamRequestFrame = 0;
+                if (!resolvedPathQueueCopy.empty()) {
+                    std::unique_lock lock(textureMapMutex);
+                    streamRequestFrame = textureMap.latestSubmissionFrame;
                 }
 
                 replacementMapAdditions.clear();
                 for (const ReplacementResolvedPath &resolvedPath : resolvedPathQueueCopy) {
                     Texture *replacementTexture = textureMap.replacementMap.getFromRelativePath(resolvedPath.fileSystemIndex, resolvedPath.relativePath);
+                    Texture *partialTexture = nullptr;
                     Texture *lowMipCacheTexture = nullptr;
 
-                    // Look for the low mip cache version if it exists if we can't use the real replacement yet.
+                    // Look for the partial texture or the low mip cache version if it exists if we can't use the real replacement yet.
                     if ((replacementTexture == nullptr) && (resolvedPath.resolvedOperation == ReplacementOperation::Stream)) {
+                        partialTexture = textureMap.replacementMap.getPartialTexture(resolvedPath.fileSystemIndex, resolvedPath.relativePath);
+                    }
+
+                    if ((replacementTexture == nullptr) && (partialTexture == nullptr) && (resolvedPath.resolvedOperation == ReplacementOperation::Stream)) {
                         auto lowMipCacheIt = textureMap.replacementMap.lowMipCacheTextures.find(resolvedPath.relativePath);
                         if (lowMipCacheIt != textureMap.replacementMap.lowMipCacheTextures.end()) {
-                            lowMipCacheTexture = lowMipCacheIt->second.texture;
+                            LowMipCacheTexture &lowMipCacheEntry = lowMipCacheIt->second;
+                            lowMipCacheEntry.used = true;
+
+                            // Upload the low mips the first time they're needed.
+                            if (lowMipCacheEntry.texture == nullptr) {
+                                TextureCopyList copyList;
+                                replacementUploadResources.emplace_back();
+                                Texture *newTexture = loadLowMipCacheEntry(lowMipCacheEntry, copyList, replacementUploadResources.back());
+                                if (newTexture != nullptr) {
+                                    copyList.record(copyWorker->commandList.get());
+
+                                    // Memory used by the low mip cache is considered as permanently in use.
+                                    std::unique_lock lock(textureMapMutex);
+                                    lowMipCacheEntry.texture = newTexture;
+                                    textureMap.replacementMap.usedTexturePoolSize += newTexture->memorySize;
+                                    textureMap.replacementMap.cachedTexturePoolSize += newTexture->memorySize;
+                                    textureMap.replacementMap.permanentTexturePoolSize += newTexture->memorySize;
+                                }
+                            }
+
+                            lowMipCacheTexture = lowMipCacheEntry.texture;
 
                             // Transition the texture from the low mip cache if it hasn't been transitioned to shader read yet.
-                            if (!lowMipCacheIt->second.transitioned) {
+                            if ((lowMipCacheTexture != nullptr) && !lowMipCacheEntry.transitioned) {
                                 afterDecodeBarriers.emplace_back(lowMipCacheTexture->texture.get(), RenderTextureLayout::SHADER_READ);
-                                lowMipCacheIt->second.transitioned = true;
+                                lowMipCacheEntry.transitioned = true;
                             }
                         }
                     }
@@ -1145,23 +1647,23 @@ namespace RT64 {
                                 streamSet.insert(resolvedPath.relativePath);
 
                                 // Push to the streaming queue.
-                                streamDescStackMutex.lock();
-                                streamDescStack.push(StreamDescription(resolvedPath.fileSystemIndex, resolvedPath.relativePath, false));
-                                streamDescStackMutex.unlock();
-                                streamDescStackChanged.notify_all();
+                                const uint64_t projectedSize = textureMap.replacementMap.fileSystems[resolvedPath.fileSystemIndex]->getSize(resolvedPath.relativePath);
+                                pushStreamDescription(StreamDescription(resolvedPath.fileSystemIndex, resolvedPath.relativePath, false, resolvedPath.textureHash, streamRequestFrame, projectedSize, StreamPartialMaxDimension));
                             }
 #                           endif
 
                             // Store the hash to check for the replacement when the texture is done streaming.
                             textureMap.replacementMap.fileSystemStreamResolvedPaths[resolvedPath.fileSystemIndex].emplace(resolvedPath.relativePath, resolvedPath);
 
-                            // Use the low mip cache texture if it exists.
-                            replacementTexture = lowMipCacheTexture;
+                            // Use the partial texture or the low mip cache texture if they exist.
+                            replacementTexture = (partialTexture != nullptr) ? partialTexture : lowMipCacheTexture;
                         }
                         // Load the texture directly on this thread (operation was defined as Stall).
                         else if (textureMap.replacementMap.fileSystems[resolvedPath.fileSystemIndex]->load(resolvedPath.relativePath, replacementBytes)) {
+                            TextureCopyList copyList;
                             replacementUploadResources.emplace_back();
-                            replacementTexture = TextureCache::loadTextureFromBytes(copyWorker->device, copyWorker->commandList.get(), replacementBytes, replacementUploadResources.back());
+                            replacementTexture = loadReplacementBytes(copyWorker->device, copyList, replacementBytes.data(), replacementBytes.size(), resolvedPath.fileSystemIndex, resolvedPath.relativePath, replacementUploadResources.back());
+                            copyList.record(copyWorker->commandList.get());
                             textureMapMutex.lock();
                             textureMap.replacementMap.addLoadedTexture(replacementTexture, resolvedPath.fileSystemIndex, resolvedPath.relativePath, true);
                             textureMapMutex.unlock();
@@ -1170,7 +1672,7 @@ namespace RT64 {
                     }
 
                     if (replacementTexture != nullptr) {
-                        // We don't use reference counting on preloaded textures or low mip cache versions, as they're permanently allocated in memory.
+                        // We don't use reference counting on preloaded textures or low mip cache versions, as they're in use for as long as they exist.
                         bool referenceCounted = (resolvedPath.resolvedOperation != ReplacementOperation::Preload) && (replacementTexture != lowMipCacheTexture);
                         replacementMapAdditions.emplace_back(ReplacementMapAddition{ resolvedPath.textureHash, replacementTexture, resolvedPath.resolvedShift, referenceCounted });
                     }
@@ -1186,35 +1688,18 @@ namespace RT64 {
                 directWorker->commandList->begin();
                 directWorker->commandList->barriers(RenderBarrierStage::GRAPHICS_AND_COMPUTE, beforeDecodeBarriers);
 
-                const ShaderRecord &textureDecode = shaderLibrary->textureDecode;
-                bool pipelineSet = false;
-                for (size_t i = 0; i < queueSize; i++) {
-                    const TextureUpload &upload = queueCopy[i];
-                    if (upload.decodeTMEM) {
-                        if (!pipelineSet) {
-                            directWorker->commandList->setPipeline(textureDecode.pipeline.get());
-                            directWorker->commandList->setComputePipelineLayout(textureDecode.pipelineLayout.get());
-                        }
-
-                        interop::TextureDecodeCB decodeCB;
-                        decodeCB.Resolution.x = upload.width;
-                        decodeCB.Resolution.y = upload.height;
-                        decodeCB.fmt = upload.loadTile.fmt;
-                        decodeCB.siz = upload.loadTile.siz;
-                        decodeCB.address = interop::uint(upload.loadTile.tmem) << 3;
-                        decodeCB.stride = interop::uint(upload.loadTile.line) << 3;
-                        decodeCB.tlut = upload.tlut;
-                        decodeCB.palette = upload.loadTile.palette;
-
-                        // Dispatch compute shader for decoding texture.
-                        const uint32_t ThreadGroupSize = 8;
-                        const uint32_t dispatchX = (decodeCB.Resolution.x + ThreadGroupSize - 1) / ThreadGroupSize;
-                        const uint32_t dispatchY = (decodeCB.Resolution.y + ThreadGroupSize - 1) / ThreadGroupSize;
+                // Decode every texture in the batch with one dispatch per descriptor set.
+                if (!decodeBatch.empty()) {
+                    const ShaderRecord &textureDecode = shaderLibrary->textureDecode;
+                    directWorker->commandList->setPipeline(textureDecode.pipeline.get());
+                    directWorker->commandList->setComputePipelineLayout(textureDecode.pipelineLayout.get());
+                    for (uint32_t c = 0; c < decodeChunkCount; c++) {
+                        const interop::TextureDecodeCB decodeCB = decodeBatch.dispatchConstants(c);
+                        const uint32_t dispatchX = std::min(decodeCB.groupCount, uint32_t(TextureDecodeBatch::GroupsPerRow));
+                        const uint32_t dispatchY = (decodeCB.groupCount + TextureDecodeBatch::GroupsPerRow - 1) / TextureDecodeBatch::GroupsPerRow;
                         directWorker->commandList->setComputePushConstants(0, &decodeCB);
-                        directWorker->commandList->setComputeDescriptorSet(descriptorSets[i]->get(), 0);
+                        directWorker->commandList->setComputeDescriptorSet(descriptorSets[c]->get(), 0);
                         directWorker->commandList->dispatch(dispatchX, dispatchY, 1);
-
-                        afterDecodeBarriers.emplace_back(RenderTextureBarrier(textureMapAdditions[i].texture->texture.get(), RenderTextureLayout::SHADER_READ));
                     }
                 }
 
@@ -1242,19 +1727,26 @@ namespace RT64 {
                         textureMap.replace(addition.hash, addition.texture, addition.shift == ReplacementShift::Half, addition.referenceCounted);
                     }
 
+                    // Partial textures replaced by the complete ones above are no longer referenced and are released here.
                     textureMap.replacementMap.evict(textureMap.evictedTextures);
                 }
 
-                // Make the new queue the remaining subsection of the upload queue that wasn't processed in this batch.
                 {
                     std::unique_lock queueLock(uploadQueueMutex);
-                    newQueue = std::vector<TextureUpload>(uploadQueue.begin() + queueSize, uploadQueue.end());
-                    uploadQueue = std::move(newQueue);
+                    uploadsInProgress = 0;
                 }
 
                 queueCopy.clear();
                 uploadQueueFinished.notify_all();
             }
+
+            // Resume the streaming jobs that stopped because the results they loaded took too much memory.
+            if (streamResultBytes > 0) {
+                streamResultBytesInFlight -= streamResultBytes;
+
+                std::unique_lock queueLock(streamDescQueueMutex);
+                scheduleStreamJobs();
+            }
         }
     }
 
@@ -1273,16 +1765,16 @@ namespace RT64 {
 
         {
             std::unique_lock queueLock(uploadQueueMutex);
-            uploadQueue.emplace_back(newUpload);
+            uploadQueue.emplace_back(std::move(newUpload));
         }
 
-        uploadQueueChanged.notify_all();
+        scheduleUploadJob();
     }
 
     void TextureCache::waitForGPUUploads() {
         std::unique_lock queueLock(uploadQueueMutex);
         uploadQueueFinished.wait(queueLock, [this]() {
-            return uploadQueue.empty();
+            return uploadQueue.empty() && (uploadsInProgress == 0);
         });
     }
 
@@ -1346,8 +1838,10 @@ namespace RT64 {
         Texture *newTexture = textureMap.replacementMap.getFromRelativePath(0, relativePathForward);
         if (newTexture == nullptr) {
             std::unique_ptr<RenderBuffer> dstUploadBuffer;
+            TextureCopyList copyList;
             loaderCommandList->begin();
-            newTexture = TextureCache::loadTextureFromBytes(copyWorker->device, loaderCommandList.get(), replacementBytes, dstUploadBuffer);
+            newTexture = TextureCache::loadTextureFromBytes(copyWorker->device, copyList, replacementBytes, dstUploadBuffer);
+            copyList.record(loaderCommandList.get());
             loaderCommandList->end();
 
             if (newTexture != nullptr) {
@@ -1380,6 +1874,7 @@ namespace RT64 {
 
         // Queue the texture as if it was the result from a streaming thread.
         if (loadedNewTexture) {
+            streamResultBytesInFlight += newTexture->memorySize;
             streamResultQueue.emplace_back(newTexture, 0, relativePathForward, false);
             textureMap.replacementMap.fileSystemStreamResolvedPaths[0].emplace(relativePathForward, resolvedPath);
         }
@@ -1389,7 +1884,7 @@ namespace RT64 {
         }
 
         uploadQueueMutex.unlock();
-        uploadQueueChanged.notify_all();
+        scheduleUploadJob();
 
         return true;
     }
@@ -1409,6 +1904,9 @@ namespace RT64 {
     void TextureCache::clearReplacementDirectories() {
         // Wait for the streaming threads to be finished.
         waitForAllStreamThreads(true);
+        cancelLowMipCachePrefetch();
+        cancelTranscodeJobs();
+        saveLowMipCacheUsage();
 
         // Reset the benchmark counters.
         resetStreamPerformanceCounters();
@@ -1417,7 +1915,10 @@ namespace RT64 {
         {
             std::unique_lock queueLock(uploadQueueMutex);
             for (const StreamResult &result : streamResultQueue) {
-                delete result.texture;
+                if (result.texture != nullptr) {
+                    streamResultBytesInFlight -= result.texture->memorySize;
+                    delete result.texture;
+                }
             }
 
             streamResultQueue.clear();
@@ -1452,7 +1953,7 @@ namespace RT64 {
             }
         }
 
-        uploadQueueChanged.notify_all();
+        scheduleUploadJob();
     }
 
     bool TextureCache::loadReplacementDirectory(const ReplacementDirectory &replacementDirectory) {
@@ -1462,16 +1963,27 @@ namespace RT64 {
     bool TextureCache::loadReplacementDirectories(const std::vector<ReplacementDirectory> &replacementDirectories) {
         clearReplacementDirectories();
 
-        std::unique_lock lock(textureMapMutex);
-        textureMap.replacementMap.replacementDirectories = replacementDirectories;
-
+        // Everything is loaded into local data first without holding the texture map lock. Resolving and deduplicating the paths runs on the
+        // job system, and its batches could otherwise wait forever behind an upload or stream job that is blocked on the same lock.
         std::vector<std::unique_ptr<FileSystem>> fileSystems;
         std::vector<std::unordered_map<uint64_t, ReplacementResolvedPath>> fileSystemResolvedPaths;
         std::vector<uint32_t> fileSystemHashVersions;
         std::vector<std::unordered_set<std::string>> fileSystemStreamSets;
+        std::vector<uint32_t> resolvedHashVersions;
+        std::unordered_map<std::string, LowMipCacheTexture> lowMipCacheTextures;
+        std::vector<LowMipCacheFile> lowMipCacheFiles;
+        ReplacementDatabase directoryDatabase;
+        bool fileSystemIsDirectory = false;
         for (const ReplacementDirectory &replacementDirectory : replacementDirectories) {
             if (std::filesystem::is_regular_file(replacementDirectory.dirOrZipPath)) {
-                std::unique_ptr<FileSystem> fileSystem = FileSystemZip::create(replacementDirectory.dirOrZipPath, replacementDirectory.zipBasePath);
+                // Packs in the v2 format are told apart from zip files by their magic, as both use the same extension.
+                std::unique_ptr<FileSystem> fileSystem;
+                if (FileSystemPack::isPackFile(replacementDirectory.dirOrZipPath)) {
+                    fileSystem = FileSystemPack::create(replacementDirectory.dirOrZipPath, replacementDirectory.zipBasePath);
+                }
+                else {
+                    fileSystem = FileSystemZip::create(replacementDirectory.dirOrZipPath, replacementDirectory.zipBasePath);
+                }
                 if (fileSystem == nullptr) {
                     fprintf(stderr, "Failed to load file system as a pack for replacements.\n");
                     return false;
@@ -1490,7 +2002,7 @@ namespace RT64 {
                 }
 
                 // Only enable that file system is a directory if it's only one directory.
-                textureMap.replacementMap.fileSystemIsDirectory = (replacementDirectories.size() == 1);
+                fileSystemIsDirectory = (replacementDirectories.size() == 1);
                 fileSystems.emplace_back(std::move(fileSystem));
                 fileSystemResolvedPaths.emplace_back();
                 fileSystemHashVersions.emplace_back();
@@ -1502,28 +2014,59 @@ namespace RT64 {
             }
         }
 
-        // Load databases and low mipmap caches from the filesystems in reverse order.
+        // Load databases and index the low mipmap caches from the filesystems in reverse order.
         {
-            loaderCommandList->begin();
-
-            uint64_t totalMemory = 0;
             std::vector<uint8_t> databaseBytes;
-            std::vector<uint8_t> mipCacheBytes;
-            std::vector<std::unique_ptr<RenderBuffer>> uploadBuffers;
             std::set<uint32_t> knownHashVersions;
             for (int32_t i = int32_t(fileSystems.size()) - 1; i >= 0; i--) {
-                if (fileSystems[i]->load(ReplacementDatabaseFilename, databaseBytes)) {
+                // Packs can skip parsing and resolving the database if the results from a previous launch are still valid. Directories
+                // are always resolved again, as their contents are expected to change while they're being worked on.
+                std::filesystem::path replacementCachePath;
+                uint64_t databaseHash = 0;
+                uint64_t indexHash = 0;
+                bool databaseLoaded = fileSystems[i]->load(ReplacementDatabaseFilename, databaseBytes);
+                if (databaseLoaded) {
+                    const ReplacementDirectory &replacementDirectory = replacementDirectories[i];
+                    if (!replacementCacheDirectory.empty() && std::filesystem::is_regular_file(replacementDirectory.dirOrZipPath)) {
+                        const std::string cacheKey = replacementDirectory.dirOrZipPath.u8string() + "|" + replacementDirectory.zipBasePath;
+                        char cacheFilename[64];
+                        snprintf(cacheFilename, sizeof(cacheFilename), "database-%016llx.bin", (unsigned long long)(XXH3_64bits(cacheKey.data(), cacheKey.size())));
+                        replacementCachePath = replacementCacheDirectory / cacheFilename;
+                        databaseHash = ReplacementCache::hashDatabase(databaseBytes);
+                        indexHash = ReplacementCache::hashIndex(fileSystems[i].get(), replacementDirectory.dirOrZipPath);
+
+                        uint32_t hashVersion = 0;
+                        if (ReplacementCache::load(replacementCachePath, databaseHash, indexHash, uint32_t(i), hashVersion, fileSystemResolvedPaths[i], &fileSystemStreamSets[i]) && (hashVersion <= TMEMHasher::CurrentHashVersion)) {
+                            fileSystemHashVersions[i] = hashVersion;
+                            knownHashVersions.insert(hashVersion);
+                            databaseLoaded = false;
+                        }
+                    }
+                }
+
+                if (databaseLoaded) {
                     try {
                         ReplacementDatabase db;
                         db = json::parse(databaseBytes.begin(), databaseBytes.end(), nullptr, true);
 
                         if (db.config.hashVersion <= TMEMHasher::CurrentHashVersion) {
-                            db.resolvePaths(fileSystems[i].get(), uint32_t(i), fileSystemResolvedPaths[i], false, nullptr, &fileSystemStreamSets[i]);
+                            db.resolvePaths(fileSystems[i].get(), uint32_t(i), fileSystemResolvedPaths[i], false, nullptr, &fileSystemStreamSets[i], jobSystem);
+
+                            // Entries that use identical files in a pack share the same path, so they also share the same loaded texture.
+                            // Directories are left as they are, as their files are expected to change while they're being worked on.
+                            if (std::filesystem::is_regular_file(replacementDirectories[i].dirOrZipPath)) {
+                                ReplacementDatabase::deduplicatePaths(fileSystems[i].get(), fileSystemResolvedPaths[i], &fileSystemStreamSets[i], jobSystem);
+                            }
+
                             fileSystemHashVersions[i] = db.config.hashVersion;
                             knownHashVersions.insert(db.config.hashVersion);
 
-                            if (textureMap.replacementMap.fileSystemIsDirectory) {
-                                textureMap.replacementMap.directoryDatabase = std::move(db);
+                            if (!replacementCachePath.empty() && !ReplacementCache::save(replacementCachePath, databaseHash, indexHash, db.config.hashVersion, fileSystemResolvedPaths[i])) {
+                                fprintf(stderr, "Failed to save the replacement cache.\n");
+                            }
+
+                            if (fileSystemIsDirectory) {
+                                directoryDatabase = std::move(db);
                             }
                         }
                     }
@@ -1532,57 +2075,82 @@ namespace RT64 {
                     }
                 }
 
-                if (fileSystems[i]->load(ReplacementLowMipCacheFilename, mipCacheBytes)) {
-                    uploadBuffers.emplace_back();
-                    if (!setLowMipCache(copyWorker->device, loaderCommandList.get(), mipCacheBytes.data(), mipCacheBytes.size(), uploadBuffers.back(), textureMap.replacementMap.lowMipCacheTextures, totalMemory)) {
+                // Caches stored as is are only indexed here and their entries are read from the file when they're used.
+                LowMipCacheFile cacheFile;
+                std::unique_ptr<FileSystemReader> cacheReader;
+                if (fileSystems[i]->getStoredLocation(ReplacementLowMipCacheFilename, cacheFile.filePath, cacheFile.fileOffset)) {
+                    cacheReader = fileSystems[i]->openReader(ReplacementLowMipCacheFilename);
+                }
+                else if (fileSystems[i]->load(ReplacementLowMipCacheFilename, cacheFile.bytes)) {
+                    cacheReader = std::make_unique<FileSystemMappedReader>(cacheFile.bytes.data(), cacheFile.bytes.size());
+                }
+
+                if (cacheReader != nullptr) {
+                    const uint32_t cacheIndex = uint32_t(lowMipCacheFiles.size());
+                    if (indexLowMipCache(*cacheReader, cacheIndex, lowMipCacheTextures)) {
+                        lowMipCacheFiles.emplace_back(std::move(cacheFile));
+                    }
+                    else {
                         fprintf(stderr, "Failed to load low mip cache.\n");
                     }
                 }
             }
 
-            loaderCommandList->end();
-
-            if (!textureMap.replacementMap.lowMipCacheTextures.empty()) {
-                copyWorker->commandQueue->executeCommandLists(loaderCommandList.get(), loaderCommandFence.get());
-                copyWorker->commandQueue->waitForCommandFence(loaderCommandFence.get());
-
-                // Memory used by low mip cache is considered as permanently in used.
-                textureMap.replacementMap.usedTexturePoolSize += totalMemory;
-                textureMap.replacementMap.cachedTexturePoolSize += totalMemory;
-            }
-
             // Build a vector from the known hash versions.
-            textureMap.replacementMap.resolvedHashVersions.clear();
-            textureMap.replacementMap.resolvedHashVersions.insert(textureMap.replacementMap.resolvedHashVersions.end(), knownHashVersions.begin(), knownHashVersions.end());
+            resolvedHashVersions.insert(resolvedHashVersions.end(), knownHashVersions.begin(), knownHashVersions.end());
         }
 
-        // Store the file systems in the replacement map.
-        uint32_t fileSystemCount = uint32_t(fileSystems.size());
-        textureMap.replacementMap.fileSystems = std::move(fileSystems);
-        textureMap.replacementMap.fileSystemResolvedPaths = std::move(fileSystemResolvedPaths);
-        textureMap.replacementMap.fileSystemHashVersions = std::move(fileSystemHashVersions);
-        textureMap.replacementMap.fileSystemStreamSets = std::move(fileSystemStreamSets);
-        textureMap.replacementMap.fileSystemStreamResolvedPaths.resize(fileSystemCount);
-
-        // Queue all textures that must be preloaded to the stream queues.
+        // Store the file systems in the replacement map and queue all textures that must be preloaded to the stream queues.
         bool texturesPreloaded = false;
         {
-            std::unique_lock queueLock(streamDescStackMutex);
+            std::unique_lock lock(textureMapMutex);
+            const uint32_t fileSystemCount = uint32_t(fileSystems.size());
+            textureMap.replacementMap.replacementDirectories = replacementDirectories;
+            textureMap.replacementMap.fileSystems = std::move(fileSystems);
+            textureMap.replacementMap.fileSystemResolvedPaths = std::move(fileSystemResolvedPaths);
+            textureMap.replacementMap.fileSystemHashVersions = std::move(fileSystemHashVersions);
+            textureMap.replacementMap.fileSystemStreamSets = std::move(fileSystemStreamSets);
+            textureMap.replacementMap.fileSystemStreamResolvedPaths.resize(fileSystemCount);
+            textureMap.replacementMap.resolvedHashVersions = std::move(resolvedHashVersions);
+            textureMap.replacementMap.lowMipCacheTextures = std::move(lowMipCacheTextures);
+            textureMap.replacementMap.lowMipCacheFiles = std::move(lowMipCacheFiles);
+            textureMap.replacementMap.directoryDatabase = std::move(directoryDatabase);
+            textureMap.replacementMap.fileSystemIsDirectory = fileSystemIsDirectory;
+
+            std::unique_lock queueLock(streamDescQueueMutex);
             for (uint32_t i = 0; i < fileSystemCount; i++) {
                 for (const std::string &relativePath : textureMap.replacementMap.fileSystemStreamSets[i]) {
-                    streamDescStack.push(StreamDescription(i, relativePath, true));
+                    streamDescQueue.emplace_back(StreamDescription(i, relativePath, true, 0, 0, 0));
                     texturesPreloaded = true;
                 }
             }
+
+            std::make_heap(streamDescQueue.begin(), streamDescQueue.end());
+            scheduleStreamJobs();
         }
 
+        // Wait for all the streaming threads to be finished. The texture map lock must not be held here, as every stream job locks it.
         if (texturesPreloaded) {
-            streamDescStackChanged.notify_all();
-
-            // Wait for all the streaming threads to be finished.
             waitForAllStreamThreads(false);
         }
 
+        std::unique_lock lock(textureMapMutex);
+
+        // Prefetch the low mips that were used in previous sessions in the background.
+        if (!textureMap.replacementMap.lowMipCacheTextures.empty()) {
+            std::string usageKey;
+            for (const ReplacementDirectory &replacementDirectory : replacementDirectories) {
+                usageKey += replacementDirectory.dirOrZipPath.u8string() + "|" + replacementDirectory.zipBasePath + "|";
+            }
+
+            if (!replacementCacheDirectory.empty()) {
+                char usageFilename[64];
+                snprintf(usageFilename, sizeof(usageFilename), "low-mip-usage-%016llx.txt", (unsigned long long)(XXH3_64bits(usageKey.data(), usageKey.size())));
+                textureMap.replacementMap.lowMipCacheUsagePath = replacementCacheDirectory / usageFilename;
+                loadLowMipCacheUsage();
+            }
+        }
+
         reloadReplacements(true);
 
         return true;
@@ -1737,22 +2305,528 @@ namespace RT64 {
         }
     }
 
+    void TextureCache::scheduleStreamJobs() {
+        // Must be called while holding the stream queue mutex. Each job keeps a stream worker for as long as there's descriptions left in the queue.
+        size_t scheduledJobs = streamWorkers.size() - freeStreamWorkers.size();
+        while (!freeStreamWorkers.empty() && (scheduledJobs < streamDescQueue.size())) {
+            StreamWorker *streamWorker = freeStreamWorkers.back();
+            freeStreamWorkers.pop_back();
+            scheduledJobs++;
+
+            // Texture streaming jobs should have a priority somewhere inbetween the main threads and the shader compilation jobs.
+            jobSystem->submit(JobSystem::Priority::Low, [this, streamWorker]() { streamJob(streamWorker); }, &streamCounter);
+        }
+    }
+
+    void TextureCache::streamJob(StreamWorker *streamWorker) {
+        std::vector<StreamDescription> &batch = streamWorker->batch;
+        std::vector<AsyncFileCompletion> completions;
+        while (true) {
+            // Gather as many requests as reads can be in flight at once. The worker is only returned once it has nothing left to load.
+            AsyncFileReader *asyncReader = streamWorker->asyncReader.get();
+            batch.clear();
+
+            // The pressure must be checked before locking the queue, as the texture map mutex is always locked first. The requests of
+            // evicted textures are cancelled first so they don't sit in the queue for as long as the pressure holds the rest back.
+            const bool underPressure = isReplacementPoolUnderPressure();
+            if (underPressure) {
+                cancelStreamDescriptions();
+            }
+
+            while (batch.size() < asyncReader->queueDepth) {
+                StreamDescription streamDesc;
+                if (!popStreamDescription(streamWorker, batch.empty(), underPressure, streamDesc)) {
+                    break;
+                }
+
+                // Skip the request if its texture was evicted, and move it behind the rest if it hasn't been used in a while.
+                StreamCheck streamCheck;
+                {
+                    std::unique_lock lock(textureMapMutex);
+                    streamCheck = checkStreamDescription(streamDesc);
+                }
+
+                if (streamCheck == StreamCheck::Requeue) {
+                    std::unique_lock queueLock(streamDescQueueMutex);
+                    streamDescQueue.emplace_back(std::move(streamDesc));
+                    std::push_heap(streamDescQueue.begin(), streamDescQueue.end());
+                }
+                else if (streamCheck == StreamCheck::Cancel) {
+                    pushStreamResult(StreamResult(nullptr, streamDesc.fileSystemIndex, streamDesc.relativePath, streamDesc.fromPreload));
+                }
+                else {
+                    batch.emplace_back(std::move(streamDesc));
+                }
+            }
+
+            // The worker was already returned if the queue didn't have anything to load.
+            if (batch.empty()) {
+                return;
+            }
+
+            // Files stored as-is in a regular file are read with all the reads of the batch in flight at the same time. Everything else
+            // goes through the file system's reader as before while those reads complete.
+            ElapsedTimer elapsedTimer;
+            std::vector<bool> batchSubmitted(batch.size(), false);
+            std::vector<uint64_t> batchFileSizes(batch.size(), 0);
+            streamWorker->largeFileBytes.resize(asyncReader->queueDepth);
+            for (uint32_t i = 0; i < batch.size(); i++) {
+                // Requests for the smallest mipmaps of a DDS skip most of the file, which the file system's reader can do without reading it.
+                // Other formats can't be loaded partially, so they're read whole like any other request.
+                const StreamDescription &streamDesc = batch[i];
+                if ((streamDesc.maxDimension > 0) && ReplacementDatabase::endsWith(ReplacementDatabase::toLower(streamDesc.relativePath), ".dds")) {
+                    continue;
+                }
+
+                const FileSystem *fileSystem = textureMap.replacementMap.fileSystems[streamDesc.fileSystemIndex].get();
+                AsyncFileRead asyncRead;
+                if (!fileSystem->getStoredLocation(streamDesc.relativePath, asyncRead.filePath, asyncRead.offset)) {
+                    continue;
+                }
+
+                asyncRead.size = fileSystem->getSize(streamDesc.relativePath);
+                if (asyncRead.size < sizeof(uint32_t)) {
+                    continue;
+                }
+
+                if (asyncRead.size <= asyncReader->registeredBufferSize) {
+                    asyncRead.destination = asyncReader->getRegisteredBuffer(i);
+                    asyncRead.bufferIndex = int32_t(i);
+                }
+                else {
+                    streamWorker->largeFileBytes[i].resize(asyncRead.size);
+                    asyncRead.destination = streamWorker->largeFileBytes[i].data();
+                }
+
+                asyncRead.userData = i;
+                batchFileSizes[i] = asyncRead.size;
+                batchSubmitted[i] = asyncReader->submit(asyncRead);
+            }
+
+            asyncReader->flush();
+
+            for (uint32_t i = 0; i < batch.size(); i++) {
+                if (!batchSubmitted[i]) {
+                    loadStreamDescription(streamWorker, batch[i]);
+                }
+            }
+
+            // Decode the files in the order their reads complete. Reads that failed are retried through the file system.
+            uint32_t submittedCount = uint32_t(std::count(batchSubmitted.begin(), batchSubmitted.end(), true));
+            while (submittedCount > 0) {
+                completions.clear();
+                asyncReader->wait(completions, 1);
+                for (const AsyncFileCompletion &completion : completions) {
+                    const uint32_t i = uint32_t(completion.userData);
+                    const StreamDescription &streamDesc = batch[i];
+                    if (!completion.success) {
+                        loadStreamDescription(streamWorker, streamDesc);
+                        submittedCount--;
+                        continue;
+                    }
+
+                    const size_t fileSize = batchFileSizes[i];
+                    const uint8_t *fileBytes = (fileSize <= asyncReader->registeredBufferSize) ? asyncReader->getRegisteredBuffer(i) : streamWorker->largeFileBytes[i].data();
+                    StreamResult streamResult(nullptr, streamDesc.fileSystemIndex, streamDesc.relativePath, streamDesc.fromPreload);
+                    streamResult.texture = loadReplacementBytes(directWorker->device, streamResult.copyList, fileBytes, fileSize, streamDesc.fileSystemIndex, streamDesc.relativePath, streamResult.uploadResource);
+
+                    // The time of the loads in the batch includes the time spent waiting for the reads that were in flight along with it.
+                    addStreamLoadTime(elapsedTimer.elapsedMicroseconds());
+
+                    if (streamResult.texture != nullptr) {
+                        pushStreamResult(std::move(streamResult));
+                    }
+
+                    submittedCount--;
+                }
+            }
+
+            // Don't hold on to the memory of large files after the batch is done.
+            for (std::vector<uint8_t> &fileBytes : streamWorker->largeFileBytes) {
+                std::vector<uint8_t>().swap(fileBytes);
+            }
+        }
+    }
+
+    bool TextureCache::popStreamDescription(StreamWorker *streamWorker, bool releaseWorker, bool underPressure, StreamDescription &streamDesc) {
+        // Check the top of the queue or return the worker if it's empty.
+        std::unique_lock queueLock(streamDescQueueMutex);
+        if (streamDescQueue.empty()) {
+            if (releaseWorker) {
+                freeStreamWorkers.emplace_back(streamWorker);
+            }
+
+            return false;
+        }
+
+        // Wait for the upload job to catch up if the results it hasn't uploaded yet already take too much memory. The upload job schedules
+        // the streaming jobs again once it's done with them.
+        if (streamResultBytesInFlight >= StreamResultMaxBytesInFlight) {
+            if (releaseWorker) {
+                freeStreamWorkers.emplace_back(streamWorker);
+            }
+
+            return false;
+        }
+
+        // Back off while the streamed replacements in use fill their share of the pool, as anything loaded now would go over the budget. Preloads and the
+        // requests for the smallest mipmaps are never held back, so textures stay visible without their largest mipmaps instead. Complete textures
+        // that are already resident don't drop their largest mipmaps under pressure, as they can only be evicted whole once they're no longer used.
+        if (underPressure && !streamDescQueue.front().fromPreload && (streamDescQueue.front().maxDimension == 0)) {
+            if (releaseWorker) {
+                freeStreamWorkers.emplace_back(streamWorker);
+                if (!streamRetryScheduled) {
+                    streamRetryScheduled = true;
+                    jobSystem->submitDelayed(JobSystem::Priority::Low, StreamPressureRetryMicroseconds, [this]() {
+                        std::unique_lock retryLock(streamDescQueueMutex);
+                        streamRetryScheduled = false;
+                        scheduleStreamJobs();
+                    }, &streamCounter);
+                }
+            }
+
+            return false;
+        }
+
+        std::pop_heap(streamDescQueue.begin(), streamDescQueue.end());
+        streamDesc = std::move(streamDescQueue.back());
+        streamDescQueue.pop_back();
+        return true;
+    }
+
+    void TextureCache::loadStreamDescription(StreamWorker *streamWorker, const StreamDescription &streamDesc) {
+        // The file is read and decompressed straight into the upload buffer, so it's timed along with the decoding.
+        ElapsedTimer elapsedTimer;
+        const FileSystem *fileSystem = textureMap.replacementMap.fileSystems[streamDesc.fileSystemIndex].get();
+        std::unique_ptr<FileSystemReader> fileReader = fileSystem->openReader(streamDesc.relativePath);
+
+        // The copies are only recorded here. The upload job submits the ones from every streaming job together with the rest of its
+        // batch behind a single fence, so streaming never waits on a GPU round trip per texture.
+        StreamResult streamResult(nullptr, streamDesc.fileSystemIndex, streamDesc.relativePath, streamDesc.fromPreload);
+        if (fileReader != nullptr) {
+            std::vector<uint8_t> &fileBytes = streamWorker->replacementBytes;
+            fileBytes.clear();
+            streamResult.texture = TextureCache::loadDDSFromReader(directWorker->device, streamResult.copyList, *fileReader, fileSystem->getSize(streamDesc.relativePath), fileBytes, streamResult.uploadResource, streamDesc.maxDimension);
+            if ((streamResult.texture == nullptr) && !fileBytes.empty()) {
+                streamResult.texture = loadReplacementBytes(directWorker->device, streamResult.copyList, fileBytes.data(), fileBytes.size(), streamDesc.fileSystemIndex, streamDesc.relativePath, streamResult.uploadResource);
+            }
+        }
+
+        addStreamLoadTime(elapsedTimer.elapsedMicroseconds());
+
+        if (streamResult.texture != nullptr) {
+            pushStreamResult(std::move(streamResult));
+        }
+    }
+
+    void TextureCache::pushStreamResult(StreamResult &&streamResult) {
+        if (streamResult.texture != nullptr) {
+            streamResultBytesInFlight += streamResult.texture->memorySize;
+        }
+
+        uploadQueueMutex.lock();
+        streamResultQueue.emplace_back(std::move(streamResult));
+        uploadQueueMutex.unlock();
+        scheduleUploadJob();
+    }
+
+    void TextureCache::pushStreamDescription(const StreamDescription &streamDesc) {
+        std::unique_lock queueLock(streamDescQueueMutex);
+        streamDescQueue.emplace_back(streamDesc);
+        std::push_heap(streamDescQueue.begin(), streamDescQueue.end());
+        scheduleStreamJobs();
+    }
+
+    TextureCache::StreamCheck TextureCache::checkStreamDescription(StreamDescription &streamDesc) {
+        // Must be called while holding the texture map mutex.
+        if (streamDesc.fromPreload) {
+            return StreamCheck::Load;
+        }
+
+        const uint64_t currentFrame = textureMap.latestSubmissionFrame;
+        auto it = textureMap.hashMap.find(streamDesc.textureHash);
+        if (it == textureMap.hashMap.end()) {
+            // The texture might still be waiting to be added to the map by the upload that requested it, so it's only considered evicted
+            // once the request is old enough.
+            const bool evicted = (currentFrame > streamDesc.requestFrame) && ((currentFrame - streamDesc.requestFrame) >= StreamStaleFrameAge);
+            return evicted ? StreamCheck::Cancel : StreamCheck::Load;
+        }
+
+        const uint64_t accessFrame = textureMap.accessList.nodes[it->second].frame;
+        if ((accessFrame < streamDesc.requestFrame) && ((currentFrame - accessFrame) >= StreamStaleFrameAge)) {
+            streamDesc.requestFrame = accessFrame;
+            return StreamCheck::Requeue;
+        }
+
+        return StreamCheck::Load;
+    }
+
+    void TextureCache::cancelStreamDescriptions() {
+        std::vector<StreamDescription> cancelledDescs;
+        {
+            std::unique_lock lock(textureMapMutex);
+            std::unique_lock queueLock(streamDescQueueMutex);
+            auto cancelledIt = std::partition(streamDescQueue.begin(), streamDescQueue.end(), [this](StreamDescription &streamDesc) {
+                return checkStreamDescription(streamDesc) != StreamCheck::Cancel;
+            });
+
+            cancelledDescs.insert(cancelledDescs.end(), std::make_move_iterator(cancelledIt), std::make_move_iterator(streamDescQueue.end()));
+            streamDescQueue.erase(cancelledIt, streamDescQueue.end());
+
+            // The requests that were moved behind the rest changed their order as well.
+            std::make_heap(streamDescQueue.begin(), streamDescQueue.end());
+        }
+
+        for (const StreamDescription &streamDesc : cancelledDescs) {
+            pushStreamResult(StreamResult(nullptr, streamDesc.fileSystemIndex, streamDesc.relativePath, streamDesc.fromPreload));
+        }
+    }
+
+    bool TextureCache::isReplacementPoolUnderPressure() {
+        std::unique_lock lock(textureMapMutex);
+        const ReplacementMap &replacementMap = textureMap.replacementMap;
+        return TextureBudget::isPoolUnderPressure(replacementMap.usedTexturePoolSize, replacementMap.permanentTexturePoolSize, replacementMap.maxTexturePoolSize);
+    }
+
     void TextureCache::waitForAllStreamThreads(bool clearQueueImmediately) {
         if (clearQueueImmediately) {
-            std::unique_lock<std::mutex> queueLock(streamDescStackMutex);
-            streamDescStack = std::stack<StreamDescription>();
+            std::unique_lock<std::mutex> queueLock(streamDescQueueMutex);
+            streamDescQueue.clear();
         }
 
-        bool keepWaiting = false;
-        do {
-            streamDescStackMutex.lock();
-            keepWaiting = (streamDescStackActiveCount > 0);
-            streamDescStackMutex.unlock();
+        streamCounter.wait();
+    }
 
-            if (keepWaiting) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    void TextureCache::prefetchLowMipCacheJob(const std::vector<LowMipCachePrefetch> &prefetchList) {
+        std::vector<uint8_t> entryBytes;
+        for (const LowMipCachePrefetch &prefetch : prefetchList) {
+            if (lowMipCachePrefetchCancelled) {
+                break;
+            }
+
+            const uint8_t *entryData = nullptr;
+            const LowMipCacheFile &cacheFile = textureMap.replacementMap.lowMipCacheFiles[prefetch.cacheIndex];
+            if (!readLowMipCacheEntry(cacheFile, prefetch.headerOffset, prefetch.byteCount, entryBytes, entryData)) {
+                continue;
             }
-        } while (keepWaiting);
+
+            LowMipCacheResult result;
+            result.relativePath = prefetch.relativePath;
+            result.texture = loadLowMipCacheTexture(copyWorker->device, result.copyList, entryData, prefetch.headerOffset, prefetch.byteCount, result.uploadResource);
+
+            {
+                std::unique_lock queueLock(uploadQueueMutex);
+                lowMipCacheResultQueue.emplace_back(std::move(result));
+            }
+
+            scheduleUploadJob();
+        }
+    }
+
+    void TextureCache::cancelLowMipCachePrefetch() {
+        lowMipCachePrefetchCancelled = true;
+        lowMipCachePrefetchCounter.wait();
+        lowMipCachePrefetchCancelled = false;
+
+        std::unique_lock queueLock(uploadQueueMutex);
+        for (const LowMipCacheResult &result : lowMipCacheResultQueue) {
+            delete result.texture;
+        }
+
+        lowMipCacheResultQueue.clear();
+    }
+
+    Texture *TextureCache::loadLowMipCacheEntry(const LowMipCacheTexture &entry, TextureCopyList &copyList, std::unique_ptr<RenderBuffer> &dstUploadResource) {
+        std::vector<uint8_t> entryBytes;
+        const uint8_t *entryData = nullptr;
+        const LowMipCacheFile &cacheFile = textureMap.replacementMap.lowMipCacheFiles[entry.cacheIndex];
+        if (!readLowMipCacheEntry(cacheFile, entry.headerOffset, entry.byteCount, entryBytes, entryData)) {
+            fprintf(stderr, "Failed to read low mip cache entry.\n");
+            return nullptr;
+        }
+
+        return loadLowMipCacheTexture(copyWorker->device, copyList, entryData, entry.headerOffset, entry.byteCount, dstUploadResource);
+    }
+
+    void TextureCache::loadLowMipCacheUsage() {
+        std::ifstream usageStream(textureMap.replacementMap.lowMipCacheUsagePath);
+        if (!usageStream.is_open()) {
+            return;
+        }
+
+        // Every line holds the amount of sessions the entry was used in followed by its path.
+        std::vector<std::pair<uint32_t, std::string>> usedEntries;
+        uint32_t uses = 0;
+        std::string relativePath;
+        while ((usageStream >> uses) && std::getline(usageStream >> std::ws, relativePath)) {
+            auto lowMipCacheIt = textureMap.replacementMap.lowMipCacheTextures.find(relativePath);
+            if (lowMipCacheIt != textureMap.replacementMap.lowMipCacheTextures.end()) {
+                lowMipCacheIt->second.previousUses = uses;
+                usedEntries.emplace_back(uses, relativePath);
+            }
+        }
+
+        // Prefetch the most used entries first until the budget runs out.
+        std::stable_sort(usedEntries.begin(), usedEntries.end(), [](const auto &a, const auto &b) {
+            return a.first > b.first;
+        });
+
+        std::vector<LowMipCachePrefetch> prefetchList;
+        uint64_t prefetchSize = 0;
+        for (const auto &usedEntry : usedEntries) {
+            const LowMipCacheTexture &entry = textureMap.replacementMap.lowMipCacheTextures[usedEntry.second];
+            if ((prefetchSize + entry.memorySize) > LowMipCachePrefetchMaxSize) {
+                break;
+            }
+
+            prefetchList.emplace_back(LowMipCachePrefetch{ usedEntry.second, entry.cacheIndex, entry.headerOffset, entry.byteCount });
+            prefetchSize += entry.memorySize;
+        }
+
+        if (!prefetchList.empty()) {
+            jobSystem->submit(JobSystem::Priority::Low, [this, prefetchList = std::move(prefetchList)]() { prefetchLowMipCacheJob(prefetchList); }, &lowMipCachePrefetchCounter);
+        }
+    }
+
+    void TextureCache::saveLowMipCacheUsage() {
+        const std::filesystem::path &usagePath = textureMap.replacementMap.lowMipCacheUsagePath;
+        if (usagePath.empty()) {
+            return;
+        }
+
+        std::vector<std::pair<uint32_t, std::string>> usedEntries;
+        for (const auto &it : textureMap.replacementMap.lowMipCacheTextures) {
+            const uint32_t uses = it.second.previousUses + (it.second.used ? 1 : 0);
+            if (uses > 0) {
+                usedEntries.emplace_back(uses, it.first);
+            }
+        }
+
+        std::sort(usedEntries.begin(), usedEntries.end(), [](const auto &a, const auto &b) {
+            return (a.first != b.first) ? (a.first > b.first) : (a.second < b.second);
+        });
+
+        std::error_code ec;
+        std::filesystem::create_directories(usagePath.parent_path(), ec);
+        std::ofstream usageStream(usagePath);
+        if (!usageStream.is_open()) {
+            fprintf(stderr, "Failed to save the low mip cache usage.\n");
+            return;
+        }
+
+        for (const auto &usedEntry : usedEntries) {
+            usageStream << usedEntry.first << " " << usedEntry.second << "\n";
+        }
+    }
+
+    Texture *TextureCache::loadReplacementBytes(RenderDevice *device, TextureCopyList &copyList, const uint8_t *fileBytes, size_t fileSize, uint32_t fileSystemIndex, const std::string &relativePath, std::unique_ptr<RenderBuffer> &dstUploadResource) {
+        if (transcodeEnabled) {
+            Texture *transcodedTexture = loadTranscodedTexture(device, copyList, fileBytes, fileSize, fileSystemIndex, relativePath, dstUploadResource);
+            if (transcodedTexture != nullptr) {
+                return transcodedTexture;
+            }
+        }
+
+        return TextureCache::loadTextureFromBytes(device, copyList, fileBytes, fileSize, dstUploadResource);
+    }
+
+    Texture *TextureCache::loadTranscodedTexture(RenderDevice *device, TextureCopyList &copyList, const uint8_t *fileBytes, size_t fileSize, uint32_t fileSystemIndex, const std::string &relativePath, std::unique_ptr<RenderBuffer> &dstUploadResource) {
+        const uint32_t PNG_MAGIC = 0x474E5089;
+        if (replacementCacheDirectory.empty() || (fileSize < sizeof(uint32_t)) || (*reinterpret_cast<const uint32_t *>(fileBytes) != PNG_MAGIC)) {
+            return nullptr;
+        }
+
+        // The transcoded file is found by the contents of the PNG, so it's shared by every pack that uses the same image and it's never
+        // stale even if the pack is modified.
+        const uint64_t fileHash = XXH3_64bits(fileBytes, fileSize);
+        char transcodeFilename[64];
+        snprintf(transcodeFilename, sizeof(transcodeFilename), "transcode-%016llx-v%u.dds", (unsigned long long)(fileHash), TextureTranscoder::Version);
+        const std::filesystem::path transcodePath = replacementCacheDirectory / transcodeFilename;
+        std::error_code ec;
+        if (std::filesystem::is_regular_file(transcodePath, ec)) {
+            MappedFile transcodeFile;
+            if (transcodeFile.open(transcodePath) && TextureTranscoder::validateDDS(transcodeFile.data(), transcodeFile.size())) {
+                Texture *transcodedTexture = new Texture();
+                if (TextureCache::setDDS(transcodedTexture, device, copyList, transcodeFile.data(), transcodeFile.size(), dstUploadResource)) {
+                    return transcodedTexture;
+                }
+
+                delete transcodedTexture;
+            }
+        }
+
+        // The PNG is decoded as usual this time, and the transcoded file will be used the next time the texture is loaded. A file that
+        // fails validation is replaced too.
+        scheduleTranscodeJob(fileHash, transcodePath, fileSystemIndex, relativePath);
+        return nullptr;
+    }
+
+    void TextureCache::scheduleTranscodeJob(uint64_t fileHash, const std::filesystem::path &transcodePath, uint32_t fileSystemIndex, const std::string &relativePath) {
+        {
+            std::unique_lock transcodeLock(transcodeMutex);
+            if (!transcodeHashesQueued.emplace(fileHash).second) {
+                return;
+            }
+        }
+
+        // The job reads the file again instead of keeping a copy of it, so the jobs waiting in the queue don't hold on to the memory of the images.
+        // The file systems can't change while the job is queued, as they're only replaced after the transcode jobs are cancelled.
+        jobSystem->submit(JobSystem::Priority::Idle, [this, transcodePath, fileSystemIndex, relativePath]() {
+            if (transcodeCancelled || !transcodeEnabled) {
+                return;
+            }
+
+            std::vector<uint8_t> pngBytes;
+            if (!textureMap.replacementMap.fileSystems[fileSystemIndex]->load(relativePath, pngBytes)) {
+                return;
+            }
+
+            // Images that can't be block compressed leave no file behind, so they're tried again in every session.
+            std::vector<uint8_t> ddsBytes;
+            if (!TextureTranscoder::transcodePNG(pngBytes.data(), pngBytes.size(), ddsBytes)) {
+                return;
+            }
+
+            // Write to a temporary file first so a file that failed to be written completely is never picked up.
+            std::error_code ec;
+            std::filesystem::create_directories(transcodePath.parent_path(), ec);
+
+            std::filesystem::path transcodeNewPath = transcodePath;
+            transcodeNewPath += ".new";
+            {
+                std::ofstream transcodeStream(transcodeNewPath, std::ios::binary);
+                if (!transcodeStream.is_open()) {
+                    fprintf(stderr, "Failed to save the transcoded replacement.\n");
+                    return;
+                }
+
+                transcodeStream.write(reinterpret_cast<const char *>(ddsBytes.data()), ddsBytes.size());
+                if (transcodeStream.bad()) {
+                    transcodeStream.close();
+                    std::filesystem::remove(transcodeNewPath, ec);
+                    return;
+                }
+            }
+
+            std::filesystem::rename(transcodeNewPath, transcodePath, ec);
+        }, &transcodeCounter);
+    }
+
+    void TextureCache::cancelTranscodeJobs() {
+        transcodeCancelled = true;
+        transcodeCounter.wait();
+        transcodeCancelled = false;
+
+        std::unique_lock transcodeLock(transcodeMutex);
+        transcodeHashesQueued.clear();
+    }
+
+    void TextureCache::setReplacementCacheDirectory(const std::filesystem::path &directory) {
+        replacementCacheDirectory = directory;
+    }
+
+    void TextureCache::setReplacementTranscoding(bool enabled) {
+        transcodeEnabled = enabled;
     }
 
     void TextureCache::resetStreamPerformanceCounters() {
@@ -1782,6 +2856,17 @@ namespace RT64 {
         textureMap.replacementMap.maxTexturePoolSize = maxSize;
     }
 
+    void TextureCache::setTextureMapMaxSize(uint64_t maxSize) {
+        std::unique_lock lock(textureMapMutex);
+        textureMap.maxMemorySize = maxSize;
+    }
+
+    void TextureCache::getTextureMapStats(uint64_t &usedSize, uint64_t &maxSize) {
+        std::unique_lock lock(textureMapMutex);
+        usedSize = textureMap.memorySize;
+        maxSize = textureMap.maxMemorySize;
+    }
+
     void TextureCache::getReplacementPoolStats(uint64_t &usedSize, uint64_t &cachedSize, uint64_t &maxSize) {
         std::unique_lock lock(textureMapMutex);
         usedSize = textureMap.replacementMap.usedTexturePoolSize;
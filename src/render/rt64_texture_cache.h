@@ -5,34 +5,27 @@
 #pragma once
 
 #include <atomic>
+#include <cassert>
 #include <condition_variable>
 #include <filesystem>
 #include <mutex>
-#include <stack>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <json/json.hpp>
 
+#include "common/rt64_async_file_reader.h"
+#include "common/rt64_job_system.h"
 #include "common/rt64_replacement_database.h"
 #include "hle/rt64_draw_call.h"
+#include "shared/rt64_texture_decode.h"
 
 #include "rt64_descriptor_sets.h"
 #include "rt64_render_worker.h"
 #include "rt64_shader_library.h"
 #include "rt64_texture.h"
-
-namespace interop {
-    struct alignas(16) TextureDecodeCB {
-        uint2 Resolution;
-        uint fmt;
-        uint siz;
-        uint address;
-        uint stride;
-        uint tlut;
-        uint palette;
-    };
-};
+#include "rt64_texture_budget.h"
 
 namespace RT64 {
     struct TextureUpload {
@@ -46,13 +39,125 @@ namespace RT64 {
         bool decodeTMEM;
     };
 
+    // Copies recorded while loading a texture so they can be submitted later along with the rest of a batch.
+    struct TextureCopyList {
+        std::vector<RenderTextureBarrier> barriers;
+        std::vector<RenderTextureCopyLocation> destinations;
+        std::vector<RenderTextureCopyLocation> sources;
+
+        void record(RenderCommandList *commandList) const {
+            if (!barriers.empty()) {
+                commandList->barriers(RenderBarrierStage::COPY, barriers);
+            }
+
+            for (size_t i = 0; i < destinations.size(); i++) {
+                commandList->copyTextureRegion(destinations[i], sources[i]);
+            }
+        }
+    };
+
+    // Entries of the low mip cache are only indexed when the cache is loaded. The texture is created the first time the entry is used
+    // or when it's prefetched because it was used in previous sessions.
     struct LowMipCacheTexture {
         Texture *texture = nullptr;
+        uint32_t cacheIndex = 0;
+        size_t headerOffset = 0;
+        size_t byteCount = 0;
+        uint64_t memorySize = 0;
+        uint32_t previousUses = 0;
+        bool used = false;
         bool transitioned = false;
     };
 
-    typedef std::pair<uint32_t, uint64_t> AccessPair;
-    typedef std::list<AccessPair> AccessList;
+    struct LowMipCachePrefetch {
+        std::string relativePath;
+        uint32_t cacheIndex = 0;
+        size_t headerOffset = 0;
+        size_t byteCount = 0;
+    };
+
+    // Caches stored as is are read at the offset of each entry when it's needed. Compressed caches can't be read from an arbitrary
+    // offset without decompressing everything before it, so their contents are kept in memory instead.
+    struct LowMipCacheFile {
+        std::filesystem::path filePath;
+        uint64_t fileOffset = 0;
+        std::vector<uint8_t> bytes;
+    };
+
+    struct LowMipCacheResult {
+        std::string relativePath;
+        Texture *texture = nullptr;
+        std::unique_ptr<RenderBuffer> uploadResource;
+        TextureCopyList copyList;
+    };
+
+    // Doubly linked list of texture indices ordered from the most to the least recently used. Nodes are stored by texture index and are
+    // recycled along with the index, so moving a texture to the front never allocates and only touches the neighbouring nodes.
+    struct AccessList {
+        static const uint32_t None = UINT32_MAX;
+
+        struct Node {
+            uint32_t previous = None;
+            uint32_t next = None;
+            uint64_t frame = 0;
+            bool linked = false;
+        };
+
+        std::vector<Node> nodes;
+        uint32_t head = None;
+        uint32_t tail = None;
+
+        void addNode() {
+            nodes.emplace_back();
+        }
+
+        void pushFront(uint32_t index, uint64_t frame) {
+            Node &node = nodes[index];
+            assert(!node.linked);
+            node.previous = None;
+            node.next = head;
+            node.frame = frame;
+            node.linked = true;
+            if (head != None) {
+                nodes[head].previous = index;
+            }
+            else {
+                tail = index;
+            }
+
+            head = index;
+        }
+
+        void remove(uint32_t index) {
+            Node &node = nodes[index];
+            if (!node.linked) {
+                return;
+            }
+
+            if (node.previous != None) {
+                nodes[node.previous].next = node.next;
+            }
+            else {
+                head = node.next;
+            }
+
+            if (node.next != None) {
+                nodes[node.next].previous = node.previous;
+            }
+            else {
+                tail = node.previous;
+            }
+
+            node.previous = None;
+            node.next = None;
+            node.linked = false;
+        }
+
+        void moveToFront(uint32_t index, uint64_t frame) {
+            remove(index);
+            pushFront(index, frame);
+        }
+    };
 
     struct ReplacementDirectory {
         std::filesystem::path dirOrZipPath;
@@ -73,6 +178,11 @@ namespace RT64 {
             std::list<Texture *>::iterator unusedTextureListIterator;
         };
 
+        struct PartialEntry {
+            Texture *texture = nullptr;
+            uint32_t references = 0;
+        };
+
         typedef std::unordered_map<uint64_t, MapEntry> LoadedTextureMap;
         typedef std::unordered_map<Texture *, LoadedTextureMap::iterator> LoadedTextureReverseMap;
 
@@ -81,6 +191,10 @@ namespace RT64 {
         std::list<Texture *> unusedTextureList;
         std::vector<uint32_t> resolvedHashVersions;
         std::unordered_map<std::string, LowMipCacheTexture> lowMipCacheTextures;
+        std::unordered_map<uint64_t, PartialEntry> partialTextureMap;
+        std::unordered_map<Texture *, uint64_t> partialTextureReverseMap;
+        std::vector<LowMipCacheFile> lowMipCacheFiles;
+        std::filesystem::path lowMipCacheUsagePath;
         std::vector<std::unique_ptr<FileSystem>> fileSystems;
         std::vector<std::unordered_map<uint64_t, ReplacementResolvedPath>> fileSystemResolvedPaths;
         std::vector<uint32_t> fileSystemHashVersions;
@@ -89,6 +203,7 @@ namespace RT64 {
         std::vector<ReplacementDirectory> replacementDirectories;
         uint64_t usedTexturePoolSize = 0;
         uint64_t cachedTexturePoolSize = 0;
+        uint64_t permanentTexturePoolSize = 0;
         uint64_t maxTexturePoolSize = 0;
         ReplacementDatabase directoryDatabase;
         bool fileSystemIsDirectory = false;
@@ -101,6 +216,8 @@ namespace RT64 {
         void removeUnusedEntriesFromDatabase();
         void addLoadedTexture(Texture *texture, uint32_t fileSystemIndex, const std::string &relativePath, bool referenceCounted);
         Texture *getFromRelativePath(uint32_t fileSystemIndex, const std::string &relativePath) const;
+        void addPartialTexture(Texture *texture, uint32_t fileSystemIndex, const std::string &relativePath);
+        Texture *getPartialTexture(uint32_t fileSystemIndex, const std::string &relativePath) const;
         uint64_t hashFromRelativePath(uint32_t fileSystemIndex, const std::string &relativePath) const;
         void incrementReference(Texture *texture);
         void decrementReference(Texture *texture);
@@ -133,7 +250,10 @@ namespace RT64 {
         std::vector<uint64_t> creationFrames;
         uint32_t globalVersion;
         AccessList accessList;
-        std::vector<AccessList::iterator> listIterators;
+        std::vector<TextureBudget::EvictionCandidate> evictionCandidates;
+        uint64_t memorySize = 0;
+        uint64_t maxMemorySize = 0;
+        uint64_t latestSubmissionFrame = 0;
         std::vector<Texture *> evictedTextures;
         ReplacementMap replacementMap;
         bool replacementMapEnabled;
@@ -145,6 +265,7 @@ namespace RT64 {
         void replace(uint64_t hash, Texture *texture, bool shiftedByHalf, bool referenceCounted);
         bool use(uint64_t hash, uint64_t submissionFrame, uint32_t &textureIndex, interop::float2 &textureScale, interop::float3 &textureDimensions, bool &textureReplaced, bool &hasMipmaps, bool &shiftedByHalf);
         bool evict(uint64_t submissionFrame, std::vector<uint64_t> &evictedHashes);
+        void evictIndex(uint32_t textureIndex, std::vector<uint64_t> &evictedHashes);
         void incrementLock();
         void decrementLock();
         Texture *get(uint32_t index) const;
@@ -156,16 +277,50 @@ namespace RT64 {
             uint32_t fileSystemIndex = 0;
             std::string relativePath;
             bool fromPreload = false;
+            uint64_t textureHash = 0;
+            uint64_t requestFrame = 0;
+            uint64_t projectedSize = 0;
+
+            // Only the mipmaps up to this size are loaded if it's not zero. The rest are loaded by another request once these are visible.
+            uint32_t maxDimension = 0;
 
             StreamDescription() {
                 // Default constructor.
             }
 
-            StreamDescription(uint32_t fileSystemIndex, const std::string &relativePath, bool fromPreload) {
+            StreamDescription(uint32_t fileSystemIndex, const std::string &relativePath, bool fromPreload, uint64_t textureHash, uint64_t requestFrame, uint64_t projectedSize, uint32_t maxDimension = 0) {
                 this->fileSystemIndex = fileSystemIndex;
                 this->relativePath = relativePath;
                 this->fromPreload = fromPreload;
+                this->textureHash = textureHash;
+                this->requestFrame = requestFrame;
+                this->projectedSize = projectedSize;
+                this->maxDimension = maxDimension;
             }
+
+            // Orders the queue so preloads go first, followed by the requests for the smallest mipmaps, the textures that were requested
+            // most recently and the smallest files.
+            bool operator<(const StreamDescription &other) const {
+                if (fromPreload != other.fromPreload) {
+                    return other.fromPreload;
+                }
+
+                if ((maxDimension > 0) != (other.maxDimension > 0)) {
+                    return other.maxDimension > 0;
+                }
+
+                if (requestFrame != other.requestFrame) {
+                    return requestFrame < other.requestFrame;
+                }
+
+                return projectedSize > other.projectedSize;
+            }
+        };
+
+        enum class StreamCheck {
+            Load,
+            Requeue,
+            Cancel
         };
 
         struct StreamResult {
@@ -173,6 +328,8 @@ namespace RT64 {
             uint32_t fileSystemIndex = 0;
             std::string relativePath;
             bool fromPreload = false;
+            std::unique_ptr<RenderBuffer> uploadResource;
+            TextureCopyList copyList;
 
             StreamResult() {
                 // Default constructor.
@@ -186,35 +343,48 @@ namespace RT64 {
             }
         };
 
-        struct StreamThread {
-            std::unique_ptr<RenderWorker> worker;
-            TextureCache *textureCache = nullptr;
-            std::unique_ptr<std::thread> thread;
-            std::atomic<bool> threadRunning;
-            std::unique_ptr<RenderBuffer> uploadResource;
+        struct StreamWorker {
+            std::vector<uint8_t> replacementBytes;
+            std::unique_ptr<AsyncFileReader> asyncReader;
+            std::vector<StreamDescription> batch;
 
-            StreamThread(TextureCache *textureCache);
-            ~StreamThread();
-            void loop();
+            // Holds the files that don't fit in the registered buffers of the reader, one for each read in the batch.
+            std::vector<std::vector<uint8_t>> largeFileBytes;
         };
 
         const ShaderLibrary *shaderLibrary;
         std::vector<TextureUpload> uploadQueue;
         std::vector<ReplacementResolvedPath> resolvedPathQueue;
         std::vector<StreamResult> streamResultQueue;
-        std::vector<std::unique_ptr<RenderBuffer>> tmemUploadResources;
+        std::atomic<uint64_t> streamResultBytesInFlight = 0;
+        std::unique_ptr<RenderBuffer> tmemStagingBuffer;
+        uint64_t tmemStagingBufferSize = 0;
         std::vector<std::unique_ptr<RenderBuffer>> replacementUploadResources;
+        std::unique_ptr<RenderBufferFormattedView> tmemStagingBufferView;
+        std::unique_ptr<RenderBuffer> decodeDescriptorBuffer;
+        uint64_t decodeDescriptorBufferSize = 0;
         std::vector<std::unique_ptr<TextureDecodeDescriptorSet>> descriptorSets;
         std::mutex uploadQueueMutex;
-        std::condition_variable uploadQueueChanged;
         std::condition_variable uploadQueueFinished;
-        std::unique_ptr<std::thread> uploadThread;
-        std::atomic<bool> uploadThreadRunning;
-        std::stack<StreamDescription> streamDescStack;
-        std::mutex streamDescStackMutex;
-        std::condition_variable streamDescStackChanged;
-        int32_t streamDescStackActiveCount = 0;
-        std::list<std::unique_ptr<StreamThread>> streamThreads;
+        size_t uploadsInProgress = 0;
+        bool uploadJobScheduled = false;
+        JobCounter uploadCounter;
+        std::vector<StreamDescription> streamDescQueue;
+        std::mutex streamDescQueueMutex;
+        std::vector<std::unique_ptr<StreamWorker>> streamWorkers;
+        std::vector<StreamWorker *> freeStreamWorkers;
+        bool streamRetryScheduled = false;
+        JobCounter streamCounter;
+        std::vector<LowMipCacheResult> lowMipCacheResultQueue;
+        std::atomic<bool> lowMipCachePrefetchCancelled = false;
+        JobCounter lowMipCachePrefetchCounter;
+        std::unordered_set<uint64_t> transcodeHashesQueued;
+        std::mutex transcodeMutex;
+        std::atomic<bool> transcodeCancelled = false;
+        std::atomic<bool> transcodeEnabled = false;
+        JobCounter transcodeCounter;
+        std::filesystem::path replacementCacheDirectory;
+        JobSystem *jobSystem;
         std::mutex streamPerformanceMutex;
         uint64_t streamLoadTimeTotal = 0;
         uint64_t streamLoadCount = 0;
@@ -230,9 +400,18 @@ namespace RT64 {
         uint32_t lockCounter;
         bool developerMode;
 
-        TextureCache(RenderWorker *directWorker, RenderWorker *copyWorker, uint32_t threadCount, const ShaderLibrary *shaderLibrary);
+        TextureCache(RenderWorker *directWorker, RenderWorker *copyWorker, JobSystem *jobSystem, uint32_t threadCount, const ShaderLibrary *shaderLibrary);
         ~TextureCache();
-        void uploadThreadLoop();
+        void scheduleUploadJob();
+        void uploadJob();
+        void scheduleStreamJobs();
+        void streamJob(StreamWorker *streamWorker);
+        bool popStreamDescription(StreamWorker *streamWorker, bool releaseWorker, bool underPressure, StreamDescription &streamDesc);
+        void loadStreamDescription(StreamWorker *streamWorker, const StreamDescription &streamDesc);
+        void pushStreamResult(StreamResult &&streamResult);
+        void pushStreamDescription(const StreamDescription &streamDesc);
+        StreamCheck checkStreamDescription(StreamDescription &streamDesc);
+        void cancelStreamDescriptions();
         void queueGPUUploadTMEM(uint64_t hash, uint64_t creationFrame, const uint8_t *bytes, int bytesCount, int width, int height, uint32_t tlut, const LoadTile &loadTile, bool decodeTMEM);
         void waitForGPUUploads();
         void addResolvedPaths(uint64_t hash, uint32_t width, uint32_t height, uint32_t tlut, const LoadTile &loadTile, const std::vector<uint8_t> &bytesTMEM, bool decodeTMEM, std::vector<ReplacementResolvedPath> &resolvedPaths, uint64_t exclusiveDbHash = 0);
@@ -253,16 +432,36 @@ namespace RT64 {
         bool evict(uint64_t submissionFrame, std::vector<uint64_t> &evictedHashes);
         void incrementLock();
         void decrementLock();
+        bool isReplacementPoolUnderPressure();
         void waitForAllStreamThreads(bool clearQueueImmediately);
+        void prefetchLowMipCacheJob(const std::vector<LowMipCachePrefetch> &prefetchList);
+        void cancelLowMipCachePrefetch();
+        Texture *loadLowMipCacheEntry(const LowMipCacheTexture &entry, TextureCopyList &copyList, std::unique_ptr<RenderBuffer> &dstUploadResource);
+        void loadLowMipCacheUsage();
+        void saveLowMipCacheUsage();
+        Texture *loadReplacementBytes(RenderDevice *device, TextureCopyList &copyList, const uint8_t *fileBytes, size_t fileSize, uint32_t fileSystemIndex, const std::string &relativePath, std::unique_ptr<RenderBuffer> &dstUploadResource);
+        Texture *loadTranscodedTexture(RenderDevice *device, TextureCopyList &copyList, const uint8_t *fileBytes, size_t fileSize, uint32_t fileSystemIndex, const std::string &relativePath, std::unique_ptr<RenderBuffer> &dstUploadResource);
+        void scheduleTranscodeJob(uint64_t fileHash, const std::filesystem::path &transcodePath, uint32_t fileSystemIndex, const std::string &relativePath);
+        void cancelTranscodeJobs();
+        void setReplacementCacheDirectory(const std::filesystem::path &directory);
+        void setReplacementTranscoding(bool enabled);
         void resetStreamPerformanceCounters();
         void addStreamLoadTime(uint64_t streamLoadTime);
         uint64_t getAverageStreamLoadTime();
         void setReplacementPoolMaxSize(uint64_t maxSize);
         void getReplacementPoolStats(uint64_t &usedSize, uint64_t &cachedSize, uint64_t &maxSize);
+        void setTextureMapMaxSize(uint64_t maxSize);
+        void getTextureMapStats(uint64_t &usedSize, uint64_t &maxSize);
         Texture *getTexture(uint32_t textureIndex);
         static void setRGBA32(Texture *dstTexture, RenderDevice *device, RenderCommandList *commandList, const uint8_t *bytes, size_t byteCount, uint32_t width, uint32_t height, uint32_t rowPitch, std::unique_ptr<RenderBuffer> &dstUploadResource, RenderPool *uploadResourcePool = nullptr, std::mutex *uploadResourcePoolMutex = nullptr);
-        static bool setDDS(Texture *dstTexture, RenderDevice *device, RenderCommandList *commandList, const uint8_t *bytes, size_t byteCount, std::unique_ptr<RenderBuffer> &dstUploadResource, RenderPool *uploadResourcePool = nullptr, std::mutex *uploadResourcePoolMutex = nullptr);
-        static bool setLowMipCache(RenderDevice *device, RenderCommandList *commandList, const uint8_t *bytes, size_t byteCount, std::unique_ptr<RenderBuffer> &dstUploadResource, std::unordered_map<std::string, LowMipCacheTexture> &dstTextureMap, uint64_t &totalMemory);
-        static Texture *loadTextureFromBytes(RenderDevice *device, RenderCommandList *commandList, const std::vector<uint8_t> &fileBytes, std::unique_ptr<RenderBuffer> &dstUploadResource, RenderPool *resourcePool = nullptr, std::mutex *uploadResourcePoolMutex = nullptr);
+        static void setRGBA32(Texture *dstTexture, RenderDevice *device, TextureCopyList &copyList, const uint8_t *bytes, size_t byteCount, uint32_t width, uint32_t height, uint32_t rowPitch, std::unique_ptr<RenderBuffer> &dstUploadResource, RenderPool *uploadResourcePool = nullptr, std::mutex *uploadResourcePoolMutex = nullptr);
+        static bool setDDS(Texture *dstTexture, RenderDevice *device, TextureCopyList &copyList, const uint8_t *bytes, size_t byteCount, std::unique_ptr<RenderBuffer> &dstUploadResource, RenderPool *uploadResourcePool = nullptr, std::mutex *uploadResourcePoolMutex = nullptr);
+        static bool setDDS(Texture *dstTexture, RenderDevice *device, TextureCopyList &copyList, FileSystemReader &reader, std::unique_ptr<RenderBuffer> &dstUploadResource, uint32_t maxDimension = 0);
+        static bool indexLowMipCache(FileSystemReader &reader, uint32_t cacheIndex, std::unordered_map<std::string, LowMipCacheTexture> &dstTextureMap);
+        static bool readLowMipCacheEntry(const LowMipCacheFile &cacheFile, size_t headerOffset, size_t byteCount, std::vector<uint8_t> &entryBytes, const uint8_t *&entryData);
+        static Texture *loadLowMipCacheTexture(RenderDevice *device, TextureCopyList &copyList, const uint8_t *entryData, size_t headerOffset, size_t byteCount, std::unique_ptr<RenderBuffer> &dstUploadResource);
+        static Texture *loadDDSFromReader(RenderDevice *device, TextureCopyList &copyList, FileSystemReader &reader, size_t fileSize, std::vector<uint8_t> &fileBytes, std::unique_ptr<RenderBuffer> &dstUploadResource, uint32_t maxDimension = 0);
+        static Texture *loadTextureFromBytes(RenderDevice *device, TextureCopyList &copyList, const uint8_t *fileBytes, size_t fileSize, std::unique_ptr<RenderBuffer> &dstUploadResource, RenderPool *resourcePool = nullptr, std::mutex *uploadResourcePoolMutex = nullptr);
+        static Texture *loadTextureFromBytes(RenderDevice *device, TextureCopyList &copyList, const std::vector<uint8_t> &fileBytes, std::unique_ptr<RenderBuffer> &dstUploadResource, RenderPool *resourcePool = nullptr, std::mutex *uploadResourcePoolMutex = nullptr);
     };
 };
\ No newline at end of file
@@ -0,0 +1,58 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "shared/rt64_texture_decode.h"
+
+namespace RT64 {
+    struct TextureDecodeBatch {
+        // Must match the definitions in TextureDecodeCS.hlsl.
+        static const uint32_t GroupSize = 8;
+        static const uint32_t GroupsPerRow = 1024;
+        static const uint32_t TexturesPerDispatch = 256;
+
+        // The thread groups of all the textures are laid out one after the other so a single dispatch can decode as many textures as the
+        // descriptor set can hold. The group offsets start over on every dispatch.
+        std::vector<interop::TextureDecodeDescriptor> descriptors;
+
+        static uint32_t groupCount(const interop::TextureDecodeDescriptor &desc) {
+            return desc.groupsPerRow * ((desc.resolution.y + GroupSize - 1) / GroupSize);
+        }
+
+        void clear() {
+            descriptors.clear();
+        }
+
+        bool empty() const {
+            return descriptors.empty();
+        }
+
+        // Fills in the group layout of the descriptor and adds it to the batch.
+        void add(interop::TextureDecodeDescriptor desc) {
+            const bool dispatchStart = (descriptors.size() % TexturesPerDispatch) == 0;
+            desc.groupOffset = dispatchStart ? 0 : (descriptors.back().groupOffset + groupCount(descriptors.back()));
+            desc.groupsPerRow = (desc.resolution.x + GroupSize - 1) / GroupSize;
+            desc.padding = 0;
+            descriptors.emplace_back(desc);
+        }
+
+        uint32_t dispatchCount() const {
+            return uint32_t((descriptors.size() + TexturesPerDispatch - 1) / TexturesPerDispatch);
+        }
+
+        interop::TextureDecodeCB dispatchConstants(uint32_t dispatchIndex) const {
+            interop::TextureDecodeCB decodeCB;
+            decodeCB.descriptorOffset = dispatchIndex * TexturesPerDispatch;
+            decodeCB.textureCount = std::min(uint32_t(descriptors.size()) - decodeCB.descriptorOffset, uint32_t(TexturesPerDispatch));
+            const interop::TextureDecodeDescriptor &lastDesc = descriptors[decodeCB.descriptorOffset + decodeCB.textureCount - 1];
+            decodeCB.groupCount = lastDesc.groupOffset + groupCount(lastDesc);
+            return decodeCB;
+        }
+    };
+};
@@ -0,0 +1,166 @@
+//
+// RT64
+//
+
+#define STB_DXT_IMPLEMENTATION
+
+#include "ddspp/ddspp.h"
+#include "stb/stb_dxt.h"
+#include "stb/stb_image.h"
+
+#include "rt64_texture_transcoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace RT64 {
+    // TextureTranscoder
+
+    static const uint32_t TranscodeBlockSize = 4;
+    static const uint32_t DDSFlagsCaps = 0x1;
+    static const uint32_t DDSFlagsHeight = 0x2;
+    static const uint32_t DDSFlagsWidth = 0x4;
+    static const uint32_t DDSFlagsPixelFormat = 0x1000;
+    static const uint32_t DDSFlagsMipmapCount = 0x20000;
+    static const uint32_t DDSFlagsLinearSize = 0x80000;
+    static const uint32_t DDSPixelFormatFourCC = 0x4;
+    static const uint32_t DDSCapsComplex = 0x8;
+    static const uint32_t DDSCapsTexture = 0x1000;
+    static const uint32_t DDSCapsMipmap = 0x400000;
+    static const uint32_t DDSFourCCDXT1 = 0x31545844;
+    static const uint32_t DDSFourCCDXT5 = 0x35545844;
+
+    static void downsampleMipmap(const std::vector<uint8_t> &srcPixels, uint32_t srcWidth, uint32_t srcHeight, std::vector<uint8_t> &dstPixels, uint32_t dstWidth, uint32_t dstHeight) {
+        // Box filter over each 2x2 footprint. Odd dimensions repeat the last row or column instead of reading past the edge.
+        dstPixels.resize(size_t(dstWidth) * dstHeight * 4);
+        for (uint32_t y = 0; y < dstHeight; y++) {
+            const uint32_t y0 = std::min(y * 2, srcHeight - 1);
+            const uint32_t y1 = std::min(y * 2 + 1, srcHeight - 1);
+            for (uint32_t x = 0; x < dstWidth; x++) {
+                const uint32_t x0 = std::min(x * 2, srcWidth - 1);
+                const uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1);
+                const uint8_t *p00 = &srcPixels[(size_t(y0) * srcWidth + x0) * 4];
+                const uint8_t *p01 = &srcPixels[(size_t(y0) * srcWidth + x1) * 4];
+                const uint8_t *p10 = &srcPixels[(size_t(y1) * srcWidth + x0) * 4];
+                const uint8_t *p11 = &srcPixels[(size_t(y1) * srcWidth + x1) * 4];
+                uint8_t *dst = &dstPixels[(size_t(y) * dstWidth + x) * 4];
+                for (uint32_t c = 0; c < 4; c++) {
+                    dst[c] = uint8_t((uint32_t(p00[c]) + p01[c] + p10[c] + p11[c] + 2) / 4);
+                }
+            }
+        }
+    }
+
+    static void compressMipmap(const std::vector<uint8_t> &pixels, uint32_t width, uint32_t height, bool useAlpha, std::vector<uint8_t> &ddsBytes) {
+        // Mipmaps smaller than a block repeat their edge pixels to fill it.
+        const uint32_t blockBytes = useAlpha ? 16 : 8;
+        const uint32_t blocksX = (width + TranscodeBlockSize - 1) / TranscodeBlockSize;
+        const uint32_t blocksY = (height + TranscodeBlockSize - 1) / TranscodeBlockSize;
+        uint8_t blockPixels[TranscodeBlockSize * TranscodeBlockSize * 4];
+        size_t dstOffset = ddsBytes.size();
+        ddsBytes.resize(dstOffset + size_t(blocksX) * blocksY * blockBytes);
+        for (uint32_t by = 0; by < blocksY; by++) {
+            for (uint32_t bx = 0; bx < blocksX; bx++) {
+                for (uint32_t py = 0; py < TranscodeBlockSize; py++) {
+                    const uint32_t y = std::min(by * TranscodeBlockSize + py, height - 1);
+                    for (uint32_t px = 0; px < TranscodeBlockSize; px++) {
+                        const uint32_t x = std::min(bx * TranscodeBlockSize + px, width - 1);
+                        memcpy(&blockPixels[(py * TranscodeBlockSize + px) * 4], &pixels[(size_t(y) * width + x) * 4], 4);
+                    }
+                }
+
+                stb_compress_dxt_block(&ddsBytes[dstOffset], blockPixels, useAlpha ? 1 : 0, STB_DXT_HIGHQUAL);
+                dstOffset += blockBytes;
+            }
+        }
+    }
+
+    bool TextureTranscoder::transcodePNG(const uint8_t *pngBytes, size_t pngSize, std::vector<uint8_t> &ddsBytes) {
+        int width, height;
+        stbi_uc *data = stbi_load_from_memory(pngBytes, int(pngSize), &width, &height, nullptr, 4);
+        if (data == nullptr) {
+            return false;
+        }
+
+        // Block compressed textures must have dimensions aligned to the block size, and the replacement's dimensions can't be padded
+        // without changing how it's sampled.
+        if (((width % TranscodeBlockSize) != 0) || ((height % TranscodeBlockSize) != 0)) {
+            stbi_image_free(data);
+            return false;
+        }
+
+        const size_t pixelCount = size_t(width) * size_t(height);
+        std::vector<uint8_t> pixels(data, data + pixelCount * 4);
+        stbi_image_free(data);
+
+        bool useAlpha = false;
+        for (size_t i = 0; (i < pixelCount) && !useAlpha; i++) {
+            useAlpha = (pixels[i * 4 + 3] < 255);
+        }
+
+        uint32_t mipCount = 1;
+        while ((uint32_t(width) >> mipCount) > 0 || (uint32_t(height) >> mipCount) > 0) {
+            mipCount++;
+        }
+
+        const uint32_t blockBytes = useAlpha ? 16 : 8;
+        uint32_t header[31] = {};
+        header[0] = 124;
+        header[1] = DDSFlagsCaps | DDSFlagsHeight | DDSFlagsWidth | DDSFlagsPixelFormat | DDSFlagsMipmapCount | DDSFlagsLinearSize;
+        header[2] = uint32_t(height);
+        header[3] = uint32_t(width);
+        header[4] = (uint32_t(width) / TranscodeBlockSize) * (uint32_t(height) / TranscodeBlockSize) * blockBytes;
+        header[6] = mipCount;
+        header[18] = 32;
+        header[19] = DDSPixelFormatFourCC;
+        header[20] = useAlpha ? DDSFourCCDXT5 : DDSFourCCDXT1;
+        header[26] = DDSCapsTexture | DDSCapsComplex | DDSCapsMipmap;
+
+        const uint32_t ddsMagic = ddspp::DDS_MAGIC;
+        ddsBytes.clear();
+        ddsBytes.resize(sizeof(ddsMagic) + sizeof(header));
+        memcpy(ddsBytes.data(), &ddsMagic, sizeof(ddsMagic));
+        memcpy(&ddsBytes[sizeof(ddsMagic)], header, sizeof(header));
+
+        uint32_t mipWidth = uint32_t(width);
+        uint32_t mipHeight = uint32_t(height);
+        std::vector<uint8_t> mipPixels;
+        for (uint32_t mip = 0; mip < mipCount; mip++) {
+            if (mip > 0) {
+                const uint32_t nextWidth = std::max(mipWidth / 2, 1U);
+                const uint32_t nextHeight = std::max(mipHeight / 2, 1U);
+                downsampleMipmap(pixels, mipWidth, mipHeight, mipPixels, nextWidth, nextHeight);
+                pixels.swap(mipPixels);
+                mipWidth = nextWidth;
+                mipHeight = nextHeight;
+            }
+
+            compressMipmap(pixels, mipWidth, mipHeight, useAlpha, ddsBytes);
+        }
+
+        return true;
+    }
+
+    bool TextureTranscoder::validateDDS(const uint8_t *ddsBytes, size_t ddsSize) {
+        // The header is decoded from a copy so a truncated file can't be read past its end.
+        uint8_t headerBytes[sizeof(uint32_t) + sizeof(ddspp::Header) + sizeof(ddspp::HeaderDXT10)] = {};
+        memcpy(headerBytes, ddsBytes, std::min(ddsSize, sizeof(headerBytes)));
+
+        ddspp::Descriptor ddsDescriptor;
+        if (ddspp::decode_header(headerBytes, ddsDescriptor) != ddspp::Success) {
+            return false;
+        }
+
+        if ((ddsDescriptor.headerSize > ddsSize) || (ddsDescriptor.numMips == 0)) {
+            return false;
+        }
+
+        uint32_t blockWidth, blockHeight;
+        ddspp::get_block_size(ddsDescriptor.format, blockWidth, blockHeight);
+        const uint32_t lastMip = ddsDescriptor.numMips - 1;
+        const uint32_t lastMipHeight = std::max(ddsDescriptor.height >> lastMip, 1U);
+        const uint64_t lastMipRows = (lastMipHeight + blockHeight - 1) / blockHeight;
+        const uint64_t lastMipEnd = uint64_t(ddspp::get_offset(ddsDescriptor, lastMip, std::max(ddsDescriptor.arraySize, 1U) - 1)) + uint64_t(ddspp::get_row_pitch(ddsDescriptor, lastMip)) * lastMipRows;
+        return (ddsDescriptor.headerSize + lastMipEnd) <= ddsSize;
+    }
+};
@@ -0,0 +1,24 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace RT64 {
+    // Compresses replacements that were shipped as PNG into DDS files with block compression and mipmaps, so they can be loaded the same
+    // way as any other DDS replacement.
+    struct TextureTranscoder {
+        // Must be increased whenever the output changes, so the files transcoded by previous versions are ignored.
+        static const uint32_t Version = 1;
+
+        // Uses BC1 for opaque images and BC3 otherwise. Fails if the dimensions aren't a multiple of the block size.
+        static bool transcodePNG(const uint8_t *pngBytes, size_t pngSize, std::vector<uint8_t> &ddsBytes);
+
+        // Checks the header and that the file is large enough to hold every mipmap it describes.
+        static bool validateDDS(const uint8_t *ddsBytes, size_t ddsSize);
+    };
+};
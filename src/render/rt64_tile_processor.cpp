@@ -14,8 +14,8 @@ namespace RT64 {
 
     TileProcessor::~TileProcessor() { }
 
-    void TileProcessor::setup(RenderWorker *worker) {
-        bufferUploader = std::make_unique<BufferUploader>(worker->device);
+    void TileProcessor::setup(RenderWorker *worker, JobSystem *jobSystem) {
+        bufferUploader = std::make_unique<BufferUploader>(worker->device, jobSystem);
     }
 
     void TileProcessor::process(const ProcessParams &p) {
@@ -27,11 +27,17 @@ namespace RT64 {
             if (prevFrameValid) {
                 const GameFrameMap::WorkloadMap &workloadMap = p.curFrame->frameMap.workloads[w];
                 auto &lerpRdpTiles = drawData.lerpRdpTiles;
-                lerpRdpTiles = curRdpTiles;
+                const bool reuseStatic = p.reuseStatic && (lerpRdpTiles.size() == curRdpTiles.size());
+                if (reuseStatic && (workloadMap.varyingTileCount == 0)) {
+                    continue;
+                }
+                else if (!reuseStatic) {
+                    lerpRdpTiles = curRdpTiles;
+                }
 
                 for (size_t t = 0; t < curRdpTiles.size(); t++) {
                     const GameFrameMap::TileMap &tileMap = workloadMap.tiles[t];
-                    if (!tileMap.mapped) {
+                    if (!tileMap.mapped || (reuseStatic && !tileMap.varying)) {
                         continue;
                     }
 
@@ -51,7 +57,8 @@ namespace RT64 {
 
         for (uint32_t w : p.curFrame->workloads) {
             const bool prevFrameValid = (p.prevFrame != nullptr) && p.curFrame->frameMap.workloads[w].mapped;
-            if (prevFrameValid) {
+            const bool reuseBuffer = p.reuseStatic && (p.curFrame->frameMap.workloads[w].varyingTileCount == 0);
+            if (prevFrameValid && !reuseBuffer) {
                 Workload &workload = p.workloadQueue->workloads[w];
                 DrawBuffers &drawBuffers = workload.drawBuffers;
                 const DrawData &drawData = workload.drawData;
@@ -61,8 +68,7 @@ namespace RT64 {
             }
         }
 
-        if (!uploads.empty()) {
-            bufferUploader->submit(p.worker, uploads);
-        }
+        // Submit even if there's nothing to upload so the copies from the previous submission aren't recorded again.
+        bufferUploader->submit(p.worker, uploads);
     }
 };
\ No newline at end of file
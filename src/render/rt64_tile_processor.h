@@ -21,11 +21,14 @@ namespace RT64 {
             const GameFrame *prevFrame = nullptr;
             float curFrameWeight = 1.0f;
             float prevFrameWeight = 0.0f;
+
+            // Results that don't depend on the frame weights were already computed by a previous call for the same frame and can be kept.
+            bool reuseStatic = false;
         };
 
         TileProcessor();
         ~TileProcessor();
-        void setup(RenderWorker *worker);
+        void setup(RenderWorker *worker, JobSystem *jobSystem);
         void process(const ProcessParams &p);
         void upload(const ProcessParams &p);
     };
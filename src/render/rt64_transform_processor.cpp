@@ -4,6 +4,8 @@
 
 #include "rt64_transform_processor.h"
 
+#include <algorithm>
+
 #include "common/rt64_math.h"
 #include "hle/rt64_game_frame.h"
 #include "hle/rt64_workload_queue.h"
@@ -15,57 +17,103 @@ namespace RT64 {
 
     TransformProcessor::~TransformProcessor() { }
 
-    void TransformProcessor::setup(RenderWorker *worker) {
-        bufferUploader = std::make_unique<BufferUploader>(worker->device);
+    void TransformProcessor::setup(RenderWorker *worker, JobSystem *jobSystem) {
+        this->jobSystem = jobSystem;
+        bufferUploader = std::make_unique<BufferUploader>(worker->device, jobSystem);
     }
 
     void TransformProcessor::process(const ProcessParams &p) {
+        batches.clear();
+
         for (uint32_t w : p.curFrame->workloads) {
             Workload &workload = p.workloadQueue->workloads[w];
             DrawData &drawData = workload.drawData;
-            const bool prevFrameValid = (p.prevFrame != nullptr) && p.curFrame->frameMap.workloads[w].mapped;
-            auto &lerpWorldTransforms = drawData.lerpWorldTransforms;
-            auto &invTWorldTransforms = drawData.invTWorldTransforms;
-            auto &prevWorldTransforms = drawData.prevWorldTransforms;
-            lerpWorldTransforms.clear();
-            invTWorldTransforms.clear();
-            prevWorldTransforms.clear();
-
-            hlslpp::float4x4 prevMatrix, curMatrix, invMatrix, invTMatrix;
+            const GameFrameMap::WorkloadMap &workloadMap = p.curFrame->frameMap.workloads[w];
+            const bool prevFrameValid = (p.prevFrame != nullptr) && workloadMap.mapped;
+            const bool reuseStatic = p.reuseStatic && (drawData.invTWorldTransforms.size() == drawData.worldTransforms.size());
+            if (reuseStatic && (!prevFrameValid || (workloadMap.varyingTransformCount == 0))) {
+                continue;
+            }
 
-            // Match with the previous frame and interpolate the transforms.
+            // Size the outputs before any batches run so they can be written to from multiple threads.
+            const uint32_t transformCount = uint32_t(drawData.worldTransforms.size());
+            drawData.invTWorldTransforms.resize(transformCount);
             if (prevFrameValid) {
-                const GameFrameMap::WorkloadMap &workloadMap = p.curFrame->frameMap.workloads[w];
-                const DrawData &prevDrawData = p.workloadQueue->workloads[workloadMap.prevWorkloadIndex].drawData;
-                for (size_t t = 0; t < drawData.worldTransforms.size(); t++) {
-                    const GameFrameMap::TransformMap &transformMap = workloadMap.transforms[t];
-                    if (transformMap.mapped) {
-                        const hlslpp::float4x4 &prevTransform = prevDrawData.worldTransforms[workloadMap.transforms[t].prevTransformIndex];
-                        const hlslpp::float4x4 &curTransform = drawData.worldTransforms[t];
-                        prevMatrix = transformMap.rigidBody.lerp(p.prevFrameWeight, prevTransform, curTransform, true);
-                        curMatrix = transformMap.rigidBody.lerp(p.curFrameWeight, prevTransform, curTransform, true);
-                        invMatrix = hlslpp::inverse(curMatrix);
-                        invTMatrix = hlslpp::transpose(invMatrix);
-                        lerpWorldTransforms.emplace_back(curMatrix);
-                        invTWorldTransforms.emplace_back(invTMatrix);
-                        prevWorldTransforms.emplace_back(prevMatrix);
-                    }
-                    else {
-                        invMatrix = hlslpp::inverse(drawData.worldTransforms[t]);
-                        invTMatrix = hlslpp::transpose(invMatrix);
-                        lerpWorldTransforms.emplace_back(drawData.worldTransforms[t]);
-                        invTWorldTransforms.emplace_back(invTMatrix);
-                        prevWorldTransforms.emplace_back(drawData.worldTransforms[t]);
-                    }
-                }
+                drawData.lerpWorldTransforms.resize(transformCount);
+                drawData.prevWorldTransforms.resize(transformCount);
             }
-            // Copy as normal and just generate the inverse of the transforms.
             else {
-                for (size_t t = 0; t < drawData.worldTransforms.size(); t++) {
-                    invMatrix = hlslpp::inverse(drawData.worldTransforms[t]);
+                drawData.lerpWorldTransforms.clear();
+                drawData.prevWorldTransforms.clear();
+            }
+
+            for (uint32_t t = 0; t < transformCount; t += TransformsPerBatch) {
+                batches.emplace_back(Batch{ w, t, std::min(t + TransformsPerBatch, transformCount), prevFrameValid, reuseStatic });
+            }
+        }
+
+        if (batches.empty()) {
+            return;
+        }
+
+        // The render thread processes the first batch itself while the workers process the rest.
+        for (size_t b = 1; b < batches.size(); b++) {
+            const Batch *batch = &batches[b];
+            jobSystem->submit(JobSystem::Priority::High, [&p, batch]() {
+                processBatch(p, *batch);
+            }, &batchCounter);
+        }
+
+        processBatch(p, batches[0]);
+        batchCounter.wait();
+    }
+
+    void TransformProcessor::processBatch(const ProcessParams &p, const Batch &batch) {
+        DrawData &drawData = p.workloadQueue->workloads[batch.workloadIndex].drawData;
+        const auto &worldTransforms = drawData.worldTransforms;
+        auto &lerpWorldTransforms = drawData.lerpWorldTransforms;
+        auto &invTWorldTransforms = drawData.invTWorldTransforms;
+        auto &prevWorldTransforms = drawData.prevWorldTransforms;
+        hlslpp::float4x4 prevMatrix, curMatrix, invMatrix, invTMatrix;
+
+        // Match with the previous frame and interpolate the transforms.
+        if (batch.interpolate) {
+            const GameFrameMap::WorkloadMap &workloadMap = p.curFrame->frameMap.workloads[batch.workloadIndex];
+            const DrawData &prevDrawData = p.workloadQueue->workloads[workloadMap.prevWorkloadIndex].drawData;
+            for (uint32_t t = batch.begin; t < batch.end; t++) {
+                const GameFrameMap::TransformMap &transformMap = workloadMap.transforms[t];
+
+                // Only the transforms that change with the weights need to be computed again.
+                if (batch.reuseStatic && !transformMap.varying) {
+                    continue;
+                }
+
+                if (transformMap.mapped) {
+                    const hlslpp::float4x4 &prevTransform = prevDrawData.worldTransforms[transformMap.prevTransformIndex];
+                    const hlslpp::float4x4 &curTransform = worldTransforms[t];
+                    prevMatrix = transformMap.rigidBody.lerp(p.prevFrameWeight, prevTransform, curTransform, true);
+                    curMatrix = transformMap.rigidBody.lerp(p.curFrameWeight, prevTransform, curTransform, true);
+                    invMatrix = hlslpp::inverse(curMatrix);
                     invTMatrix = hlslpp::transpose(invMatrix);
-                    invTWorldTransforms.push_back(invTMatrix);
+                    lerpWorldTransforms[t] = curMatrix;
+                    invTWorldTransforms[t] = invTMatrix;
+                    prevWorldTransforms[t] = prevMatrix;
                 }
+                else {
+                    invMatrix = hlslpp::inverse(worldTransforms[t]);
+                    invTMatrix = hlslpp::transpose(invMatrix);
+                    lerpWorldTransforms[t] = worldTransforms[t];
+                    invTWorldTransforms[t] = invTMatrix;
+                    prevWorldTransforms[t] = worldTransforms[t];
+                }
+            }
+        }
+        // Copy as normal and just generate the inverse of the transforms.
+        else {
+            for (uint32_t t = batch.begin; t < batch.end; t++) {
+                invMatrix = hlslpp::inverse(worldTransforms[t]);
+                invTMatrix = hlslpp::transpose(invMatrix);
+                invTWorldTransforms[t] = invTMatrix;
             }
         }
     }
@@ -75,6 +123,13 @@ namespace RT64 {
 
         for (uint32_t w : p.curFrame->workloads) {
             const bool prevFrameValid = (p.prevFrame != nullptr);
+            const GameFrameMap::WorkloadMap &workloadMap = p.curFrame->frameMap.workloads[w];
+
+            // The buffers still hold the transforms uploaded by the previous call if none of them changed.
+            if (p.reuseStatic && (!workloadMap.mapped || (workloadMap.varyingTransformCount == 0))) {
+                continue;
+            }
+
             Workload &workload = p.workloadQueue->workloads[w];
             const DrawData &drawData = workload.drawData;
             DrawBuffers &drawBuffers = workload.drawBuffers;
@@ -11,6 +11,20 @@ namespace RT64 {
     struct WorkloadQueue;
 
     struct TransformProcessor {
+        // Amount of transforms processed by each job. Interpolating a transform is expensive enough for this to outweigh the cost of the job.
+        static const uint32_t TransformsPerBatch = 64;
+
+        struct Batch {
+            uint32_t workloadIndex;
+            uint32_t begin;
+            uint32_t end;
+            bool interpolate;
+            bool reuseStatic;
+        };
+
+        JobSystem *jobSystem = nullptr;
+        JobCounter batchCounter;
+        std::vector<Batch> batches;
         std::unique_ptr<BufferUploader> bufferUploader;
         std::vector<BufferUploader::Upload> uploads;
 
@@ -21,12 +35,16 @@ namespace RT64 {
             const GameFrame *prevFrame = nullptr;
             float curFrameWeight = 1.0f;
             float prevFrameWeight = 0.0f;
+
+            // Results that don't depend on the frame weights were already computed by a previous call for the same frame and can be kept.
+            bool reuseStatic = false;
         };
 
         TransformProcessor();
         ~TransformProcessor();
-        void setup(RenderWorker *worker);
+        void setup(RenderWorker *worker, JobSystem *jobSystem);
         void process(const ProcessParams &p);
+        static void processBatch(const ProcessParams &p, const Batch &batch);
         void upload(const ProcessParams &p);
     };
 };
\ No newline at end of file
@@ -2,27 +2,50 @@
 // RT64
 //
 
-#include "TextureDecoder.hlsli"
+#include "shared/rt64_texture_decode.h"
 
+// Must match the values in TextureDecodeBatch.
 #define GROUP_SIZE 8
+#define DISPATCH_GROUPS_PER_ROW 1024
+#define TEXTURE_DECODE_UPPER_RANGE 256
+
+// Every texture in the batch reads its snapshot of TMEM from the same atlas at its own offset.
+static uint gTMEMOffset;
+#define TMEM_RESOURCE Buffer<uint>
+#define TMEM_LOAD(TMEM, address) TMEM.Load(gTMEMOffset + (address))
 
-struct TextureDecodeCB {
-    uint2 Resolution;
-    uint fmt;
-    uint siz;
-    uint address;
-    uint stride;
-    uint tlut;
-    uint palette;
-};
+#include "TextureDecoder.hlsli"
 
 [[vk::push_constant]] ConstantBuffer<TextureDecodeCB> gConstants : register(b0);
-Texture1D<uint> TMEM : register(t1);
-RWTexture2D<float4> RGBA32 : register(u2);
+StructuredBuffer<TextureDecodeDescriptor> gDescriptors : register(t1);
+Buffer<uint> gTMEMAtlas : register(t2);
+RWTexture2D<float4> gOutputs[TEXTURE_DECODE_UPPER_RANGE] : register(u3);
 
 [numthreads(GROUP_SIZE, GROUP_SIZE, 1)]
-void CSMain(uint2 coord : SV_DispatchThreadID) {
-    if ((coord.x < gConstants.Resolution.x) && (coord.y < gConstants.Resolution.y)) {
-        RGBA32[coord] = sampleTMEM(coord, gConstants.siz, gConstants.fmt, gConstants.address, gConstants.stride, gConstants.tlut, gConstants.palette, TMEM);
+void CSMain(uint2 groupId : SV_GroupID, uint2 groupThreadId : SV_GroupThreadID) {
+    const uint groupIndex = groupId.y * DISPATCH_GROUPS_PER_ROW + groupId.x;
+    if (groupIndex >= gConstants.groupCount) {
+        return;
+    }
+
+    // Find the texture the group belongs to. Groups are laid out in the same order as the descriptors.
+    uint lo = 0;
+    uint hi = gConstants.textureCount - 1;
+    while (lo < hi) {
+        const uint mid = (lo + hi + 1) / 2;
+        if (gDescriptors[gConstants.descriptorOffset + mid].groupOffset <= groupIndex) {
+            lo = mid;
+        }
+        else {
+            hi = mid - 1;
+        }
+    }
+
+    const TextureDecodeDescriptor desc = gDescriptors[gConstants.descriptorOffset + lo];
+    const uint localGroup = groupIndex - desc.groupOffset;
+    const uint2 coord = uint2(localGroup % desc.groupsPerRow, localGroup / desc.groupsPerRow) * GROUP_SIZE + groupThreadId;
+    if ((coord.x < desc.resolution.x) && (coord.y < desc.resolution.y)) {
+        gTMEMOffset = desc.tmemOffset;
+        gOutputs[NonUniformResourceIndex(lo)][coord] = sampleTMEM(coord, desc.siz, desc.fmt, desc.address, desc.stride, desc.tlut, desc.palette, gTMEMAtlas);
     }
-}
\ No newline at end of file
+}
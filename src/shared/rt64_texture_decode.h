@@ -0,0 +1,33 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include "shared/rt64_hlsl.h"
+
+#ifdef HLSL_CPU
+namespace interop {
+#endif
+    struct TextureDecodeCB {
+        uint textureCount;
+        uint groupCount;
+        uint descriptorOffset;
+    };
+
+    struct TextureDecodeDescriptor {
+        uint2 resolution;
+        uint fmt;
+        uint siz;
+        uint address;
+        uint stride;
+        uint tlut;
+        uint palette;
+        uint tmemOffset;
+        uint groupOffset;
+        uint groupsPerRow;
+        uint padding;
+    };
+#ifdef HLSL_CPU
+};
+#endif
@@ -0,0 +1,193 @@
+//
+// RT64
+//
+
+#include "common/rt64_async_file_reader.h"
+
+#include <cstring>
+#include <fstream>
+#include <random>
+
+#include "rt64_test.h"
+
+namespace RT64 {
+    struct TemporaryDirectory {
+        std::filesystem::path path;
+
+        TemporaryDirectory(const std::string &name) {
+            path = std::filesystem::temp_directory_path() / name;
+            std::filesystem::remove_all(path);
+            std::filesystem::create_directories(path);
+        }
+
+        ~TemporaryDirectory() {
+            std::error_code ec;
+            std::filesystem::remove_all(path, ec);
+        }
+    };
+
+    static const uint32_t QueueDepth = 4;
+    static const size_t BufferSize = 64 * 1024;
+
+    static std::vector<uint8_t> writeRandomFile(const std::filesystem::path &path, size_t size, uint32_t seed) {
+        std::mt19937 random(seed);
+        std::vector<uint8_t> contents(size);
+        for (uint8_t &byte : contents) {
+            byte = uint8_t(random());
+        }
+
+        std::ofstream fileStream(path, std::ios::binary);
+        fileStream.write(reinterpret_cast<const char *>(contents.data()), contents.size());
+        return contents;
+    }
+
+    // The reader must take exactly as many reads as its queue depth, reject the rest, and take new ones again as soon as any complete.
+    static void testQueueDepth() {
+        TemporaryDirectory directory("rt64_async_file_reader_test");
+        const std::filesystem::path filePath = directory.path / "contents.bin";
+        const std::vector<uint8_t> contents = writeRandomFile(filePath, 1024 * 1024, 47);
+
+        std::unique_ptr<AsyncFileReader> reader = AsyncFileReader::create(QueueDepth, BufferSize);
+        CHECK(reader != nullptr);
+        if (reader == nullptr) {
+            return;
+        }
+
+        CHECK(reader->queueDepth == QueueDepth);
+        CHECK(reader->readsInFlight == 0);
+        CHECK(!reader->isQueueFull());
+
+        // Waiting without any reads in flight must not block.
+        std::vector<AsyncFileCompletion> completions;
+        reader->wait(completions, 1);
+        CHECK(completions.empty());
+
+        struct PendingRead {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            uint8_t *destination = nullptr;
+            int32_t bufferIndex = -1;
+        };
+
+        // Every other read goes to regular memory instead of a registered buffer.
+        std::vector<std::vector<uint8_t>> regularBuffers(QueueDepth, std::vector<uint8_t>(BufferSize));
+        std::vector<PendingRead> pendingReads(QueueDepth);
+        std::vector<uint32_t> freeSlots;
+        for (uint32_t i = 0; i < QueueDepth; i++) {
+            freeSlots.emplace_back(QueueDepth - i - 1);
+        }
+
+        std::mt19937 random(48);
+        const uint32_t ReadCount = 64;
+        uint32_t submittedCount = 0;
+        uint32_t completedCount = 0;
+        uint32_t maxReadsInFlight = 0;
+        while (completedCount < ReadCount) {
+            while ((submittedCount < ReadCount) && !freeSlots.empty()) {
+                const uint32_t slot = freeSlots.back();
+                PendingRead &pendingRead = pendingReads[slot];
+                pendingRead.size = 1 + (random() % BufferSize);
+                pendingRead.offset = random() % (contents.size() - pendingRead.size + 1);
+                pendingRead.bufferIndex = ((submittedCount % 2) == 0) ? int32_t(slot) : -1;
+                pendingRead.destination = (pendingRead.bufferIndex >= 0) ? reader->getRegisteredBuffer(slot) : regularBuffers[slot].data();
+                memset(pendingRead.destination, 0, pendingRead.size);
+
+                AsyncFileRead read;
+                read.filePath = filePath;
+                read.offset = pendingRead.offset;
+                read.size = pendingRead.size;
+                read.destination = pendingRead.destination;
+                read.bufferIndex = pendingRead.bufferIndex;
+                read.userData = slot;
+                CHECK(reader->submit(read));
+                freeSlots.pop_back();
+                submittedCount++;
+            }
+
+            maxReadsInFlight = std::max(maxReadsInFlight, reader->readsInFlight);
+            CHECK(reader->readsInFlight <= QueueDepth);
+
+            // A full queue must reject any other read until one of them completes.
+            if (reader->isQueueFull()) {
+                AsyncFileRead read;
+                read.filePath = filePath;
+                read.size = 1;
+                read.destination = regularBuffers[0].data();
+                CHECK(!reader->submit(read));
+            }
+
+            reader->flush();
+
+            completions.clear();
+            const uint32_t readsInFlight = reader->readsInFlight;
+            reader->wait(completions, 1);
+            CHECK(!completions.empty());
+            CHECK(reader->readsInFlight == (readsInFlight - completions.size()));
+            for (const AsyncFileCompletion &completion : completions) {
+                CHECK(completion.success);
+                const PendingRead &pendingRead = pendingReads[completion.userData];
+                CHECK(memcmp(pendingRead.destination, &contents[pendingRead.offset], pendingRead.size) == 0);
+                freeSlots.emplace_back(uint32_t(completion.userData));
+                completedCount++;
+            }
+        }
+
+        CHECK(maxReadsInFlight == QueueDepth);
+        CHECK(reader->readsInFlight == 0);
+        CHECK(freeSlots.size() == QueueDepth);
+    }
+
+    // Reads that can't be completed must either be rejected or complete as failures, and must not take up the queue afterwards.
+    static void testFailedReads() {
+        TemporaryDirectory directory("rt64_async_file_reader_failed_test");
+        const std::filesystem::path filePath = directory.path / "contents.bin";
+        const std::vector<uint8_t> contents = writeRandomFile(filePath, 4096, 49);
+
+        std::unique_ptr<AsyncFileReader> reader = AsyncFileReader::create(QueueDepth, BufferSize);
+        CHECK(reader != nullptr);
+        if (reader == nullptr) {
+            return;
+        }
+
+        std::vector<uint8_t> destination(BufferSize);
+        auto checkFailed = [&](const std::filesystem::path &path, uint64_t offset, uint64_t size) {
+            AsyncFileRead read;
+            read.filePath = path;
+            read.offset = offset;
+            read.size = size;
+            read.destination = destination.data();
+            read.userData = 1234;
+            if (reader->submit(read)) {
+                std::vector<AsyncFileCompletion> completions;
+                reader->wait(completions, 1);
+                CHECK(completions.size() == 1);
+                CHECK((completions.size() == 1) && (completions[0].userData == 1234) && !completions[0].success);
+            }
+
+            CHECK(reader->readsInFlight == 0);
+        };
+
+        checkFailed(directory.path / "missing.bin", 0, 16);
+        checkFailed(filePath, contents.size(), 16);
+        checkFailed(filePath, contents.size() - 8, 16);
+
+        // The reader must still work normally after the failures.
+        AsyncFileRead read;
+        read.filePath = filePath;
+        read.offset = 100;
+        read.size = 200;
+        read.destination = destination.data();
+        CHECK(reader->submit(read));
+
+        std::vector<AsyncFileCompletion> completions;
+        reader->wait(completions, 1);
+        CHECK((completions.size() == 1) && completions[0].success);
+        CHECK(memcmp(destination.data(), &contents[100], 200) == 0);
+    }
+};
+
+int main(int argc, char *argv[]) {
+    RT64::testQueueDepth();
+    RT64::testFailedReads();
+    return RT64::testResult();
+}
@@ -0,0 +1,113 @@
+//
+// RT64
+//
+
+#include "hle/rt64_dynamic_resolution.h"
+
+#include <cmath>
+
+#include "rt64_test.h"
+
+namespace RT64 {
+    // Simulates a GPU whose frame time grows with the amount of pixels rendered.
+    static double gpuTimeForMultiplier(double msAtNative, double multiplier) {
+        return msAtNative * multiplier * multiplier;
+    }
+
+    static double runFrames(DynamicResolution &dynamicResolution, double msAtNative, double targetMs, uint32_t frameCount) {
+        for (uint32_t i = 0; i < frameCount; i++) {
+            dynamicResolution.update(gpuTimeForMultiplier(msAtNative, dynamicResolution.multiplier), targetMs);
+        }
+
+        return dynamicResolution.multiplier;
+    }
+
+    static bool isStep(double multiplier) {
+        const double steps = multiplier / DynamicResolution::StepSize;
+        return std::fabs(steps - std::round(steps)) < 1e-9;
+    }
+
+    static void testStartsAtMaximum() {
+        DynamicResolution dynamicResolution;
+        dynamicResolution.setBounds(1.0, 4.0);
+        CHECK(dynamicResolution.multiplier == 4.0);
+
+        // Plenty of headroom keeps the multiplier at the maximum.
+        CHECK(runFrames(dynamicResolution, 0.1, 16.6, 300) == 4.0);
+    }
+
+    static void testDecreasesToFit() {
+        DynamicResolution dynamicResolution;
+        dynamicResolution.setBounds(1.0, 4.0);
+
+        // 2.0 ms at native resolution costs 32 ms at 4x, so the multiplier must drop to where the frame fits in 16.6 ms.
+        const double multiplier = runFrames(dynamicResolution, 2.0, 16.6, 60);
+        CHECK(multiplier < 4.0);
+        CHECK(multiplier >= 1.0);
+        CHECK(isStep(multiplier));
+        CHECK(gpuTimeForMultiplier(2.0, multiplier) <= 16.6);
+
+        // It must settle instead of oscillating once it fits.
+        const double settledMultiplier = runFrames(dynamicResolution, 2.0, 16.6, 600);
+        CHECK(settledMultiplier == multiplier);
+    }
+
+    static void testRespectsMinimum() {
+        DynamicResolution dynamicResolution;
+        dynamicResolution.setBounds(1.5, 3.0);
+
+        // Even if nothing fits, the multiplier can't go below the user's minimum.
+        CHECK(runFrames(dynamicResolution, 50.0, 16.6, 300) == 1.5);
+    }
+
+    static void testIncreasesAfterSustainedHeadroom() {
+        DynamicResolution dynamicResolution;
+        dynamicResolution.setBounds(1.0, 4.0);
+        runFrames(dynamicResolution, 4.0, 16.6, 60);
+        const double loadedMultiplier = dynamicResolution.multiplier;
+        CHECK(loadedMultiplier < 4.0);
+
+        // A short drop in the load must not raise the multiplier right away.
+        CHECK(runFrames(dynamicResolution, 0.5, 16.6, 10) == loadedMultiplier);
+
+        // A sustained one must, one step at a time, up to the maximum.
+        const double raisedMultiplier = runFrames(dynamicResolution, 0.5, 16.6, 200);
+        CHECK(raisedMultiplier > loadedMultiplier);
+        CHECK(raisedMultiplier <= (loadedMultiplier + 2.0 * DynamicResolution::StepSize));
+        CHECK(runFrames(dynamicResolution, 0.5, 16.6, 2000) == 4.0);
+    }
+
+    static void testIgnoresInvalidSamples() {
+        DynamicResolution dynamicResolution;
+        dynamicResolution.setBounds(1.0, 2.0);
+        CHECK(runFrames(dynamicResolution, 0.0, 16.6, 100) == 2.0);
+        for (uint32_t i = 0; i < 100; i++) {
+            dynamicResolution.update(100.0, 0.0);
+        }
+
+        CHECK(dynamicResolution.multiplier == 2.0);
+    }
+
+    static void testBoundsAreQuantized() {
+        DynamicResolution dynamicResolution;
+        dynamicResolution.setBounds(1.1, 2.9);
+        CHECK(isStep(dynamicResolution.minMultiplier));
+        CHECK(isStep(dynamicResolution.maxMultiplier));
+        CHECK(dynamicResolution.minMultiplier <= dynamicResolution.maxMultiplier);
+
+        // Inverted bounds collapse into a single multiplier.
+        dynamicResolution.setBounds(3.0, 2.0);
+        CHECK(dynamicResolution.minMultiplier == dynamicResolution.maxMultiplier);
+        CHECK(dynamicResolution.multiplier == dynamicResolution.maxMultiplier);
+    }
+};
+
+int main(int argc, char *argv[]) {
+    RT64::testStartsAtMaximum();
+    RT64::testDecreasesToFit();
+    RT64::testRespectsMinimum();
+    RT64::testIncreasesAfterSustainedHeadroom();
+    RT64::testIgnoresInvalidSamples();
+    RT64::testBoundsAreQuantized();
+    return RT64::testResult();
+}
@@ -0,0 +1,277 @@
+//
+// RT64
+//
+
+#include "common/rt64_filesystem_pack.h"
+#include "common/rt64_filesystem_pack_writer.h"
+
+#include <map>
+#include <memory>
+#include <random>
+
+#include "rt64_test.h"
+
+namespace RT64 {
+    struct PackFile {
+        std::vector<uint8_t> contents;
+        std::vector<size_t> segmentOffsets;
+    };
+
+    // Removes the directory the pack was written to once the test is done with it.
+    struct TemporaryDirectory {
+        std::filesystem::path path;
+
+        TemporaryDirectory(const std::string &name) {
+            path = std::filesystem::temp_directory_path() / name;
+            std::filesystem::remove_all(path);
+            std::filesystem::create_directories(path);
+        }
+
+        ~TemporaryDirectory() {
+            std::error_code ec;
+            std::filesystem::remove_all(path, ec);
+        }
+    };
+
+    // Repeats a short pattern with some noise so the contents compress, but not to nothing.
+    static std::vector<uint8_t> compressibleContents(std::mt19937 &random, size_t size) {
+        std::vector<uint8_t> contents(size);
+        for (size_t i = 0; i < size; i++) {
+            contents[i] = ((random() % 16) == 0) ? uint8_t(random()) : uint8_t(i % 61);
+        }
+
+        return contents;
+    }
+
+    static std::vector<uint8_t> randomContents(std::mt19937 &random, size_t size) {
+        std::vector<uint8_t> contents(size);
+        for (uint8_t &byte : contents) {
+            byte = uint8_t(random());
+        }
+
+        return contents;
+    }
+
+    static bool writePack(const std::filesystem::path &packPath, const std::map<std::string, PackFile> &files, const std::vector<uint8_t> &dictionary, bool useCompression) {
+        std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> compressionContext(ZSTD_createCCtx(), &ZSTD_freeCCtx);
+        std::unique_ptr<ZSTD_CDict, decltype(&ZSTD_freeCDict)> compressionDictionary(nullptr, &ZSTD_freeCDict);
+        if (!dictionary.empty()) {
+            compressionDictionary.reset(ZSTD_createCDict(dictionary.data(), dictionary.size(), 3));
+        }
+
+        FileSystemPackWriter packWriter;
+        if (!packWriter.open(packPath, dictionary)) {
+            return false;
+        }
+
+        for (const auto &it : files) {
+            // Files without segments are compressed as a single chunk.
+            std::vector<size_t> segmentOffsets = it.second.segmentOffsets;
+            if (segmentOffsets.empty()) {
+                segmentOffsets.emplace_back(0);
+            }
+
+            segmentOffsets.emplace_back(it.second.contents.size());
+
+            FileSystemPackPayload payload;
+            payload.compress(it.second.contents, segmentOffsets, compressionContext.get(), compressionDictionary.get(), useCompression);
+            if (!packWriter.add(it.first, payload)) {
+                return false;
+            }
+        }
+
+        return packWriter.finalize();
+    }
+
+    static void checkContents(const FileSystem &fileSystem, const std::string &path, const std::vector<uint8_t> &contents) {
+        CHECK(fileSystem.exists(path));
+        CHECK(fileSystem.getSize(path) == contents.size());
+
+        std::vector<uint8_t> loaded(contents.size());
+        CHECK(fileSystem.load(path, loaded.data(), loaded.size()));
+        CHECK(loaded == contents);
+
+        // Reading in small steps must give the same contents as reading the file at once.
+        std::unique_ptr<FileSystemReader> reader = fileSystem.openReader(path);
+        CHECK(reader != nullptr);
+        if (reader != nullptr) {
+            std::vector<uint8_t> streamed;
+            uint8_t readBytes[1000];
+            size_t readCount = 0;
+            while ((readCount = reader->read(readBytes, sizeof(readBytes))) > 0) {
+                streamed.insert(streamed.end(), readBytes, readBytes + readCount);
+            }
+
+            CHECK(streamed == contents);
+        }
+    }
+
+    static std::map<std::string, PackFile> createFiles(std::mt19937 &random) {
+        std::map<std::string, PackFile> files;
+        files["small.bin"].contents = compressibleContents(random, 100);
+        files["textures/stored.dds"].contents = randomContents(random, 70000);
+        files["textures/compressed.dds"].contents = compressibleContents(random, 200000);
+
+        // Chunks like the ones a DDS with mipmaps is split into: a header followed by mipmaps that get smaller.
+        PackFile &chunkedFile = files["textures/chunked.dds"];
+        chunkedFile.contents = compressibleContents(random, 148 + 65536 + 16384 + 4096 + 1024);
+        chunkedFile.segmentOffsets = { 0, 148, 148 + 65536, 148 + 65536 + 16384, 148 + 65536 + 16384 + 4096 };
+        return files;
+    }
+
+    static void testRoundTrip(const std::vector<uint8_t> &dictionary, bool useCompression) {
+        TemporaryDirectory directory("rt64_filesystem_pack_test");
+        std::mt19937 random(43);
+        const std::map<std::string, PackFile> files = createFiles(random);
+        const std::filesystem::path packPath = directory.path / "test.rtz";
+        CHECK(writePack(packPath, files, dictionary, useCompression));
+        CHECK(FileSystemPack::isPackFile(packPath));
+
+        std::unique_ptr<FileSystem> fileSystem = FileSystemPack::create(packPath, "");
+        CHECK(fileSystem != nullptr);
+        if (fileSystem == nullptr) {
+            return;
+        }
+
+        for (const auto &it : files) {
+            checkContents(*fileSystem, it.first, it.second.contents);
+        }
+
+        CHECK(!fileSystem->exists("missing.bin"));
+        CHECK(!fileSystem->exists("textures"));
+        CHECK(fileSystem->getSize("missing.bin") == 0);
+
+        // Iterating the pack must list every file exactly once.
+        std::map<std::string, uint32_t> listed;
+        for (const std::string &path : *fileSystem) {
+            listed[path]++;
+        }
+
+        CHECK(listed.size() == files.size());
+        for (const auto &it : files) {
+            CHECK(listed[it.first] == 1);
+        }
+
+        // Random data never gets smaller, so it must be stored as is and be readable straight out of the pack file.
+        const FileSystemPack *packFileSystem = static_cast<const FileSystemPack *>(fileSystem.get());
+        const FileSystemPackEntry *storedEntry = packFileSystem->findEntry("textures/stored.dds");
+        CHECK((storedEntry != nullptr) && (storedEntry->compression == FileSystemPackCompression::None));
+
+        std::filesystem::path storedPath;
+        uint64_t storedOffset = 0;
+        CHECK(fileSystem->getStoredLocation("textures/stored.dds", storedPath, storedOffset));
+        CHECK((storedOffset % FileSystemPackPayloadAlignment) == 0);
+
+        const std::vector<uint8_t> &storedContents = files.at("textures/stored.dds").contents;
+        std::vector<uint8_t> storedBytes(storedContents.size());
+        std::ifstream storedStream(storedPath, std::ios::binary);
+        storedStream.seekg(storedOffset);
+        storedStream.read(reinterpret_cast<char *>(storedBytes.data()), storedBytes.size());
+        CHECK(storedBytes == storedContents);
+
+        const FileSystemPackEntry *chunkedEntry = packFileSystem->findEntry("textures/chunked.dds");
+        CHECK(chunkedEntry != nullptr);
+        if ((chunkedEntry != nullptr) && useCompression) {
+            const FileSystemPackCompression expectedCompression = dictionary.empty() ? FileSystemPackCompression::Zstd : FileSystemPackCompression::ZstdDictionary;
+            CHECK(chunkedEntry->compression == expectedCompression);
+            CHECK(chunkedEntry->chunkCount == 5);
+            CHECK(chunkedEntry->compressedSize < chunkedEntry->uncompressedSize);
+        }
+        else if (chunkedEntry != nullptr) {
+            CHECK(chunkedEntry->compression == FileSystemPackCompression::None);
+            CHECK(chunkedEntry->chunkCount == 0);
+        }
+    }
+
+    static void testSkipAcrossChunks() {
+        TemporaryDirectory directory("rt64_filesystem_pack_skip_test");
+        std::mt19937 random(44);
+        const std::map<std::string, PackFile> files = createFiles(random);
+        const std::filesystem::path packPath = directory.path / "test.rtz";
+        CHECK(writePack(packPath, files, {}, true));
+
+        std::unique_ptr<FileSystem> fileSystem = FileSystemPack::create(packPath, "");
+        CHECK(fileSystem != nullptr);
+        if (fileSystem == nullptr) {
+            return;
+        }
+
+        // Skipping to the start of every mipmap, or to the middle of one, must land on the same bytes as the original file.
+        const PackFile &chunkedFile = files.at("textures/chunked.dds");
+        const size_t skipOffsets[] = { 0, 148, 1000, 148 + 65536, 148 + 65536 + 16384 + 17, 148 + 65536 + 16384 + 4096 };
+        for (size_t skipOffset : skipOffsets) {
+            std::unique_ptr<FileSystemReader> reader = fileSystem->openReader("textures/chunked.dds");
+            CHECK(reader != nullptr);
+            if (reader == nullptr) {
+                continue;
+            }
+
+            CHECK(reader->skip(skipOffset) == skipOffset);
+
+            const size_t remainingSize = chunkedFile.contents.size() - skipOffset;
+            std::vector<uint8_t> remaining(remainingSize);
+            CHECK(reader->read(remaining.data(), remaining.size()) == remainingSize);
+            CHECK(std::equal(remaining.begin(), remaining.end(), chunkedFile.contents.begin() + skipOffset));
+        }
+    }
+
+    static void testBasePath() {
+        TemporaryDirectory directory("rt64_filesystem_pack_base_test");
+        std::mt19937 random(45);
+        const std::map<std::string, PackFile> files = createFiles(random);
+        const std::filesystem::path packPath = directory.path / "test.rtz";
+        CHECK(writePack(packPath, files, {}, true));
+
+        std::unique_ptr<FileSystem> fileSystem = FileSystemPack::create(packPath, "textures");
+        CHECK(fileSystem != nullptr);
+        if (fileSystem == nullptr) {
+            return;
+        }
+
+        checkContents(*fileSystem, "compressed.dds", files.at("textures/compressed.dds").contents);
+        CHECK(!fileSystem->exists("small.bin"));
+
+        uint32_t listedCount = 0;
+        for (const std::string &path : *fileSystem) {
+            CHECK(fileSystem->exists(path));
+            listedCount++;
+        }
+
+        CHECK(listedCount == 3);
+    }
+
+    static void testRejectsInvalidPacks() {
+        TemporaryDirectory directory("rt64_filesystem_pack_invalid_test");
+        std::mt19937 random(46);
+        const std::filesystem::path packPath = directory.path / "test.rtz";
+        CHECK(writePack(packPath, createFiles(random), {}, true));
+
+        // A pack cut short must be rejected when opened instead of reading past the end of the mapping later.
+        const uintmax_t packSize = std::filesystem::file_size(packPath);
+        std::filesystem::resize_file(packPath, packSize - 16);
+        CHECK(FileSystemPack::create(packPath, "") == nullptr);
+
+        std::filesystem::resize_file(packPath, sizeof(FileSystemPackHeader) - 1);
+        CHECK(FileSystemPack::create(packPath, "") == nullptr);
+
+        const std::filesystem::path otherPath = directory.path / "other.bin";
+        std::ofstream otherStream(otherPath, std::ios::binary);
+        const std::vector<uint8_t> otherContents = randomContents(random, 4096);
+        otherStream.write(reinterpret_cast<const char *>(otherContents.data()), otherContents.size());
+        otherStream.close();
+        CHECK(!FileSystemPack::isPackFile(otherPath));
+        CHECK(FileSystemPack::create(otherPath, "") == nullptr);
+    }
+};
+
+int main(int argc, char *argv[]) {
+    std::mt19937 random(47);
+    const std::vector<uint8_t> dictionary = RT64::compressibleContents(random, 4096);
+    RT64::testRoundTrip({}, false);
+    RT64::testRoundTrip({}, true);
+    RT64::testRoundTrip(dictionary, true);
+    RT64::testSkipAcrossChunks();
+    RT64::testBasePath();
+    RT64::testRejectsInvalidPacks();
+    return RT64::testResult();
+}
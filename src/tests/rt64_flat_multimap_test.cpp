@@ -0,0 +1,274 @@
+//
+// RT64
+//
+
+#include "common/rt64_flat_multimap.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "rt64_test.h"
+
+namespace RT64 {
+    // Checks the flat multimap against the standard one. The values of every key must be the same and be visited in insertion order.
+    template<typename Key>
+    static void checkEquivalent(const FlatMultiMap<Key, uint32_t> &flatMap, const std::unordered_multimap<Key, uint32_t> &referenceMap, const std::vector<Key> &missingKeys) {
+        CHECK(flatMap.size() == referenceMap.size());
+        CHECK(flatMap.empty() == referenceMap.empty());
+
+        std::unordered_set<Key> referenceKeys;
+        for (const auto &it : referenceMap) {
+            referenceKeys.insert(it.first);
+        }
+
+        CHECK(flatMap.keyCount == referenceKeys.size());
+
+        for (Key key : referenceKeys) {
+            std::vector<uint32_t> referenceValues;
+            auto range = referenceMap.equal_range(key);
+            for (auto it = range.first; it != range.second; it++) {
+                referenceValues.emplace_back(it->second);
+            }
+
+            // Values are inserted in increasing order, so sorting the reference's values gives the insertion order.
+            std::sort(referenceValues.begin(), referenceValues.end());
+
+            std::vector<uint32_t> flatValues;
+            for (uint32_t e = flatMap.first(key); e != flatMap.End; e = flatMap.entries[e].next) {
+                CHECK(flatMap.entries[e].key == key);
+                flatValues.emplace_back(flatMap.entries[e].value);
+            }
+
+            CHECK(flatValues == referenceValues);
+        }
+
+        for (Key key : missingKeys) {
+            if (referenceKeys.find(key) == referenceKeys.end()) {
+                CHECK(flatMap.first(key) == flatMap.End);
+            }
+        }
+
+        // Iterating the slots must visit every key exactly once.
+        std::unordered_set<Key> slotKeys;
+        for (const auto &slot : flatMap.slots) {
+            if (slot.first != flatMap.End) {
+                CHECK(slotKeys.insert(slot.key).second);
+            }
+        }
+
+        CHECK(slotKeys == referenceKeys);
+    }
+
+    template<typename Key>
+    static void runDifferential(uint32_t seed, const std::vector<Key> &keyPool, uint32_t operationCount) {
+        std::mt19937 random(seed);
+        FlatMultiMap<Key, uint32_t> flatMap;
+        std::unordered_multimap<Key, uint32_t> referenceMap;
+        uint32_t nextValue = 0;
+        for (uint32_t i = 0; i < operationCount; i++) {
+            const uint32_t operation = random() % 1000;
+            if (operation == 0) {
+                flatMap.clear();
+                referenceMap.clear();
+            }
+            else {
+                const Key key = keyPool[random() % keyPool.size()];
+                flatMap.emplace(key, nextValue);
+                referenceMap.emplace(key, nextValue);
+                nextValue++;
+            }
+
+            if ((i % 257) == 0) {
+                checkEquivalent(flatMap, referenceMap, keyPool);
+            }
+        }
+
+        checkEquivalent(flatMap, referenceMap, keyPool);
+    }
+
+    static void testSmallIndices() {
+        // Transform indices and matrix IDs: few keys, many repetitions.
+        std::vector<uint32_t> keyPool;
+        for (uint32_t i = 0; i < 40; i++) {
+            keyPool.emplace_back(i);
+        }
+
+        runDifferential<uint32_t>(1, keyPool, 20000);
+    }
+
+    static void testAlignedAddresses() {
+        // Addresses share their lower bits, which must not make them collide.
+        std::vector<uint32_t> keyPool;
+        for (uint32_t i = 0; i < 3000; i++) {
+            keyPool.emplace_back(0x80000000U + i * 0x1000U);
+        }
+
+        runDifferential<uint32_t>(2, keyPool, 20000);
+    }
+
+    static void testWideHashes() {
+        // Call hashes use all 64 bits. Include keys that only differ in their upper half.
+        std::mt19937_64 random(3);
+        std::vector<uint64_t> keyPool;
+        for (uint32_t i = 0; i < 2000; i++) {
+            keyPool.emplace_back(random());
+        }
+
+        for (uint64_t i = 0; i < 64; i++) {
+            keyPool.emplace_back(i << 32);
+        }
+
+        runDifferential<uint64_t>(4, keyPool, 40000);
+    }
+
+    typedef std::vector<std::pair<uint32_t, uint32_t>> MatchVector;
+
+    // Mirrors the linear transform ID matching done by GameFrame::matchWorkload before and after the flat multimap was introduced.
+    // The n-th transform submitted with an ID is paired with the n-th transform of the previous workload that used the same ID.
+    static MatchVector matchTransformIdsReference(const std::multimap<uint32_t, uint32_t> &curIdMap, const std::multimap<uint32_t, uint32_t> &prevIdMap) {
+        MatchVector matches;
+        auto curIt = curIdMap.begin();
+        auto prevIt = prevIdMap.begin();
+        while ((curIt != curIdMap.end()) && (prevIt != prevIdMap.end())) {
+            if (curIt->first < prevIt->first) {
+                curIt++;
+            }
+            else if (curIt->first > prevIt->first) {
+                prevIt++;
+            }
+            else {
+                matches.emplace_back(curIt->second, prevIt->second);
+                curIt++;
+                prevIt++;
+            }
+        }
+
+        return matches;
+    }
+
+    static MatchVector matchTransformIdsFlat(const FlatMultiMap<uint32_t, uint32_t> &curIdMap, const FlatMultiMap<uint32_t, uint32_t> &prevIdMap) {
+        MatchVector matches;
+        for (const auto &curSlot : curIdMap.slots) {
+            if (curSlot.first == curIdMap.End) {
+                continue;
+            }
+
+            uint32_t curEntry = curSlot.first;
+            uint32_t prevEntry = prevIdMap.first(curSlot.key);
+            while ((curEntry != curIdMap.End) && (prevEntry != prevIdMap.End)) {
+                matches.emplace_back(curIdMap.entries[curEntry].value, prevIdMap.entries[prevEntry].value);
+                curEntry = curIdMap.entries[curEntry].next;
+                prevEntry = prevIdMap.entries[prevEntry].next;
+            }
+        }
+
+        return matches;
+    }
+
+    // Mirrors the call hash matching done by GameFrame::matchScene. Every call is paired with all the previous calls that have the same hash.
+    static MatchVector matchCallHashesReference(const std::multimap<uint64_t, uint32_t> &curCallHashMap, const std::multimap<uint64_t, uint32_t> &prevCallHashMap) {
+        MatchVector matches;
+        for (const std::pair<uint64_t, uint32_t> curIt : curCallHashMap) {
+            auto prevRange = prevCallHashMap.equal_range(curIt.first);
+            for (auto prevIt = prevRange.first; prevIt != prevRange.second; prevIt++) {
+                matches.emplace_back(curIt.second, prevIt->second);
+            }
+        }
+
+        return matches;
+    }
+
+    static MatchVector matchCallHashesFlat(const FlatMultiMap<uint64_t, uint32_t> &curCallHashMap, const FlatMultiMap<uint64_t, uint32_t> &prevCallHashMap) {
+        MatchVector matches;
+        for (const auto &curEntry : curCallHashMap.entries) {
+            for (uint32_t prevEntry = prevCallHashMap.first(curEntry.key); prevEntry != prevCallHashMap.End; prevEntry = prevCallHashMap.entries[prevEntry].next) {
+                matches.emplace_back(curEntry.value, prevCallHashMap.entries[prevEntry].value);
+            }
+        }
+
+        return matches;
+    }
+
+    // Builds a randomized frame where values are the submission indices and keys are picked from the pool.
+    template<typename Key>
+    static void buildFrame(std::mt19937 &random, const std::vector<Key> &keyPool, uint32_t keyCount, uint32_t entryCount, FlatMultiMap<Key, uint32_t> &flatMap, std::multimap<Key, uint32_t> &referenceMap) {
+        flatMap.clear();
+        referenceMap.clear();
+        for (uint32_t i = 0; i < entryCount; i++) {
+            const Key key = keyPool[random() % keyCount];
+            flatMap.emplace(key, i);
+            referenceMap.emplace(key, i);
+        }
+    }
+
+    static void testMatchingPairs() {
+        // Each frame only uses part of the pool so some keys are missing from one of the two frames.
+        std::mt19937 random(5);
+        std::mt19937_64 random64(6);
+        std::vector<uint32_t> idPool;
+        std::vector<uint64_t> hashPool;
+        for (uint32_t i = 0; i < 500; i++) {
+            idPool.emplace_back(random() % 2000);
+            hashPool.emplace_back(random64());
+        }
+
+        FlatMultiMap<uint32_t, uint32_t> curIdMap, prevIdMap;
+        std::multimap<uint32_t, uint32_t> curIdReference, prevIdReference;
+        FlatMultiMap<uint64_t, uint32_t> curCallHashMap, prevCallHashMap;
+        std::multimap<uint64_t, uint32_t> curCallReference, prevCallReference;
+        for (uint32_t frame = 0; frame < 200; frame++) {
+            const uint32_t keyCount = 1 + (random() % idPool.size());
+            buildFrame(random, idPool, keyCount, random() % 1500, curIdMap, curIdReference);
+            buildFrame(random, idPool, keyCount, random() % 1500, prevIdMap, prevIdReference);
+            buildFrame(random, hashPool, keyCount, random() % 1000, curCallHashMap, curCallReference);
+            buildFrame(random, hashPool, keyCount, random() % 1000, prevCallHashMap, prevCallReference);
+
+            // Each pair is processed independently by the matcher, so only the set of pairs must be the same and not the order they're visited in.
+            MatchVector idReferenceMatches = matchTransformIdsReference(curIdReference, prevIdReference);
+            MatchVector idFlatMatches = matchTransformIdsFlat(curIdMap, prevIdMap);
+            std::sort(idReferenceMatches.begin(), idReferenceMatches.end());
+            std::sort(idFlatMatches.begin(), idFlatMatches.end());
+            CHECK(idFlatMatches == idReferenceMatches);
+
+            MatchVector callReferenceMatches = matchCallHashesReference(curCallReference, prevCallReference);
+            MatchVector callFlatMatches = matchCallHashesFlat(curCallHashMap, prevCallHashMap);
+            std::sort(callReferenceMatches.begin(), callReferenceMatches.end());
+            std::sort(callFlatMatches.begin(), callFlatMatches.end());
+            CHECK(callFlatMatches == callReferenceMatches);
+        }
+    }
+
+    static void testClearKeepsAllocations() {
+        FlatMultiMap<uint32_t, uint32_t> flatMap;
+        for (uint32_t i = 0; i < 1000; i++) {
+            flatMap.emplace(i, i);
+        }
+
+        const size_t slotCount = flatMap.slots.size();
+        const size_t entryCapacity = flatMap.entries.capacity();
+        flatMap.clear();
+        CHECK(flatMap.empty());
+        CHECK(flatMap.first(0) == flatMap.End);
+        CHECK(flatMap.slots.size() == slotCount);
+        CHECK(flatMap.entries.capacity() == entryCapacity);
+
+        for (uint32_t i = 0; i < 1000; i++) {
+            flatMap.emplace(i, i);
+        }
+
+        CHECK(flatMap.slots.size() == slotCount);
+        CHECK(flatMap.entries.capacity() == entryCapacity);
+    }
+};
+
+int main(int argc, char *argv[]) {
+    RT64::testSmallIndices();
+    RT64::testAlignedAddresses();
+    RT64::testWideHashes();
+    RT64::testMatchingPairs();
+    RT64::testClearKeepsAllocations();
+    return RT64::testResult();
+}
@@ -0,0 +1,137 @@
+//
+// RT64
+//
+
+#include "common/rt64_frame_limiter.h"
+
+#include <algorithm>
+
+#include "rt64_test.h"
+
+namespace RT64 {
+    // Simulates an OS timer that can only wake threads up on the boundaries of its ticks, plus a fixed latency.
+    struct MockClock : FrameLimiter::Clock {
+        Timestamp currentTimestamp = Timestamp() + std::chrono::seconds(1);
+        int64_t tickNanoseconds = 0;
+        int64_t latencyNanoseconds = 0;
+        int64_t spinNanoseconds = 1'000;
+        uint64_t spinCount = 0;
+
+        MockClock(int64_t tickNanoseconds, int64_t latencyNanoseconds) {
+            this->tickNanoseconds = tickNanoseconds;
+            this->latencyNanoseconds = latencyNanoseconds;
+        }
+
+        Timestamp now() override {
+            return currentTimestamp;
+        }
+
+        void sleepMilliseconds(uint32_t milliseconds) override {
+            int64_t wakeNanoseconds = currentTimestamp.time_since_epoch().count() + int64_t(milliseconds) * 1'000'000;
+            if (tickNanoseconds > 0) {
+                wakeNanoseconds = ((wakeNanoseconds + tickNanoseconds - 1) / tickNanoseconds) * tickNanoseconds;
+            }
+
+            currentTimestamp = Timestamp(std::chrono::nanoseconds(wakeNanoseconds + latencyNanoseconds));
+        }
+
+        void spin() override {
+            currentTimestamp += std::chrono::nanoseconds(spinNanoseconds);
+            spinCount++;
+        }
+
+        void advance(int64_t nanoseconds) {
+            currentTimestamp += std::chrono::nanoseconds(nanoseconds);
+        }
+    };
+
+    struct PacingResult {
+        int64_t maxErrorNanoseconds = 0;
+        uint64_t spinCount = 0;
+    };
+
+    // Runs the limiter for the given amount of frames and measures how late it woke up compared to the deadlines after the warm up.
+    static PacingResult runFrames(FrameLimiter &limiter, MockClock &clock, uint32_t warmUpFrames, uint32_t measuredFrames, int64_t workNanoseconds) {
+        PacingResult result;
+        for (uint32_t i = 0; i < (warmUpFrames + measuredFrames); i++) {
+            if (i == warmUpFrames) {
+                clock.spinCount = 0;
+            }
+
+            const Timestamp deadline = limiter.nextDeadline;
+            limiter.wait();
+            if ((i >= warmUpFrames) && (deadline != Timestamp())) {
+                const int64_t errorNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(clock.now() - deadline).count();
+                result.maxErrorNanoseconds = std::max(result.maxErrorNanoseconds, errorNanoseconds);
+            }
+
+            clock.advance(workNanoseconds);
+        }
+
+        result.spinCount = clock.spinCount;
+        return result;
+    }
+
+    static void testPreciseTimer() {
+        MockClock clock(0, 300'000);
+        FrameLimiter limiter(&clock);
+        limiter.setTargetRate(60);
+
+        PacingResult result = runFrames(limiter, clock, 60, 600, 2'000'000);
+        CHECK(limiter.missedDeadlines == 0);
+        CHECK(result.maxErrorNanoseconds <= clock.spinNanoseconds);
+
+        // The slack converges to the real latency, so only a fraction of every frame is spent spinning.
+        CHECK(limiter.slackNanoseconds < 1'000'000);
+        CHECK(result.spinCount < uint64_t(600 * 1'500'000 / clock.spinNanoseconds));
+    }
+
+    static void testCoarseTimer() {
+        // Default timer granularity on Windows.
+        MockClock clock(15'625'000, 0);
+        FrameLimiter limiter(&clock);
+        limiter.setTargetRate(30);
+
+        // The limiter must learn it can't rely on the sleeps being precise and leave a long enough part of the frame to the spin.
+        PacingResult result = runFrames(limiter, clock, 120, 600, 2'000'000);
+        CHECK(limiter.slackNanoseconds > 10'000'000);
+        CHECK(result.maxErrorNanoseconds <= clock.spinNanoseconds);
+    }
+
+    static void testMissedDeadline() {
+        MockClock clock(0, 100'000);
+        FrameLimiter limiter(&clock);
+        limiter.setTargetRate(60);
+        runFrames(limiter, clock, 10, 0, 1'000'000);
+
+        // A stall longer than a frame must restart the pacing instead of catching up with a burst of frames.
+        clock.advance(100'000'000);
+        limiter.wait();
+        CHECK(limiter.missedDeadlines == 1);
+
+        const Timestamp afterStall = clock.now();
+        limiter.wait();
+        const int64_t frameNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(clock.now() - afterStall).count();
+        CHECK(frameNanoseconds >= (limiter.intervalNanoseconds - clock.spinNanoseconds));
+        CHECK(limiter.missedDeadlines == 1);
+    }
+
+    static void testUnlimited() {
+        MockClock clock(0, 0);
+        FrameLimiter limiter(&clock);
+        limiter.setTargetRate(0);
+
+        const Timestamp startTimestamp = clock.now();
+        limiter.wait();
+        limiter.wait();
+        CHECK(clock.now() == startTimestamp);
+    }
+};
+
+int main(int argc, char *argv[]) {
+    RT64::testPreciseTimer();
+    RT64::testCoarseTimer();
+    RT64::testMissedDeadline();
+    RT64::testUnlimited();
+    return RT64::testResult();
+}
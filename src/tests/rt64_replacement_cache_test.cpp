@@ -0,0 +1,258 @@
+//
+// RT64
+//
+
+#include "common/rt64_replacement_cache.h"
+#include "common/rt64_filesystem_directory.h"
+
+#include <cstring>
+#include <fstream>
+
+#include "rt64_test.h"
+
+namespace RT64 {
+    struct TemporaryDirectory {
+        std::filesystem::path path;
+
+        TemporaryDirectory(const std::string &name) {
+            path = std::filesystem::temp_directory_path() / name;
+            std::filesystem::remove_all(path);
+            std::filesystem::create_directories(path);
+        }
+
+        ~TemporaryDirectory() {
+            std::error_code ec;
+            std::filesystem::remove_all(path, ec);
+        }
+    };
+
+    static void writeFile(const std::filesystem::path &path, const std::string &contents) {
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream fileStream(path, std::ios::binary);
+        fileStream.write(contents.data(), contents.size());
+    }
+
+    static std::unordered_map<uint64_t, ReplacementResolvedPath> createResolvedPaths() {
+        std::unordered_map<uint64_t, ReplacementResolvedPath> resolvedPathMap;
+        for (uint64_t i = 1; i <= 100; i++) {
+            ReplacementResolvedPath &resolvedPath = resolvedPathMap[i * 0x9E3779B97F4A7C15ULL];
+            resolvedPath.textureHash = i * 0x9E3779B97F4A7C15ULL;
+            resolvedPath.relativePath = "textures/" + std::to_string(i % 40) + ".dds";
+            resolvedPath.resolvedOperation = ((i % 10) == 0) ? ReplacementOperation::Preload : ReplacementOperation::Stream;
+            resolvedPath.originalOperation = ((i % 3) == 0) ? ReplacementOperation::Stall : ReplacementOperation::Auto;
+            resolvedPath.resolvedShift = ((i % 4) == 0) ? ReplacementShift::None : ReplacementShift::Half;
+            resolvedPath.originalShift = ReplacementShift::Auto;
+        }
+
+        return resolvedPathMap;
+    }
+
+    static bool sameResolvedPaths(const std::unordered_map<uint64_t, ReplacementResolvedPath> &a, const std::unordered_map<uint64_t, ReplacementResolvedPath> &b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+
+        for (const auto &it : a) {
+            auto bIt = b.find(it.first);
+            if ((bIt == b.end()) || (bIt->second.fileSystemIndex != it.second.fileSystemIndex) || (bIt->second.textureHash != it.second.textureHash) ||
+                (bIt->second.relativePath != it.second.relativePath) || (bIt->second.resolvedOperation != it.second.resolvedOperation) ||
+                (bIt->second.originalOperation != it.second.originalOperation) || (bIt->second.resolvedShift != it.second.resolvedShift) ||
+                (bIt->second.originalShift != it.second.originalShift))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // A cache that can't be used must leave the outputs as they were, as the caller resolves the database into them instead.
+    static bool loadRejected(const std::filesystem::path &cachePath, uint64_t databaseHash, uint64_t indexHash) {
+        std::unordered_map<uint64_t, ReplacementResolvedPath> resolvedPathMap;
+        std::unordered_set<std::string> pathsToPreload;
+        uint32_t hashVersion = UINT32_MAX;
+        const bool loaded = ReplacementCache::load(cachePath, databaseHash, indexHash, 0, hashVersion, resolvedPathMap, &pathsToPreload);
+        return !loaded && resolvedPathMap.empty() && pathsToPreload.empty() && (hashVersion == UINT32_MAX);
+    }
+
+    static void testRoundTrip() {
+        TemporaryDirectory directory("rt64_replacement_cache_test");
+        const std::filesystem::path cachePath = directory.path / "cache" / "pack.rch";
+        std::unordered_map<uint64_t, ReplacementResolvedPath> resolvedPathMap = createResolvedPaths();
+        for (auto &it : resolvedPathMap) {
+            it.second.fileSystemIndex = 3;
+        }
+
+        CHECK(ReplacementCache::save(cachePath, 0x1234, 0x5678, 5, resolvedPathMap));
+        CHECK(!std::filesystem::exists(cachePath.string() + ".new"));
+
+        std::unordered_map<uint64_t, ReplacementResolvedPath> loadedPathMap;
+        std::unordered_set<std::string> pathsToPreload;
+        uint32_t hashVersion = 0;
+        CHECK(ReplacementCache::load(cachePath, 0x1234, 0x5678, 3, hashVersion, loadedPathMap, &pathsToPreload));
+        CHECK(hashVersion == 5);
+        CHECK(sameResolvedPaths(loadedPathMap, resolvedPathMap));
+
+        std::unordered_set<std::string> expectedPathsToPreload;
+        for (const auto &it : resolvedPathMap) {
+            if (it.second.resolvedOperation == ReplacementOperation::Preload) {
+                expectedPathsToPreload.insert(it.second.relativePath);
+            }
+        }
+
+        CHECK(!expectedPathsToPreload.empty());
+        CHECK(pathsToPreload == expectedPathsToPreload);
+
+        // Saving again replaces the previous cache.
+        resolvedPathMap.erase(resolvedPathMap.begin());
+        CHECK(ReplacementCache::save(cachePath, 0x1234, 0x5678, 5, resolvedPathMap));
+        CHECK(ReplacementCache::load(cachePath, 0x1234, 0x5678, 3, hashVersion, loadedPathMap, nullptr));
+        CHECK(sameResolvedPaths(loadedPathMap, resolvedPathMap));
+    }
+
+    static void testStaleHashes() {
+        TemporaryDirectory directory("rt64_replacement_cache_stale_test");
+        const std::filesystem::path cachePath = directory.path / "pack.rch";
+        CHECK(ReplacementCache::save(cachePath, 0x1234, 0x5678, 5, createResolvedPaths()));
+        CHECK(loadRejected(cachePath, 0x1235, 0x5678));
+        CHECK(loadRejected(cachePath, 0x1234, 0x5679));
+        CHECK(loadRejected(directory.path / "missing.rch", 0x1234, 0x5678));
+    }
+
+    static void testDatabaseHash() {
+        const std::string database = "{ \"textures\": [ { \"path\": \"a.dds\", \"hashes\": { \"rt64\": \"0123456789abcdef\" } } ] }";
+        const std::vector<uint8_t> databaseBytes(database.begin(), database.end());
+        std::vector<uint8_t> editedBytes = databaseBytes;
+        editedBytes[editedBytes.size() / 2] ^= 1;
+        CHECK(ReplacementCache::hashDatabase(databaseBytes) == ReplacementCache::hashDatabase(databaseBytes));
+        CHECK(ReplacementCache::hashDatabase(databaseBytes) != ReplacementCache::hashDatabase(editedBytes));
+    }
+
+    // The index hash must change with anything that can change how the database resolves: the files in the pack, and the pack itself as
+    // files with identical contents are resolved to the same path.
+    static void testIndexHash() {
+        TemporaryDirectory directory("rt64_replacement_cache_index_test");
+        const std::filesystem::path contentsPath = directory.path / "contents";
+        const std::filesystem::path packPath = directory.path / "pack.rtz";
+        writeFile(contentsPath / "textures" / "a.dds", "a");
+        writeFile(contentsPath / "textures" / "b.dds", "b");
+        writeFile(packPath, "pack");
+
+        std::unique_ptr<FileSystem> fileSystem = FileSystemDirectory::create(contentsPath);
+        CHECK(fileSystem != nullptr);
+        if (fileSystem == nullptr) {
+            return;
+        }
+
+        const uint64_t indexHash = ReplacementCache::hashIndex(fileSystem.get(), packPath);
+        CHECK(ReplacementCache::hashIndex(fileSystem.get(), packPath) == indexHash);
+
+        writeFile(contentsPath / "textures" / "c.dds", "c");
+        const uint64_t addedHash = ReplacementCache::hashIndex(fileSystem.get(), packPath);
+        CHECK(addedHash != indexHash);
+
+        std::filesystem::rename(contentsPath / "textures" / "c.dds", contentsPath / "textures" / "d.dds");
+        const uint64_t renamedHash = ReplacementCache::hashIndex(fileSystem.get(), packPath);
+        CHECK(renamedHash != addedHash);
+
+        // The same paths in a pack that was written again with different contents.
+        writeFile(packPath, "pack with other contents");
+        CHECK(ReplacementCache::hashIndex(fileSystem.get(), packPath) != renamedHash);
+
+        // Paths must be separated, so moving characters between them gives a different hash.
+        TemporaryDirectory otherDirectory("rt64_replacement_cache_index_other_test");
+        writeFile(otherDirectory.path / "ab", "");
+        writeFile(otherDirectory.path / "c", "");
+        TemporaryDirectory joinedDirectory("rt64_replacement_cache_index_joined_test");
+        writeFile(joinedDirectory.path / "a", "");
+        writeFile(joinedDirectory.path / "bc", "");
+        std::unique_ptr<FileSystem> otherFileSystem = FileSystemDirectory::create(otherDirectory.path);
+        std::unique_ptr<FileSystem> joinedFileSystem = FileSystemDirectory::create(joinedDirectory.path);
+        CHECK(ReplacementCache::hashIndex(otherFileSystem.get(), packPath) != ReplacementCache::hashIndex(joinedFileSystem.get(), packPath));
+    }
+
+    static void testCorruptCaches() {
+        TemporaryDirectory directory("rt64_replacement_cache_corrupt_test");
+        const std::filesystem::path cachePath = directory.path / "pack.rch";
+        CHECK(ReplacementCache::save(cachePath, 0x1234, 0x5678, 5, createResolvedPaths()));
+
+        std::vector<uint8_t> cacheBytes(std::filesystem::file_size(cachePath));
+        {
+            std::ifstream cacheStream(cachePath, std::ios::binary);
+            cacheStream.read(reinterpret_cast<char *>(cacheBytes.data()), cacheBytes.size());
+        }
+
+        auto checkRejected = [&](const std::vector<uint8_t> &bytes) {
+            const std::filesystem::path corruptPath = directory.path / "corrupt.rch";
+            {
+                std::ofstream corruptStream(corruptPath, std::ios::binary);
+                corruptStream.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+            }
+
+            CHECK(loadRejected(corruptPath, 0x1234, 0x5678));
+        };
+
+        ReplacementCacheHeader header;
+        memcpy(&header, cacheBytes.data(), sizeof(header));
+        CHECK(header.entryCount == 100);
+
+        // Caches from another format or version.
+        std::vector<uint8_t> corruptBytes = cacheBytes;
+        reinterpret_cast<ReplacementCacheHeader *>(corruptBytes.data())->magic ^= 1;
+        checkRejected(corruptBytes);
+
+        corruptBytes = cacheBytes;
+        reinterpret_cast<ReplacementCacheHeader *>(corruptBytes.data())->version = ReplacementCacheVersion + 1;
+        checkRejected(corruptBytes);
+
+        // Caches cut short, too long, or whose header doesn't match the size of the contents.
+        checkRejected(std::vector<uint8_t>(cacheBytes.begin(), cacheBytes.begin() + sizeof(ReplacementCacheHeader) - 1));
+        checkRejected(std::vector<uint8_t>(cacheBytes.begin(), cacheBytes.end() - 1));
+
+        corruptBytes = cacheBytes;
+        corruptBytes.emplace_back(0);
+        checkRejected(corruptBytes);
+
+        corruptBytes = cacheBytes;
+        reinterpret_cast<ReplacementCacheHeader *>(corruptBytes.data())->entryCount = UINT64_MAX / sizeof(ReplacementCacheEntry);
+        checkRejected(corruptBytes);
+
+        // Entries that point outside of the paths or hold values that aren't valid.
+        ReplacementCacheEntry *lastEntry = nullptr;
+        auto corruptLastEntry = [&]() {
+            corruptBytes = cacheBytes;
+            lastEntry = reinterpret_cast<ReplacementCacheEntry *>(&corruptBytes[sizeof(ReplacementCacheHeader)]) + (header.entryCount - 1);
+        };
+
+        corruptLastEntry();
+        lastEntry->pathOffset = header.pathsSize + 1;
+        checkRejected(corruptBytes);
+
+        corruptLastEntry();
+        lastEntry->pathLength = uint32_t(header.pathsSize - lastEntry->pathOffset + 1);
+        checkRejected(corruptBytes);
+
+        corruptLastEntry();
+        lastEntry->resolvedOperation = uint8_t(ReplacementOperation::Auto) + 1;
+        checkRejected(corruptBytes);
+
+        corruptLastEntry();
+        lastEntry->originalShift = uint8_t(ReplacementShift::Auto) + 1;
+        checkRejected(corruptBytes);
+
+        // The original cache is still valid.
+        std::unordered_map<uint64_t, ReplacementResolvedPath> loadedPathMap;
+        uint32_t hashVersion = 0;
+        CHECK(ReplacementCache::load(cachePath, 0x1234, 0x5678, 0, hashVersion, loadedPathMap, nullptr));
+        CHECK(sameResolvedPaths(loadedPathMap, createResolvedPaths()));
+    }
+};
+
+int main(int argc, char *argv[]) {
+    RT64::testRoundTrip();
+    RT64::testStaleHashes();
+    RT64::testDatabaseHash();
+    RT64::testIndexHash();
+    RT64::testCorruptCaches();
+    return RT64::testResult();
+}
@@ -0,0 +1,241 @@
+//
+// RT64
+//
+
+#include "common/rt64_replacement_database.h"
+#include "common/rt64_filesystem_directory.h"
+#include "common/rt64_job_system.h"
+
+#include <fstream>
+#include <map>
+#include <random>
+#include <set>
+
+#include "rt64_test.h"
+
+namespace RT64 {
+    static std::string randomPath(std::mt19937 &random) {
+        // A small alphabet makes paths and wildcards share prefixes often, which is what the matcher's trie is built around.
+        static const char Alphabet[] = "ab/.";
+        const uint32_t length = random() % 10;
+        std::string path;
+        for (uint32_t i = 0; i < length; i++) {
+            path += Alphabet[random() % (sizeof(Alphabet) - 1)];
+        }
+
+        return path;
+    }
+
+    static std::string randomWildcard(std::mt19937 &random, const std::vector<std::string> &paths) {
+        // Start from one of the paths most of the time so the wildcards actually match some of them.
+        std::string wildcard = ((random() % 4) != 0) ? paths[random() % paths.size()] : randomPath(random);
+        const uint32_t editCount = random() % 4;
+        for (uint32_t i = 0; i < editCount; i++) {
+            const size_t position = wildcard.empty() ? 0 : (random() % (wildcard.size() + 1));
+            switch (random() % 4) {
+            case 0:
+                wildcard.insert(position, "*");
+                break;
+            case 1:
+                wildcard.erase(position, std::string::npos);
+                wildcard += '*';
+                break;
+            case 2:
+                if (position < wildcard.size()) {
+                    wildcard[position] = '?';
+                }
+
+                break;
+            default:
+                wildcard.insert(position, 1, "ab/."[random() % 4]);
+                break;
+            }
+        }
+
+        return wildcard;
+    }
+
+    // Checks the indexed matcher against the linear scan that checks every filter of the database in order.
+    static void testFilterMatcher() {
+        std::mt19937 random(45);
+        for (uint32_t iteration = 0; iteration < 200; iteration++) {
+            std::vector<std::string> paths;
+            const uint32_t pathCount = 1 + (random() % 64);
+            for (uint32_t i = 0; i < pathCount; i++) {
+                paths.emplace_back(randomPath(random));
+            }
+
+            ReplacementDatabase db;
+            std::vector<ReplacementDatabase> filterDbs;
+            const uint32_t filterCount = random() % 32;
+            for (uint32_t i = 0; i < filterCount; i++) {
+                ReplacementOperationFilter filter;
+                filter.wildcard = randomWildcard(random, paths);
+                filter.operation = ReplacementOperation(random() % uint32_t(ReplacementOperation::Auto));
+                db.operationFilters.emplace_back(filter);
+
+                // A database with only this filter tells whether the linear scan matches it, regardless of the operation it sets.
+                ReplacementDatabase &filterDb = filterDbs.emplace_back();
+                filterDb.config.defaultOperation = ReplacementOperation::Auto;
+                filterDb.operationFilters.emplace_back(filter);
+                filterDb.operationFilters.back().operation = ReplacementOperation::Stall;
+            }
+
+            // Paths that none of the wildcards were built from must be rejected the same way.
+            for (uint32_t i = 0; i < 16; i++) {
+                paths.emplace_back(randomPath(random));
+            }
+
+            const ReplacementFilterMatcher matcher(db.operationFilters);
+            for (const std::string &path : paths) {
+                uint32_t expectedIndex = ReplacementFilterMatcher::None;
+                for (uint32_t i = 0; i < filterCount; i++) {
+                    if (filterDbs[i].resolveOperation(path, ReplacementOperation::Auto) == ReplacementOperation::Stall) {
+                        expectedIndex = i;
+                    }
+                }
+
+                CHECK(matcher.find(path) == expectedIndex);
+                CHECK(db.resolveOperation(path, ReplacementOperation::Auto, matcher) == db.resolveOperation(path, ReplacementOperation::Auto));
+                CHECK(db.resolveOperation(path, ReplacementOperation::Preload, matcher) == ReplacementOperation::Preload);
+            }
+        }
+    }
+
+    // Resolving the database in batches on the job system must give the same results as resolving it on the calling thread.
+    static void testResolvePathsInBatches() {
+        const std::filesystem::path directoryPath = std::filesystem::temp_directory_path() / "rt64_replacement_database_test";
+        std::filesystem::remove_all(directoryPath);
+        std::filesystem::create_directories(directoryPath / "textures");
+
+        std::mt19937 random(46);
+        ReplacementDatabase db;
+        for (uint32_t i = 0; i < 5000; i++) {
+            ReplacementTexture texture;
+            texture.hashes.rt64 = ReplacementDatabase::hashToString(uint64_t(random() % 4000) + 1);
+            texture.path = "textures/" + std::to_string(i % 3000) + ".png";
+            if ((i % 7) == 0) {
+                texture.operation = ReplacementOperation::Stall;
+            }
+
+            // Leave some of the files missing.
+            if ((i < 3000) && ((i % 5) != 0)) {
+                std::ofstream fileStream(directoryPath / ((i % 2) ? "textures/" + std::to_string(i) + ".dds" : texture.path), std::ios::binary);
+                fileStream << i;
+            }
+
+            db.addReplacement(texture);
+        }
+
+        db.operationFilters.emplace_back(ReplacementOperationFilter{ { "textures/1*" }, ReplacementOperation::Preload });
+        db.operationFilters.emplace_back(ReplacementOperationFilter{ { "textures/?2*" }, ReplacementOperation::Stall });
+        db.shiftFilters.emplace_back(ReplacementShiftFilter{ { "*5.dds" }, ReplacementShift::None });
+
+        std::unique_ptr<FileSystem> fileSystem = FileSystemDirectory::create(directoryPath);
+        CHECK(fileSystem != nullptr);
+        if (fileSystem != nullptr) {
+            std::unordered_map<uint64_t, ReplacementResolvedPath> resolvedPaths;
+            std::unordered_map<uint64_t, ReplacementResolvedPath> batchResolvedPaths;
+            std::vector<uint64_t> hashesMissing;
+            std::vector<uint64_t> batchHashesMissing;
+            std::unordered_set<std::string> pathsToPreload;
+            std::unordered_set<std::string> batchPathsToPreload;
+            JobSystem jobSystem(4);
+            db.resolvePaths(fileSystem.get(), 1, resolvedPaths, false, &hashesMissing, &pathsToPreload);
+            db.resolvePaths(fileSystem.get(), 1, batchResolvedPaths, false, &batchHashesMissing, &batchPathsToPreload, &jobSystem);
+
+            CHECK(!resolvedPaths.empty());
+            CHECK(!hashesMissing.empty());
+            CHECK(!pathsToPreload.empty());
+            CHECK(batchResolvedPaths.size() == resolvedPaths.size());
+            CHECK(batchHashesMissing == hashesMissing);
+            CHECK(batchPathsToPreload == pathsToPreload);
+            for (const auto &it : resolvedPaths) {
+                auto batchIt = batchResolvedPaths.find(it.first);
+                CHECK(batchIt != batchResolvedPaths.end());
+                if (batchIt != batchResolvedPaths.end()) {
+                    CHECK(batchIt->second.fileSystemIndex == it.second.fileSystemIndex);
+                    CHECK(batchIt->second.relativePath == it.second.relativePath);
+                    CHECK(batchIt->second.resolvedOperation == it.second.resolvedOperation);
+                    CHECK(batchIt->second.resolvedShift == it.second.resolvedShift);
+                }
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::remove_all(directoryPath, ec);
+    }
+
+    // Identical files must be redirected to the same path, and a group with any preloaded entry must be entirely preloaded.
+    static void testDeduplicatePaths() {
+        const std::filesystem::path directoryPath = std::filesystem::temp_directory_path() / "rt64_replacement_database_dedup_test";
+        std::filesystem::remove_all(directoryPath);
+        std::filesystem::create_directories(directoryPath);
+
+        // Groups of files of the same size where only some of them are identical.
+        const uint32_t FileCount = 600;
+        for (uint32_t i = 0; i < FileCount; i++) {
+            std::ofstream fileStream(directoryPath / (std::to_string(i) + ".dds"), std::ios::binary);
+            fileStream << std::string(16 + (i % 3), char('a' + ((i / 3) % 5)));
+        }
+
+        std::unique_ptr<FileSystem> fileSystem = FileSystemDirectory::create(directoryPath);
+        CHECK(fileSystem != nullptr);
+        if (fileSystem != nullptr) {
+            std::unordered_map<uint64_t, ReplacementResolvedPath> resolvedPaths;
+            std::unordered_set<std::string> pathsToPreload;
+            for (uint32_t i = 0; i < FileCount; i++) {
+                ReplacementResolvedPath &resolvedPath = resolvedPaths[i + 1];
+                resolvedPath.textureHash = i + 1;
+                resolvedPath.relativePath = std::to_string(i) + ".dds";
+                resolvedPath.resolvedOperation = ((i % 7) == 0) ? ReplacementOperation::Preload : ReplacementOperation::Stream;
+                if (resolvedPath.resolvedOperation == ReplacementOperation::Preload) {
+                    pathsToPreload.insert(resolvedPath.relativePath);
+                }
+            }
+
+            std::unordered_map<uint64_t, ReplacementResolvedPath> batchResolvedPaths = resolvedPaths;
+            std::unordered_set<std::string> batchPathsToPreload = pathsToPreload;
+            JobSystem jobSystem(4);
+            const uint32_t redirectedCount = ReplacementDatabase::deduplicatePaths(fileSystem.get(), resolvedPaths, &pathsToPreload);
+            CHECK(ReplacementDatabase::deduplicatePaths(fileSystem.get(), batchResolvedPaths, &batchPathsToPreload, &jobSystem) == redirectedCount);
+            CHECK(redirectedCount == (FileCount - 15));
+            CHECK(batchPathsToPreload == pathsToPreload);
+
+            std::map<std::string, std::set<ReplacementOperation>> pathOperations;
+            std::map<std::pair<uint32_t, uint32_t>, std::set<std::string>> contentPaths;
+            for (const auto &it : resolvedPaths) {
+                const uint32_t i = uint32_t(it.first - 1);
+                const ReplacementResolvedPath &batchResolvedPath = batchResolvedPaths[it.first];
+                CHECK(batchResolvedPath.relativePath == it.second.relativePath);
+                CHECK(batchResolvedPath.resolvedOperation == it.second.resolvedOperation);
+                pathOperations[it.second.relativePath].insert(it.second.resolvedOperation);
+                contentPaths[{ i % 3, (i / 3) % 5 }].insert(it.second.relativePath);
+            }
+
+            CHECK(pathOperations.size() == 15);
+            for (const auto &it : pathOperations) {
+                CHECK(it.second.size() == 1);
+                CHECK((*it.second.begin() != ReplacementOperation::Preload) || (pathsToPreload.find(it.first) != pathsToPreload.end()));
+            }
+
+            for (const auto &it : contentPaths) {
+                CHECK(it.second.size() == 1);
+            }
+
+            for (const std::string &path : pathsToPreload) {
+                CHECK(pathOperations.find(path) != pathOperations.end());
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::remove_all(directoryPath, ec);
+    }
+};
+
+int main(int argc, char *argv[]) {
+    RT64::testFilterMatcher();
+    RT64::testResolvePathsInBatches();
+    RT64::testDeduplicatePaths();
+    return RT64::testResult();
+}
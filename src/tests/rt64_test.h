@@ -0,0 +1,33 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include <cstdio>
+
+// Minimal harness for the unit tests. Failed checks are printed and counted, and the test fails if any of them did.
+
+namespace RT64 {
+    inline int &testFailureCount() {
+        static int failureCount = 0;
+        return failureCount;
+    }
+
+    inline int testResult() {
+        if (testFailureCount() > 0) {
+            fprintf(stderr, "%d check(s) failed.\n", testFailureCount());
+            return 1;
+        }
+
+        return 0;
+    }
+};
+
+#define CHECK(condition)                                                                        \
+    do {                                                                                        \
+        if (!(condition)) {                                                                     \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed.\n", __FILE__, __LINE__, #condition);      \
+            RT64::testFailureCount()++;                                                         \
+        }                                                                                       \
+    } while (false)
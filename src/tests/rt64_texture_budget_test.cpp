@@ -0,0 +1,173 @@
+//
+// RT64
+//
+
+#include "render/rt64_texture_budget.h"
+
+#include <map>
+#include <random>
+#include <set>
+
+#include "rt64_test.h"
+
+namespace RT64 {
+    static const uint64_t MegabyteSize = 1024 * 1024;
+
+    static void testEvictionOrder() {
+        std::vector<TextureBudget::EvictionCandidate> candidates = {
+            { 0, 10, 1 * MegabyteSize },
+            { 1, 100, 16 * MegabyteSize },
+            { 2, 1000, 1 * MegabyteSize },
+            { 3, 10, 64 * MegabyteSize },
+        };
+
+        // Freeing 17 MB must pick the candidates with the most memory for the time they've been idle, and no more than necessary.
+        const size_t evictCount = TextureBudget::sortEvictionCandidates(candidates, 97 * MegabyteSize, 80 * MegabyteSize);
+        CHECK(evictCount == 2);
+        CHECK(candidates[0].textureIndex == 1);
+        CHECK(candidates[1].textureIndex == 2);
+        CHECK(candidates[2].textureIndex == 3);
+        CHECK(candidates[3].textureIndex == 0);
+
+        // Nothing is evicted while under the budget, and everything is if the candidates can't free enough memory.
+        CHECK(TextureBudget::sortEvictionCandidates(candidates, 50 * MegabyteSize, 80 * MegabyteSize) == 0);
+        CHECK(TextureBudget::sortEvictionCandidates(candidates, 1000 * MegabyteSize, 80 * MegabyteSize) == candidates.size());
+    }
+
+    // Simulates the textures decoded from TMEM: a hot set used every frame and a stream of textures that are only used for a few frames.
+    static void testEvictionSimulation() {
+        const uint64_t MinimumIdleFrames = 4;
+        const uint64_t MaxMemorySize = 64 * MegabyteSize;
+        std::mt19937 random(39);
+        std::map<uint32_t, uint64_t> textureSizes;
+        std::map<uint32_t, uint64_t> textureAccessFrames;
+        uint64_t memorySize = 0;
+        uint32_t nextTextureIndex = 0;
+
+        std::vector<uint32_t> hotTextures;
+        for (uint32_t i = 0; i < 32; i++) {
+            hotTextures.emplace_back(nextTextureIndex);
+            textureSizes[nextTextureIndex] = ((random() % 4) + 1) * 64 * 1024;
+            memorySize += textureSizes[nextTextureIndex];
+            nextTextureIndex++;
+        }
+
+        std::vector<TextureBudget::EvictionCandidate> candidates;
+        for (uint64_t frame = 1; frame <= 2000; frame++) {
+            for (uint32_t textureIndex : hotTextures) {
+                textureAccessFrames[textureIndex] = frame;
+            }
+
+            const uint32_t newTextureCount = random() % 8;
+            for (uint32_t i = 0; i < newTextureCount; i++) {
+                textureSizes[nextTextureIndex] = (uint64_t(1) << (random() % 4)) * 64 * 1024;
+                textureAccessFrames[nextTextureIndex] = frame;
+                memorySize += textureSizes[nextTextureIndex];
+                nextTextureIndex++;
+            }
+
+            // Only textures that can't be referenced by the frames in flight anymore are candidates.
+            candidates.clear();
+            for (const auto &it : textureAccessFrames) {
+                const uint64_t idleFrames = frame - it.second;
+                if (idleFrames >= MinimumIdleFrames) {
+                    candidates.emplace_back(TextureBudget::EvictionCandidate{ it.first, idleFrames, textureSizes[it.first] });
+                }
+            }
+
+            const size_t evictCount = TextureBudget::sortEvictionCandidates(candidates, memorySize, MaxMemorySize);
+            for (size_t i = 0; i < evictCount; i++) {
+                const uint32_t textureIndex = candidates[i].textureIndex;
+                CHECK((frame - textureAccessFrames[textureIndex]) >= MinimumIdleFrames);
+                memorySize -= textureSizes[textureIndex];
+                textureSizes.erase(textureIndex);
+                textureAccessFrames.erase(textureIndex);
+            }
+
+            // The hot set and the textures of the frames in flight can't add up to more than the budget, so the cache must always fit in it.
+            CHECK(memorySize <= MaxMemorySize);
+        }
+
+        // The hot set must never be evicted, as there's always something that's been unused for longer that can go first.
+        for (uint32_t textureIndex : hotTextures) {
+            CHECK(textureSizes.find(textureIndex) != textureSizes.end());
+        }
+    }
+
+    static void testPermanentAllocations() {
+        const uint64_t MaxPoolSize = 1024 * MegabyteSize;
+
+        // Without permanent allocations, the streamed textures get the whole pool.
+        CHECK(TextureBudget::streamedPoolBudget(MaxPoolSize, 0) == MaxPoolSize);
+        CHECK(!TextureBudget::isPoolUnderPressure(MaxPoolSize - 1, 0, MaxPoolSize));
+        CHECK(TextureBudget::isPoolUnderPressure(MaxPoolSize, 0, MaxPoolSize));
+
+        // Permanent allocations reduce the share of the streamed textures, and only the streamed usage is compared against it.
+        const uint64_t permanentSize = 256 * MegabyteSize;
+        CHECK(TextureBudget::streamedPoolBudget(MaxPoolSize, permanentSize) == (MaxPoolSize - permanentSize));
+        CHECK(!TextureBudget::isPoolUnderPressure(permanentSize + 700 * MegabyteSize, permanentSize, MaxPoolSize));
+        CHECK(TextureBudget::isPoolUnderPressure(permanentSize + 768 * MegabyteSize, permanentSize, MaxPoolSize));
+
+        // Permanent allocations that take over the pool still leave a minimum share for streaming.
+        const uint64_t largePermanentSize = 2 * MaxPoolSize;
+        CHECK(TextureBudget::streamedPoolBudget(MaxPoolSize, largePermanentSize) == (MaxPoolSize / 4));
+        CHECK(!TextureBudget::isPoolUnderPressure(largePermanentSize, largePermanentSize, MaxPoolSize));
+        CHECK(!TextureBudget::isPoolUnderPressure(largePermanentSize + 200 * MegabyteSize, largePermanentSize, MaxPoolSize));
+        CHECK(TextureBudget::isPoolUnderPressure(largePermanentSize + 256 * MegabyteSize, largePermanentSize, MaxPoolSize));
+
+        // An unlimited pool is never under pressure.
+        CHECK(!TextureBudget::isPoolUnderPressure(UINT64_MAX, 0, 0));
+    }
+
+    // Simulates the replacement pool while a pack is preloaded and streamed: the streaming only backs off while the textures it loaded
+    // and that are still in use fill the share of the pool the preloads left.
+    static void testReplacementPoolSimulation() {
+        const uint64_t MaxPoolSize = 512 * MegabyteSize;
+        const uint64_t TextureSize = 4 * MegabyteSize;
+        const uint64_t PreloadSize = 2 * MegabyteSize;
+        uint64_t usedPoolSize = 0;
+        uint64_t permanentPoolSize = 0;
+        std::set<uint32_t> streamedInUse;
+        std::mt19937 random(40);
+        uint32_t pressureFrames = 0;
+        for (uint32_t frame = 0; frame < 1000; frame++) {
+            // Preloads and low mips grow during the first frames regardless of the pressure.
+            if (frame < 100) {
+                usedPoolSize += PreloadSize;
+                permanentPoolSize += PreloadSize;
+            }
+
+            if (TextureBudget::isPoolUnderPressure(usedPoolSize, permanentPoolSize, MaxPoolSize)) {
+                pressureFrames++;
+            }
+            else {
+                streamedInUse.insert(frame);
+                usedPoolSize += TextureSize;
+            }
+
+            // Textures stop being used at random, which moves them to the unused list where they can be evicted.
+            if (!streamedInUse.empty() && ((random() % 3) == 0)) {
+                streamedInUse.erase(streamedInUse.begin());
+                usedPoolSize -= TextureSize;
+            }
+
+            CHECK((usedPoolSize - permanentPoolSize) == (streamedInUse.size() * TextureSize));
+        }
+
+        // Once the preloads are done, the streamed textures in use must fit in what they left of the pool.
+        CHECK((usedPoolSize - permanentPoolSize) <= TextureBudget::streamedPoolBudget(MaxPoolSize, permanentPoolSize));
+
+        // The pool must fill up and throttle the streaming without stopping it.
+        CHECK(pressureFrames > 0);
+        CHECK(pressureFrames < 1000);
+        CHECK(usedPoolSize <= MaxPoolSize);
+    }
+};
+
+int main(int argc, char *argv[]) {
+    RT64::testEvictionOrder();
+    RT64::testEvictionSimulation();
+    RT64::testPermanentAllocations();
+    RT64::testReplacementPoolSimulation();
+    return RT64::testResult();
+}
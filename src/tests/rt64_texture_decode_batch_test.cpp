@@ -0,0 +1,145 @@
+//
+// RT64
+//
+
+#include "render/rt64_texture_decode_batch.h"
+
+#include <random>
+
+#include "rt64_test.h"
+
+namespace RT64 {
+    // Mirrors the search done by TextureDecodeCS to find the texture a group belongs to.
+    static uint32_t findDescriptor(const TextureDecodeBatch &batch, const interop::TextureDecodeCB &decodeCB, uint32_t groupIndex) {
+        uint32_t lo = 0;
+        uint32_t hi = decodeCB.textureCount - 1;
+        while (lo < hi) {
+            const uint32_t mid = (lo + hi + 1) / 2;
+            if (batch.descriptors[decodeCB.descriptorOffset + mid].groupOffset <= groupIndex) {
+                lo = mid;
+            }
+            else {
+                hi = mid - 1;
+            }
+        }
+
+        return lo;
+    }
+
+    // Runs every group of every dispatch and checks each texture gets exactly the groups it needs to cover its resolution.
+    static void checkBatch(const TextureDecodeBatch &batch) {
+        std::vector<uint32_t> visitedGroups(batch.descriptors.size(), 0);
+        uint32_t textureCount = 0;
+        for (uint32_t c = 0; c < batch.dispatchCount(); c++) {
+            const interop::TextureDecodeCB decodeCB = batch.dispatchConstants(c);
+            CHECK(decodeCB.descriptorOffset == (c * TextureDecodeBatch::TexturesPerDispatch));
+            CHECK(decodeCB.textureCount > 0);
+            CHECK(decodeCB.textureCount <= TextureDecodeBatch::TexturesPerDispatch);
+            CHECK(batch.descriptors[decodeCB.descriptorOffset].groupOffset == 0);
+            textureCount += decodeCB.textureCount;
+
+            // The dispatch covers the groups with the same layout as the shader, including the groups past the end of the last row.
+            const uint32_t dispatchX = std::min(decodeCB.groupCount, uint32_t(TextureDecodeBatch::GroupsPerRow));
+            const uint32_t dispatchY = (decodeCB.groupCount + TextureDecodeBatch::GroupsPerRow - 1) / TextureDecodeBatch::GroupsPerRow;
+            uint32_t expectedDescriptor = 0;
+            for (uint32_t y = 0; y < dispatchY; y++) {
+                for (uint32_t x = 0; x < dispatchX; x++) {
+                    const uint32_t groupIndex = y * TextureDecodeBatch::GroupsPerRow + x;
+                    if (groupIndex >= decodeCB.groupCount) {
+                        continue;
+                    }
+
+                    // Groups are visited in order, so the texture they belong to can be tracked by skipping past the ones already covered.
+                    while (groupIndex >= (batch.descriptors[decodeCB.descriptorOffset + expectedDescriptor].groupOffset + TextureDecodeBatch::groupCount(batch.descriptors[decodeCB.descriptorOffset + expectedDescriptor]))) {
+                        expectedDescriptor++;
+                    }
+
+                    const uint32_t descriptorIndex = findDescriptor(batch, decodeCB, groupIndex);
+                    CHECK(descriptorIndex == expectedDescriptor);
+
+                    const interop::TextureDecodeDescriptor &desc = batch.descriptors[decodeCB.descriptorOffset + descriptorIndex];
+                    CHECK(groupIndex >= desc.groupOffset);
+
+                    const uint32_t localGroup = groupIndex - desc.groupOffset;
+                    CHECK(localGroup < TextureDecodeBatch::groupCount(desc));
+                    CHECK(((localGroup / desc.groupsPerRow) * TextureDecodeBatch::GroupSize) < desc.resolution.y);
+                    visitedGroups[decodeCB.descriptorOffset + descriptorIndex]++;
+                }
+            }
+        }
+
+        CHECK(textureCount == batch.descriptors.size());
+
+        for (size_t i = 0; i < batch.descriptors.size(); i++) {
+            const interop::TextureDecodeDescriptor &desc = batch.descriptors[i];
+            CHECK((desc.groupsPerRow * TextureDecodeBatch::GroupSize) >= desc.resolution.x);
+            CHECK(((desc.groupsPerRow - 1) * TextureDecodeBatch::GroupSize) < desc.resolution.x);
+            CHECK(visitedGroups[i] == TextureDecodeBatch::groupCount(desc));
+        }
+    }
+
+    static interop::TextureDecodeDescriptor makeDescriptor(uint32_t width, uint32_t height) {
+        interop::TextureDecodeDescriptor desc = {};
+        desc.resolution.x = width;
+        desc.resolution.y = height;
+        return desc;
+    }
+
+    static void testSingleDispatch() {
+        TextureDecodeBatch batch;
+        batch.add(makeDescriptor(32, 32));
+        batch.add(makeDescriptor(1, 1));
+        batch.add(makeDescriptor(9, 17));
+        batch.add(makeDescriptor(64, 8));
+        CHECK(batch.dispatchCount() == 1);
+        CHECK(batch.descriptors[0].groupOffset == 0);
+        CHECK(batch.descriptors[1].groupOffset == 16);
+        CHECK(batch.descriptors[2].groupOffset == 17);
+        CHECK(batch.descriptors[3].groupOffset == 23);
+        CHECK(batch.dispatchConstants(0).groupCount == 31);
+        checkBatch(batch);
+    }
+
+    static void testDispatchBoundaries() {
+        // Fill exactly one dispatch, then go one texture over it. The group offsets must start over on the second dispatch.
+        TextureDecodeBatch batch;
+        for (uint32_t i = 0; i < TextureDecodeBatch::TexturesPerDispatch; i++) {
+            batch.add(makeDescriptor(8 + (i % 5) * 8, 8 + (i % 3) * 8));
+        }
+
+        CHECK(batch.dispatchCount() == 1);
+        checkBatch(batch);
+
+        batch.add(makeDescriptor(16, 16));
+        CHECK(batch.dispatchCount() == 2);
+        CHECK(batch.dispatchConstants(1).textureCount == 1);
+        CHECK(batch.dispatchConstants(1).groupCount == 4);
+        CHECK(batch.descriptors[TextureDecodeBatch::TexturesPerDispatch].groupOffset == 0);
+        checkBatch(batch);
+    }
+
+    static void testRandomSizes() {
+        // Textures with very different group counts, including ones large enough to need several rows of groups in the dispatch.
+        std::mt19937 random(7);
+        TextureDecodeBatch batch;
+        for (uint32_t b = 0; b < 20; b++) {
+            batch.clear();
+
+            const uint32_t textureCount = 1 + (random() % (TextureDecodeBatch::TexturesPerDispatch * 3));
+            for (uint32_t i = 0; i < textureCount; i++) {
+                const uint32_t maxSize = ((random() % 8) == 0) ? 1024 : 64;
+                batch.add(makeDescriptor(1 + (random() % maxSize), 1 + (random() % maxSize)));
+            }
+
+            CHECK(batch.dispatchCount() == ((textureCount + TextureDecodeBatch::TexturesPerDispatch - 1) / TextureDecodeBatch::TexturesPerDispatch));
+            checkBatch(batch);
+        }
+    }
+};
+
+int main(int argc, char *argv[]) {
+    RT64::testSingleDispatch();
+    RT64::testDispatchBoundaries();
+    RT64::testRandomSizes();
+    return RT64::testResult();
+}
@@ -0,0 +1,157 @@
+//
+// RT64
+//
+
+#include "common/rt64_tmem_decoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "rt64_test.h"
+
+// The decode shader is compiled as C++ so the CPU decoder can be compared against the exact same source the GPU runs. Only the subset of
+// HLSL used by TextureDecoder.hlsli and Formats.hlsli is emulated here, and the CPU interop types are left out to avoid depending on hlslpp.
+#undef HLSL_CPU
+
+namespace HLSL {
+    typedef uint32_t uint;
+
+    struct int2 {
+        int x, y;
+    };
+
+    struct uint2 {
+        uint x, y;
+    };
+
+    struct float4 {
+        float r, g, b, a;
+
+        float4(float v) : r(v), g(v), b(v), a(v) { }
+        float4(float r, float g, float b, float a) : r(r), g(g), b(b), a(a) { }
+    };
+
+    template<typename T>
+    inline T select(bool cond, T val1, T val2) {
+        return cond ? val1 : val2;
+    }
+
+    inline bool and(bool a, bool b) {
+        return a && b;
+    }
+
+    inline bool or(bool a, bool b) {
+        return a || b;
+    }
+
+    inline float clamp(float v, float lo, float hi) {
+        return std::min(std::max(v, lo), hi);
+    }
+
+    inline int round(float v) {
+        return int(std::lround(v));
+    }
+
+    inline uint min(uint a, uint b) {
+        return std::min(a, b);
+    }
+
+    struct TMEMBuffer {
+        const uint8_t *bytes;
+    };
+
+#   define TMEM_RESOURCE TMEMBuffer
+#   define TMEM_LOAD(TMEM, address) uint((TMEM).bytes[(address)])
+#   include "shaders/TextureDecoder.hlsli"
+};
+
+namespace RT64 {
+    static const uint32_t TMEMSize = 0x1000;
+
+    // Converts the shader's output the same way a store to an RGBA8 UNORM texture does.
+    static uint32_t toUNORM8(const HLSL::float4 &color) {
+        auto toByte = [](float v) {
+            return uint32_t(std::lround(std::min(std::max(v, 0.0f), 1.0f) * 255.0f));
+        };
+
+        return toByte(color.r) | (toByte(color.g) << 8) | (toByte(color.b) << 16) | (toByte(color.a) << 24);
+    }
+
+    static uint32_t shaderTexel(const uint8_t *TMEM, const TMEMDecoder::Params &params, uint32_t x, uint32_t y) {
+        const HLSL::int2 texel = { int(x), int(y) };
+        const HLSL::TMEMBuffer buffer = { TMEM };
+        return toUNORM8(HLSL::sampleTMEM(texel, params.siz, params.fmt, params.address, params.stride, params.tlut, params.palette, buffer));
+    }
+
+    static bool compareTexture(const uint8_t *TMEM, const TMEMDecoder::Params &params, uint32_t width, uint32_t height) {
+        std::vector<uint32_t> decoded(width * height);
+        TMEMDecoder::decode(TMEM, TMEMSize, params, width, height, reinterpret_cast<uint8_t *>(decoded.data()), width * sizeof(uint32_t));
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                const uint32_t expected = shaderTexel(TMEM, params, x, y);
+                const uint32_t texel = TMEMDecoder::decodeTexel(TMEM, TMEMSize, params, x, y);
+                if ((texel != expected) || (decoded[y * width + x] != expected)) {
+                    fprintf(stderr, "Mismatch at (%u, %u) for fmt %u siz %u tlut %u palette %u address 0x%X stride %u: shader 0x%08X, texel 0x%08X, decode 0x%08X.\n",
+                        x, y, params.fmt, params.siz, params.tlut, params.palette, params.address, params.stride, expected, texel, decoded[y * width + x]);
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    static void testAllFormats() {
+        std::mt19937 random(37);
+        std::vector<uint8_t> TMEM(TMEMSize);
+        const uint32_t tlutModes[] = { G_TT_NONE, G_TT_RGBA16, G_TT_IA16 };
+        for (uint32_t iteration = 0; iteration < 16; iteration++) {
+            for (uint8_t &byte : TMEM) {
+                byte = uint8_t(random());
+            }
+
+            for (uint32_t siz = G_IM_SIZ_4b; siz <= G_IM_SIZ_32b; siz++) {
+                for (uint32_t fmt = G_IM_FMT_RGBA; fmt <= G_IM_FMT_I; fmt++) {
+                    for (uint32_t tlut : tlutModes) {
+                        TMEMDecoder::Params params;
+                        params.fmt = fmt;
+                        params.siz = siz;
+                        params.tlut = tlut;
+                        params.palette = random() % 16;
+                        params.address = (random() % 512) << 3;
+                        params.stride = ((random() % 64) + 1) << 3;
+
+                        // Sizes that aren't a multiple of the word size and rows that wrap around TMEM must match too.
+                        const uint32_t width = (random() % 48) + 1;
+                        const uint32_t height = (random() % 48) + 1;
+                        CHECK(compareTexture(TMEM.data(), params, width, height));
+                    }
+                }
+            }
+        }
+    }
+
+    static void testLoadTileParams() {
+        LoadTile loadTile = {};
+        loadTile.fmt = G_IM_FMT_CI;
+        loadTile.siz = G_IM_SIZ_4b;
+        loadTile.line = 2;
+        loadTile.tmem = 0x40;
+        loadTile.palette = 7;
+
+        const TMEMDecoder::Params params(loadTile, G_TT_RGBA16);
+        CHECK(params.fmt == G_IM_FMT_CI);
+        CHECK(params.siz == G_IM_SIZ_4b);
+        CHECK(params.address == (0x40U << 3));
+        CHECK(params.stride == (2U << 3));
+        CHECK(params.palette == 7);
+        CHECK(params.tlut == G_TT_RGBA16);
+    }
+};
+
+int main(int argc, char *argv[]) {
+    RT64::testAllFormats();
+    RT64::testLoadTileParams();
+    return RT64::testResult();
+}
@@ -16,8 +16,11 @@
 #include <ddspp/ddspp.h>
 #include <miniz/miniz.h>
 #include <plainargs/plainargs.h>
+#include <zdict.h>
 #include <zstd.h>
 
+#include "../../common/rt64_filesystem_pack_writer.cpp"
+#include "../../common/rt64_job_system.h"
 #include "../../common/rt64_replacement_database.cpp"
 
 enum {
@@ -50,6 +53,7 @@ struct CompressionOutput {
     uint32_t uncompressedSize = 0;
     uint32_t checksum = 0;
     mz_uint16 compressionMethod = 0;
+    RT64::FileSystemPackPayload packPayload;
 };
 
 std::queue<CompressionInput> inputQueue;
@@ -60,9 +64,70 @@ std::condition_variable outputQueueChanged;
 std::atomic<bool> compressionFailed;
 std::atomic<bool> useCompression;
 std::atomic<bool> useZstd;
+std::atomic<bool> usePackV2;
+std::atomic<bool> useMipChunks;
+ZSTD_CDict *packCompressionDictionary = nullptr;
+
+void compressForPack(const std::vector<uint8_t> &fileData, bool storeUncompressed, ZSTD_CCtx *compressionContext, CompressionOutput &output) {
+    // DDS files can be split into a chunk for the header and one for each mipmap, so they can be decompressed separately.
+    std::vector<size_t> segmentOffsets = { 0 };
+    if (useMipChunks && (fileData.size() >= sizeof(uint32_t)) && (*reinterpret_cast<const uint32_t *>(fileData.data()) == ddspp::DDS_MAGIC)) {
+        ddspp::Descriptor ddsDescriptor;
+        if ((fileData.size() >= ddspp::MAX_HEADER_SIZE) && (ddspp::decode_header(const_cast<uint8_t *>(fileData.data()), ddsDescriptor) == ddspp::Success)) {
+            for (uint32_t mip = 0; mip < ddsDescriptor.numMips; mip++) {
+                size_t mipOffset = ddsDescriptor.headerSize + ddspp::get_offset(ddsDescriptor, mip, 0);
+                if ((mipOffset > segmentOffsets.back()) && (mipOffset < fileData.size())) {
+                    segmentOffsets.emplace_back(mipOffset);
+                }
+            }
+        }
+    }
+
+    segmentOffsets.emplace_back(fileData.size());
+    output.packPayload.compress(fileData, segmentOffsets, compressionContext, packCompressionDictionary, useCompression && !storeUncompressed);
+}
+
+bool trainPackDictionary(const std::filesystem::path &searchDirectory, const std::set<std::string> &files, std::vector<uint8_t> &dictionary) {
+    // Sample the start of the files, which holds the headers and largest mipmaps that are the most likely to share data.
+    const size_t SampleMaxSize = 64 * 1024;
+    const size_t SamplesMaxTotalSize = 64 * 1024 * 1024;
+    const size_t DictionaryMaxSize = 110 * 1024;
+    std::vector<uint8_t> samples;
+    std::vector<size_t> sampleSizes;
+    for (const std::string &file : files) {
+        if (samples.size() >= SamplesMaxTotalSize) {
+            break;
+        }
+
+        std::ifstream fileStream(searchDirectory / std::filesystem::u8path(file), std::ios::binary);
+        if (!fileStream.is_open()) {
+            continue;
+        }
+
+        size_t sampleOffset = samples.size();
+        samples.resize(sampleOffset + SampleMaxSize);
+        fileStream.read(reinterpret_cast<char *>(&samples[sampleOffset]), SampleMaxSize);
+        samples.resize(sampleOffset + size_t(fileStream.gcount()));
+        if (samples.size() > sampleOffset) {
+            sampleSizes.emplace_back(samples.size() - sampleOffset);
+        }
+    }
+
+    dictionary.resize(DictionaryMaxSize);
+    size_t dictionarySize = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), samples.data(), sampleSizes.data(), unsigned(sampleSizes.size()));
+    if (ZDICT_isError(dictionarySize)) {
+        fprintf(stderr, "Failed to train the dictionary: %s.\n", ZDICT_getErrorName(dictionarySize));
+        dictionary.clear();
+        return false;
+    }
+
+    dictionary.resize(dictionarySize);
+    return true;
+}
 
 void compressionThread() {
     std::vector<uint8_t> fileData;
+    std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> compressionContext(ZSTD_createCCtx(), &ZSTD_freeCCtx);
     while (!compressionFailed) {
         CompressionInput input;
         {
@@ -100,7 +165,12 @@ void compressionThread() {
 
         mz_uint16 compressionMethod = 0;
         size_t compressedSize = 0;
-        if (useCompression) {
+        if (usePackV2) {
+            // The low mip cache is stored as is so its entries can be read from the pack when they're used instead of keeping the whole cache in memory.
+            const bool storeUncompressed = (input.zipPath == RT64::ReplacementLowMipCacheFilename);
+            compressForPack(fileData, storeUncompressed, compressionContext.get(), output);
+        }
+        else if (useCompression) {
             if (useZstd && !input.preferDeflateOverZstd) {
                 // Max compression level has shown significant advantages in size reduction.
                 compressedSize = ZSTD_compress(output.fileData.data(), output.fileData.size(), fileData.data(), fileData.size(), ZSTD_maxCLevel());
@@ -119,15 +189,18 @@ void compressionThread() {
             }
         }
 
-        if (compressedSize > 0) {
-            output.fileData.resize(compressedSize);
-            output.compressionMethod = compressionMethod;
-        }
-        else {
-            memcpy(output.fileData.data(), fileData.data(), output.fileData.size());
+        // The pack compression already decides whether to store the file as is.
+        if (!usePackV2) {
+            if (compressedSize > 0) {
+                output.fileData.resize(compressedSize);
+                output.compressionMethod = compressionMethod;
+            }
+            else {
+                memcpy(output.fileData.data(), fileData.data(), output.fileData.size());
+            }
         }
 
-        output.zipPath = input.zipPath;
+        output.zipPath = usePackV2 ? RT64::FileSystem::toForwardSlashes(input.zipPath) : input.zipPath;
         output.uncompressedSize = fileData.size();
         output.checksum = mz_crc32(MZ_CRC32_INIT, fileData.data(), fileData.size());
 
@@ -148,7 +221,7 @@ void showHelp() {
     fprintf(stdout,
         "texture_packer <path> --create-low-mip-cache\n"
         "\tGenerate the cache used for streaming textures in by extracting the lowest quality mipmaps.\n\n"
-        "texture_packer <path> --create-pack [--deflate] [--store] [--threads number]\n"
+        "texture_packer <path> --create-pack [--deflate] [--store] [--threads number] [--pack-v2 [--dictionary] [--mip-chunks]]\n"
         "\tCreate the pack by including all the textures supported by the database and the low mip cache.\n"
         "\tUse '--deflate' to downgrade the compression algorithm and make the resulting package compatible\n"
         "\twith more third-party zip software. This is not recommended as load times will be worse.\n"
@@ -156,6 +229,10 @@ void showHelp() {
         "\tthe speed of the storage where the pack is loaded from.\n"
         "\tUse '--threads number' to specify the amount of compression threads. By default, the tool will\n"
         "\tuse all threads of the system available.\n"
+        "\tUse '--pack-v2' to create the pack in the format that can be mapped into memory directly instead of\n"
+        "\ta zip file. Files that don't get smaller when compressed are stored as is. Use '--dictionary' to\n"
+        "\ttrain a zstd dictionary from the files and compress them with it. Use '--mip-chunks' to compress\n"
+        "\tevery mipmap of a DDS as a separate chunk that can be decompressed on its own.\n"
         "\t\n"
     );
 }
@@ -342,7 +419,11 @@ int main(int argc, char *argv[]) {
     std::vector<uint64_t> hashesMissing;
     std::unordered_map<uint64_t, RT64::ReplacementResolvedPath> resolvedPathMap;
     std::unique_ptr<RT64::FileSystem> fileSystem = RT64::FileSystemDirectory::create(searchDirectory);
-    database.resolvePaths(fileSystem.get(), 0, resolvedPathMap, mode == Mode::CreateLowMipCache, &hashesMissing);
+    {
+        // The calling thread resolves a batch as well, so it's left out of the workers.
+        RT64::JobSystem jobSystem(std::max(std::thread::hardware_concurrency() - 1U, 1U));
+        database.resolvePaths(fileSystem.get(), 0, resolvedPathMap, mode == Mode::CreateLowMipCache, &hashesMissing, nullptr, &jobSystem);
+    }
 
     for (auto it : resolvedPathMap) {
         if ((mode != Mode::CreateLowMipCache) || (it.second.resolvedOperation == RT64::ReplacementOperation::Stream)) {
@@ -412,6 +493,14 @@ int main(int argc, char *argv[]) {
             useCompression = true;
         }
 
+        usePackV2 = args.hasOption("pack-v2");
+        useMipChunks = usePackV2 && args.hasOption("mip-chunks");
+        const bool usePackDictionary = usePackV2 && useCompression && args.hasOption("dictionary");
+        if (usePackV2 && useCompression && !useZstd) {
+            fprintf(stderr, "Deflate is not supported by the v2 pack format.\n");
+            return 1;
+        }
+
         // Perform some file case validation before creating the pack.
         fprintf(stdout, "Validating database files...\n");
 
@@ -448,13 +537,12 @@ int main(int argc, char *argv[]) {
         std::filesystem::path packPath = searchDirectory / packName;
         std::string packPathStr = packPath.u8string();
         mz_zip_archive zipArchive = {};
-        if (!mz_zip_writer_init_file_v2(&zipArchive, packPathStr.c_str(), 0, MZ_ZIP_FLAG_WRITE_ZIP64)) {
-            fprintf(stderr, "Failed to open %s for writing.\n", packPathStr.c_str());
-            return 1;
-        }
-
+        RT64::FileSystemPackWriter packWriter;
+        std::set<std::string> packFiles;
         uint32_t outputQueueTotal = 0;
         auto addToQueue = [&](const std::string &file, bool preferDeflateOverZstd = false) {
+            packFiles.insert(file);
+
             CompressionInput input;
             input.filePath = searchDirectory / std::filesystem::u8path(file);
             input.zipPath = file;
@@ -485,6 +573,38 @@ int main(int argc, char *argv[]) {
             compressionFailed = true;
         }
 
+        // The dictionary is optional, so the pack is still created without it if there's not enough data to train one.
+        std::vector<uint8_t> packDictionary;
+        std::unique_ptr<ZSTD_CDict, decltype(&ZSTD_freeCDict)> compressionDictionary(nullptr, &ZSTD_freeCDict);
+        if (!compressionFailed && usePackDictionary) {
+            fprintf(stdout, "Training dictionary...\n");
+            if (trainPackDictionary(searchDirectory, packFiles, packDictionary)) {
+                compressionDictionary.reset(ZSTD_createCDict(packDictionary.data(), packDictionary.size(), ZSTD_maxCLevel()));
+                packCompressionDictionary = compressionDictionary.get();
+            }
+
+            if (packCompressionDictionary == nullptr) {
+                fprintf(stderr, "Creating the pack without a dictionary.\n");
+                packDictionary.clear();
+            }
+        }
+
+        if (compressionFailed) {
+            fprintf(stderr, "Pack creation has failed.\n");
+            return 1;
+        }
+
+        if (usePackV2) {
+            if (!packWriter.open(packPath, packDictionary)) {
+                fprintf(stderr, "Failed to open %s for writing.\n", packPathStr.c_str());
+                return 1;
+            }
+        }
+        else if (!mz_zip_writer_init_file_v2(&zipArchive, packPathStr.c_str(), 0, MZ_ZIP_FLAG_WRITE_ZIP64)) {
+            fprintf(stderr, "Failed to open %s for writing.\n", packPathStr.c_str());
+            return 1;
+        }
+
         if (!compressionFailed) {
             // Create all worker threads.
             std::list<std::unique_ptr<std::thread>> compressionThreads;
@@ -508,7 +628,13 @@ int main(int argc, char *argv[]) {
 
                 if (!output.zipPath.empty()) {
                     mz_uint flags = useCompression ? MZ_ZIP_FLAG_COMPRESSED_DATA : 0;
-                    if (!mz_zip_writer_add_mem_ex_v2(&zipArchive, output.zipPath.c_str(), output.fileData.data(), output.fileData.size(), nullptr, 0, flags, useCompression ? output.uncompressedSize : 0, output.checksum, nullptr, nullptr, 0, nullptr, 0, output.compressionMethod)) {
+                    if (usePackV2) {
+                        if (!packWriter.add(output.zipPath, output.packPayload)) {
+                            fprintf(stderr, "Failed to add %s to pack.\n", output.zipPath.c_str());
+                            compressionFailed = true;
+                        }
+                    }
+                    else if (!mz_zip_writer_add_mem_ex_v2(&zipArchive, output.zipPath.c_str(), output.fileData.data(), output.fileData.size(), nullptr, 0, flags, useCompression ? output.uncompressedSize : 0, output.checksum, nullptr, nullptr, 0, nullptr, 0, output.compressionMethod)) {
                         fprintf(stderr, "Failed to add %s to pack.\n", output.zipPath.c_str());
                         compressionFailed = true;
                     }
@@ -526,16 +652,26 @@ int main(int argc, char *argv[]) {
             }
         }
 
-        if (!compressionFailed) {
-            if (!mz_zip_writer_finalize_archive(&zipArchive)) {
-                fprintf(stderr, "Failed to finalize archive %s.\n", packPathStr.c_str());
+        if (usePackV2) {
+            if (!compressionFailed && !packWriter.finalize()) {
+                fprintf(stderr, "Failed to finalize pack %s.\n", packPathStr.c_str());
                 compressionFailed = true;
             }
+
+            packWriter.stream.close();
         }
+        else {
+            if (!compressionFailed) {
+                if (!mz_zip_writer_finalize_archive(&zipArchive)) {
+                    fprintf(stderr, "Failed to finalize archive %s.\n", packPathStr.c_str());
+                    compressionFailed = true;
+                }
+            }
 
-        if (!mz_zip_writer_end(&zipArchive)) {
-            fprintf(stderr, "Failed to close %s for writing.\n", packPathStr.c_str());
-            compressionFailed = true;
+            if (!mz_zip_writer_end(&zipArchive)) {
+                fprintf(stderr, "Failed to close %s for writing.\n", packPathStr.c_str());
+                compressionFailed = true;
+            }
         }
 
         if (compressionFailed) {